@@ -11,13 +11,20 @@
 #include <SFML/Graphics.hpp>
 #include "Training/AiControllerData.h"
 #include "Training/AiPlayerTrainer.h"
+#include "Training/DemonstrationRecorder.h"
+#include "Training/Distiller.h"
+#include "Training/EvolutionStrategyTrainer.h"
+#include "Util/Random.h"
 #include "Util/WindowsDialogs.h"
 #include "Windows.h"
 
 enum class PlayMode
 {
 	TrainAiControllers,
+	TrainEvolutionStrategy,
 	VsSavedAi,
+	// Distills the saved AI into a smaller network and plays against that instead
+	VsDistilledAi,
 	PlayerVsPlayer
 };
 
@@ -33,14 +40,44 @@ constexpr float k_gameDuration = 15.0f * 1.0f;
 constexpr int k_numControllers = 1024;
 constexpr int m_numGameSeasons = 8;
 constexpr float k_percentControllersToKeepPerGeneration = 0.2f;
+constexpr int k_targetNumSpecies = 16;
+// Prefer cheaper networks when picking survivors, instead of only the strongest
+constexpr bool k_paretoSelection = false;
+// Children bred per survivor slot, of which only the one predicted to be best plays games
+constexpr int k_surrogateCandidatesPerChild = 4;
+// Children that can't outscore an idle opponent in short games are bred again, up to this many times
+constexpr int k_gatingAttempts = 3;
+// Benchmark the champion against hand written opponents every generation
+constexpr bool k_scriptedBaselines = true;
+// Stop playing games with controllers that are clearly in or out of the next generation
+constexpr bool k_racingEvaluation = true;
+// Rank controllers by ratings that persist across generations
+constexpr bool k_useRatings = true;
+// Pair controllers whose order is least certain, rather than in a fixed rotation
+constexpr MatchmakingStrategy k_matchmaking = MatchmakingStrategy::InformationGain;
+// Play each round of games on worker threads, one per hardware thread
+constexpr bool k_parallelGames = true;
+// End training games once one side can't plausibly catch up, or nothing is happening
+constexpr bool k_endGamesEarly = true;
+// Replace controllers continuously on worker threads instead of a generation at a time
+constexpr bool k_steadyStateEvolution = false;
+// Past champions that every new champion is benchmarked against, to measure progress
+constexpr int k_hallOfFameSize = 32;
 constexpr int k_saveEveryNGenerations = 100;
 constexpr int k_numGenerationsToRun = 1000 * 1000;
 const char* k_saveFileName = "Ai_v%d_%d_%d_deep_%dgen.bin";
+const char* k_evolutionStrategySaveFileName = "Ai_v%d_%d_%d_es_%diter.bin";
 //const char* k_loadFileName = "Ai_v0_1_0_deep_14400gen.bin";
 const char* k_loadFileName = "Ai_v0_1_0_deep_10600gen.bin";
+// Records human players to train networks that imitate them. nullptr to disable.
+const char* k_demonstrationFileName = nullptr;
+// Hidden levels of the network the saved AI is distilled into for VsDistilledAi
+const std::vector<int> k_distilledHiddenLevels = { 8 };
+
+constexpr bool k_isTrainingMode = (k_playMode == PlayMode::TrainAiControllers) || (k_playMode == PlayMode::TrainEvolutionStrategy);
 
 // Disable vsync when training AI so the simulations can run as fast as possible
-constexpr bool k_vsyncEnabled = (k_playMode != PlayMode::TrainAiControllers);
+constexpr bool k_vsyncEnabled = !k_isTrainingMode;
 constexpr float k_windowWidth = 1280;	// 1280
 constexpr float k_aspectRatio = 16.0f / 9.0f;
 
@@ -49,7 +86,7 @@ constexpr int k_startupDelay = 60 * 0;
 constexpr bool k_imguiEnabled = true;
 
 // TODO: Move these into somewhere nicer, probably a struct in App
-static bool s_vsyncEnabled = (k_playMode != PlayMode::TrainAiControllers);
+static bool s_vsyncEnabled = !k_isTrainingMode;
 static int s_antialiasingValue = 0;
 // TODO: Make a nicer way to set antialiasing values, or at least hide it better
 const std::vector<int> k_antialiasingValueToLevel = { 0, 2, 4, 8, 16 };
@@ -63,10 +100,20 @@ App::~App()
 		delete m_aiPlayerTrainer;
 	}
 
+	if (m_evolutionStrategyTrainer != nullptr)
+	{
+		delete m_evolutionStrategyTrainer;
+	}
+
 	if (m_testGame != nullptr)
 	{
 		delete m_testGame;
 	}
+
+	if (m_demonstrationRecorder != nullptr)
+	{
+		delete m_demonstrationRecorder;
+	}
 }
 
 void App::Initialize()
@@ -178,6 +225,24 @@ void App::InitializeGame()
 		config.m_numGameSeasons = m_numGameSeasons;
 		config.m_gameDuration = k_gameDuration;
 		config.m_percentToKeep = k_percentControllersToKeepPerGeneration;
+		config.m_targetNumSpecies = k_targetNumSpecies;
+		config.m_paretoSelection = k_paretoSelection;
+		config.m_surrogateCandidatesPerChild = k_surrogateCandidatesPerChild;
+		config.m_gatingAttempts = k_gatingAttempts;
+		config.m_scriptedBaselines = k_scriptedBaselines;
+		config.m_racing = k_racingEvaluation;
+		config.m_useRatings = k_useRatings;
+		config.m_matchmaking = k_matchmaking;
+		config.m_parallelGames = k_parallelGames;
+		if (k_endGamesEarly)
+		{
+			// A goal takes at least a few seconds from kickoff
+			config.m_earlyEndRules.m_mercyGoalsPerMinute = 12.0f;
+			config.m_earlyEndRules.m_stallSeconds = 2.0f;
+			config.m_earlyEndRules.m_noProgressSeconds = 8.0f;
+		}
+		config.m_steadyState = k_steadyStateEvolution;
+		config.m_hallOfFameSize = k_hallOfFameSize;
 		config.m_saveEveryNGenerations = k_saveEveryNGenerations;
 		config.m_numGenerations = k_numGenerationsToRun;
 		config.m_saveFile = k_saveFileName;
@@ -191,7 +256,21 @@ void App::InitializeGame()
 		break;
 	}
 
+	case PlayMode::TrainEvolutionStrategy:
+	{
+		EvolutionStrategyTrainer::Config config;
+		config.m_gameDuration = k_gameDuration;
+		config.m_saveEveryNIterations = k_saveEveryNGenerations;
+		config.m_numIterations = k_numGenerationsToRun;
+		config.m_saveFile = k_evolutionStrategySaveFileName;
+
+		_ASSERT(m_evolutionStrategyTrainer == nullptr);
+		m_evolutionStrategyTrainer = new EvolutionStrategyTrainer(config);
+		break;
+	}
+
 	case PlayMode::VsSavedAi:
+	case PlayMode::VsDistilledAi:
 	{
 		// TODO: Figure out a better way of loading AI controllers without instantiating m_aiPlayerTrainer
 		AiPlayerTrainer::Config dummyConfig;
@@ -200,11 +279,25 @@ void App::InitializeGame()
 		// Fail loudly if saved controllers couldn't be read
 		_ASSERT(success);
 
+		if (k_playMode == PlayMode::VsDistilledAi)
+		{
+			NeuralNetPlayerController* teacher = m_aiPlayerTrainer->GetAiController(0)->m_controller;
+			Distiller::Config distillerConfig;
+			distillerConfig.m_studentHiddenLevels = k_distilledHiddenLevels;
+			distillerConfig.m_gameDuration = k_gameDuration;
+			Distiller distiller(*teacher->DebugGetNetwork(), distillerConfig);
+			Random rand;
+			distiller.Run(rand);
+			distiller.PlayMatch(rand);
+			teacher->SetNetwork(distiller.GetStudent());
+		}
+
 		_ASSERT(m_testGame == nullptr);
 		m_testGame = new NeuronGame();
 		m_testGame->SetPlayerController(0, new HumanPlayerController(InputProvider(0, m_userInputBlocker)));
 		m_testGame->SetPlayerController(1, m_aiPlayerTrainer->GetAiController(0)->m_controller);
 //		m_testGame->SetPlayerController(1, m_aiPlayerTrainer->GetAiController(1000)->m_controller);
+		StartRecordingDemonstrations(0);
 		break;
 	}
 	break;
@@ -215,6 +308,7 @@ void App::InitializeGame()
 		m_testGame = new NeuronGame();
 		m_testGame->SetPlayerController(0, new HumanPlayerController(InputProvider(0, m_userInputBlocker)));
 		m_testGame->SetPlayerController(1, new HumanPlayerController(InputProvider(1, m_userInputBlocker)));
+		StartRecordingDemonstrations(-1);
 		break;
 	}
 
@@ -223,12 +317,32 @@ void App::InitializeGame()
 	}
 }
 
+void App::StartRecordingDemonstrations(const int playerIndex)
+{
+	if (k_demonstrationFileName == nullptr)
+	{
+		return;
+	}
+
+	DemonstrationRecorder::Config config;
+	config.m_playerIndex = playerIndex;
+	_ASSERT(m_demonstrationRecorder == nullptr);
+	m_demonstrationRecorder = new DemonstrationRecorder(config);
+	bool success = m_demonstrationRecorder->Open(k_demonstrationFileName);
+	_ASSERT(success);
+	m_testGame->SetRecorder(m_demonstrationRecorder);
+}
+
 void App::UpdateGame()
 {
 	if (k_playMode == PlayMode::TrainAiControllers)
 	{
 		m_aiPlayerTrainer->Update();
 	}
+	else if (k_playMode == PlayMode::TrainEvolutionStrategy)
+	{
+		m_evolutionStrategyTrainer->Update();
+	}
 	else
 	{
 		m_testGame->Update();
@@ -242,7 +356,11 @@ void App::DrawGame()
 	const NeuronGame* gameToDisplay = m_testGame;
 	if (k_playMode == PlayMode::TrainAiControllers)
 	{
-		gameToDisplay = m_aiPlayerTrainer->GetGame(0);
+		gameToDisplay = m_aiPlayerTrainer->GetGame();
+	}
+	else if (k_playMode == PlayMode::TrainEvolutionStrategy)
+	{
+		gameToDisplay = m_evolutionStrategyTrainer->GetGame();
 	}
 
 	const float length = gameToDisplay->GetFieldLength();
@@ -6,6 +6,8 @@
 
 class AiControllerData;
 class AiPlayerTrainer;
+class DemonstrationRecorder;
+class EvolutionStrategyTrainer;
 class NeuronGame;
 
 class App
@@ -19,6 +21,8 @@ public:
 
 private:
 	void InitializeGame();
+	// Records the inputs of 'playerIndex' (-1 for every player) in m_testGame, if enabled
+	void StartRecordingDemonstrations(const int playerIndex);
 	void UpdateGame();
 	void DrawGame();
 
@@ -38,9 +42,13 @@ private:
 
 	// Instance of AiPlayerTrainer for running game simulations and training NeuralNetPlayerController
 	AiPlayerTrainer* m_aiPlayerTrainer = nullptr;
+	// Alternative trainer that uses evolution strategies on a single network
+	EvolutionStrategyTrainer* m_evolutionStrategyTrainer = nullptr;
 
 	// TEMP: Game instance for testing
 	NeuronGame* m_testGame = nullptr;
+	// Records m_testGame for behavior cloning
+	DemonstrationRecorder* m_demonstrationRecorder = nullptr;
 
 	bool m_renderThisFrame = true;
 
@@ -4,6 +4,7 @@
 #include <SFML/Graphics.hpp>
 
 #include "Util/Random.h"
+#include "Util/ShapeDrawer.h"
 #include "Util/Shapes.h"
 
 
@@ -226,7 +227,7 @@ void PhysicsTest::DrawPhysicsTest()
 	{
 		if (shape != nullptr)
 		{
-			shape->Draw(m_window);
+			ShapeDrawer::Draw(m_window, *shape);
 		}
 	}
 
@@ -0,0 +1,501 @@
+#include "pch.h"
+#include "BackpropTrainer.h"
+
+#include <algorithm>
+#include "Optimizer.h"
+#include <thread>
+#include "Util/Math.h"
+#include "Util/Random.h"
+#include "Util/Simd.h"
+
+namespace
+{
+	float Dot(const float* a, const float* b, const int count)
+	{
+		int i = 0;
+		float sum = 0.0f;
+#if PLIB_SIMD_SSE2
+		__m128 sum0 = _mm_setzero_ps();
+		__m128 sum1 = _mm_setzero_ps();
+		for (; i + 8 <= count; i += 8)
+		{
+			sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+			sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+		}
+		float lanes[4];
+		_mm_storeu_ps(lanes, _mm_add_ps(sum0, sum1));
+		sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+		for (; i < count; i++)
+		{
+			sum += a[i] * b[i];
+		}
+		return sum;
+	}
+
+	// Dot products of one row of weights with four rows of inputs. The weights are only loaded once.
+	void Dot4(const float* weights, const float* const inputs[4], const int count, float outSums[4])
+	{
+		int i = 0;
+		outSums[0] = 0.0f;
+		outSums[1] = 0.0f;
+		outSums[2] = 0.0f;
+		outSums[3] = 0.0f;
+#if PLIB_SIMD_SSE2
+		__m128 sum0 = _mm_setzero_ps();
+		__m128 sum1 = _mm_setzero_ps();
+		__m128 sum2 = _mm_setzero_ps();
+		__m128 sum3 = _mm_setzero_ps();
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 w = _mm_loadu_ps(weights + i);
+			sum0 = _mm_add_ps(sum0, _mm_mul_ps(w, _mm_loadu_ps(inputs[0] + i)));
+			sum1 = _mm_add_ps(sum1, _mm_mul_ps(w, _mm_loadu_ps(inputs[1] + i)));
+			sum2 = _mm_add_ps(sum2, _mm_mul_ps(w, _mm_loadu_ps(inputs[2] + i)));
+			sum3 = _mm_add_ps(sum3, _mm_mul_ps(w, _mm_loadu_ps(inputs[3] + i)));
+		}
+		// Transpose so each lane holds the sum for one input row
+		_MM_TRANSPOSE4_PS(sum0, sum1, sum2, sum3);
+		_mm_storeu_ps(outSums, _mm_add_ps(_mm_add_ps(sum0, sum1), _mm_add_ps(sum2, sum3)));
+#endif
+		for (; i < count; i++)
+		{
+			outSums[0] += weights[i] * inputs[0][i];
+			outSums[1] += weights[i] * inputs[1][i];
+			outSums[2] += weights[i] * inputs[2][i];
+			outSums[3] += weights[i] * inputs[3][i];
+		}
+	}
+
+	// y += a * x
+	void Axpy(float* y, const float a, const float* x, const int count)
+	{
+		int i = 0;
+#if PLIB_SIMD_SSE2
+		const __m128 a4 = _mm_set1_ps(a);
+		for (; i + 4 <= count; i += 4)
+		{
+			_mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(a4, _mm_loadu_ps(x + i))));
+		}
+#endif
+		for (; i < count; i++)
+		{
+			y[i] += a * x[i];
+		}
+	}
+
+	// Same as Neuron::Activation
+	float Activate(const ActivationFunction activation, const float x)
+	{
+		switch (activation)
+		{
+		case ActivationFunction::Identity:
+			return x;
+		case ActivationFunction::TanH:
+			return tanhf(x);
+		case ActivationFunction::Sigmoid:
+			return Sigmoid(x);
+		}
+		_ASSERT(false);	// Should never get here
+		return 0.0f;
+	}
+
+	// Derivative of the activation function, in terms of its output
+	float ActivationDx(const ActivationFunction activation, const float output)
+	{
+		switch (activation)
+		{
+		case ActivationFunction::Identity:
+			return 1.0f;
+		case ActivationFunction::TanH:
+			return 1.0f - (output * output);
+		case ActivationFunction::Sigmoid:
+			// Same as SigmoidDx, without recomputing the sigmoid
+			return output * (1.0f - output);
+		}
+		_ASSERT(false);	// Should never get here
+		return 0.0f;
+	}
+}
+
+// Everything one shard needs for its forward and backward passes
+class BackpropTrainer::Workspace
+{
+public:
+	// Outputs of each level, one row per sample. The input level is read straight from the data.
+	std::vector<std::vector<float>> m_outputs;
+	// Gradient of the loss with respect to each level's outputs, then its weighted sums
+	std::vector<std::vector<float>> m_deltas;
+	std::vector<float> m_gradient;
+	float m_loss = 0.0f;
+};
+
+
+BackpropTrainer::BackpropTrainer(Network& network, const Config& config) :
+	m_config(config),
+	m_network(network)
+{
+	_ASSERT(config.m_batchSize > 0);
+
+	const int numLevels = network.GetNumLevels();
+	m_levelSizes.resize(numLevels);
+	m_levelParameterStart.resize(numLevels, 0);
+	m_activations.resize(numLevels);
+	int numParameters = 0;
+	for (int l = 0; l < numLevels; l++)
+	{
+		const NetworkLevel& level = network.GetLevel(l);
+		m_levelSizes[l] = static_cast<int>(level.neurons.size());
+		if (l == 0)
+		{
+			continue;
+		}
+
+		m_levelParameterStart[l] = numParameters;
+		for (const Neuron& neuron : level.neurons)
+		{
+			// Every level must be fully connected to the one before it
+			_ASSERT(neuron.weights.size() == m_levelSizes[l - 1]);
+			m_activations[l].push_back(neuron.m_activationFunction);
+		}
+		numParameters += m_levelSizes[l] * (m_levelSizes[l - 1] + 1);
+	}
+	_ASSERT(numParameters == network.GetNumParameters());
+
+	m_parameters.resize(numParameters);
+	network.GetParameters(m_parameters.data());
+
+	if (config.m_optimizer == GradientOptimizer::Adam)
+	{
+		AdamOptimizer::Config adamConfig;
+		adamConfig.m_learningRate = config.m_learningRate;
+		m_adam = new AdamOptimizer(numParameters, adamConfig);
+	}
+	else
+	{
+		SgdOptimizer::Config sgdConfig;
+		sgdConfig.m_learningRate = config.m_learningRate;
+		sgdConfig.m_momentum = config.m_momentum;
+		m_sgd = new SgdOptimizer(numParameters, sgdConfig);
+	}
+
+	const int numThreads = (config.m_numThreads > 0) ?
+		config.m_numThreads :
+		Math::Max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	for (int i = 0; i < numThreads; i++)
+	{
+		Workspace* workspace = new Workspace();
+		workspace->m_outputs.resize(numLevels);
+		workspace->m_deltas.resize(numLevels);
+		workspace->m_gradient.resize(numParameters);
+		m_workspaces.push_back(workspace);
+	}
+}
+
+BackpropTrainer::~BackpropTrainer()
+{
+	if (m_adam != nullptr)
+	{
+		delete m_adam;
+	}
+	if (m_sgd != nullptr)
+	{
+		delete m_sgd;
+	}
+	for (Workspace* workspace : m_workspaces)
+	{
+		delete workspace;
+	}
+	m_workspaces.clear();
+}
+
+float BackpropTrainer::TrainEpoch(const TrainingSet& data, Random& rand)
+{
+	const int numSamples = data.GetNumSamples();
+	if (numSamples == 0)
+	{
+		return 0.0f;
+	}
+
+	m_sampleOrder.resize(numSamples);
+	for (int i = 0; i < numSamples; i++)
+	{
+		m_sampleOrder[i] = i;
+	}
+	for (int i = 0; i < numSamples - 1; i++)
+	{
+		std::swap(m_sampleOrder[i], m_sampleOrder[rand.NextInt(i, numSamples)]);
+	}
+
+	double totalLoss = 0.0;
+	for (int start = 0; start < numSamples; start += m_config.m_batchSize)
+	{
+		const int batchSize = Math::Min(m_config.m_batchSize, numSamples - start);
+		totalLoss += static_cast<double>(TrainBatch(data, &m_sampleOrder[start], batchSize)) * batchSize;
+	}
+	return static_cast<float>(totalLoss / numSamples);
+}
+
+float BackpropTrainer::TrainBatch(const TrainingSet& data, const int* sampleIndices, const int numSamples)
+{
+	if (numSamples <= 0)
+	{
+		return 0.0f;
+	}
+
+	const float loss = RunShards(data, sampleIndices, numSamples, true) / numSamples;
+
+	std::vector<float>& gradient = m_workspaces[0]->m_gradient;
+	if (m_config.m_weightDecay != 0.0f)
+	{
+		Axpy(gradient.data(), m_config.m_weightDecay, m_parameters.data(), static_cast<int>(gradient.size()));
+	}
+	if (m_adam != nullptr)
+	{
+		m_adam->Step(m_parameters.data(), gradient.data());
+	}
+	else
+	{
+		m_sgd->Step(m_parameters.data(), gradient.data());
+	}
+	m_network.SetParameters(m_parameters.data());
+	m_numSteps++;
+
+	return loss;
+}
+
+float BackpropTrainer::ComputeLoss(const TrainingSet& data)
+{
+	const int numSamples = data.GetNumSamples();
+	if (numSamples == 0)
+	{
+		return 0.0f;
+	}
+
+	m_sampleOrder.resize(numSamples);
+	for (int i = 0; i < numSamples; i++)
+	{
+		m_sampleOrder[i] = i;
+	}
+
+	// Batches keep the activations small enough to stay in cache
+	double totalLoss = 0.0;
+	const int chunkSize = m_config.m_batchSize * GetNumThreads();
+	for (int start = 0; start < numSamples; start += chunkSize)
+	{
+		totalLoss += RunShards(data, &m_sampleOrder[start], Math::Min(chunkSize, numSamples - start), false);
+	}
+	return static_cast<float>(totalLoss / numSamples);
+}
+
+float BackpropTrainer::ComputeGradient(const TrainingSet& data, const int* sampleIndices, const int numSamples, std::vector<float>& outGradient)
+{
+	if (numSamples <= 0)
+	{
+		outGradient.assign(m_parameters.size(), 0.0f);
+		return 0.0f;
+	}
+	const float loss = RunShards(data, sampleIndices, numSamples, true) / numSamples;
+	outGradient = m_workspaces[0]->m_gradient;
+	return loss;
+}
+
+float BackpropTrainer::RunShards(const TrainingSet& data, const int* sampleIndices, const int numSamples, const bool computeGradient)
+{
+	_ASSERT(data.GetNumInputs() == m_levelSizes.front());
+	_ASSERT(data.GetNumOutputs() == m_levelSizes.back());
+
+	const int maxShards = Math::Max(1, numSamples / Math::Max(1, m_config.m_minSamplesPerThread));
+	const int numShards = Math::Min(GetNumThreads(), maxShards);
+	const float lossScale = 1.0f / numSamples;
+
+	// Shards are as even as possible, and the first few take the remainder
+	std::vector<int> shardStart(numShards + 1, 0);
+	for (int shard = 0; shard < numShards; shard++)
+	{
+		const int shardSize = (numSamples / numShards) + ((shard < (numSamples % numShards)) ? 1 : 0);
+		shardStart[shard + 1] = shardStart[shard] + shardSize;
+	}
+
+	std::vector<std::thread> threads;
+	for (int shard = 1; shard < numShards; shard++)
+	{
+		threads.emplace_back(&BackpropTrainer::RunShard, this, std::ref(*m_workspaces[shard]), std::cref(data),
+			sampleIndices + shardStart[shard], shardStart[shard + 1] - shardStart[shard], lossScale, computeGradient);
+	}
+	// This thread does the first shard
+	RunShard(*m_workspaces[0], data, sampleIndices, shardStart[1], lossScale, computeGradient);
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	float totalLoss = m_workspaces[0]->m_loss;
+	for (int shard = 1; shard < numShards; shard++)
+	{
+		totalLoss += m_workspaces[shard]->m_loss;
+		if (computeGradient)
+		{
+			std::vector<float>& gradient = m_workspaces[0]->m_gradient;
+			Axpy(gradient.data(), 1.0f, m_workspaces[shard]->m_gradient.data(), static_cast<int>(gradient.size()));
+		}
+	}
+	return totalLoss;
+}
+
+void BackpropTrainer::RunShard(Workspace& workspace, const TrainingSet& data, const int* sampleIndices, const int numSamples, const float lossScale, const bool computeGradient) const
+{
+	Forward(workspace, data, sampleIndices, numSamples);
+
+	// Loss is half the squared error
+	const int numOutputs = m_levelSizes.back();
+	const std::vector<float>& outputs = workspace.m_outputs.back();
+	double loss = 0.0;
+	for (int s = 0; s < numSamples; s++)
+	{
+		const float* targets = data.GetTargets(sampleIndices[s]);
+		for (int i = 0; i < numOutputs; i++)
+		{
+			const float error = outputs[(s * numOutputs) + i] - targets[i];
+			loss += 0.5 * error * error;
+		}
+	}
+	workspace.m_loss = static_cast<float>(loss);
+
+	if (computeGradient)
+	{
+		Backward(workspace, data, sampleIndices, numSamples, lossScale);
+	}
+}
+
+void BackpropTrainer::Forward(Workspace& workspace, const TrainingSet& data, const int* sampleIndices, const int numSamples) const
+{
+	const int numLevels = static_cast<int>(m_levelSizes.size());
+	std::vector<const float*> inputRows(numSamples);
+	for (int s = 0; s < numSamples; s++)
+	{
+		inputRows[s] = data.GetInputs(sampleIndices[s]);
+	}
+
+	for (int l = 1; l < numLevels; l++)
+	{
+		const int numInputs = m_levelSizes[l - 1];
+		const int numNeurons = m_levelSizes[l];
+		const int rowSize = numInputs + 1;
+		const float* parameters = &m_parameters[m_levelParameterStart[l]];
+		const std::vector<ActivationFunction>& activations = m_activations[l];
+		std::vector<float>& outputs = workspace.m_outputs[l];
+		outputs.resize(numSamples * numNeurons);
+
+		// Four samples at a time, so each row of weights is read once for all of them
+		int s = 0;
+		for (; s + 4 <= numSamples; s += 4)
+		{
+			const float* rows[4] = { inputRows[s], inputRows[s + 1], inputRows[s + 2], inputRows[s + 3] };
+			for (int n = 0; n < numNeurons; n++)
+			{
+				const float* weights = parameters + (n * rowSize);
+				float sums[4];
+				Dot4(weights, rows, numInputs, sums);
+				for (int k = 0; k < 4; k++)
+				{
+					outputs[((s + k) * numNeurons) + n] = sums[k] + weights[numInputs];
+				}
+			}
+		}
+		for (; s < numSamples; s++)
+		{
+			for (int n = 0; n < numNeurons; n++)
+			{
+				const float* weights = parameters + (n * rowSize);
+				outputs[(s * numNeurons) + n] = Dot(weights, inputRows[s], numInputs) + weights[numInputs];
+			}
+		}
+
+		for (s = 0; s < numSamples; s++)
+		{
+			float* row = &outputs[s * numNeurons];
+			for (int n = 0; n < numNeurons; n++)
+			{
+				row[n] = Activate(activations[n], row[n]);
+			}
+			// This level's outputs are the next level's inputs
+			inputRows[s] = row;
+		}
+	}
+}
+
+void BackpropTrainer::Backward(Workspace& workspace, const TrainingSet& data, const int* sampleIndices, const int numSamples, const float lossScale) const
+{
+	const int numLevels = static_cast<int>(m_levelSizes.size());
+	std::fill(workspace.m_gradient.begin(), workspace.m_gradient.end(), 0.0f);
+
+	// Gradient of the average loss with respect to the outputs
+	const int numOutputs = m_levelSizes.back();
+	const std::vector<float>& outputs = workspace.m_outputs.back();
+	std::vector<float>& outputDeltas = workspace.m_deltas.back();
+	outputDeltas.resize(numSamples * numOutputs);
+	for (int s = 0; s < numSamples; s++)
+	{
+		const float* targets = data.GetTargets(sampleIndices[s]);
+		for (int i = 0; i < numOutputs; i++)
+		{
+			const int index = (s * numOutputs) + i;
+			outputDeltas[index] = (outputs[index] - targets[i]) * lossScale;
+		}
+	}
+
+	for (int l = numLevels - 1; l >= 1; l--)
+	{
+		const int numInputs = m_levelSizes[l - 1];
+		const int numNeurons = m_levelSizes[l];
+		const int rowSize = numInputs + 1;
+		const std::vector<ActivationFunction>& activations = m_activations[l];
+		const std::vector<float>& levelOutputs = workspace.m_outputs[l];
+		std::vector<float>& deltas = workspace.m_deltas[l];
+
+		// Through the activation function, from the outputs to the weighted sums
+		for (int s = 0; s < numSamples; s++)
+		{
+			for (int n = 0; n < numNeurons; n++)
+			{
+				const int index = (s * numNeurons) + n;
+				deltas[index] *= ActivationDx(activations[n], levelOutputs[index]);
+			}
+		}
+
+		// Each neuron's row of the gradient gets its delta times the inputs
+		float* gradient = &workspace.m_gradient[m_levelParameterStart[l]];
+		for (int s = 0; s < numSamples; s++)
+		{
+			const float* inputs = (l > 1) ? &workspace.m_outputs[l - 1][s * numInputs] : data.GetInputs(sampleIndices[s]);
+			const float* sampleDeltas = &deltas[s * numNeurons];
+			for (int n = 0; n < numNeurons; n++)
+			{
+				float* row = gradient + (n * rowSize);
+				Axpy(row, sampleDeltas[n], inputs, numInputs);
+				row[numInputs] += sampleDeltas[n];
+			}
+		}
+
+		// The inputs of the first level are data, so there's nothing more to do
+		if (l == 1)
+		{
+			break;
+		}
+
+		// Each input's delta is the sum of the neurons' deltas times their weights
+		const float* parameters = &m_parameters[m_levelParameterStart[l]];
+		std::vector<float>& inputDeltas = workspace.m_deltas[l - 1];
+		inputDeltas.assign(numSamples * numInputs, 0.0f);
+		for (int s = 0; s < numSamples; s++)
+		{
+			float* sampleInputDeltas = &inputDeltas[s * numInputs];
+			const float* sampleDeltas = &deltas[s * numNeurons];
+			for (int n = 0; n < numNeurons; n++)
+			{
+				Axpy(sampleInputDeltas, sampleDeltas[n], parameters + (n * rowSize), numInputs);
+			}
+		}
+	}
+}
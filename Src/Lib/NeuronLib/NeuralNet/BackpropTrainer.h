@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Network.h"
+#include <vector>
+
+class AdamOptimizer;
+class Random;
+class SgdOptimizer;
+
+enum class GradientOptimizer
+{
+	Sgd,
+	Adam,
+};
+
+// Inputs and target outputs for supervised training
+// Samples are stored one after another, so the inputs of a sample are contiguous, as are its targets.
+class TrainingSet
+{
+public:
+	TrainingSet(const int numInputs, const int numOutputs) :
+		m_numInputs(numInputs),
+		m_numOutputs(numOutputs)
+	{
+	}
+
+	void AddSample(const float* inputs, const float* targets)
+	{
+		m_inputs.insert(m_inputs.end(), inputs, inputs + m_numInputs);
+		m_targets.insert(m_targets.end(), targets, targets + m_numOutputs);
+	}
+	void Clear()
+	{
+		m_inputs.clear();
+		m_targets.clear();
+	}
+	void Reserve(const int numSamples)
+	{
+		m_inputs.reserve(static_cast<size_t>(numSamples) * m_numInputs);
+		m_targets.reserve(static_cast<size_t>(numSamples) * m_numOutputs);
+	}
+
+	int GetNumInputs() const { return m_numInputs; }
+	int GetNumOutputs() const { return m_numOutputs; }
+	int GetNumSamples() const { return (m_numInputs > 0) ? static_cast<int>(m_inputs.size()) / m_numInputs : 0; }
+	const float* GetInputs(const int sampleIndex) const { return &m_inputs[sampleIndex * m_numInputs]; }
+	const float* GetTargets(const int sampleIndex) const { return &m_targets[sampleIndex * m_numOutputs]; }
+
+private:
+	int m_numInputs = 0;
+	int m_numOutputs = 0;
+	std::vector<float> m_inputs;
+	std::vector<float> m_targets;
+};
+
+// Trains a network's weights and biases with backpropagation
+//
+// The loss is half the squared error between the network's outputs and the targets, averaged over
+// the samples in a mini-batch. The topology isn't changed, and every activation function the
+// network can use (Identity, TanH, and Sigmoid) is supported.
+//
+// The parameters are kept in the same flat array as Network::GetParameters. Each level is a matrix
+// with one row per neuron, holding its weights followed by its bias, so the forward and backward
+// passes run straight over contiguous rows. The forward pass works on four samples at a time so
+// each row of weights is loaded once for all four.
+//
+// A mini-batch is split into shards that are run on separate threads, each with its own
+// activations and gradient. The gradients are added together before the optimizer takes a step,
+// so the result doesn't depend on the number of threads (other than rounding).
+class BackpropTrainer
+{
+public:
+	class Config
+	{
+	public:
+		GradientOptimizer m_optimizer = GradientOptimizer::Adam;
+		float m_learningRate = 0.001f;
+		// Only used by Sgd
+		float m_momentum = 0.9f;
+		// Pulls parameters towards zero to keep them from growing without bound
+		float m_weightDecay = 0.0f;
+		int m_batchSize = 64;
+
+		// Threads used for each mini-batch. 0 uses one per hardware thread.
+		int m_numThreads = 0;
+		// Shards smaller than this aren't worth starting a thread for
+		int m_minSamplesPerThread = 32;
+	};
+
+	// Trains 'network' in place. Its topology must not change while the trainer exists.
+	BackpropTrainer(Network& network, const Config& config);
+	~BackpropTrainer();
+
+	// One pass over all the samples in a random order, one step per mini-batch.
+	// Returns the average loss over the epoch, measured before each step.
+	float TrainEpoch(const TrainingSet& data, Random& rand);
+	// One step using the given samples. Returns the loss before the step.
+	float TrainBatch(const TrainingSet& data, const int* sampleIndices, const int numSamples);
+
+	// Average loss over every sample, without training
+	float ComputeLoss(const TrainingSet& data);
+	// Gradient of the average loss over the given samples, in Network::GetParameters order.
+	// Returns the loss.
+	float ComputeGradient(const TrainingSet& data, const int* sampleIndices, const int numSamples, std::vector<float>& outGradient);
+
+	int GetNumThreads() const { return static_cast<int>(m_workspaces.size()); }
+	int GetNumSteps() const { return m_numSteps; }
+
+private:
+	class Workspace;
+
+	// Runs the samples on as many threads as are worth using. If 'computeGradient' is set, the
+	// total gradient ends up in the first workspace. Returns the total loss (not the average).
+	float RunShards(const TrainingSet& data, const int* sampleIndices, const int numSamples, const bool computeGradient);
+	// Forward pass, and backward pass if 'computeGradient' is set, for one shard
+	void RunShard(Workspace& workspace, const TrainingSet& data, const int* sampleIndices, const int numSamples, const float lossScale, const bool computeGradient) const;
+	void Forward(Workspace& workspace, const TrainingSet& data, const int* sampleIndices, const int numSamples) const;
+	void Backward(Workspace& workspace, const TrainingSet& data, const int* sampleIndices, const int numSamples, const float lossScale) const;
+
+private:
+	const Config m_config;
+	Network& m_network;
+	std::vector<float> m_parameters;
+	AdamOptimizer* m_adam = nullptr;
+	SgdOptimizer* m_sgd = nullptr;
+
+	// Number of neurons in each level, including the input level
+	std::vector<int> m_levelSizes;
+	// Index of each level's first parameter. The input level has none.
+	std::vector<int> m_levelParameterStart;
+	// Activation function of every neuron, by level
+	std::vector<std::vector<ActivationFunction>> m_activations;
+
+	std::vector<Workspace*> m_workspaces;
+	std::vector<int> m_sampleOrder;
+	int m_numSteps = 0;
+};
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "Network.h"
 
+#include "Util/Hash.h"
 #include "Util/Math.h"
 #include "Util/Random.h"
 
@@ -40,9 +41,9 @@ void Neuron::Deserialize(BinaryBuffer& stream)
 
 void Neuron::RandomizeWeights(Random& rand)
 {
-	for (auto& weight : weights)
+	if (!weights.empty())
 	{
-		weight = rand.NextGaussian();
+		rand.FillGaussian(weights.data(), static_cast<int>(weights.size()));
 	}
 
 	// Reset the activation function in case it was Identity
@@ -115,9 +116,28 @@ void NetworkLevel::MakeIdentity()
 
 void NetworkLevel::Randomize(Random& rand)
 {
+	// Generate the weights and biases for the whole level in one go. Bulk generation is much
+	// faster than asking for one value at a time.
+	size_t numValues = 0;
+	for (const auto& neuron : neurons)
+	{
+		numValues += neuron.weights.size() + 1;
+	}
+	if (numValues == 0)
+	{
+		return;
+	}
+
+	std::vector<float> values(numValues);
+	rand.FillGaussian(values.data(), static_cast<int>(numValues));
+
+	const float* nextValue = values.data();
 	for (auto& neuron : neurons)
 	{
-		neuron.RandomizeAll(rand);
+		std::copy(nextValue, nextValue + neuron.weights.size(), neuron.weights.begin());
+		nextValue += neuron.weights.size();
+		neuron.bias = *nextValue++;
+		neuron.m_activationFunction = ActivationFunction::Default;
 	}
 }
 
@@ -152,6 +172,67 @@ void Network::Deserialize(BinaryBuffer& stream)
 	DeserializeSimpleObject(stream, m_mutationSettings);
 }
 
+uint64_t Network::GetHash() const
+{
+	uint64_t hash = Hash::Fnv1aSimpleObject(m_numInputs);
+	for (const auto& level : m_levels)
+	{
+		const int numNeurons = static_cast<int>(level.neurons.size());
+		hash = Hash::Fnv1aSimpleObject(numNeurons, hash);
+		for (const auto& neuron : level.neurons)
+		{
+			const int numWeights = static_cast<int>(neuron.weights.size());
+			hash = Hash::Fnv1aSimpleObject(numWeights, hash);
+			if (numWeights > 0)
+			{
+				hash = Hash::Fnv1a(neuron.weights.data(), neuron.weights.size() * sizeof(float), hash);
+			}
+			hash = Hash::Fnv1aSimpleObject(neuron.bias, hash);
+			hash = Hash::Fnv1aSimpleObject(neuron.m_activationFunction, hash);
+		}
+	}
+	return hash;
+}
+
+int Network::GetNumParameters() const
+{
+	int numParameters = 0;
+	for (int levelIndex = 1; levelIndex < m_levels.size(); levelIndex++)
+	{
+		for (const Neuron& neuron : m_levels[levelIndex].neurons)
+		{
+			numParameters += static_cast<int>(neuron.weights.size()) + 1;
+		}
+	}
+	return numParameters;
+}
+
+void Network::GetParameters(float* outParameters) const
+{
+	float* nextParameter = outParameters;
+	for (int levelIndex = 1; levelIndex < m_levels.size(); levelIndex++)
+	{
+		for (const Neuron& neuron : m_levels[levelIndex].neurons)
+		{
+			nextParameter = std::copy(neuron.weights.begin(), neuron.weights.end(), nextParameter);
+			*nextParameter++ = neuron.bias;
+		}
+	}
+}
+
+void Network::SetParameters(const float* parameters)
+{
+	const float* nextParameter = parameters;
+	for (int levelIndex = 1; levelIndex < m_levels.size(); levelIndex++)
+	{
+		for (Neuron& neuron : m_levels[levelIndex].neurons)
+		{
+			std::copy(nextParameter, nextParameter + neuron.weights.size(), neuron.weights.begin());
+			nextParameter += neuron.weights.size();
+			neuron.bias = *nextParameter++;
+		}
+	}
+}
 
 void Network::InitializeFromParents(Random& rand, const Network* parent0, const Network* parent1)
 {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include "Util/Serializable.h"
 #include <vector>
 
@@ -197,6 +198,19 @@ public:
 	virtual void Deserialize(BinaryBuffer& stream) override;
 
 	int GetNumLevels() const { return static_cast<int>(m_levels.size()); }
+	const NetworkLevel& GetLevel(const int levelIndex) const { return m_levels[levelIndex]; }
+
+	// Learnable parameters (weights and biases) flattened into a single array.
+	// Ordered by level, then neuron, with each neuron's bias after its weights. The input level
+	// has no parameters since its values come directly from the inputs.
+	int GetNumParameters() const;
+	void GetParameters(float* outParameters) const;
+	void SetParameters(const float* parameters);
+
+	// Returns a hash of everything that affects the output of Evaluate (topology, weights, biases,
+	// and activation functions). Networks that behave identically will have the same hash.
+	// Note: Mutation settings are intentionally not included
+	uint64_t GetHash() const;
 
 	// Primarily used for validating unit tests
 	bool operator == (const Network& rhs) const
@@ -210,10 +224,10 @@ public:
 	std::vector<float> Evaluate(const std::vector<float>& inputs) const
 	{
 		// assert inputs.size() == numInputs
-		// Static vectors are a nice optimization for single-threaded, but won't work multi-threaded
-		// TODO: Make these thread local if this optimization is needed for multi-threading
-		static std::vector<float> scratch1;
-		static std::vector<float> scratch2;
+		// Reusing the same vectors avoids allocations. They're thread local so multiple threads can
+		// evaluate networks at the same time.
+		thread_local std::vector<float> scratch1;
+		thread_local std::vector<float> scratch2;
 		std::vector<float>* l1 = &scratch1;
 		std::vector<float>* l2 = &scratch2;
 
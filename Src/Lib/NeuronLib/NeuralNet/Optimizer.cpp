@@ -0,0 +1,69 @@
+#include "pch.h"
+#include "Optimizer.h"
+
+#include <algorithm>
+#include "Util/Math.h"
+
+AdamOptimizer::AdamOptimizer(const int numParameters, const Config& config) :
+	m_config(config)
+{
+	m_firstMoment.resize(numParameters, 0.0f);
+	m_secondMoment.resize(numParameters, 0.0f);
+}
+
+void AdamOptimizer::Step(float* parameters, const float* gradient)
+{
+	m_numSteps++;
+
+	// The averages start at zero, so they're biased low for the first few steps. Scaling the step
+	// size corrects for it.
+	const double correction1 = 1.0 - pow(static_cast<double>(m_config.m_beta1), m_numSteps);
+	const double correction2 = 1.0 - pow(static_cast<double>(m_config.m_beta2), m_numSteps);
+	const float stepSize = static_cast<float>(m_config.m_learningRate * Math::Sqrt(correction2) / correction1);
+
+	const float beta1 = m_config.m_beta1;
+	const float beta2 = m_config.m_beta2;
+	const int numParameters = GetNumParameters();
+	for (int i = 0; i < numParameters; i++)
+	{
+		const float g = gradient[i];
+		m_firstMoment[i] = (beta1 * m_firstMoment[i]) + ((1.0f - beta1) * g);
+		m_secondMoment[i] = (beta2 * m_secondMoment[i]) + ((1.0f - beta2) * g * g);
+		parameters[i] -= stepSize * m_firstMoment[i] / (Math::Sqrt(m_secondMoment[i]) + m_config.m_epsilon);
+	}
+}
+
+void AdamOptimizer::Reset()
+{
+	std::fill(m_firstMoment.begin(), m_firstMoment.end(), 0.0f);
+	std::fill(m_secondMoment.begin(), m_secondMoment.end(), 0.0f);
+	m_numSteps = 0;
+}
+
+//=============================================================================
+
+SgdOptimizer::SgdOptimizer(const int numParameters, const Config& config) :
+	m_config(config)
+{
+	m_velocity.resize(numParameters, 0.0f);
+}
+
+void SgdOptimizer::Step(float* parameters, const float* gradient)
+{
+	m_numSteps++;
+
+	const float learningRate = m_config.m_learningRate;
+	const float momentum = m_config.m_momentum;
+	const int numParameters = GetNumParameters();
+	for (int i = 0; i < numParameters; i++)
+	{
+		m_velocity[i] = (momentum * m_velocity[i]) - (learningRate * gradient[i]);
+		parameters[i] += m_velocity[i];
+	}
+}
+
+void SgdOptimizer::Reset()
+{
+	std::fill(m_velocity.begin(), m_velocity.end(), 0.0f);
+	m_numSteps = 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+
+// Adam optimizer
+// Reference: Kingma & Ba, "Adam: A Method for Stochastic Optimization" (2014)
+//
+// Keeps running averages of the gradient and the squared gradient for every parameter, so each
+// parameter gets its own step size. Works with any flat array of parameters, such as the ones
+// from Network::GetParameters.
+class AdamOptimizer
+{
+public:
+	class Config
+	{
+	public:
+		float m_learningRate = 0.001f;
+		// Decay rates of the running averages of the gradient and squared gradient
+		float m_beta1 = 0.9f;
+		float m_beta2 = 0.999f;
+		// Keeps the step size finite when the squared gradient is close to zero
+		float m_epsilon = 1e-8f;
+	};
+
+	AdamOptimizer(const int numParameters, const Config& config);
+
+	// Moves the parameters one step against the gradient, so it minimizes.
+	// To maximize, pass in the negated gradient.
+	void Step(float* parameters, const float* gradient);
+
+	// Forgets all history, as if no steps had been taken
+	void Reset();
+
+	int GetNumParameters() const { return static_cast<int>(m_firstMoment.size()); }
+	int GetNumSteps() const { return m_numSteps; }
+	float GetLearningRate() const { return m_config.m_learningRate; }
+	void SetLearningRate(const float learningRate) { m_config.m_learningRate = learningRate; }
+
+private:
+	Config m_config;
+	std::vector<float> m_firstMoment;
+	std::vector<float> m_secondMoment;
+	int m_numSteps = 0;
+};
+
+// Stochastic gradient descent with momentum
+//
+// Every step adds the gradient to a running velocity, and the velocity is what moves the
+// parameters. Momentum smooths out the noise from small batches. Set it to 0 for plain SGD.
+class SgdOptimizer
+{
+public:
+	class Config
+	{
+	public:
+		float m_learningRate = 0.01f;
+		float m_momentum = 0.9f;
+	};
+
+	SgdOptimizer(const int numParameters, const Config& config);
+
+	// Moves the parameters one step against the gradient, so it minimizes
+	void Step(float* parameters, const float* gradient);
+
+	// Forgets all history, as if no steps had been taken
+	void Reset();
+
+	int GetNumParameters() const { return static_cast<int>(m_velocity.size()); }
+	int GetNumSteps() const { return m_numSteps; }
+	float GetLearningRate() const { return m_config.m_learningRate; }
+	void SetLearningRate(const float learningRate) { m_config.m_learningRate = learningRate; }
+
+private:
+	Config m_config;
+	std::vector<float> m_velocity;
+	int m_numSteps = 0;
+};
@@ -0,0 +1,715 @@
+#include "pch.h"
+#include "BatchedNeuronGame.h"
+
+#include "GameStateForNeuralNetInput.h"
+#include "NeuronPlayerInput.h"
+#include "Util/Broadphase.h"
+#include "Util/Math.h"
+#include "Util/Simd.h"
+
+using Simd::Float4;
+using Simd::Mask4;
+
+namespace
+{
+	constexpr int k_numLanes = Float4::k_numLanes;
+
+	// Vector2, with one vector from each of four games. Operations are done in the same order as
+	// Vector2, so results match it exactly.
+	class Vector2x4
+	{
+	public:
+		Vector2x4() = default;
+		Vector2x4(const Float4 _x, const Float4 _y) : x(_x), y(_y) {}
+
+		Vector2x4 operator+(const Vector2x4& rhs) const { return Vector2x4(x + rhs.x, y + rhs.y); }
+		Vector2x4 operator-(const Vector2x4& rhs) const { return Vector2x4(x - rhs.x, y - rhs.y); }
+		Vector2x4 operator-() const { return Vector2x4(-x, -y); }
+		Vector2x4 operator*(const Vector2x4& rhs) const { return Vector2x4(x * rhs.x, y * rhs.y); }
+		Vector2x4 operator*(const Float4 scale) const { return Vector2x4(x * scale, y * scale); }
+
+		Float4 Dot(const Vector2x4& other) const { return (x * other.x) + (y * other.y); }
+		Float4 GetLengthSquared() const { return Dot(*this); }
+		// Same as Vector2::RotateAroundOrigin, given the sine and cosine of the angle
+		Vector2x4 Rotate(const Float4 sin, const Float4 cos) const { return Vector2x4((x * cos) - (y * sin), (y * cos) + (x * sin)); }
+		// Rotates by minus the angle. Same as Shape::RotateToLocal.
+		Vector2x4 RotateInverse(const Float4 sin, const Float4 cos) const { return Vector2x4((x * cos) + (y * sin), (y * cos) - (x * sin)); }
+
+		static Vector2x4 Select(const Mask4 mask, const Vector2x4& a, const Vector2x4& b)
+		{
+			return Vector2x4(Simd::Select(mask, a.x, b.x), Simd::Select(mask, a.y, b.y));
+		}
+
+	public:
+		Float4 x;
+		Float4 y;
+	};
+
+	// Position, velocity and facing of one object in each of four games
+	class Body4
+	{
+	public:
+		Vector2x4 m_pos;
+		Vector2x4 m_vel;
+		Float4 m_facing;
+		// Sine and cosine of m_facing. Only kept for players, and updated whenever m_facing is.
+		Float4 m_sin;
+		Float4 m_cos;
+	};
+
+	// Lanes are done one at a time with the same functions NeuronGame uses, so results match exactly
+	void SinCos(const Float4 radians, Float4& outSin, Float4& outCos)
+	{
+		float r[k_numLanes];
+		float s[k_numLanes];
+		float c[k_numLanes];
+		radians.Store(r);
+		for (int i = 0; i < k_numLanes; i++)
+		{
+			Math::SinCos(r[i], s[i], c[i]);
+		}
+		outSin = Float4::Load(s);
+		outCos = Float4::Load(c);
+	}
+
+	Float4 Remainder(const Float4 f, const float divisor)
+	{
+		float lanes[k_numLanes];
+		f.Store(lanes);
+		for (float& lane : lanes)
+		{
+			lane = remainderf(lane, divisor);
+		}
+		return Float4::Load(lanes);
+	}
+
+	Float4 Load(const std::vector<float>& values, const int first)
+	{
+		return Float4::Load(&values[first]);
+	}
+
+	// Writes 'value' to the games in 'mask', and leaves the rest as they were
+	void Store(std::vector<float>& values, const int first, const Float4 value, const Mask4 mask)
+	{
+		Simd::Select(mask, value, Float4::Load(&values[first])).Store(&values[first]);
+	}
+
+	// See NeuronGame::ApplyInputToPlayer
+	void ApplyInputToPlayer(Body4& player, const Float4 steering, const Float4 speed, const Float4 boost)
+	{
+		// Determine target speed
+		const Float4 clampedThrottle = Simd::Select(Simd::Abs(speed) <= k_throttleDeadZone, 0.0f, Simd::Clamp(speed, -1.0f, 1.0f));
+		const Float4 targetSpeed = Simd::Select(boost >= 0.5f,
+			k_maxBoostedSpeed,
+			clampedThrottle * Simd::Select(clampedThrottle >= 0.0f, k_maxForwardSpeed, k_maxReverseSpeed));
+		const Vector2x4 oldForward(player.m_cos, player.m_sin);
+		const Vector2x4 targetVelocity = oldForward * targetSpeed;
+		const Vector2x4 desiredDeltaVelocity = targetVelocity - player.m_vel;
+		const Float4 desiredDeltaVelocitySquared = desiredDeltaVelocity.GetLengthSquared();
+		constexpr float k_maxAccelerationPerTick = k_maxAcceleration * k_timePerTick;
+		constexpr float k_maxAccelerationPerTickSquared = k_maxAccelerationPerTick * k_maxAccelerationPerTick;
+		// Both are computed, and each game keeps the one it would have taken
+		const Vector2x4 directionOfAcceleration = desiredDeltaVelocity * (Float4(1.0f) / Simd::Sqrt(desiredDeltaVelocitySquared));
+		player.m_vel = Vector2x4::Select(desiredDeltaVelocitySquared <= k_maxAccelerationPerTickSquared,
+			targetVelocity,
+			player.m_vel + directionOfAcceleration * k_maxAccelerationPerTickSquared);
+
+		player.m_pos = player.m_pos + player.m_vel * k_timePerTick;
+
+		const Mask4 isMovingForward = oldForward.Dot(player.m_vel) >= 0.0f;
+
+		// Turn rate is limited by last update's velocity
+		const Float4 clampedSteering = Simd::Select(Simd::Abs(steering) <= k_turningDeadZone, 0.0f, Simd::Clamp(steering, -1.0f, 1.0f));
+		const Float4 currentSpeed = Simd::Sqrt(player.m_vel.GetLengthSquared());
+		const Float4 speedPercentOfMax = currentSpeed / k_maxForwardSpeed;
+		const Float4 turnThrottleScalar = Simd::Clamp(Float4(1.0f) - ((Float4(1.0f) - speedPercentOfMax) * (Float4(1.0f) - speedPercentOfMax)), 0.0f, 1.0f);
+		const Float4 deltaAngle = clampedSteering * k_maxTurnRadiansPerSecond * k_timePerTick * turnThrottleScalar * Simd::Select(isMovingForward, 1.0f, -1.0f);
+		// Always keep facing in the range of [0..2pi]
+		player.m_facing = Remainder(player.m_facing + deltaAngle, k_2pi);
+		// Facing doesn't change again this tick
+		SinCos(player.m_facing, player.m_sin, player.m_cos);
+	}
+
+	// See NeuronBall::CollideWithField
+	void CollideBallWithField(Body4& ball, const FieldCollisionStyle style)
+	{
+		constexpr float k_radius = NeuronBall::GetRadius();
+		const Float4 x = Simd::Clamp(ball.m_pos.x, k_radius, k_fieldLength - k_radius);
+		const Float4 y = Simd::Clamp(ball.m_pos.y, k_radius, k_fieldWidth - k_radius);
+		if (style == FieldCollisionStyle::PushAndBounce)
+		{
+			ball.m_vel.x = Simd::Select(x != ball.m_pos.x, -ball.m_vel.x, ball.m_vel.x);
+			ball.m_vel.y = Simd::Select(y != ball.m_pos.y, -ball.m_vel.y, ball.m_vel.y);
+		}
+		ball.m_pos = Vector2x4(x, y);
+	}
+
+	// See NeuronPlayer::CollideWithField
+	void CollidePlayerWithField(Body4& player)
+	{
+		const Vector2x4 halfForward = Vector2x4(player.m_cos, player.m_sin) * 0.5f;
+		const Vector2x4 halfRight(halfForward.y, -halfForward.x);
+		const Vector2x4 halfLengthVector = halfForward * NeuronPlayer::GetPlayerLength();
+		const Vector2x4 halfWidthVector = halfRight * NeuronPlayer::GetPlayerWidth();
+		const Vector2x4 corners[] =
+		{
+			player.m_pos + halfLengthVector + halfWidthVector,
+			player.m_pos + halfLengthVector - halfWidthVector,
+			player.m_pos - halfLengthVector - halfWidthVector,
+			player.m_pos - halfLengthVector + halfWidthVector,
+		};
+		Vector2x4 minCorner = corners[0];
+		Vector2x4 maxCorner = corners[0];
+		for (int i = 1; i < 4; i++)
+		{
+			minCorner = Vector2x4(Simd::Min(minCorner.x, corners[i].x), Simd::Min(minCorner.y, corners[i].y));
+			maxCorner = Vector2x4(Simd::Max(maxCorner.x, corners[i].x), Simd::Max(maxCorner.y, corners[i].y));
+		}
+
+		// A player is too small to be over both sides at once, so at most one of each pair is non-zero
+		const Vector2x4 pushDistance(
+			Simd::Max(0.0f, -minCorner.x) + Simd::Min(0.0f, Float4(k_fieldLength) - maxCorner.x),
+			Simd::Max(0.0f, -minCorner.y) + Simd::Min(0.0f, Float4(k_fieldWidth) - maxCorner.y));
+		player.m_pos = player.m_pos + pushDistance;
+	}
+
+	// Broadphase::CanCollide for each of four games
+	Mask4 CanCollide(const Body4& a, const float boundingRadiusA, const Body4& b, const float boundingRadiusB)
+	{
+		const float reach = boundingRadiusA + boundingRadiusB + Broadphase::k_slack;
+		return (b.m_pos - a.m_pos).GetLengthSquared() <= Math::Sqr(reach);
+	}
+
+	// Broadphase::CanLeaveBounds for each of four games
+	Mask4 CanLeaveField(const Body4& body, const float boundingRadius)
+	{
+		const float reach = boundingRadius + Broadphase::k_slack;
+		return
+			(body.m_pos.x < reach) |
+			(body.m_pos.y < reach) |
+			(body.m_pos.x > k_fieldLength - reach) |
+			(body.m_pos.y > k_fieldWidth - reach);
+	}
+
+	// See CollisionResponse::ApplyResponse. 's1' is moved out of 's0'.
+	void ApplyResponse(Body4& s0, Body4& s1, const float m0, const float m1, const Vector2x4& penetration, const Vector2x4& normal, const Mask4 collided)
+	{
+		// 1. Resolve penetration
+		s1.m_pos = Vector2x4::Select(collided, s1.m_pos + penetration, s1.m_pos);
+
+		// Only resolve collision if relative velocities are pointed at each other
+		const Mask4 isApproaching = collided & (normal.Dot(s1.m_vel - s0.m_vel) < 0.0f);
+		const Vector2x4 v0 = s0.m_vel;
+		const Vector2x4 v1 = s1.m_vel;
+		const Vector2x4 x0 = s0.m_pos;
+		const Vector2x4 x1 = s1.m_pos;
+		const Vector2x4 v0out = v0 -
+			(x0 - x1) *
+			((2 * m1) / (m0 + m1)) *
+			((v0 - v1).Dot(x0 - x1) / (x0 - x1).GetLengthSquared());
+		const Vector2x4 v1out = v1 -
+			(x1 - x0) *
+			((2 * m0) / (m0 + m1)) *
+			((v1 - v0).Dot(x1 - x0) / (x1 - x0).GetLengthSquared());
+		s0.m_vel = Vector2x4::Select(isApproaching, v0out, v0);
+		s1.m_vel = Vector2x4::Select(isApproaching, v1out, v1);
+	}
+
+	// See Circle::Collide(const Rectangle&). Every case is computed, and each game keeps the one it
+	// would have taken.
+	void CollideBallWithPlayer(Body4& ball, Body4& player, const float ballMass, const float playerMass)
+	{
+		constexpr float k_radius = NeuronBall::GetRadius();
+		constexpr float k_halfLength = NeuronPlayer::GetPlayerHalfLength();
+		constexpr float k_halfWidth = NeuronPlayer::GetPlayerHalfWidth();
+
+		// Transform circle into rectangle's space
+		const Vector2x4 relCirclePos = (ball.m_pos - player.m_pos).RotateInverse(player.m_sin, player.m_cos);
+		const Vector2x4 absPos(Simd::Abs(relCirclePos.x), Simd::Abs(relCirclePos.y));
+
+		// Top of the box
+		const Mask4 isTop = absPos.x < k_halfLength;
+		const Vector2x4 topPenetration(0.0f, -Simd::Max(Float4(k_halfWidth) - (absPos.y - k_radius), 0.0f));
+		const Vector2x4 topNormal(0.0f, -1.0f);
+
+		// Side of the box
+		const Mask4 isSide = absPos.y < k_halfWidth;
+		const Vector2x4 sidePenetration(-Simd::Max(Float4(k_halfLength) - (absPos.x - k_radius), 0.0f), 0.0f);
+		const Vector2x4 sideNormal(-1.0f, 0.0f);
+
+		// Corner point
+		const Vector2x4 toCorner = Vector2x4(k_halfLength, k_halfWidth) - absPos;
+		const Float4 toCornerSquared = toCorner.GetLengthSquared();
+		const Mask4 hasDirection = toCornerSquared > Math::FloatSmallNumber;
+		const Float4 distance = Simd::Select(hasDirection, Simd::Sqrt(toCornerSquared), 0.0f);
+		const Vector2x4 cornerNormal = Vector2x4::Select(hasDirection, toCorner * (Float4(1.0f) / distance), Vector2x4(0.0f, 0.0f));
+		const Float4 depth = Float4(k_radius) - distance;
+		const Vector2x4 cornerPenetration = Vector2x4::Select(depth > 0.0f, cornerNormal * depth, Vector2x4(0.0f, 0.0f));
+
+		const Vector2x4 absPenetration = Vector2x4::Select(isTop, topPenetration, Vector2x4::Select(isSide, sidePenetration, cornerPenetration));
+		const Vector2x4 absNormal = Vector2x4::Select(isTop, topNormal, Vector2x4::Select(isSide, sideNormal, cornerNormal));
+		const Mask4 collided = (absPenetration.x != 0.0f) | (absPenetration.y != 0.0f);
+
+		// Transform results into correct quadrant, then back into world space
+		const Vector2x4 signCorrection(Simd::Sign(relCirclePos.x), Simd::Sign(relCirclePos.y));
+		const Vector2x4 penetration = (absPenetration * signCorrection).Rotate(player.m_sin, player.m_cos);
+		const Vector2x4 normal = (absNormal * signCorrection).Rotate(player.m_sin, player.m_cos);
+		ApplyResponse(ball, player, ballMass, playerMass, penetration, normal, collided);
+	}
+
+	// One pass of Rectangle::Collide(const Rectangle&), with r1 transformed into r0's space.
+	void OverlapPlayers(const Body4& r0, const Body4& r1, Mask4& outOverlaps, Vector2x4& outPenetration, Vector2x4& outNormal)
+	{
+		constexpr float k_halfLength = NeuronPlayer::GetPlayerHalfLength();
+		constexpr float k_halfWidth = NeuronPlayer::GetPlayerHalfWidth();
+
+		const Vector2x4 relPos = (r1.m_pos - r0.m_pos).RotateInverse(r0.m_sin, r0.m_cos);
+		const Vector2x4 relForward = Vector2x4(r1.m_cos, r1.m_sin).RotateInverse(r0.m_sin, r0.m_cos);
+		const Vector2x4 relRight(relForward.y, -relForward.x);
+		const Vector2x4 relHalfLength = relForward * k_halfLength;
+		const Vector2x4 relHalfWidth = relRight * k_halfWidth;
+		const Vector2x4 relPoints[] =
+		{
+			relPos + relHalfLength + relHalfWidth,
+			relPos + relHalfLength - relHalfWidth,
+			relPos - relHalfLength - relHalfWidth,
+			relPos - relHalfLength + relHalfWidth,
+		};
+		Vector2x4 minPoint = relPoints[0];
+		Vector2x4 maxPoint = relPoints[0];
+		for (int i = 1; i < 4; i++)
+		{
+			minPoint = Vector2x4(Simd::Min(minPoint.x, relPoints[i].x), Simd::Min(minPoint.y, relPoints[i].y));
+			maxPoint = Vector2x4(Simd::Max(maxPoint.x, relPoints[i].x), Simd::Max(maxPoint.y, relPoints[i].y));
+		}
+
+		const Mask4 overlapsX = !((minPoint.x >= k_halfLength) | (maxPoint.x <= -k_halfLength));
+		const Mask4 overlapsY = !((minPoint.y >= k_halfWidth) | (maxPoint.y <= -k_halfWidth));
+		outOverlaps = overlapsX & overlapsY;
+
+		// Choose the direction with the smaller penetration depth on each axis, then the smaller axis
+		const Float4 pMinX = Float4(k_halfLength) - minPoint.x;
+		const Float4 pMaxX = Float4(-k_halfLength) - maxPoint.x;
+		const Mask4 useMinX = Simd::Abs(pMinX) <= Simd::Abs(pMaxX);
+		const Float4 penetrationX = Simd::Select(useMinX, pMinX, pMaxX);
+		const Float4 pMinY = Float4(k_halfWidth) - minPoint.y;
+		const Float4 pMaxY = Float4(-k_halfWidth) - maxPoint.y;
+		const Mask4 useMinY = Simd::Abs(pMinY) <= Simd::Abs(pMaxY);
+		const Float4 penetrationY = Simd::Select(useMinY, pMinY, pMaxY);
+
+		const Mask4 useY = (penetrationY * penetrationY) < (penetrationX * penetrationX);
+		outPenetration = Vector2x4::Select(useY, Vector2x4(0.0f, penetrationY), Vector2x4(penetrationX, 0.0f));
+		outNormal = Vector2x4::Select(useY,
+			Vector2x4(0.0f, Simd::Select(useMinY, 1.0f, -1.0f)),
+			Vector2x4(Simd::Select(useMinX, 1.0f, -1.0f), 0.0f));
+	}
+
+	// See Rectangle::Collide(const Rectangle&). NeuronGame collides player 1 with player 0, so the
+	// first pass is in player 1's space.
+	void CollidePlayers(Body4& p0, Body4& p1, const float playerMass)
+	{
+		Mask4 overlaps0;
+		Vector2x4 penetration0;
+		Vector2x4 normal0;
+		OverlapPlayers(p1, p0, overlaps0, penetration0, normal0);
+		Mask4 overlaps1;
+		Vector2x4 penetration1;
+		Vector2x4 normal1;
+		OverlapPlayers(p0, p1, overlaps1, penetration1, normal1);
+
+		// Compare collision responses and use the one with shorter penetration. In the first, player 1
+		// is shape0 and player 0 is moved. In the second, it's the other way around.
+		const Mask4 isPlayer0Moved = penetration0.GetLengthSquared() <= penetration1.GetLengthSquared();
+		const Vector2x4 penetration = Vector2x4::Select(isPlayer0Moved,
+			penetration0.Rotate(p1.m_sin, p1.m_cos),
+			penetration1.Rotate(p0.m_sin, p0.m_cos));
+		const Vector2x4 normal = Vector2x4::Select(isPlayer0Moved,
+			normal0.Rotate(p1.m_sin, p1.m_cos),
+			normal1.Rotate(p0.m_sin, p0.m_cos));
+
+		Body4 s0;
+		Body4 s1;
+		s0.m_pos = Vector2x4::Select(isPlayer0Moved, p1.m_pos, p0.m_pos);
+		s0.m_vel = Vector2x4::Select(isPlayer0Moved, p1.m_vel, p0.m_vel);
+		s1.m_pos = Vector2x4::Select(isPlayer0Moved, p0.m_pos, p1.m_pos);
+		s1.m_vel = Vector2x4::Select(isPlayer0Moved, p0.m_vel, p1.m_vel);
+		ApplyResponse(s0, s1, playerMass, playerMass, penetration, normal, overlaps0 & overlaps1);
+		p0.m_pos = Vector2x4::Select(isPlayer0Moved, s1.m_pos, s0.m_pos);
+		p0.m_vel = Vector2x4::Select(isPlayer0Moved, s1.m_vel, s0.m_vel);
+		p1.m_pos = Vector2x4::Select(isPlayer0Moved, s0.m_pos, s1.m_pos);
+		p1.m_vel = Vector2x4::Select(isPlayer0Moved, s0.m_vel, s1.m_vel);
+	}
+}
+
+
+void BatchedNeuronGame::BodyArrays::Resize(const int numLanes)
+{
+	m_posX.resize(numLanes);
+	m_posY.resize(numLanes);
+	m_velX.resize(numLanes);
+	m_velY.resize(numLanes);
+	m_facing.resize(numLanes);
+	m_sin.resize(numLanes);
+	m_cos.resize(numLanes);
+}
+
+void BatchedNeuronGame::InputArrays::Resize(const int numLanes)
+{
+	m_steering.resize(numLanes);
+	m_speed.resize(numLanes);
+	m_boost.resize(numLanes);
+}
+
+
+BatchedNeuronGame::BatchedNeuronGame(const int numGames) :
+	m_numGames(numGames),
+	m_numLanes(((numGames + k_numLanes - 1) / k_numLanes) * k_numLanes)
+{
+	_ASSERT(numGames > 0);
+	for (int playerIndex = 0; playerIndex < k_numPlayers; playerIndex++)
+	{
+		m_players[playerIndex].Resize(m_numLanes);
+		m_inputs[playerIndex].Resize(m_numLanes);
+		m_scores[playerIndex].resize(m_numLanes);
+	}
+	m_ball.Resize(m_numLanes);
+	m_gameDuration.resize(m_numLanes);
+	m_timeRemaining.resize(m_numLanes);
+
+	// Padding games have no time, so they're never updated
+	for (int i = 0; i < m_numLanes; i++)
+	{
+		ResetGame(i, 0.0f);
+	}
+}
+
+void BatchedNeuronGame::ResetGames(const float gameDuration)
+{
+	for (int i = 0; i < m_numGames; i++)
+	{
+		ResetGame(i, gameDuration);
+	}
+}
+
+void BatchedNeuronGame::ResetGame(const int gameIndex, const float gameDuration)
+{
+	ResetField(gameIndex);
+	for (int playerIndex = 0; playerIndex < k_numPlayers; playerIndex++)
+	{
+		m_scores[playerIndex][gameIndex] = 0.0f;
+		SetPlayerInput(gameIndex, playerIndex, NeuronPlayerInput());
+	}
+	m_gameDuration[gameIndex] = gameDuration;
+	m_timeRemaining[gameIndex] = gameDuration;
+}
+
+void BatchedNeuronGame::SetPlayerInput(const int gameIndex, const int playerIndex, const NeuronPlayerInput& input)
+{
+	InputArrays& inputs = m_inputs[playerIndex];
+	inputs.m_steering[gameIndex] = input.m_steering;
+	inputs.m_speed[gameIndex] = input.m_speed;
+	inputs.m_boost[gameIndex] = input.m_boost;
+}
+
+NeuronGameSnapshot BatchedNeuronGame::Snapshot(const int gameIndex) const
+{
+	const auto saveBody = [gameIndex](const BodyArrays& arrays, NeuronGameSnapshot::Body& outBody)
+	{
+		outBody.m_posX = arrays.m_posX[gameIndex];
+		outBody.m_posY = arrays.m_posY[gameIndex];
+		outBody.m_velX = arrays.m_velX[gameIndex];
+		outBody.m_velY = arrays.m_velY[gameIndex];
+	};
+
+	NeuronGameSnapshot snapshot;
+	for (int playerIndex = 0; playerIndex < k_numPlayers; playerIndex++)
+	{
+		NeuronGameSnapshot::Player& outPlayer = snapshot.m_players[playerIndex];
+		saveBody(m_players[playerIndex], outPlayer.m_body);
+		outPlayer.m_facing = m_players[playerIndex].m_facing[gameIndex];
+		outPlayer.m_boost = 0.0f;
+		snapshot.m_scores[playerIndex] = static_cast<uint8_t>(m_scores[playerIndex][gameIndex]);
+	}
+	saveBody(m_ball, snapshot.m_ball);
+	snapshot.m_gameDuration = m_gameDuration[gameIndex];
+	snapshot.m_timeRemaining = m_timeRemaining[gameIndex];
+	snapshot.m_stallSeconds = 0.0f;
+	snapshot.m_secondsSinceBallTouched = 0.0f;
+	snapshot.m_earlyEndReason = static_cast<uint8_t>(GameEndReason::None);
+	return snapshot;
+}
+
+void BatchedNeuronGame::Restore(const int gameIndex, const NeuronGameSnapshot& snapshot)
+{
+	const auto loadBody = [gameIndex](const NeuronGameSnapshot::Body& body, BodyArrays& outArrays)
+	{
+		outArrays.m_posX[gameIndex] = body.m_posX;
+		outArrays.m_posY[gameIndex] = body.m_posY;
+		outArrays.m_velX[gameIndex] = body.m_velX;
+		outArrays.m_velY[gameIndex] = body.m_velY;
+	};
+
+	for (int playerIndex = 0; playerIndex < k_numPlayers; playerIndex++)
+	{
+		BodyArrays& player = m_players[playerIndex];
+		const NeuronGameSnapshot::Player& savedPlayer = snapshot.m_players[playerIndex];
+		loadBody(savedPlayer.m_body, player);
+		player.m_facing[gameIndex] = savedPlayer.m_facing;
+		player.m_sin[gameIndex] = Math::Sin(savedPlayer.m_facing);
+		player.m_cos[gameIndex] = Math::Cos(savedPlayer.m_facing);
+		m_scores[playerIndex][gameIndex] = static_cast<float>(snapshot.m_scores[playerIndex]);
+	}
+	loadBody(snapshot.m_ball, m_ball);
+	m_gameDuration[gameIndex] = snapshot.m_gameDuration;
+	m_timeRemaining[gameIndex] = snapshot.m_timeRemaining;
+}
+
+void BatchedNeuronGame::Update()
+{
+	for (int firstGame = 0; firstGame < m_numLanes; firstGame += k_numLanes)
+	{
+		UpdateLanes(firstGame);
+	}
+}
+
+GameState BatchedNeuronGame::GetGameState(const int gameIndex) const
+{
+	if (IsGameOver(gameIndex))
+	{
+		return GameState::GameOver;
+	}
+	if (m_timeRemaining[gameIndex] == m_gameDuration[gameIndex])
+	{
+		return GameState::PreGame;
+	}
+	return GameState::InGame;
+}
+
+bool BatchedNeuronGame::IsGameOver(const int gameIndex) const
+{
+	return
+		(m_scores[0][gameIndex] >= k_scoreToWin) ||
+		(m_scores[1][gameIndex] >= k_scoreToWin) ||
+		(m_timeRemaining[gameIndex] <= 0.0f);
+}
+
+int BatchedNeuronGame::GetNumGamesRunning() const
+{
+	int numRunning = 0;
+	for (int i = 0; i < m_numGames; i++)
+	{
+		numRunning += IsGameOver(i) ? 0 : 1;
+	}
+	return numRunning;
+}
+
+Vector2 BatchedNeuronGame::GetPlayerPos(const int gameIndex, const int playerIndex) const
+{
+	const BodyArrays& player = m_players[playerIndex];
+	return Vector2(player.m_posX[gameIndex], player.m_posY[gameIndex]);
+}
+
+Vector2 BatchedNeuronGame::GetPlayerVelocity(const int gameIndex, const int playerIndex) const
+{
+	const BodyArrays& player = m_players[playerIndex];
+	return Vector2(player.m_velX[gameIndex], player.m_velY[gameIndex]);
+}
+
+float BatchedNeuronGame::GetPlayerFacing(const int gameIndex, const int playerIndex) const
+{
+	return m_players[playerIndex].m_facing[gameIndex];
+}
+
+Vector2 BatchedNeuronGame::GetBallPos(const int gameIndex) const
+{
+	return Vector2(m_ball.m_posX[gameIndex], m_ball.m_posY[gameIndex]);
+}
+
+Vector2 BatchedNeuronGame::GetBallVelocity(const int gameIndex) const
+{
+	return Vector2(m_ball.m_velX[gameIndex], m_ball.m_velY[gameIndex]);
+}
+
+int BatchedNeuronGame::GetPlayerScore(const int gameIndex, const int playerIndex) const
+{
+	return static_cast<int>(m_scores[playerIndex][gameIndex]);
+}
+
+float BatchedNeuronGame::GetTimeRemaining(const int gameIndex) const
+{
+	return m_timeRemaining[gameIndex];
+}
+
+void BatchedNeuronGame::GetObservation(const int gameIndex, const int playerIndex, float* outState) const
+{
+	// Same order and mirroring as GameStateForNeuralNetInput::SampleGameState
+	const bool isMirrored = (playerIndex != 0);
+	const Vector2 fieldSize(k_fieldLength, k_fieldWidth);
+	int nextInput = 0;
+	const auto writePosition = [&](const Vector2 pos)
+	{
+		const Vector2 relativePos = isMirrored ? (fieldSize - pos) : pos;
+		outState[nextInput++] = relativePos.x;
+		outState[nextInput++] = relativePos.y;
+	};
+	const auto writeVector = [&](const Vector2 vector)
+	{
+		const Vector2 relativeVector = isMirrored ? -vector : vector;
+		outState[nextInput++] = relativeVector.x;
+		outState[nextInput++] = relativeVector.y;
+	};
+
+	_ASSERT(k_numPlayers == 2);
+	const int dataOrder[k_numPlayers] = { playerIndex, 1 - playerIndex };
+	for (const int index : dataOrder)
+	{
+		const BodyArrays& player = m_players[index];
+		writePosition(GetPlayerPos(gameIndex, index));
+		writeVector(GetPlayerVelocity(gameIndex, index));
+		writeVector(Vector2(player.m_cos[gameIndex], player.m_sin[gameIndex]));
+		// Players don't have boost yet. See NeuronPlayer::m_boost.
+		outState[nextInput++] = 0.0f;
+	}
+	writePosition(GetBallPos(gameIndex));
+	writeVector(GetBallVelocity(gameIndex));
+	for (const int index : dataOrder)
+	{
+		outState[nextInput++] = m_scores[index][gameIndex];
+	}
+	outState[nextInput++] = m_timeRemaining[gameIndex];
+	_ASSERT(nextInput == GameStateForNeuralNetInput::k_numGameStateInputs);
+}
+
+void BatchedNeuronGame::ResetField(const int gameIndex)
+{
+	// Same as NeuronGame::ResetField
+	const Vector2 startPos[k_numPlayers] =
+	{
+		Vector2(k_fieldLength * 0.1f, k_fieldWidth * (0.5f - k_playerWidthOffsetPercent)),
+		Vector2(k_fieldLength * 0.9f, k_fieldWidth * (0.5f + k_playerWidthOffsetPercent)),
+	};
+	const float startFacing[k_numPlayers] = { DegToRad(0.0f), DegToRad(180.0f) };
+	for (int playerIndex = 0; playerIndex < k_numPlayers; playerIndex++)
+	{
+		BodyArrays& player = m_players[playerIndex];
+		player.m_posX[gameIndex] = startPos[playerIndex].x;
+		player.m_posY[gameIndex] = startPos[playerIndex].y;
+		player.m_velX[gameIndex] = 0.0f;
+		player.m_velY[gameIndex] = 0.0f;
+		player.m_facing[gameIndex] = startFacing[playerIndex];
+		player.m_sin[gameIndex] = Math::Sin(startFacing[playerIndex]);
+		player.m_cos[gameIndex] = Math::Cos(startFacing[playerIndex]);
+	}
+
+	m_ball.m_posX[gameIndex] = k_fieldLength * 0.5f;
+	m_ball.m_posY[gameIndex] = k_fieldWidth * 0.5f;
+	m_ball.m_velX[gameIndex] = 0.0f;
+	m_ball.m_velY[gameIndex] = 0.0f;
+}
+
+void BatchedNeuronGame::UpdateLanes(const int firstGame)
+{
+	// Games that are over are computed along with the rest, but their results are never stored
+	const Float4 timeRemaining = Load(m_timeRemaining, firstGame);
+	const Float4 score0 = Load(m_scores[0], firstGame);
+	const Float4 score1 = Load(m_scores[1], firstGame);
+	const Mask4 isRunning = (score0 < static_cast<float>(k_scoreToWin)) & (score1 < static_cast<float>(k_scoreToWin)) & (timeRemaining > 0.0f);
+	if (!isRunning.Any())
+	{
+		return;
+	}
+
+	const auto loadBody = [firstGame](const BodyArrays& arrays)
+	{
+		Body4 body;
+		body.m_pos = Vector2x4(Load(arrays.m_posX, firstGame), Load(arrays.m_posY, firstGame));
+		body.m_vel = Vector2x4(Load(arrays.m_velX, firstGame), Load(arrays.m_velY, firstGame));
+		body.m_facing = Load(arrays.m_facing, firstGame);
+		body.m_sin = Load(arrays.m_sin, firstGame);
+		body.m_cos = Load(arrays.m_cos, firstGame);
+		return body;
+	};
+	const auto storeBody = [firstGame](BodyArrays& arrays, const Body4& body, const Mask4 mask)
+	{
+		Store(arrays.m_posX, firstGame, body.m_pos.x, mask);
+		Store(arrays.m_posY, firstGame, body.m_pos.y, mask);
+		Store(arrays.m_velX, firstGame, body.m_vel.x, mask);
+		Store(arrays.m_velY, firstGame, body.m_vel.y, mask);
+		Store(arrays.m_facing, firstGame, body.m_facing, mask);
+		Store(arrays.m_sin, firstGame, body.m_sin, mask);
+		Store(arrays.m_cos, firstGame, body.m_cos, mask);
+	};
+
+	Body4 players[k_numPlayers];
+	for (int playerIndex = 0; playerIndex < k_numPlayers; playerIndex++)
+	{
+		Body4& player = players[playerIndex];
+		const InputArrays& inputs = m_inputs[playerIndex];
+		player = loadBody(m_players[playerIndex]);
+		ApplyInputToPlayer(player,
+			Load(inputs.m_steering, firstGame),
+			Load(inputs.m_speed, firstGame),
+			Load(inputs.m_boost, firstGame));
+	}
+
+	// See NeuronGame::UpdateBall
+	Body4 ball = loadBody(m_ball);
+	ball.m_pos = ball.m_pos + ball.m_vel * k_timePerTick;
+	ball.m_vel = ball.m_vel * (1.0f - (NeuronBall::GetRollingFriction() * k_timePerTick));
+	CollideBallWithField(ball, FieldCollisionStyle::PushAndBounce);
+
+	// See NeuronGame::ProcessCollisions. Masses match Circle and Rectangle::ComputeMassAndInertia
+	// with a density of 1.
+	const float ballMass = 1.0f * k_pi * Math::Sqr(NeuronBall::GetRadius());
+	const float playerMass = 1.0f * NeuronPlayer::GetPlayerHalfLength() * NeuronPlayer::GetPlayerHalfWidth() * 4.0f;
+	// Lanes can't skip work on their own, so each test is only skipped when the broadphase rules it
+	// out in all four games
+	const float playerRadius = NeuronPlayer::GetPlayerRadius();
+	constexpr float k_ballRadius = NeuronBall::GetRadius();
+	for (Body4& player : players)
+	{
+		if (CanLeaveField(player, playerRadius).Any())
+		{
+			CollidePlayerWithField(player);
+		}
+	}
+	for (Body4& player : players)
+	{
+		if (CanCollide(ball, k_ballRadius, player, playerRadius).Any())
+		{
+			CollideBallWithPlayer(ball, player, ballMass, playerMass);
+		}
+	}
+	CollideBallWithField(ball, FieldCollisionStyle::PushOnly);
+	if (CanCollide(players[0], playerRadius, players[1], playerRadius).Any())
+	{
+		CollidePlayers(players[0], players[1], playerMass);
+	}
+
+	// See NeuronGame::CheckForGoal
+	const float k_epsilon = Math::FloatSmallNumber;
+	constexpr float k_radius = NeuronBall::GetRadius();
+	constexpr float k_goalWidth = k_fieldWidth * 0.25f;
+	const Mask4 isInGoalMouth = (ball.m_pos.y >= ((k_fieldWidth - k_goalWidth) * 0.5f)) & (ball.m_pos.y <= ((k_fieldWidth + k_goalWidth) * 0.5f));
+	const Mask4 isGoalFor1 = isRunning & isInGoalMouth & (ball.m_pos.x <= (k_radius + k_epsilon));
+	const Mask4 isGoalFor0 = isRunning & isInGoalMouth & (ball.m_pos.x >= (k_fieldLength - (k_radius + k_epsilon)));
+	const Mask4 isGoal = isGoalFor0 | isGoalFor1;
+	Store(m_scores[0], firstGame, score0 + 1.0f, isGoalFor0);
+	Store(m_scores[1], firstGame, score1 + 1.0f, isGoalFor1);
+	Store(m_timeRemaining, firstGame, Simd::Max(timeRemaining - k_timePerTick, 0.0f), isRunning);
+
+	const Mask4 isMoved = isRunning & !isGoal;
+	for (int playerIndex = 0; playerIndex < k_numPlayers; playerIndex++)
+	{
+		storeBody(m_players[playerIndex], players[playerIndex], isMoved);
+	}
+	storeBody(m_ball, ball, isMoved);
+	const int goalBits = isGoal.GetBits();
+	for (int lane = 0; lane < k_numLanes; lane++)
+	{
+		if ((goalBits & (1 << lane)) != 0)
+		{
+			ResetField(firstGame + lane);
+		}
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "NeuronBall/NeuronGame.h"
+#include "Util/Array.h"
+#include "Util/Vector.h"
+#include <vector>
+
+class NeuronPlayerInput;
+
+// Runs many NeuronGames at once, with the same rules and physics
+//
+// Instead of an object per game, the state of every game is stored in arrays with one entry per
+// game (eg. every game's ball x-position is next to each other). Each step of an update then runs
+// on four games at a time with SIMD instructions. Every operation is done in the same order as
+// NeuronGame, so each game's results match a NeuronGame given the same inputs.
+//
+// Differences from NeuronGame...
+// - There are no controllers. Inputs are set with SetPlayerInput and kept until they're changed.
+// - Both players' inputs are set before the update, so player 1 doesn't see where player 0 has
+//   moved to on the same tick.
+// - Collisions only compute what the response uses, so there's no collision point.
+// - There are no EarlyEndRules. Games always play to k_scoreToWin or until time runs out.
+class BatchedNeuronGame
+{
+public:
+	explicit BatchedNeuronGame(const int numGames);
+
+	int GetNumGames() const { return m_numGames; }
+
+	// Resets every game, and clears their inputs
+	void ResetGames(const float gameDuration);
+	// Resets one game, and clears its inputs
+	void ResetGame(const int gameIndex, const float gameDuration);
+
+	void SetPlayerInput(const int gameIndex, const int playerIndex, const NeuronPlayerInput& input);
+
+	// Same as NeuronGame::Snapshot and Restore, for one game. Snapshots can be moved between the two,
+	// eg. to play many variations of a NeuronGame from the same point.
+	// Inputs are left as they are. Players have no boost here, and there are no EarlyEndRules, so
+	// those parts of the snapshot are saved as 0 and ignored.
+	NeuronGameSnapshot Snapshot(const int gameIndex) const;
+	void Restore(const int gameIndex, const NeuronGameSnapshot& snapshot);
+
+	// Advances every game that isn't over by one tick
+	void Update();
+	GameState GetGameState(const int gameIndex) const;
+	bool IsGameOver(const int gameIndex) const;
+	int GetNumGamesRunning() const;
+
+	Vector2 GetPlayerPos(const int gameIndex, const int playerIndex) const;
+	Vector2 GetPlayerVelocity(const int gameIndex, const int playerIndex) const;
+	float GetPlayerFacing(const int gameIndex, const int playerIndex) const;
+	Vector2 GetBallPos(const int gameIndex) const;
+	Vector2 GetBallVelocity(const int gameIndex) const;
+	int GetPlayerScore(const int gameIndex, const int playerIndex) const;
+	float GetTimeRemaining(const int gameIndex) const;
+
+	// Writes the game as seen by 'playerIndex', the same as GameStateForNeuralNetInput.
+	// 'outState' must have room for GameStateForNeuralNetInput::k_numGameStateInputs values.
+	void GetObservation(const int gameIndex, const int playerIndex, float* outState) const;
+
+private:
+	// Position, velocity and facing of one object in every game
+	class BodyArrays
+	{
+	public:
+		void Resize(const int numLanes);
+
+	public:
+		std::vector<float> m_posX;
+		std::vector<float> m_posY;
+		std::vector<float> m_velX;
+		std::vector<float> m_velY;
+		std::vector<float> m_facing;
+		// Sine and cosine of m_facing, so they're only computed when it changes.
+		// Only kept up to date for players.
+		std::vector<float> m_sin;
+		std::vector<float> m_cos;
+	};
+
+	class InputArrays
+	{
+	public:
+		void Resize(const int numLanes);
+
+	public:
+		std::vector<float> m_steering;
+		std::vector<float> m_speed;
+		std::vector<float> m_boost;
+	};
+
+	// Called after a goal to reset player and ball positions
+	void ResetField(const int gameIndex);
+	// Updates the four games starting at 'firstGame'
+	void UpdateLanes(const int firstGame);
+
+private:
+	const int m_numGames;
+	// Number of games rounded up to a whole number of SIMD lanes. The extra games are always over.
+	const int m_numLanes;
+
+	Array<BodyArrays, k_numPlayers> m_players;
+	Array<InputArrays, k_numPlayers> m_inputs;
+	BodyArrays m_ball;
+	// Stored as floats so they can be updated along with everything else
+	Array<std::vector<float>, k_numPlayers> m_scores;
+	std::vector<float> m_gameDuration;
+	std::vector<float> m_timeRemaining;
+};
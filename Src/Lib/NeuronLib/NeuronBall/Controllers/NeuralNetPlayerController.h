@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include "NeuronBall/NeuronPlayerController.h"
 #include "Util/Serializable.h"
 
@@ -24,6 +25,11 @@ public:
 	void Breed(Random& rand, const NeuralNetPlayerController* parent0 = nullptr, const NeuralNetPlayerController* parent1 = nullptr);
 	// Rewrites m_neuralNetwork randomly
 	void Randomize(Random& rand);
+	// Replaces m_neuralNetwork with a copy of 'network'
+	void SetNetwork(const Network& network);
+
+	// Returns a hash that uniquely identifies the behavior of this controller
+	uint64_t GetHash() const;
 
 	const Network* DebugGetNetwork() const { return m_neuralNetwork; }
 
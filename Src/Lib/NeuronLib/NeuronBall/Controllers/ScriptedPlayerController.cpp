@@ -0,0 +1,137 @@
+#include "pch.h"
+#include "ScriptedPlayerController.h"
+
+#include "NeuronBall/NeuronBall.h"
+#include "NeuronBall/NeuronGame.h"
+#include "NeuronBall/NeuronPlayer.h"
+#include "NeuronBall/NeuronPlayerInput.h"
+#include "Util/Hash.h"
+#include "Util/Math.h"
+
+//static
+ScriptedPlayerController* ScriptedPlayerController::Create(const ScriptedOpponent opponent)
+{
+	switch (opponent)
+	{
+	case ScriptedOpponent::Idle:
+		return new IdlePlayerController();
+	case ScriptedOpponent::BallChaser:
+		return new BallChaserPlayerController();
+	case ScriptedOpponent::GoalDefender:
+		return new GoalDefenderPlayerController();
+	default:
+		_ASSERT(false);
+		return nullptr;
+	}
+}
+
+//static
+const char* ScriptedPlayerController::GetName(const ScriptedOpponent opponent)
+{
+	switch (opponent)
+	{
+	case ScriptedOpponent::Idle:
+		return "Idle";
+	case ScriptedOpponent::BallChaser:
+		return "BallChaser";
+	case ScriptedOpponent::GoalDefender:
+		return "GoalDefender";
+	default:
+		_ASSERT(false);
+		return "Unknown";
+	}
+}
+
+uint64_t ScriptedPlayerController::GetHash() const
+{
+	// Tagged so it can't be mistaken for the hash of a network's parameters
+	constexpr char k_tag[] = "ScriptedPlayerController";
+	const uint64_t hash = Hash::Fnv1a(k_tag, sizeof(k_tag));
+	return Hash::Fnv1aSimpleObject(m_opponent, hash);
+}
+
+//static
+void ScriptedPlayerController::DriveTowards(NeuronPlayerInput& outPlayerInput, const NeuronPlayer& player, const Vector2 target, const float speed)
+{
+	const Vector2 toTarget = target - player.GetPos();
+	const Vector2 forward = player.GetForward();
+
+	// Signed angle from the player's forward direction to the target. Steering increases the facing
+	// angle, so a positive angle steers toward the target.
+	const float cross = (forward.x * toTarget.y) - (forward.y * toTarget.x);
+	const float angle = Math::ATan2(cross, forward.Dot(toTarget));
+	constexpr float k_steeringPerRadian = 2.0f;
+	outPlayerInput.m_steering = Math::Clamp(angle * k_steeringPerRadian, -1.0f, 1.0f);
+	outPlayerInput.m_speed = speed;
+	outPlayerInput.m_boost = 0.0f;
+}
+
+//static
+Vector2 ScriptedPlayerController::GetOwnGoalCenter(const NeuronGame& game, const int playerIndex)
+{
+	// Player 0 defends the goal at x = 0
+	const float x = (playerIndex == 0) ? 0.0f : game.GetFieldLength();
+	return Vector2(x, game.GetFieldWidth() * 0.5f);
+}
+
+//static
+Vector2 ScriptedPlayerController::GetOpponentGoalCenter(const NeuronGame& game, const int playerIndex)
+{
+	return GetOwnGoalCenter(game, 1 - playerIndex);
+}
+
+
+void IdlePlayerController::GetInputFromGameState(NeuronPlayerInput& outPlayerInput, const NeuronGame& game, const int playerIndex)
+{
+	outPlayerInput.m_steering = 0.0f;
+	outPlayerInput.m_speed = 0.0f;
+	outPlayerInput.m_boost = 0.0f;
+}
+
+
+void BallChaserPlayerController::GetInputFromGameState(NeuronPlayerInput& outPlayerInput, const NeuronGame& game, const int playerIndex)
+{
+	const NeuronPlayer& player = game.GetPlayer(playerIndex);
+	const Vector2 ballPos = game.GetBall().m_shape.GetPos();
+	const Vector2 ballToGoal = (GetOpponentGoalCenter(game, playerIndex) - ballPos).GetSafeNormalized();
+
+	// Only push the ball when it's between the player and the goal, otherwise it gets pushed the
+	// wrong way. Go around to a point behind it first.
+	const bool isBehindBall = (ballPos - player.GetPos()).Dot(ballToGoal) > 0.0f;
+	if (isBehindBall)
+	{
+		DriveTowards(outPlayerInput, player, ballPos, 1.0f);
+		// Boost when lined up for a shot
+		constexpr float k_minAlignmentToBoost = 0.9f;
+		outPlayerInput.m_boost = (player.GetForward().Dot(ballToGoal) >= k_minAlignmentToBoost) ? 1.0f : 0.0f;
+	}
+	else
+	{
+		constexpr float k_approachDistance = 4.0f * NeuronBall::GetRadius();
+		DriveTowards(outPlayerInput, player, ballPos - (ballToGoal * k_approachDistance), 1.0f);
+	}
+}
+
+
+void GoalDefenderPlayerController::GetInputFromGameState(NeuronPlayerInput& outPlayerInput, const NeuronGame& game, const int playerIndex)
+{
+	const NeuronPlayer& player = game.GetPlayer(playerIndex);
+	const Vector2 ballPos = game.GetBall().m_shape.GetPos();
+	const Vector2 ownGoal = GetOwnGoalCenter(game, playerIndex);
+
+	// Clear the ball once it's in the defensive quarter of the field
+	const float dangerDistance = game.GetFieldLength() * 0.25f;
+	const Vector2 goalToBall = ballPos - ownGoal;
+	if (goalToBall.GetLengthSquared() <= Math::Sqr(dangerDistance))
+	{
+		DriveTowards(outPlayerInput, player, ballPos, 1.0f);
+		return;
+	}
+
+	// Otherwise wait on the line between the goal and the ball, slowing down on arrival
+	constexpr float k_guardFraction = 0.2f;
+	const Vector2 guardPos = ownGoal + (goalToBall * k_guardFraction);
+	const float distance = (guardPos - player.GetPos()).GetLength();
+	constexpr float k_slowDownDistance = 10.0f;
+	DriveTowards(outPlayerInput, player, guardPos, Math::Min(distance / k_slowDownDistance, 1.0f));
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include "NeuronBall/NeuronPlayerController.h"
+#include "Util/Vector.h"
+
+class NeuronPlayer;
+
+// Hand written opponents, ordered from weakest to strongest
+enum class ScriptedOpponent
+{
+	// Never moves
+	Idle,
+	// Drives around behind the ball and pushes it toward the opponent's goal
+	BallChaser,
+	// Waits between the ball and its own goal, and only chases the ball when it gets close
+	GoalDefender,
+
+	Count
+};
+
+// Base for controllers that play by a fixed set of rules instead of a network.
+// They're much cheaper to run than a network and never change, so they make a fixed measure of
+// progress and a quick test of whether a new network can play at all.
+class ScriptedPlayerController : public NeuronPlayerController
+{
+public:
+	static ScriptedPlayerController* Create(const ScriptedOpponent opponent);
+	static const char* GetName(const ScriptedOpponent opponent);
+
+	explicit ScriptedPlayerController(const ScriptedOpponent opponent) :
+		m_opponent(opponent)
+	{
+	}
+	virtual ~ScriptedPlayerController() = default;
+
+	ScriptedOpponent GetOpponent() const { return m_opponent; }
+	// Identity used to cache the results of games, the same way as NeuralNetPlayerController::GetHash
+	uint64_t GetHash() const;
+
+protected:
+	// Steers toward 'target', driving forward at 'speed'
+	static void DriveTowards(NeuronPlayerInput& outPlayerInput, const NeuronPlayer& player, const Vector2 target, const float speed);
+	// Center of the goal 'playerIndex' defends
+	static Vector2 GetOwnGoalCenter(const NeuronGame& game, const int playerIndex);
+	// Center of the goal 'playerIndex' scores in
+	static Vector2 GetOpponentGoalCenter(const NeuronGame& game, const int playerIndex);
+
+private:
+	const ScriptedOpponent m_opponent;
+};
+
+class IdlePlayerController : public ScriptedPlayerController
+{
+public:
+	IdlePlayerController() : ScriptedPlayerController(ScriptedOpponent::Idle) {}
+
+	virtual void GetInputFromGameState(NeuronPlayerInput& outPlayerInput, const NeuronGame& game, const int playerIndex) override;
+};
+
+class BallChaserPlayerController : public ScriptedPlayerController
+{
+public:
+	BallChaserPlayerController() : ScriptedPlayerController(ScriptedOpponent::BallChaser) {}
+
+	virtual void GetInputFromGameState(NeuronPlayerInput& outPlayerInput, const NeuronGame& game, const int playerIndex) override;
+};
+
+class GoalDefenderPlayerController : public ScriptedPlayerController
+{
+public:
+	GoalDefenderPlayerController() : ScriptedPlayerController(ScriptedOpponent::GoalDefender) {}
+
+	virtual void GetInputFromGameState(NeuronPlayerInput& outPlayerInput, const NeuronGame& game, const int playerIndex) override;
+};
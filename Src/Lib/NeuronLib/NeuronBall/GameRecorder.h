@@ -0,0 +1,16 @@
+#pragma once
+
+class NeuronPlayerInput;
+
+// Receives what the players see and do on every tick of a NeuronGame (see NeuronGame::SetRecorder).
+// Keeps the game independent of whatever stores the recording.
+class IGameRecorder
+{
+public:
+	virtual ~IGameRecorder() {}
+
+	virtual bool ShouldRecordPlayer(const int playerIndex) const = 0;
+	// 'observation' holds GameStateForNeuralNetInput::k_numGameStateInputs values, from the point of
+	// view of the player that chose 'action'
+	virtual void Record(const float* observation, const NeuronPlayerInput& action) = 0;
+};
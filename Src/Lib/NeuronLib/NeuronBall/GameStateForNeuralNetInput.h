@@ -0,0 +1,141 @@
+#pragma once
+
+#include "NeuronBall/NeuronBall.h"
+#include "NeuronBall/NeuronGame.h"
+#include "Util/Array.h"
+#include <vector>
+
+// The game state as seen by one player, in the form neural networks take as input.
+// Positions and directions are mirrored for player 1, so both players see themselves attacking the
+// same way.
+class GameStateForNeuralNetInput
+{
+public:
+	static constexpr int k_numGameStateInputs = 21;
+
+	GameStateForNeuralNetInput(const NeuronGame& game, const int playerIndex) :
+		m_game(game),
+		m_playerIndex(playerIndex),
+		m_nextInputToWrite(0)
+	{
+		SampleGameState();
+	}
+
+	// The inputs, in the order the network expects them
+	const float* GetState() const { return &m_neuralNetInputs[0]; }
+
+	// TODO: PERF: Get rid of the need for this function!
+	std::vector<float> GetStateAsStdVector() const
+	{
+		std::vector<float> output;
+		output.reserve(m_neuralNetInputs.Count());
+		for (const float f : m_neuralNetInputs)
+		{
+			output.push_back(f);
+		}
+		return output;
+	}
+
+private:
+	Vector2 PosRelativeToPlayer(Vector2 pos)
+	{
+		if (m_playerIndex == 0)
+		{
+			return pos;
+		}
+
+		// Equation...
+		// c = center of the field
+		// p = position to mirror around the center
+		// p' = mirrored position
+		// p' = c - (p - c) = 2c - p
+		// In this case, c is (halfLength, halfWidth), so 2c is (length, width)
+		const Vector2 fieldSize(m_game.GetFieldLength(), m_game.GetFieldWidth());
+		return fieldSize - pos;
+	}
+
+	Vector2 VectorRelativeToPlayer(Vector2 vector)
+	{
+		if (m_playerIndex == 0)
+		{
+			return vector;
+		}
+		// Rotate 180 degrees
+		return -vector;
+	}
+
+	void WriteWorldPosition(const Vector2 pos)
+	{
+		const Vector2 relativePos = PosRelativeToPlayer(pos);
+		m_neuralNetInputs[m_nextInputToWrite++] = relativePos.x;
+		m_neuralNetInputs[m_nextInputToWrite++] = relativePos.y;
+	}
+
+	void WriteRelativeVector(const Vector2 vector)
+	{
+		const Vector2 relativeVector = VectorRelativeToPlayer(vector);
+		m_neuralNetInputs[m_nextInputToWrite++] = relativeVector.x;
+		m_neuralNetInputs[m_nextInputToWrite++] = relativeVector.y;
+	}
+
+	void WriteFloat(const float value)
+	{
+		m_neuralNetInputs[m_nextInputToWrite++] = value;
+	}
+
+	void SampleGameState()
+	{
+		m_nextInputToWrite = 0;
+
+		// TODO: Translate all game state to relate to input playerIndex
+
+		// Input values...
+		// - Player0 (Pos(x,y), Velocity(x,y), Forward(x,y), Boost)
+		// - Player1 (Pos(x,y), Velocity(x,y), Forward(x,y), Boost)
+		// - Ball (Pos(x,y), Velocity(x,y))
+		// Optional
+		// - Scores (mine, theirs)
+		// - Time Remaining (sec)
+
+		// This dirty method of determining the player data order only works with two players
+		_ASSERT(k_numPlayers == 2);
+		Array<int, k_numPlayers> dataOrder;
+		dataOrder[0] = m_playerIndex;
+		dataOrder[1] = 1 - m_playerIndex;
+
+		for (int playerIndex : dataOrder)
+		{
+			const NeuronPlayer& player = m_game.GetPlayer(playerIndex);
+
+			WriteWorldPosition(player.GetPos());
+			WriteRelativeVector(player.GetVelocity());
+			WriteRelativeVector(player.GetForward());
+			WriteFloat(player.GetBoostRemaining());
+		}
+		_ASSERT(m_nextInputToWrite == 14); // There should be 7 state variables per player
+
+		{
+			const NeuronBall& ball = m_game.GetBall();
+
+			WriteWorldPosition(ball.m_shape.GetPos());
+			WriteRelativeVector(ball.m_shape.GetVelocity());
+		}
+		_ASSERT(m_nextInputToWrite == 18); // Ball adds 4 more
+
+		for (int playerIndex : dataOrder)
+		{
+			WriteFloat(static_cast<float>(m_game.GetPlayerScore(playerIndex)));
+		}
+		_ASSERT(m_nextInputToWrite == 20); // Scores add two
+
+		WriteFloat(m_game.GetTimeRemaining());
+		_ASSERT(m_nextInputToWrite == 21); // There are a total of 21 state variables that describe the the game
+		_ASSERT(m_nextInputToWrite == k_numGameStateInputs); // Make sure these match
+	}
+
+private:
+	const NeuronGame& m_game;
+	const int m_playerIndex;
+	int m_nextInputToWrite;
+	Array<float, k_numGameStateInputs> m_neuralNetInputs;
+};
@@ -2,24 +2,14 @@
 #include "NeuronGame.h"
 
 #include <algorithm>
+#include "GameRecorder.h"
+#include "GameStateForNeuralNetInput.h"
 #include "NeuronPlayerController.h"
 #include "NeuronPlayerInput.h"
 #include "Util/Constants.h"
 
 constexpr float k_defaultGameDuration = 60.0f * 1.0f;
-constexpr float k_playerWidthOffsetPercent = 0.04f;
-constexpr int k_scoreToWin = 5;
-
-constexpr float k_maxTurnRadiansPerSecond = DegToRad(270.0f);
-constexpr float k_turningDeadZone = 0.1f;
-constexpr float k_maxForwardSpeed = 30.0f;
-constexpr float k_maxBoostedSpeed = k_maxForwardSpeed * 1.75f;
-constexpr float k_maxReverseSpeed = k_maxForwardSpeed * 0.75f;
-// TODO: Consider separating acceleration into forward, reverse, and braking accelerations
-constexpr float k_maxAcceleration = 100.0f;
-constexpr float k_throttleDeadZone = 0.1f;
-// Run at 60hz
-constexpr float k_timePerTick = 1.0f / 60.0f;
+
 
 NeuronGame::NeuronGame()
 {
@@ -37,6 +27,7 @@ void NeuronGame::ResetGame(const float gameDuration)
 	m_scores.Zero();
 	m_gameDuration = gameDuration;
 	m_timeRemaining = m_gameDuration;
+	m_earlyEndReason = GameEndReason::None;
 	// Set player controllers to null
 	m_playerControllers.Zero();
 }
@@ -57,6 +48,13 @@ void NeuronGame::Update()
 				NeuronPlayerInput playerInput;
 				m_playerControllers[playerIndex]->GetInputFromGameState(playerInput, *this, playerIndex);
 
+				if ((m_recorder != nullptr) && m_recorder->ShouldRecordPlayer(playerIndex))
+				{
+					// Sampled before the input is applied, so it matches what the controller saw
+					const GameStateForNeuralNetInput observation(*this, playerIndex);
+					m_recorder->Record(observation.GetState(), playerInput);
+				}
+
 				// TODO: This will always process and move player[0] first, giving player[1] slightly more information
 				ApplyInputToPlayer(m_players[playerIndex], playerInput);
 			}
@@ -66,9 +64,80 @@ void NeuronGame::Update()
 		ProcessCollisions();
 		CheckForGoal();
 		m_timeRemaining = Math::Max(m_timeRemaining - k_timePerTick, 0.0f);
+		CheckForEarlyEnd();
+
+		if (IsGameOver())
+		{
+			m_gameEndStats.m_numGames[static_cast<int>(GetEndReason())]++;
+			m_gameEndStats.m_secondsPlayed += m_gameDuration - m_timeRemaining;
+			m_gameEndStats.m_secondsSaved += m_timeRemaining;
+		}
 	}
 }
 
+NeuronGameSnapshot NeuronGame::Snapshot() const
+{
+	const auto saveBody = [](const Shape& shape, NeuronGameSnapshot::Body& outBody)
+	{
+		outBody.m_posX = shape.m_pos.x;
+		outBody.m_posY = shape.m_pos.y;
+		outBody.m_velX = shape.m_velocity.x;
+		outBody.m_velY = shape.m_velocity.y;
+	};
+
+	NeuronGameSnapshot snapshot;
+	for (int playerIndex = 0; playerIndex < k_numPlayers; playerIndex++)
+	{
+		const NeuronPlayer& player = m_players[playerIndex];
+		NeuronGameSnapshot::Player& outPlayer = snapshot.m_players[playerIndex];
+		saveBody(player.m_shape, outPlayer.m_body);
+		outPlayer.m_facing = player.GetFacing();
+		outPlayer.m_boost = player.m_boost;
+		_ASSERT((m_scores[playerIndex] >= 0) && (m_scores[playerIndex] <= UINT8_MAX));
+		snapshot.m_scores[playerIndex] = static_cast<uint8_t>(m_scores[playerIndex]);
+	}
+	saveBody(m_ball.m_shape, snapshot.m_ball);
+	snapshot.m_gameDuration = m_gameDuration;
+	snapshot.m_timeRemaining = m_timeRemaining;
+	snapshot.m_stallSeconds = m_stallSeconds;
+	snapshot.m_secondsSinceBallTouched = m_secondsSinceBallTouched;
+	snapshot.m_earlyEndReason = static_cast<uint8_t>(m_earlyEndReason);
+	return snapshot;
+}
+
+void NeuronGame::Restore(const NeuronGameSnapshot& snapshot)
+{
+	const auto loadBody = [](const NeuronGameSnapshot::Body& body, Shape& outShape)
+	{
+		outShape.SetPos(Vector2(body.m_posX, body.m_posY));
+		outShape.SetVelocity(Vector2(body.m_velX, body.m_velY));
+	};
+
+	for (int playerIndex = 0; playerIndex < k_numPlayers; playerIndex++)
+	{
+		NeuronPlayer& player = m_players[playerIndex];
+		const NeuronGameSnapshot::Player& savedPlayer = snapshot.m_players[playerIndex];
+		loadBody(savedPlayer.m_body, player.m_shape);
+		player.SetFacing(savedPlayer.m_facing);
+		player.m_boost = savedPlayer.m_boost;
+		m_scores[playerIndex] = snapshot.m_scores[playerIndex];
+	}
+	loadBody(snapshot.m_ball, m_ball.m_shape);
+	m_gameDuration = snapshot.m_gameDuration;
+	m_timeRemaining = snapshot.m_timeRemaining;
+	m_stallSeconds = snapshot.m_stallSeconds;
+	m_secondsSinceBallTouched = snapshot.m_secondsSinceBallTouched;
+	m_earlyEndReason = static_cast<GameEndReason>(snapshot.m_earlyEndReason);
+}
+
+NeuronGame NeuronGame::Fork() const
+{
+	NeuronGame game;
+	game.SetEarlyEndRules(m_earlyEndRules);
+	game.Restore(Snapshot());
+	return game;
+}
+
 GameState NeuronGame::GetGameState() const
 {
 	if (IsGameOver())
@@ -87,7 +156,25 @@ bool NeuronGame::IsGameOver() const
 	return
 		(m_scores[0] >= k_scoreToWin) ||
 		(m_scores[1] >= k_scoreToWin) ||
-		(m_timeRemaining <= 0.0f);
+		(m_timeRemaining <= 0.0f) ||
+		(m_earlyEndReason != GameEndReason::None);
+}
+
+GameEndReason NeuronGame::GetEndReason() const
+{
+	if ((m_scores[0] >= k_scoreToWin) || (m_scores[1] >= k_scoreToWin))
+	{
+		return GameEndReason::ScoreToWin;
+	}
+	if (m_earlyEndReason != GameEndReason::None)
+	{
+		return m_earlyEndReason;
+	}
+	if (m_timeRemaining <= 0.0f)
+	{
+		return GameEndReason::TimeUp;
+	}
+	return GameEndReason::None;
 }
 
 void NeuronGame::ResetField()
@@ -102,9 +189,14 @@ void NeuronGame::ResetField()
 
 	m_ball.m_shape.SetPos(Vector2(m_fieldLength * 0.5f, m_fieldWidth * 0.5f));
 	m_ball.m_shape.SetVelocity(Vector2::Zero);
+
+	// Every kickoff starts from stopped, so it gets a fresh chance before the stall rules apply
+	m_stallSeconds = 0.0f;
+	m_secondsSinceBallTouched = 0.0f;
 }
 
 // static
+// Note: BatchedNeuronGame runs the same physics on many games at once. Keep the two in step.
 void NeuronGame::ApplyInputToPlayer(NeuronPlayer& outPlayer, const NeuronPlayerInput& input)
 {
 	// Determine target speed
@@ -165,35 +257,60 @@ void NeuronGame::ProcessCollisions()
 	// 5. Check player vs player (move both)
 
 	// TODO: Alternate order players are processed each frame to maintain fairness? Would that matter?
+
+	// Each check is skipped when the shapes' bounding circles show they can't be touching
+
 	// 1. Check player vs field (move player)
+	const Vector2 fieldSize(m_fieldLength, m_fieldWidth);
 	for (int i = 0; i < GetNumPlayers(); i++)
 	{
-		GetPlayer(i).CollideWithField(*this);
+		const bool canLeaveField = Broadphase::CanLeaveBounds(GetPlayer(i).m_shape, fieldSize);
+		m_broadphaseStats.m_playerField.Record(!canLeaveField);
+		if (canLeaveField)
+		{
+			GetPlayer(i).CollideWithField(*this);
+		}
 	}
 
+	// Shapes are used by their real types, so collision tests are called directly, not through Shape
+
 	// 2. Check ball vs player
 	for (int i = 0; i < GetNumPlayers(); i++)
 	{
-		Shape* ballShape = &m_ball.m_shape;
-		Shape* playerShape = GetPlayer(i).m_shape;
-		CollisionResponse response = ballShape->Collide(*playerShape);
-		if (response.m_collided)
+		Circle& ballShape = m_ball.m_shape;
+		Rectangle& playerShape = GetPlayer(i).m_shape;
+		const bool canCollide = Broadphase::CanCollide(ballShape, playerShape);
+		m_broadphaseStats.m_ballPlayer.Record(!canCollide);
+		if (canCollide)
 		{
-			response.ApplyResponse(*ballShape, *playerShape);
+			CollisionResponse response = ballShape.Collide(playerShape);
+			if (response.m_collided)
+			{
+				response.ApplyResponse(ballShape, playerShape);
+				m_isBallTouched = true;
+			}
 		}
 	}
 
 	// 3. Check ball vs field (move ball)
+	// The ball's bounding circle is the ball, so there's nothing cheaper to test first
 	m_ball.CollideWithField(*this, FieldCollisionStyle::PushOnly);
 
 	// 5. Check player vs player (move both)
 	{
-		Shape* p0Shape = GetPlayer(0).m_shape;
-		Shape* p1Shape = GetPlayer(1).m_shape;
-		CollisionResponse response = p0Shape->Collide(*p1Shape);
-		if (response.m_collided)
+		Rectangle& p0Shape = GetPlayer(0).m_shape;
+		Rectangle& p1Shape = GetPlayer(1).m_shape;
+		const bool canCollide = Broadphase::CanCollide(p0Shape, p1Shape);
+		m_broadphaseStats.m_playerPlayer.Record(!canCollide);
+		if (canCollide)
 		{
-			response.ApplyResponse(*p0Shape, *p1Shape);
+			// Player 1 is tested against player 0, which is the order the double dispatch through Shape
+			// used to give. It decides which player moves when both ways out are equally deep.
+			CollisionResponse response = p1Shape.Collide(p0Shape);
+			if (response.m_collided)
+			{
+				response.ApplyResponse(p0Shape, p1Shape);
+			}
 		}
 	}
 }
@@ -228,3 +345,40 @@ void NeuronGame::ScoreForPlayerIndex(const int playerIndex)
 	m_scores[playerIndex]++;
 	ResetField();
 }
+
+void NeuronGame::CheckForEarlyEnd()
+{
+	const bool isBallTouched = m_isBallTouched;
+	m_isBallTouched = false;
+	if (!m_earlyEndRules.IsEnabled() || IsGameOver())
+	{
+		return;
+	}
+
+	const int lead = Math::Abs(m_scores[0] - m_scores[1]);
+	if ((m_earlyEndRules.m_mercyGoalsPerMinute > 0.0f) &&
+		(static_cast<float>(lead) > m_earlyEndRules.m_mercyGoalsPerMinute * (m_timeRemaining / 60.0f)))
+	{
+		m_earlyEndReason = GameEndReason::Mercy;
+		return;
+	}
+
+	const float maxSpeedSquared = Math::Sqr(m_earlyEndRules.m_stallSpeed);
+	bool isStalled = (m_ball.m_shape.GetVelocity().GetLengthSquared() < maxSpeedSquared);
+	for (int i = 0; i < k_numPlayers; i++)
+	{
+		isStalled = isStalled && (m_players[i].GetVelocity().GetLengthSquared() < maxSpeedSquared);
+	}
+	m_stallSeconds = isStalled ? (m_stallSeconds + k_timePerTick) : 0.0f;
+	if ((m_earlyEndRules.m_stallSeconds > 0.0f) && (m_stallSeconds >= m_earlyEndRules.m_stallSeconds))
+	{
+		m_earlyEndReason = GameEndReason::Stall;
+		return;
+	}
+
+	m_secondsSinceBallTouched = isBallTouched ? 0.0f : (m_secondsSinceBallTouched + k_timePerTick);
+	if ((m_earlyEndRules.m_noProgressSeconds > 0.0f) && (m_secondsSinceBallTouched >= m_earlyEndRules.m_noProgressSeconds))
+	{
+		m_earlyEndReason = GameEndReason::NoProgress;
+	}
+}
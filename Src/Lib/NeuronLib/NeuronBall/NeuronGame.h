@@ -1,15 +1,157 @@
 #pragma  once
+#include <cstdint>
+#include <type_traits>	// for std::is_trivially_copyable
 #include "NeuronBall.h"
 #include "NeuronPlayer.h"
+#include "Util/Broadphase.h"
 #include "Util/Constants.h"
 #include "Util/Vector.h"
 
+class IGameRecorder;
 class NeuronPlayerInput;
 class NeuronPlayer;
 class NeuronPlayerController;
 
 constexpr int k_numPlayers = 2;
+constexpr int k_scoreToWin = 5;
 
+// Tuning shared by NeuronGame and BatchedNeuronGame
+// Length is along x-axis
+constexpr float k_fieldLength = 100.0f;
+// Width is along y-axis
+constexpr float k_fieldWidth = 80.0f;
+constexpr float k_playerWidthOffsetPercent = 0.04f;
+
+constexpr float k_maxTurnRadiansPerSecond = DegToRad(270.0f);
+constexpr float k_turningDeadZone = 0.1f;
+constexpr float k_maxForwardSpeed = 30.0f;
+constexpr float k_maxBoostedSpeed = k_maxForwardSpeed * 1.75f;
+constexpr float k_maxReverseSpeed = k_maxForwardSpeed * 0.75f;
+// TODO: Consider separating acceleration into forward, reverse, and braking accelerations
+constexpr float k_maxAcceleration = 100.0f;
+constexpr float k_throttleDeadZone = 0.1f;
+// Run at 60hz
+constexpr float k_timePerTick = 1.0f / 60.0f;
+
+
+// How often each of the game's broadphase tests let it skip an exact collision test
+class BroadphaseStats
+{
+public:
+	void Add(const BroadphaseStats& other)
+	{
+		m_playerField.Add(other.m_playerField);
+		m_ballPlayer.Add(other.m_ballPlayer);
+		m_playerPlayer.Add(other.m_playerPlayer);
+	}
+
+public:
+	BroadphaseCounter m_playerField;
+	BroadphaseCounter m_ballPlayer;
+	BroadphaseCounter m_playerPlayer;
+};
+
+enum class GameEndReason
+{
+	// Still being played
+	None,
+	ScoreToWin,
+	TimeUp,
+	// Ended early by EarlyEndRules
+	Mercy,
+	Stall,
+	NoProgress,
+	Count
+};
+
+// Rules for ending a game before time runs out, once the result is clear or nothing is happening.
+// The score at that point stands, so whoever is ahead wins, and a tied game is a draw.
+// Every rule is off by default, so games play out in full.
+class EarlyEndRules
+{
+public:
+	bool IsEnabled() const
+	{
+		return (m_mercyGoalsPerMinute > 0.0f) || (m_stallSeconds > 0.0f) || (m_noProgressSeconds > 0.0f);
+	}
+
+public:
+	// Ends the game once a player leads by more goals than could be scored back at this rate in the
+	// time left. 0 to disable.
+	float m_mercyGoalsPerMinute = 0.0f;
+	// Ends the game once both players and the ball have been moving slower than m_stallSpeed for
+	// this long. 0 to disable.
+	float m_stallSeconds = 0.0f;
+	// m/s
+	float m_stallSpeed = 0.5f;
+	// Ends the game once neither player has touched the ball for this long. 0 to disable.
+	float m_noProgressSeconds = 0.0f;
+};
+
+// How the games played on a NeuronGame ended, and how much simulated time ending early saved
+class GameEndStats
+{
+public:
+	void Add(const GameEndStats& other)
+	{
+		for (int i = 0; i < static_cast<int>(GameEndReason::Count); i++)
+		{
+			m_numGames[i] += other.m_numGames[i];
+		}
+		m_secondsPlayed += other.m_secondsPlayed;
+		m_secondsSaved += other.m_secondsSaved;
+	}
+
+	int GetNumGames(const GameEndReason reason) const { return m_numGames[static_cast<int>(reason)]; }
+	int GetNumEndedEarly() const
+	{
+		return GetNumGames(GameEndReason::Mercy) + GetNumGames(GameEndReason::Stall) + GetNumGames(GameEndReason::NoProgress);
+	}
+
+public:
+	int m_numGames[static_cast<int>(GameEndReason::Count)] = {};
+	// Simulated seconds
+	double m_secondsPlayed = 0.0;
+	double m_secondsSaved = 0.0;
+};
+
+// Everything about a NeuronGame that changes while it's played, so play can be picked up again from
+// that point. Controllers, the recorder and broadphase stats aren't included.
+// Plain floats rather than Vector2s, so it stays trivially copyable and can be copied with memcpy,
+// written to a file as is, or kept by the million.
+class NeuronGameSnapshot
+{
+public:
+	class Body
+	{
+	public:
+		float m_posX;
+		float m_posY;
+		float m_velX;
+		float m_velY;
+	};
+
+	class Player
+	{
+	public:
+		Body m_body;
+		float m_facing;
+		float m_boost;
+	};
+
+public:
+	Player m_players[k_numPlayers];
+	Body m_ball;
+	float m_gameDuration;
+	float m_timeRemaining;
+	// Progress toward EarlyEndRules
+	float m_stallSeconds;
+	float m_secondsSinceBallTouched;
+	uint8_t m_scores[k_numPlayers];
+	uint8_t m_earlyEndReason;
+};
+static_assert(std::is_trivially_copyable<NeuronGameSnapshot>::value, "Snapshots are meant to be copied as raw memory");
+static_assert(sizeof(NeuronGameSnapshot) <= 96, "Snapshots are meant to be small enough to keep millions of them");
 
 enum class GameState
 {
@@ -33,21 +175,44 @@ public:
 	void ResetGame(const float gameDuration);
 
 	void SetPlayerController(int playerIndex, NeuronPlayerController* playerController);
+	// Records what the players see and do on every tick. Not owned, and kept when the game is reset.
+	void SetRecorder(IGameRecorder* recorder) { m_recorder = recorder; }
+	// Kept when the game is reset
+	void SetEarlyEndRules(const EarlyEndRules& rules) { m_earlyEndRules = rules; }
+	const EarlyEndRules& GetEarlyEndRules() const { return m_earlyEndRules; }
 
 	void Update();
 	GameState GetGameState() const;
 	bool IsGameOver() const;
+	// Why the game ended, or None if it's still being played
+	GameEndReason GetEndReason() const;
 
 	float GetFieldWidth() const { return m_fieldWidth; }
 	float GetFieldLength() const { return m_fieldLength; }
 	float GetGoalWidth() const { return m_fieldWidth * 0.25f; }
 	static constexpr int GetNumPlayers() { return k_numPlayers; }
+	static constexpr int GetScoreToWin() { return k_scoreToWin; }
 	const NeuronPlayer& GetPlayer(const int index) const { return m_players[index]; }
 	NeuronPlayer& GetPlayer(const int index) { return m_players[index]; }
 	const NeuronBall& GetBall() const { return m_ball; }
 	int GetPlayerScore(const int playerIndex) const { return m_scores[playerIndex]; }
 	float GetTimeRemaining() const { return m_timeRemaining; }
 
+	// Saves the state of play, so Restore can continue from it, on this game or any other.
+	// Updating a restored game with the same inputs gives exactly the same results.
+	NeuronGameSnapshot Snapshot() const;
+	// Sets the state of play. Controllers, the recorder and broadphase stats are left as they are.
+	void Restore(const NeuronGameSnapshot& snapshot);
+	// Returns a new game in the same state of play as this one, with no controllers or recorder
+	NeuronGame Fork() const;
+
+	// Totals over every update since the last reset. Kept when the game is reset.
+	const BroadphaseStats& GetBroadphaseStats() const { return m_broadphaseStats; }
+	void ResetBroadphaseStats() { m_broadphaseStats = BroadphaseStats(); }
+	// Totals over every game that ended since the last reset. Kept when the game is reset.
+	const GameEndStats& GetGameEndStats() const { return m_gameEndStats; }
+	void ResetGameEndStats() { m_gameEndStats = GameEndStats(); }
+
 private:
 	// Called after a goal to reset player and ball positions
 	void ResetField();
@@ -57,12 +222,12 @@ private:
 	void ProcessCollisions();
 	void CheckForGoal();
 	void ScoreForPlayerIndex(const int playerIndex);
+	// Ends the game if any of m_earlyEndRules apply
+	void CheckForEarlyEnd();
 
 private:
-	// Length is along x-axis
-	const float m_fieldLength = 100.0f;
-	// Width is along y-axis
-	const float m_fieldWidth = 80.0f;
+	const float m_fieldLength = k_fieldLength;
+	const float m_fieldWidth = k_fieldWidth;
 
 	Array<NeuronPlayer, k_numPlayers> m_players;
 	NeuronBall m_ball;
@@ -70,5 +235,16 @@ private:
 	float m_gameDuration;
 	float m_timeRemaining;
 
+	EarlyEndRules m_earlyEndRules;
+	GameEndReason m_earlyEndReason = GameEndReason::None;
+	// Seconds that everything has been moving slower than m_earlyEndRules.m_stallSpeed
+	float m_stallSeconds = 0.0f;
+	float m_secondsSinceBallTouched = 0.0f;
+	// Set by ProcessCollisions
+	bool m_isBallTouched = false;
+
 	Array<NeuronPlayerController*, k_numPlayers> m_playerControllers;
+	IGameRecorder* m_recorder = nullptr;
+	BroadphaseStats m_broadphaseStats;
+	GameEndStats m_gameEndStats;
 };
@@ -2,6 +2,7 @@
 #include "NeuronGameDisplay.h"
 
 #include "NeuronGame.h"
+#include "Util/ShapeDrawer.h"
 #include <SFML/Graphics.hpp>
 
 namespace
@@ -92,8 +93,9 @@ void NeuronGameDisplay::Draw(sf::RenderWindow& window) const
 	{
 		const NeuronPlayer& neuronPlayer = m_neuronGame.GetPlayer(i);
 		sf::Color playerColor = (i == 0) ? playerColor1 : playerColor2;
-		neuronPlayer.m_shape->Draw(
+		ShapeDrawer::Draw(
 			window,
+			neuronPlayer.m_shape,
 			playerColor,
 			playerOutlineColor,
 			playerOutlineThickness
@@ -114,7 +116,7 @@ void NeuronGameDisplay::Draw(sf::RenderWindow& window) const
 
 	// Draw ball
 	const NeuronBall& neuronBall = m_neuronGame.GetBall();
-	neuronBall.m_shape.Draw(window, ballFillColor, ballOutlineColor, ballOutlineThickness);
+	ShapeDrawer::Draw(window, neuronBall.m_shape, ballFillColor, ballOutlineColor, ballOutlineThickness);
 
 	// Draw score
 	{
@@ -8,51 +8,48 @@ float k_defaultPlayerDensity = 1.0f;
 
 NeuronPlayer::NeuronPlayer(const Vector2 pos, const float facing)
 {
-	Rectangle* rect = new Rectangle();
-	rect->m_pos = pos;
-	rect->m_velocity = Vector2::Zero;
-	rect->m_facing = facing;
-	rect->m_angularVelocity = 0.0f;
-	rect->m_halfLength = GetPlayerHalfLength();
-	rect->m_halfWidth = GetPlayerHalfWidth();
-	rect->ComputeMassAndInertia(k_defaultPlayerDensity);
-
-	m_shape = rect;
+	m_shape.m_pos = pos;
+	m_shape.m_velocity = Vector2::Zero;
+	m_shape.m_facing = facing;
+	m_shape.m_angularVelocity = 0.0f;
+	m_shape.m_halfLength = GetPlayerHalfLength();
+	m_shape.m_halfWidth = GetPlayerHalfWidth();
+	m_shape.ComputeMassAndInertia(k_defaultPlayerDensity);
 }
 
 Vector2 NeuronPlayer::GetPos() const
 {
-	return m_shape->m_pos;
+	return m_shape.m_pos;
 }
 
 void NeuronPlayer::SetPos(const Vector2 pos)
 {
-	m_shape->m_pos = pos;
+	m_shape.m_pos = pos;
 }
 
 Vector2 NeuronPlayer::GetVelocity() const
 {
-	return m_shape->m_velocity;
+	return m_shape.m_velocity;
 }
 
 void NeuronPlayer::SetVelocity(const Vector2 vel)
 {
-	m_shape->m_velocity = vel;
+	m_shape.m_velocity = vel;
 }
 
 float NeuronPlayer::GetFacing() const
 {
-	return m_shape->m_facing;
+	return m_shape.m_facing;
 }
 
 void NeuronPlayer::SetFacing(const float facing)
 {
-	m_shape->m_facing = facing;
+	m_shape.m_facing = facing;
 }
 
 Vector2 NeuronPlayer::GetForward() const
 {
-	return Vector2(Math::Cos(m_shape->m_facing), Math::Sin(m_shape->m_facing));
+	return m_shape.GetForward();
 }
 
 Array<Vector2, 4> NeuronPlayer::GetCornerPoints() const
@@ -66,17 +63,18 @@ Array<Vector2, 4> NeuronPlayer::GetCornerPoints() const
 	const Vector2 halfWidthVector = halfRight * GetPlayerWidth();
 
 	// Compute all the corner points in counter-clockwise order
-	corners[0] = Vector2(m_shape->m_pos + halfLengthVector + halfWidthVector);
-	corners[1] = Vector2(m_shape->m_pos + halfLengthVector - halfWidthVector);
-	corners[2] = Vector2(m_shape->m_pos - halfLengthVector - halfWidthVector);
-	corners[3] = Vector2(m_shape->m_pos - halfLengthVector + halfWidthVector);
+	corners[0] = Vector2(m_shape.m_pos + halfLengthVector + halfWidthVector);
+	corners[1] = Vector2(m_shape.m_pos + halfLengthVector - halfWidthVector);
+	corners[2] = Vector2(m_shape.m_pos - halfLengthVector - halfWidthVector);
+	corners[3] = Vector2(m_shape.m_pos - halfLengthVector + halfWidthVector);
 
 	return corners;
 }
 
 bool NeuronPlayer::CollideWithField(const NeuronGame& game)
 {
-	// Perf: Early-out if player is clearly not close to the walls
+	// Note: NeuronGame skips this when the player is clearly not close to the walls.
+	// See Broadphase::CanLeaveBounds.
 	const float fieldLength = game.GetFieldLength();
 	const float fieldWidth = game.GetFieldWidth();
 
@@ -106,7 +104,7 @@ bool NeuronPlayer::CollideWithField(const NeuronGame& game)
 	}
 
 	// Move the player back by how much it was over the line
-	m_shape->m_pos += pushDistance;
+	m_shape.m_pos += pushDistance;
 
 	// If pushDistance isn't zero, there was a collision
 	return pushDistance != Vector2::Zero;
@@ -1,11 +1,11 @@
 #pragma once
 #include "Util/Array.h"
+#include "Util/Shapes.h"
 #include "Util/Vector.h"
 
 
 class NeuronBall;
 class NeuronGame;
-class Shape;
 
 class NeuronPlayer
 {
@@ -34,7 +34,7 @@ public:
 	static float GetPlayerRadius() { return Math::Sqrt(Math::Sqr(GetPlayerHalfWidth()) + Math::Sqr(GetPlayerHalfLength())); }
 
 public:
-	Shape* m_shape = nullptr;
+	Rectangle m_shape;
 	// Available boost
 	float m_boost = 0.0f;
 };
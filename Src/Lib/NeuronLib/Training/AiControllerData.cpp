@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "AiControllerData.h"
 
+#include "AiControllerManager.h"
 #include "NeuronBall/Controllers/NeuralNetPlayerController.h"
 
 
@@ -22,11 +23,26 @@ void AiControllerData::Serialize(BinaryBuffer& stream) const
 	m_controller->Serialize(stream);
 	SerializeSimpleObject(stream, m_winLossRecord);
 	SerializeInt(stream, m_generation);
+	SerializeFloat(stream, m_rating.m_rating);
+	SerializeFloat(stream, m_rating.m_deviation);
 }
 
 void AiControllerData::Deserialize(BinaryBuffer& stream)
+{
+	Deserialize(stream, AiControllerManager::GetFileRevisionNumber());
+}
+
+void AiControllerData::Deserialize(BinaryBuffer& stream, const int fileRevisionNumber)
 {
 	m_controller->Deserialize(stream);
 	DeserializeSimpleObject(stream, m_winLossRecord);
 	DeserializeInt(stream, m_generation);
+
+	// Ratings were added in revision 1. Older controllers start out unrated.
+	m_rating = Rating();
+	if (fileRevisionNumber >= 1)
+	{
+		DeserializeFloat(stream, m_rating.m_rating);
+		DeserializeFloat(stream, m_rating.m_deviation);
+	}
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Rating.h"
 #include "Util/Serializable.h"
 
 class NeuralNetPlayerController;
@@ -24,6 +25,25 @@ public:
 	{
 		return (m_wins * k_pointsForWin) + (m_ties * k_pointsForTie) + (m_losses * k_pointsForLoss);
 	}
+	int GetNumGames() const
+	{
+		return m_wins + m_losses + m_ties;
+	}
+	void AddResult(const int score, const int opponentScore)
+	{
+		if (score > opponentScore)
+		{
+			m_wins++;
+		}
+		else if (score < opponentScore)
+		{
+			m_losses++;
+		}
+		else
+		{
+			m_ties++;
+		}
+	}
 public:
 	int m_wins = 0;
 	int m_losses = 0;
@@ -37,10 +57,16 @@ public:
 	~AiControllerData();
 
 	void Serialize(BinaryBuffer& stream) const override;
+	// Reads data written with the current file revision
 	void Deserialize(BinaryBuffer& stream) override;
+	// Reads data written with an older file revision
+	void Deserialize(BinaryBuffer& stream, const int fileRevisionNumber);
 
 public:
 	NeuralNetPlayerController* m_controller = nullptr;
+	// Results from the current generation only
 	WinLossRecord m_winLossRecord;
 	int m_generation = 0;
+	// Strength estimate that persists across generations
+	Rating m_rating;
 };
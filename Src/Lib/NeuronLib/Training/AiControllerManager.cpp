@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <fstream>
 #include "Training\AiControllerData.h"
+#include "Training\HallOfFame.h"
 #include "Util\BinaryBuffer.h"
 #include "Util\Random.h"
 
@@ -12,7 +13,7 @@
 const char* k_fileMagicString = "pcAI";
 constexpr int k_fileMajorVersion = 0;
 constexpr int k_fileMinorVersion = 1;
-constexpr int k_fileRevisionNumber = 0;
+constexpr int k_fileRevisionNumber = 2;
 
 //static
 const char* AiControllerManager::GetFileMagicString()
@@ -38,6 +39,44 @@ int AiControllerManager::GetFileRevisionNumber()
 	return k_fileRevisionNumber;
 }
 
+//static
+void AiControllerManager::WriteControllersToFile(const char* outputFileName, const AiControllerList& controllers, const HallOfFame* hallOfFame)
+{
+	if (outputFileName == nullptr)
+	{
+		return;
+	}
+
+	// TODO: Use a dynamically sized buffer or write each controller one at a time so
+	//       not as much memory is needed, or both
+	HeapBuffer buffer(1024 * 1024 * 16);	// allocate a buffer that's easily bigger than needed
+	const char* magicString = GetFileMagicString();
+	buffer.WriteBytes(magicString, static_cast<int>(strlen(magicString)));
+	buffer.WriteInt(GetFileMajorVersion());
+	buffer.WriteInt(GetFileMinorVersion());
+	buffer.WriteInt(GetFileRevisionNumber());
+
+	buffer.WriteInt(static_cast<int>(controllers.size()));
+	for (const AiControllerData* controller : controllers)
+	{
+		controller->Serialize(buffer);
+	}
+
+	if (hallOfFame != nullptr)
+	{
+		hallOfFame->Serialize(buffer);
+	}
+	else
+	{
+		// Empty hall of fame
+		buffer.WriteInt(0);
+	}
+
+	auto file = std::fstream(outputFileName, std::ios::out | std::ios::binary);
+	file.write(buffer.GetPtr(), buffer.GetCurrent());
+	file.close();
+}
+
 
 static bool LoadControllersFromFile(AiControllerList& outControllers, const char* inputFileName)
 {
@@ -82,7 +121,7 @@ static bool LoadControllersFromFile(AiControllerList& outControllers, const char
 			Random defaultRand;
 			controller = new AiControllerData(defaultRand);
 		}
-		controller->Deserialize(buffer);
+		controller->Deserialize(buffer, fileRevisionNumber);
 	}
 
 	const bool success = buffer.GetErrorStatus() == BinaryBuffer::ErrorStatus::NoError;
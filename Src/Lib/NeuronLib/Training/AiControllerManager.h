@@ -5,6 +5,7 @@
 #include <vector>
 
 class AiControllerData;
+class HallOfFame;
 
 typedef std::vector<AiControllerData*> AiControllerList;
 
@@ -20,6 +21,10 @@ public:
 	// Newer revisions can read data from older revisions
 	static int GetFileRevisionNumber();
 
+	// Writes the controllers and hall of fame to a file in the current format. Does nothing if the
+	// file name is null. The hall of fame is optional.
+	static void WriteControllersToFile(const char* outputFileName, const AiControllerList& controllers, const HallOfFame* hallOfFame = nullptr);
+
 	std::vector<std::string> GetAllFiles() const;
 	const AiControllerList* GetControllerList(const std::string& filename) const;
 
@@ -4,12 +4,26 @@
 #include <algorithm>
 #include "AiControllerData.h"
 #include "AiControllerManager.h"
+#include "EvaluationScheduler.h"
+#include "FitnessSurrogate.h"
+#include "Matchmaker.h"
 #include <fstream>
+#include "HallOfFame.h"
+#include "MatchResultCache.h"
 #include "NeuralNet/Network.h"
+#include "NeuronBall/GameStateForNeuralNetInput.h"
 #include "NeuronBall/NeuronGame.h"
 #include "NeuronBall/Controllers/NeuralNetPlayerController.h"
+#include "NeuronBall/Controllers/ScriptedPlayerController.h"
+#include "ParetoRanking.h"
+#include "Speciation.h"
+#include "SteadyStateEvolution.h"
+#include <string>
 #include "Util/Random.h"
 #include "Util/BinaryBuffer.h"
+#include "Util/ThreadPool.h"
+#include "Util/Hash.h"
+#include "Util/Math.h"
 #include <windows.h> // for OutputDebugString
 
 
@@ -28,6 +42,24 @@ public:
 };
 
 
+// Plays a whole game without rendering and returns the score of each seat
+static MatchResult PlayHeadlessGame(NeuronGame& game, const float duration, NeuronPlayerController* player0, NeuronPlayerController* player1)
+{
+	game.ResetGame(duration);
+	game.SetPlayerController(0, player0);
+	game.SetPlayerController(1, player1);
+	while (!game.IsGameOver())
+	{
+		game.Update();
+	}
+
+	MatchResult result;
+	result.m_scores[0] = game.GetPlayerScore(0);
+	result.m_scores[1] = game.GetPlayerScore(1);
+	return result;
+}
+
+
 class GameSeason
 {
 public:
@@ -58,19 +90,117 @@ AiPlayerTrainer::AiPlayerTrainer(const Config& config) :
 
 	for (int i = 0; i < m_config.m_numControllers; i++)
 	{
+		// New controllers start with random weights
 		AiControllerData* aiControllerData = new AiControllerData(m_rand);
-		aiControllerData->m_controller->Randomize(m_rand);
 		m_controllers.push_back(aiControllerData);
 	}
 
-	// TODO: Use multiple games once execution is multi-threaded
 	m_currentGame = new NeuronGame();
+	m_currentGame->SetEarlyEndRules(config.m_earlyEndRules);
 
 	m_season = new GameSeason(config.m_numControllers, config.m_numGameSeasons);
+
+	m_matchCache = new MatchResultCache(config.m_matchCacheCapacity);
+
+	if (config.m_steadyState)
+	{
+		SteadyStateEvolution::Config steadyStateConfig;
+		steadyStateConfig.m_numThreads = config.m_numThreads;
+		steadyStateConfig.m_gameDuration = config.m_gameDuration;
+		steadyStateConfig.m_earlyEndRules = config.m_earlyEndRules;
+		steadyStateConfig.m_minGamesBeforeReplacement = config.m_minGamesBeforeReplacement;
+		steadyStateConfig.m_gameRulesHash = GetGameRulesHash();
+		steadyStateConfig.m_useRatings = config.m_useRatings;
+		steadyStateConfig.m_childRatingDeviation = config.m_childRatingDeviation;
+		m_steadyState = new SteadyStateEvolution(steadyStateConfig, m_controllers, *m_matchCache, m_rand);
+
+		m_showcaseControllers[0] = new NeuralNetPlayerController(m_rand);
+		m_showcaseControllers[1] = new NeuralNetPlayerController(m_rand);
+	}
+	else if (config.m_targetNumSpecies > 0)
+	{
+		Speciation::Config speciationConfig;
+		speciationConfig.m_targetNumSpecies = config.m_targetNumSpecies;
+		m_speciation = new Speciation(speciationConfig);
+	}
+
+	m_matchmaker = IMatchmaker::Create(config.m_matchmaking);
+
+	if (config.m_hallOfFameSize > 0)
+	{
+		HallOfFame::Config hallOfFameConfig;
+		hallOfFameConfig.m_capacity = config.m_hallOfFameSize;
+		m_hallOfFame = new HallOfFame(hallOfFameConfig);
+	}
+
+	if ((config.m_surrogateCandidatesPerChild > 1) && !config.m_steadyState)
+	{
+		FitnessSurrogate::Config surrogateConfig;
+		// Remember a few generations of results
+		surrogateConfig.m_capacity = Math::Max(surrogateConfig.m_capacity, config.m_numControllers * 4);
+		m_surrogate = new FitnessSurrogate(surrogateConfig);
+	}
+
+	if (((config.m_gatingAttempts > 0) || config.m_scriptedBaselines) && !config.m_steadyState)
+	{
+		for (int i = 0; i < static_cast<int>(ScriptedOpponent::Count); i++)
+		{
+			m_scriptedOpponents.push_back(ScriptedPlayerController::Create(static_cast<ScriptedOpponent>(i)));
+		}
+	}
+
+	if (config.m_racing && !config.m_steadyState)
+	{
+		EvaluationScheduler::Config schedulerConfig;
+		schedulerConfig.m_percentToKeep = config.m_percentToKeep;
+		schedulerConfig.m_gamesPerRound = config.m_racingGamesPerRound;
+		// Each season has every controller scheduled for one game
+		schedulerConfig.m_maxRounds = Math::Max(1, config.m_numGameSeasons / config.m_racingGamesPerRound);
+		schedulerConfig.m_eliminationFraction = config.m_racingEliminationFraction;
+		schedulerConfig.m_confidence = config.m_racingConfidence;
+		m_evaluationScheduler = new EvaluationScheduler(schedulerConfig, m_matchmaker);
+	}
+
+	if (config.m_parallelGames && !config.m_steadyState)
+	{
+		m_threadPool = new ThreadPool(config.m_numThreads);
+		for (int i = 0; i < m_threadPool->GetNumThreads(); i++)
+		{
+			m_workerGames.push_back(new NeuronGame());
+			m_workerGames.back()->SetEarlyEndRules(config.m_earlyEndRules);
+		}
+	}
+
+	if (!config.m_steadyState)
+	{
+		StartEvaluation();
+	}
 }
 
 AiPlayerTrainer::~AiPlayerTrainer()
 {
+	// Stop the workers before anything they use is deleted
+	if (m_steadyState != nullptr)
+	{
+		delete m_steadyState;
+	}
+	if (m_threadPool != nullptr)
+	{
+		delete m_threadPool;
+	}
+	for (NeuronGame* game : m_workerGames)
+	{
+		delete game;
+	}
+	m_workerGames.clear();
+	for (NeuralNetPlayerController* controller : m_showcaseControllers)
+	{
+		if (controller != nullptr)
+		{
+			delete controller;
+		}
+	}
+
 	if (m_currentGame != nullptr)
 	{
 		delete m_currentGame;
@@ -87,10 +217,55 @@ AiPlayerTrainer::~AiPlayerTrainer()
 
 	_ASSERT(m_season != nullptr);
 	delete m_season;
+
+	_ASSERT(m_matchCache != nullptr);
+	delete m_matchCache;
+
+	if (m_speciation != nullptr)
+	{
+		delete m_speciation;
+	}
+
+	if (m_evaluationScheduler != nullptr)
+	{
+		delete m_evaluationScheduler;
+	}
+
+	if (m_matchmaker != nullptr)
+	{
+		delete m_matchmaker;
+	}
+
+	if (m_hallOfFame != nullptr)
+	{
+		delete m_hallOfFame;
+	}
+
+	if (m_surrogate != nullptr)
+	{
+		delete m_surrogate;
+	}
+
+	for (ScriptedPlayerController* opponent : m_scriptedOpponents)
+	{
+		delete opponent;
+	}
+	m_scriptedOpponents.clear();
 }
 
 void AiPlayerTrainer::Update()
 {
+	if (m_steadyState != nullptr)
+	{
+		UpdateSteadyState();
+		return;
+	}
+	if (m_threadPool != nullptr)
+	{
+		UpdateParallel();
+		return;
+	}
+
 	// Early-out if the current game index is out of range
 	// This is only used to detect the end of testing condition
 	// TODO: Figure out a better way to stop playing when done
@@ -103,6 +278,22 @@ void AiPlayerTrainer::Update()
 
 	if (game->GetGameState() == GameState::PreGame)
 	{
+		// Skip over any games that have already been played by identical networks
+		int p0Score = 0;
+		int p1Score = 0;
+		while (TryGetCachedResult(m_season->m_gameStats[m_currentGameInSeason], p0Score, p1Score))
+		{
+			RecordGameResult(m_season->m_gameStats[m_currentGameInSeason], p0Score, p1Score);
+			AdvanceToNextGame();
+
+			// Stop if the cached game was the last one in the season. Either training is complete or
+			// a new generation was just prepared, which can start on the next update.
+			if ((m_currentGameInSeason == 0) || (m_currentGameInSeason >= m_season->m_gameStats.size()))
+			{
+				return;
+			}
+		}
+
 		const GameStats& stats = m_season->m_gameStats[m_currentGameInSeason];
 		
 		game->SetPlayerController(0, m_controllers[stats.m_controllerIndex0]->m_controller);
@@ -111,79 +302,656 @@ void AiPlayerTrainer::Update()
 
 	game->Update();
 
+	if ((m_surrogate != nullptr) && (m_surrogate->GetNumProbeStates() == 0))
+	{
+		SampleProbeState(*game);
+	}
+
 	if (game->IsGameOver())
 	{
 		// Record the game's score and reset the game
-
 		const GameStats& stats = m_season->m_gameStats[m_currentGameInSeason];
-		AiControllerData* p0 = m_controllers[stats.m_controllerIndex0];
-		AiControllerData* p1 = m_controllers[stats.m_controllerIndex1];
+		const int p0Score = game->GetPlayerScore(0);
+		const int p1Score = game->GetPlayerScore(1);
+		RecordGameResult(stats, p0Score, p1Score);
 
-		// TODO: Keep track of which AiControllerData was used for each game
-		int p0Score = game->GetPlayerScore(0);
-		int p1Score = game->GetPlayerScore(1);
-		if (p0Score == p1Score)
+		if (m_matchCache->IsEnabled())
 		{
-			p0->m_winLossRecord.m_ties++;
-			p1->m_winLossRecord.m_ties++;
+			MatchResult result;
+			result.m_scores[0] = p0Score;
+			result.m_scores[1] = p1Score;
+			m_matchCache->Store(
+				m_controllers[stats.m_controllerIndex0]->m_controller->GetHash(),
+				m_controllers[stats.m_controllerIndex1]->m_controller->GetHash(),
+				GetGameRulesHash(),
+				result
+			);
 		}
-		else if (p0Score > p1Score)
+
+		game->ResetGame(m_config.m_gameDuration);
+
+		AdvanceToNextGame();
+	}
+}
+
+bool AiPlayerTrainer::TryGetCachedResult(const GameStats& stats, int& outP0Score, int& outP1Score)
+{
+	if (!m_matchCache->IsEnabled())
+	{
+		return false;
+	}
+
+	MatchResult result;
+	m_cacheLookupsThisGeneration++;
+	const bool found = m_matchCache->Lookup(
+		m_controllers[stats.m_controllerIndex0]->m_controller->GetHash(),
+		m_controllers[stats.m_controllerIndex1]->m_controller->GetHash(),
+		GetGameRulesHash(),
+		result
+	);
+	if (found)
+	{
+		m_cacheHitsThisGeneration++;
+		outP0Score = result.m_scores[0];
+		outP1Score = result.m_scores[1];
+	}
+	return found;
+}
+
+void AiPlayerTrainer::RecordGameResult(const GameStats& stats, const int p0Score, const int p1Score)
+{
+	AiControllerData* p0 = m_controllers[stats.m_controllerIndex0];
+	AiControllerData* p1 = m_controllers[stats.m_controllerIndex1];
+	p0->m_winLossRecord.AddResult(p0Score, p1Score);
+	p1->m_winLossRecord.AddResult(p1Score, p0Score);
+	Rating::Update(p0->m_rating, p1->m_rating, Rating::GetGameScore(p0Score, p1Score));
+	m_gamesThisGeneration++;
+}
+
+void AiPlayerTrainer::AdvanceToNextGame()
+{
+	// Shift to next game in season
+	m_currentGameInSeason++;
+
+	// Check if all games have been run
+	if (m_currentGameInSeason >= m_season->m_gameStats.size())
+	{
+		FinishRound();
+	}
+}
+
+void AiPlayerTrainer::FinishRound()
+{
+	if (ScheduleNextRound())
+	{
+		return;
+	}
+	PrepareNextGeneration();
+}
+
+void AiPlayerTrainer::UpdateParallel()
+{
+	// Training is complete
+	if (!m_isRoundRunning && (m_currentGameInSeason >= m_season->m_gameStats.size()))
+	{
+		return;
+	}
+
+	if (!m_threadPool->IsBusy())
+	{
+		if (m_isRoundRunning)
 		{
-			p0->m_winLossRecord.m_wins++;
-			p1->m_winLossRecord.m_losses++;
+			FinishParallelRound();
 		}
-		else
+		if (m_currentGameInSeason < m_season->m_gameStats.size())
 		{
-			p0->m_winLossRecord.m_losses++;
-			p1->m_winLossRecord.m_wins++;
+			StartParallelRound();
 		}
+	}
+
+	// The showcase game is only for show, so its result isn't recorded. The controllers are only
+	// read by the workers, so it's safe to play them here at the same time.
+	const int numGamesInRound = static_cast<int>(m_season->m_gameStats.size());
+	if (numGamesInRound == 0)
+	{
+		return;
+	}
+	NeuronGame* game = m_currentGame;
+	if (game->GetGameState() == GameState::PreGame)
+	{
+		const GameStats& stats = m_season->m_gameStats[m_showcaseGameIndex % numGamesInRound];
+		game->SetPlayerController(0, m_controllers[stats.m_controllerIndex0]->m_controller);
+		game->SetPlayerController(1, m_controllers[stats.m_controllerIndex1]->m_controller);
+	}
+
+	game->Update();
+
+	if ((m_surrogate != nullptr) && (m_surrogate->GetNumProbeStates() == 0))
+	{
+		SampleProbeState(*game);
+	}
+
+	if (game->IsGameOver())
+	{
 		game->ResetGame(m_config.m_gameDuration);
+		m_showcaseGameIndex++;
+	}
+}
+
+void AiPlayerTrainer::StartParallelRound()
+{
+	// Cached results are looked up here, on this thread, so only new games go to the workers
+	const int numGames = static_cast<int>(m_season->m_gameStats.size());
+	m_roundResults.resize(numGames);
+	m_roundGamesToPlay.clear();
+	for (int i = 0; i < numGames; i++)
+	{
+		MatchResult& result = m_roundResults[i];
+		if (!TryGetCachedResult(m_season->m_gameStats[i], result.m_scores[0], result.m_scores[1]))
+		{
+			m_roundGamesToPlay.push_back(i);
+		}
+	}
+
+	m_roundStartTime = std::chrono::steady_clock::now();
+	m_isRoundRunning = true;
+	m_threadPool->Start(static_cast<int>(m_roundGamesToPlay.size()),
+		[this](const int jobIndex, const int threadIndex)
+		{
+			// Each job writes to its own result, so no locking is needed
+			const int gameIndex = m_roundGamesToPlay[jobIndex];
+			const GameStats& stats = m_season->m_gameStats[gameIndex];
+			m_roundResults[gameIndex] = PlayHeadlessGame(
+				*m_workerGames[threadIndex],
+				m_config.m_gameDuration,
+				m_controllers[stats.m_controllerIndex0]->m_controller,
+				m_controllers[stats.m_controllerIndex1]->m_controller
+			);
+		});
+}
 
-		// Shift to next game in season
-		m_currentGameInSeason++;
+void AiPlayerTrainer::FinishParallelRound()
+{
+	_ASSERT(!m_threadPool->IsBusy());
+	m_isRoundRunning = false;
+	m_parallelSecondsThisGeneration += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_roundStartTime).count();
+	m_parallelGamesThisGeneration += static_cast<int>(m_roundGamesToPlay.size());
 
-		// Check if all games have been run
-		if (m_currentGameInSeason >= m_season->m_gameStats.size())
+	if (m_matchCache->IsEnabled())
+	{
+		const uint64_t rulesHash = GetGameRulesHash();
+		for (const int gameIndex : m_roundGamesToPlay)
 		{
-			PrepareNextGeneration();
+			const GameStats& stats = m_season->m_gameStats[gameIndex];
+			m_matchCache->Store(
+				m_controllers[stats.m_controllerIndex0]->m_controller->GetHash(),
+				m_controllers[stats.m_controllerIndex1]->m_controller->GetHash(),
+				rulesHash,
+				m_roundResults[gameIndex]
+			);
 		}
 	}
+
+	// Ratings depend on the order results come in, so they're recorded in schedule order no matter
+	// which games finished first
+	const int numGames = static_cast<int>(m_season->m_gameStats.size());
+	for (int i = 0; i < numGames; i++)
+	{
+		RecordGameResult(m_season->m_gameStats[i], m_roundResults[i].m_scores[0], m_roundResults[i].m_scores[1]);
+	}
+
+	m_currentGameInSeason = numGames;
+	FinishRound();
+}
+
+void AiPlayerTrainer::StartEvaluation()
+{
+	const int numControllers = static_cast<int>(m_controllers.size());
+	if (m_evaluationScheduler != nullptr)
+	{
+		m_evaluationScheduler->Reset(numControllers);
+	}
+	else if (m_matchmaker != nullptr)
+	{
+		m_matchmaker->Reset(numControllers);
+		m_matchmakingRound = 0;
+	}
+	else
+	{
+		// The fixed season never changes
+		return;
+	}
+
+	const bool scheduled = ScheduleNextRound();
+	_ASSERT(scheduled);
+}
+
+bool AiPlayerTrainer::ScheduleNextRound()
+{
+	if ((m_evaluationScheduler == nullptr) && (m_matchmaker == nullptr))
+	{
+		return false;
+	}
+
+	std::vector<EvaluationScheduler::Estimate> estimates;
+	GetEstimates(estimates);
+
+	std::vector<EvaluationScheduler::Matchup> matchups;
+	if (m_evaluationScheduler != nullptr)
+	{
+		if (!m_evaluationScheduler->ScheduleNextRound(estimates, m_rand, matchups))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		// Two rounds per season, so every controller plays the same number of games as it would
+		// in the fixed season
+		if (m_matchmakingRound >= m_config.m_numGameSeasons * 2)
+		{
+			return false;
+		}
+		std::vector<int> players(m_controllers.size());
+		for (int i = 0; i < players.size(); i++)
+		{
+			players[i] = i;
+		}
+		m_matchmaker->PairRound(estimates, players, m_rand, matchups);
+		m_matchmakingRound++;
+	}
+	if (matchups.empty())
+	{
+		// An empty season would never finish, since Update() takes it to mean there's nothing to play
+		return false;
+	}
+
+	m_season->m_gameStats.clear();
+	for (const EvaluationScheduler::Matchup& matchup : matchups)
+	{
+		m_season->m_gameStats.push_back(GameStats(matchup.m_index0, matchup.m_index1));
+	}
+	m_currentGameInSeason = 0;
+	return true;
+}
+
+void AiPlayerTrainer::GetEstimates(std::vector<EvaluationScheduler::Estimate>& outEstimates) const
+{
+	outEstimates.resize(m_controllers.size());
+	for (int i = 0; i < m_controllers.size(); i++)
+	{
+		outEstimates[i] = m_config.m_useRatings ?
+			EvaluationScheduler::MakeEstimate(m_controllers[i]->m_rating) :
+			EvaluationScheduler::MakeEstimate(m_controllers[i]->m_winLossRecord);
+	}
+}
+
+//static
+uint64_t AiPlayerTrainer::GetGameRulesHash(const float gameDuration, const EarlyEndRules& earlyEndRules)
+{
+	uint64_t hash = Hash::Fnv1aSimpleObject(gameDuration);
+	hash = Hash::Fnv1aSimpleObject(NeuronGame::GetScoreToWin(), hash);
+	// Left out when disabled, so results from before the rules existed still match
+	if (earlyEndRules.IsEnabled())
+	{
+		hash = Hash::Fnv1aSimpleObject(earlyEndRules, hash);
+	}
+	return hash;
+}
+
+//static
+float AiPlayerTrainer::GetEvaluationCost(const AiControllerData& controller)
+{
+	// One multiply-add per weight, plus one add for each bias
+	return static_cast<float>(controller.m_controller->DebugGetNetwork()->GetNumParameters());
+}
+
+float AiPlayerTrainer::GetSelectionScore(const AiControllerData& controller) const
+{
+	// Points per game rather than points, since controllers can play a different number of games
+	// when racing
+	return m_config.m_useRatings ?
+		controller.m_rating.m_rating :
+		EvaluationScheduler::GetPointsPerGame(controller.m_winLossRecord);
+}
+
+void AiPlayerTrainer::BreedChild(AiControllerData& child, const AiControllerData& parent)
+{
+	// A parent that can't pass the gate can't be expected to have children that do
+	const bool isGated = (m_config.m_gatingAttempts > 0) && !m_scriptedOpponents.empty() && PassesGate(*parent.m_controller);
+	const int numAttempts = isGated ? m_config.m_gatingAttempts : 1;
+	float prediction = 0.0f;
+	bool hasPrediction = false;
+	for (int attempt = 0; attempt < numAttempts; attempt++)
+	{
+		hasPrediction = BreedNetwork(child, parent, prediction);
+		if (!isGated || PassesGate(*child.m_controller))
+		{
+			break;
+		}
+		// The last attempt is kept even if it fails, so the population size doesn't change
+		m_gatingRejectionsThisGeneration++;
+	}
+	if (isGated)
+	{
+		m_gatedChildrenThisGeneration++;
+	}
+	if (hasPrediction)
+	{
+		m_surrogatePredictions.emplace_back(&child, prediction);
+	}
+
+	child.m_generation = parent.m_generation + 1;
+	child.m_rating = parent.m_rating.MakeChildRating(m_config.m_childRatingDeviation);
+}
+
+bool AiPlayerTrainer::BreedNetwork(AiControllerData& child, const AiControllerData& parent, float& outPrediction)
+{
+	if ((m_surrogate != nullptr) && m_surrogate->IsReady())
+	{
+		// Keep the candidate with the best predicted score
+		std::vector<float> behavior;
+		Network bestNetwork;
+		float bestPrediction = 0.0f;
+		for (int candidate = 0; candidate < m_config.m_surrogateCandidatesPerChild; candidate++)
+		{
+			child.m_controller->Breed(m_rand, parent.m_controller);
+			m_surrogate->ComputeBehavior(*child.m_controller->DebugGetNetwork(), behavior);
+			const float prediction = m_surrogate->Predict(behavior);
+			if ((candidate == 0) || (prediction > bestPrediction))
+			{
+				bestPrediction = prediction;
+				bestNetwork = *child.m_controller->DebugGetNetwork();
+			}
+		}
+		child.m_controller->SetNetwork(bestNetwork);
+		m_surrogateCandidatesThisGeneration += m_config.m_surrogateCandidatesPerChild;
+		outPrediction = bestPrediction;
+		return true;
+	}
+
+	child.m_controller->Breed(m_rand, parent.m_controller);
+	return false;
+}
+
+bool AiPlayerTrainer::PassesGate(NeuralNetPlayerController& controller)
+{
+	int goalDifference = 0;
+	PlayScriptedOpponent(controller, *m_scriptedOpponents[0], m_config.m_gatingGameDuration, goalDifference, m_gatingGamesThisGeneration);
+	return goalDifference > 0;
+}
+
+WinLossRecord AiPlayerTrainer::PlayScriptedOpponent(NeuralNetPlayerController& controller, ScriptedPlayerController& opponent, const float gameDuration, int& outGoalDifference, int& ioNumGamesPlayed)
+{
+	// Both sides are deterministic, so the results are cached like any other game
+	const uint64_t controllerHash = controller.GetHash();
+	const uint64_t opponentHash = opponent.GetHash();
+	const uint64_t rulesHash = GetGameRulesHash(gameDuration);
+
+	WinLossRecord record;
+	outGoalDifference = 0;
+	NeuronGame game;
+	for (int seat = 0; seat < 2; seat++)
+	{
+		const uint64_t hashSeat0 = (seat == 0) ? controllerHash : opponentHash;
+		const uint64_t hashSeat1 = (seat == 0) ? opponentHash : controllerHash;
+		MatchResult result;
+		if (!m_matchCache->IsEnabled() || !m_matchCache->Lookup(hashSeat0, hashSeat1, rulesHash, result))
+		{
+			result = (seat == 0) ?
+				PlayHeadlessGame(game, gameDuration, &controller, &opponent) :
+				PlayHeadlessGame(game, gameDuration, &opponent, &controller);
+			if (m_matchCache->IsEnabled())
+			{
+				m_matchCache->Store(hashSeat0, hashSeat1, rulesHash, result);
+			}
+			ioNumGamesPlayed++;
+		}
+		record.AddResult(result.m_scores[seat], result.m_scores[1 - seat]);
+		outGoalDifference += result.m_scores[seat] - result.m_scores[1 - seat];
+	}
+	return record;
+}
+
+void AiPlayerTrainer::ReportScriptedBaselines(NeuralNetPlayerController& champion)
+{
+	char msg[256];
+	for (ScriptedPlayerController* opponent : m_scriptedOpponents)
+	{
+		int goalDifference = 0;
+		int numGamesPlayed = 0;
+		const WinLossRecord record = PlayScriptedOpponent(champion, *opponent, m_config.m_gameDuration, goalDifference, numGamesPlayed);
+		sprintf_s(msg, "Baseline: champion %d/%d/%d with goal difference %+d against %s\n",
+			record.m_wins,
+			record.m_losses,
+			record.m_ties,
+			goalDifference,
+			ScriptedPlayerController::GetName(opponent->GetOpponent())
+		);
+		OutputDebugStringA(msg);
+	}
+}
+
+void AiPlayerTrainer::SortControllers()
+{
+	if (!m_config.m_paretoSelection)
+	{
+		// Sort controllers based on score.
+		sort(begin(m_controllers),
+			end(m_controllers),
+			[this](AiControllerData* a, AiControllerData* b)
+			{
+				const float pointsCmp = GetSelectionScore(*a) - GetSelectionScore(*b);
+				// Divide levelsCmp by two to allow for easy growth by one level while still
+				// restricting unbounded growth.
+				int levelsCmp = (a->m_controller->DebugGetNetwork()->GetNumLevels() - b->m_controller->DebugGetNetwork()->GetNumLevels()) / 2;
+				// More points is better. If points are equal, fewer levels is better.
+				return (pointsCmp > 0) || ((pointsCmp == 0) && (levelsCmp < 0));
+			});
+		OutputDebugStringA("========================================================================\n");
+		return;
+	}
+
+	const int numControllers = static_cast<int>(m_controllers.size());
+	std::vector<ParetoPoint> points(numControllers);
+	for (int i = 0; i < numControllers; i++)
+	{
+		points[i].m_score = GetSelectionScore(*m_controllers[i]);
+		points[i].m_cost = GetEvaluationCost(*m_controllers[i]);
+	}
+	ParetoRanking ranking;
+	ranking.Rank(points);
+
+	// Controllers are replaced from the back, so the best fronts survive. The best score comes
+	// first, so m_controllers[0] is still the champion.
+	const std::vector<AiControllerData*> unsorted = m_controllers;
+	const std::vector<int>& order = ranking.GetOrder();
+	float minCost = points[order[0]].m_cost;
+	float maxCost = minCost;
+	for (int i = 0; i < numControllers; i++)
+	{
+		m_controllers[i] = unsorted[order[i]];
+		if (ranking.GetRank(order[i]) == 0)
+		{
+			minCost = Math::Min(minCost, points[order[i]].m_cost);
+			maxCost = Math::Max(maxCost, points[order[i]].m_cost);
+		}
+	}
+
+	char msg[256];
+	OutputDebugStringA("========================================================================\n");
+	sprintf_s(msg, "Pareto: %d fronts, %d controllers in the first front costing %.0f to %.0f multiply-adds\n",
+		ranking.GetNumFronts(),
+		ranking.GetFrontSize(0),
+		minCost,
+		maxCost
+	);
+	OutputDebugStringA(msg);
 }
 
 void AiPlayerTrainer::PrepareNextGeneration()
 {
-	// Sort controllers based on score.
-	sort(begin(m_controllers),
-		end(m_controllers),
-		[](AiControllerData* a, AiControllerData* b)
-		{
-			int pointsCmp = (a->m_winLossRecord.GetPoints() - b->m_winLossRecord.GetPoints());
-			// Divide levelsCmp by two to allow for easy growth by one level while still
-			// restricting unbounded growth.
-			int levelsCmp = (a->m_controller->DebugGetNetwork()->GetNumLevels() - b->m_controller->DebugGetNetwork()->GetNumLevels()) / 2;
-			// More points is better. If points are equal, fewer levels is better.
-			return (pointsCmp > 0) || ((pointsCmp == 0) && (levelsCmp < 0));
-		});
+	SortControllers();
 
 	// Output stats
 	char msg[256];
-	OutputDebugStringA("========================================================================\n");
 
 	for (int i = 0; i < m_controllers.size(); i++)
 	{
 		const AiControllerData* aiData = m_controllers[i];
-		sprintf_s(msg, "Controller %2d = %d/%d/%d = %3d points\n",
+		sprintf_s(msg, "Controller %2d = %d/%d/%d = %3d points, rating %4.0f +/- %3.0f\n",
 			i,
 			aiData->m_winLossRecord.m_wins,
 			aiData->m_winLossRecord.m_losses,
 			aiData->m_winLossRecord.m_ties,
-			aiData->m_winLossRecord.GetPoints()
+			aiData->m_winLossRecord.GetPoints(),
+			aiData->m_rating.m_rating,
+			aiData->m_rating.m_deviation
 		);
 		OutputDebugStringA(msg);
 	}
 
-	sprintf_s(msg, "%d games played in %d seasons\n", static_cast<int>(m_season->m_gameStats.size()), m_config.m_numGameSeasons);
+	if (m_evaluationScheduler != nullptr)
+	{
+		const int fullScheduleGames = static_cast<int>(m_controllers.size()) * m_config.m_numGameSeasons;
+		sprintf_s(msg, "Racing: %d games in %d rounds (%.1f%% of %d seasons), %d accepted, %d eliminated, %d still racing\n",
+			m_gamesThisGeneration,
+			m_evaluationScheduler->GetRound(),
+			(fullScheduleGames > 0) ? (100.0f * m_gamesThisGeneration) / fullScheduleGames : 0.0f,
+			m_config.m_numGameSeasons,
+			m_evaluationScheduler->GetNumAccepted(),
+			m_evaluationScheduler->GetNumEliminated(),
+			m_evaluationScheduler->GetNumRacing()
+		);
+	}
+	else
+	{
+		sprintf_s(msg, "%d games played in %d seasons\n", m_gamesThisGeneration, m_config.m_numGameSeasons);
+	}
 	OutputDebugStringA(msg);
+	m_gamesThisGeneration = 0;
+	if (m_threadPool != nullptr)
+	{
+		sprintf_s(msg, "Parallel: %d games simulated on %d threads in %.2fs (%.0f games/s)\n",
+			m_parallelGamesThisGeneration,
+			m_threadPool->GetNumThreads(),
+			m_parallelSecondsThisGeneration,
+			m_parallelGamesThisGeneration / Math::Max(m_parallelSecondsThisGeneration, 0.001)
+		);
+		OutputDebugStringA(msg);
+
+		// Idle time is time a worker spent waiting for the others to finish their share of a round
+		double totalBusySeconds = 0.0;
+		double totalIdleSeconds = 0.0;
+		int64_t numSteals = 0;
+		std::string idlePerThread;
+		for (int i = 0; i < m_threadPool->GetNumThreads(); i++)
+		{
+			const ThreadPool::WorkerStats stats = m_threadPool->GetWorkerStats(i);
+			totalBusySeconds += stats.m_busySeconds;
+			totalIdleSeconds += stats.m_idleSeconds;
+			numSteals += stats.m_numSteals;
+			const double workerSeconds = stats.m_busySeconds + stats.m_idleSeconds;
+			char percent[16];
+			sprintf_s(percent, " %.1f%%", (workerSeconds > 0.0) ? (100.0 * stats.m_idleSeconds) / workerSeconds : 0.0);
+			idlePerThread += percent;
+		}
+		const double totalSeconds = totalBusySeconds + totalIdleSeconds;
+		sprintf_s(msg, "Load balance: %.1f%% of thread time idle, %lld steals. Idle per thread:",
+			(totalSeconds > 0.0) ? (100.0 * totalIdleSeconds) / totalSeconds : 0.0,
+			static_cast<long long>(numSteals)
+		);
+		OutputDebugStringA(msg);
+		idlePerThread += "\n";
+		OutputDebugStringA(idlePerThread.c_str());
+		m_threadPool->ResetStats();
+	}
+	m_parallelGamesThisGeneration = 0;
+	m_parallelSecondsThisGeneration = 0.0;
+	{
+		BroadphaseStats broadphaseStats = m_currentGame->GetBroadphaseStats();
+		m_currentGame->ResetBroadphaseStats();
+		for (NeuronGame* game : m_workerGames)
+		{
+			broadphaseStats.Add(game->GetBroadphaseStats());
+			game->ResetBroadphaseStats();
+		}
+		sprintf_s(msg, "Broadphase: skipped %.1f%% of player-field, %.1f%% of ball-player, %.1f%% of player-player tests\n",
+			broadphaseStats.m_playerField.GetRejectionPercent(),
+			broadphaseStats.m_ballPlayer.GetRejectionPercent(),
+			broadphaseStats.m_playerPlayer.GetRejectionPercent()
+		);
+		OutputDebugStringA(msg);
+	}
+	{
+		// With parallel games the current game is only for show, so only the workers' games count
+		GameEndStats endStats;
+		if (m_threadPool == nullptr)
+		{
+			endStats.Add(m_currentGame->GetGameEndStats());
+		}
+		m_currentGame->ResetGameEndStats();
+		for (NeuronGame* game : m_workerGames)
+		{
+			endStats.Add(game->GetGameEndStats());
+			game->ResetGameEndStats();
+		}
+		if (m_config.m_earlyEndRules.IsEnabled())
+		{
+			const double secondsSimulated = endStats.m_secondsPlayed + endStats.m_secondsSaved;
+			sprintf_s(msg, "Early end: %d mercy, %d stalled, %d no progress. Saved %.0fs of %.0fs simulated time (%.1f%%)\n",
+				endStats.GetNumGames(GameEndReason::Mercy),
+				endStats.GetNumGames(GameEndReason::Stall),
+				endStats.GetNumGames(GameEndReason::NoProgress),
+				endStats.m_secondsSaved,
+				secondsSimulated,
+				(secondsSimulated > 0.0) ? (100.0 * endStats.m_secondsSaved) / secondsSimulated : 0.0
+			);
+			OutputDebugStringA(msg);
+		}
+	}
+	if (m_matchmaker != nullptr)
+	{
+		sprintf_s(msg, "Matchmaking: %d rematches\n", m_matchmaker->GetNumRematches());
+		OutputDebugStringA(msg);
+	}
+	if (m_matchCache->IsEnabled())
+	{
+		const float hitRate = (m_cacheLookupsThisGeneration > 0) ?
+			(100.0f * m_cacheHitsThisGeneration) / m_cacheLookupsThisGeneration :
+			0.0f;
+		sprintf_s(msg, "Match cache: %d of %d games reused (%.1f%%), %d/%d entries\n",
+			m_cacheHitsThisGeneration,
+			m_cacheLookupsThisGeneration,
+			hitRate,
+			m_matchCache->GetNumEntries(),
+			m_matchCache->GetCapacity()
+		);
+		OutputDebugStringA(msg);
+	}
+	m_cacheLookupsThisGeneration = 0;
+	m_cacheHitsThisGeneration = 0;
+	if (m_surrogate != nullptr)
+	{
+		UpdateSurrogate();
+	}
+	if (m_config.m_gatingAttempts > 0)
+	{
+		sprintf_s(msg, "Gating: %d children tested, %d rebred after failing, %d short games played\n",
+			m_gatedChildrenThisGeneration,
+			m_gatingRejectionsThisGeneration,
+			m_gatingGamesThisGeneration
+		);
+		OutputDebugStringA(msg);
+	}
+	m_gatedChildrenThisGeneration = 0;
+	m_gatingRejectionsThisGeneration = 0;
+	m_gatingGamesThisGeneration = 0;
+	if (m_config.m_scriptedBaselines)
+	{
+		ReportScriptedBaselines(*m_controllers[0]->m_controller);
+	}
+	UpdateHallOfFame(*m_controllers[0]->m_controller->DebugGetNetwork());
 	sprintf_s(msg, "Generation %d complete =====================================\n", m_generation);
 	OutputDebugStringA(msg);
 
@@ -208,15 +976,13 @@ void AiPlayerTrainer::PrepareNextGeneration()
 		// TODO: Keep some random other controllers too
 
 		// Replace "dead" controllers with new ones for the next generation
-		const int numControllersToKeep = static_cast<int>(m_controllers.size() * m_config.m_percentToKeep);
-		for (int i = numControllersToKeep; i < m_controllers.size(); i++)
+		if (m_speciation != nullptr)
 		{
-			// Using only asexual reproduction for now.
-			// TODO: Develop a more reliable way to get good results from merging multiple parents
-			const int parentIndex = m_rand.NextInt(0, numControllersToKeep);
-			const AiControllerData& parent = *m_controllers[parentIndex];
-			m_controllers[i]->m_controller->Breed(m_rand, parent.m_controller);
-			m_controllers[i]->m_generation = parent.m_generation + 1;
+			BreedWithinSpecies();
+		}
+		else
+		{
+			BreedFromBest();
 		}
 
 		// Randomize seeding of controllers
@@ -226,42 +992,435 @@ void AiPlayerTrainer::PrepareNextGeneration()
 			std::swap(m_controllers[i], m_controllers[swapIndex]);
 		}
 
-		// Reset points for next generation
+		// Reset points for next generation. Ratings carry over, but become less certain.
 		for (auto controller : m_controllers)
 		{
 			controller->m_winLossRecord.Reset();
+			controller->m_rating.AddUncertainty(m_config.m_ratingDeviationPerGeneration);
 		}
 
 		m_generation++;
 		m_currentGameInSeason = 0;
+		StartEvaluation();
 	}
 }
 
-void AiPlayerTrainer::WriteControllersToFile(const char* outputFileName) const
+void AiPlayerTrainer::UpdateSteadyState()
+{
+	if (m_generation > m_config.m_numGenerations)
+	{
+		m_steadyState->Stop();
+		return;
+	}
+	// Controllers may have been loaded from a file since the trainer was created, so wait until
+	// the first update to start
+	m_steadyState->Start();
+
+	NeuronGame* game = m_currentGame;
+	if (game->GetGameState() == GameState::PreGame)
+	{
+		// Show the best controller against a random one
+		std::unique_lock<std::mutex> lock = m_steadyState->LockControllers();
+		const AiControllerData* best = GetBestAiController();
+		const AiControllerData* opponent = m_controllers[m_rand.NextInt(0, static_cast<int>(m_controllers.size()))];
+		m_showcaseControllers[0]->SetNetwork(*best->m_controller->DebugGetNetwork());
+		m_showcaseControllers[1]->SetNetwork(*opponent->m_controller->DebugGetNetwork());
+		game->SetPlayerController(0, m_showcaseControllers[0]);
+		game->SetPlayerController(1, m_showcaseControllers[1]);
+	}
+
+	game->Update();
+
+	if (game->IsGameOver())
+	{
+		game->ResetGame(m_config.m_gameDuration);
+	}
+
+	const int64_t numReplacements = m_steadyState->GetStats().m_numReplacements;
+	if (numReplacements >= static_cast<int64_t>(m_generation + 1) * m_config.m_numControllers)
+	{
+		ReportSteadyStateGeneration();
+	}
+}
+
+void AiPlayerTrainer::ReportSteadyStateGeneration()
+{
+	const SteadyStateEvolution::Stats stats = m_steadyState->GetStats();
+	std::unique_lock<std::mutex> lock = m_steadyState->LockControllers();
+
+	// Sort a copy, since the workers refer to controllers by index. Records of survivors are never
+	// reset, so total points would favor the oldest controllers. Sorted by the same score that
+	// SteadyStateEvolution replaces controllers by.
+	AiControllerList sortedControllers;
+	const auto sortControllers = [this, &sortedControllers]()
+	{
+		sortedControllers.assign(m_controllers.begin(), m_controllers.end());
+		sort(begin(sortedControllers),
+			end(sortedControllers),
+			[this](const AiControllerData* a, const AiControllerData* b)
+			{
+				return GetSelectionScore(*a) > GetSelectionScore(*b);
+			});
+	};
+	sortControllers();
+
+	char msg[256];
+	OutputDebugStringA("========================================================================\n");
+
+	for (int i = 0; i < sortedControllers.size(); i++)
+	{
+		const AiControllerData* aiData = sortedControllers[i];
+		sprintf_s(msg, "Controller %2d = %d/%d/%d = %3d points, score %.2f, generation %d\n",
+			i,
+			aiData->m_winLossRecord.m_wins,
+			aiData->m_winLossRecord.m_losses,
+			aiData->m_winLossRecord.m_ties,
+			aiData->m_winLossRecord.GetPoints(),
+			GetSelectionScore(*aiData),
+			aiData->m_generation
+		);
+		OutputDebugStringA(msg);
+	}
+
+	const double wallSeconds = stats.m_runningSeconds / m_steadyState->GetNumThreads();
+	const int64_t numResults = stats.m_numGamesPlayed + stats.m_numCachedResults;
+	sprintf_s(msg, "Steady state: %lld games played, %lld cached, %lld stale, %lld replacements\n",
+		stats.m_numGamesPlayed,
+		stats.m_numCachedResults,
+		stats.m_numStaleResults,
+		stats.m_numReplacements
+	);
+	OutputDebugStringA(msg);
+	sprintf_s(msg, "%.0f results/s on %d threads, %.1f%% thread utilization\n",
+		(wallSeconds > 0.0) ? (numResults / wallSeconds) : 0.0,
+		m_steadyState->GetNumThreads(),
+		(stats.m_runningSeconds > 0.0) ? (100.0 * stats.m_busySeconds / stats.m_runningSeconds) : 0.0
+	);
+	OutputDebugStringA(msg);
+
+	// Benchmark a copy of the champion, so the workers don't have to wait for the games
+	Network champion = *sortedControllers[0]->m_controller->DebugGetNetwork();
+	lock.unlock();
+	UpdateHallOfFame(champion);
+	lock.lock();
+
+	sprintf_s(msg, "Generation %d complete =====================================\n", m_generation);
+	OutputDebugStringA(msg);
+
+	if ((m_generation % m_config.m_saveEveryNGenerations == 0) ||
+		(m_generation == m_config.m_numGenerations))
+	{
+		char filename[256];
+		sprintf_s(filename, m_config.m_saveFile,
+			AiControllerManager::GetFileMajorVersion(),
+			AiControllerManager::GetFileMinorVersion(),
+			AiControllerManager::GetFileRevisionNumber(),
+			m_generation
+		);
+
+		// Written best first, like the generational path, since controller 0 is loaded as the best AI.
+		// Controllers may have been replaced while the lock was released, so sort again.
+		sortControllers();
+		AiControllerManager::WriteControllersToFile(filename, sortedControllers, m_hallOfFame);
+	}
+
+	m_generation++;
+}
+
+void AiPlayerTrainer::BreedFromBest()
+{
+	const int numControllersToKeep = static_cast<int>(m_controllers.size() * m_config.m_percentToKeep);
+	for (int i = numControllersToKeep; i < m_controllers.size(); i++)
+	{
+		// Using only asexual reproduction for now.
+		// TODO: Develop a more reliable way to get good results from merging multiple parents
+		const int parentIndex = m_rand.NextInt(0, numControllersToKeep);
+		BreedChild(*m_controllers[i], *m_controllers[parentIndex]);
+	}
+}
+
+void AiPlayerTrainer::BreedWithinSpecies()
+{
+	const int numControllers = static_cast<int>(m_controllers.size());
+	std::vector<const Network*> networks(numControllers);
+	std::vector<int> points(numControllers);
+	for (int i = 0; i < numControllers; i++)
+	{
+		networks[i] = m_controllers[i]->m_controller->DebugGetNetwork();
+		// Speciation works on whole numbers, so points per game are in hundredths
+		const float pointsScale = m_config.m_useRatings ? 1.0f : 100.0f;
+		points[i] = static_cast<int>(Math::Round(GetSelectionScore(*m_controllers[i]) * pointsScale));
+	}
+	m_speciation->Speciate(networks, points);
+
+	// Ratings are around 1500 rather than starting from 0, so every species would get almost the same
+	// share of children. Shares are measured from the weakest controller instead.
+	const int minSharePoints = m_config.m_useRatings ? *std::min_element(points.begin(), points.end()) : 0;
+
+	char msg[256];
+	sprintf_s(msg, "Speciation: %d species (threshold %.2f), %d distance calculations in %.2f ms\n",
+		m_speciation->GetNumSpecies(),
+		m_speciation->GetThreshold(),
+		m_speciation->GetNumDistanceCalculations(),
+		m_speciation->GetSpeciateMilliseconds()
+	);
+	OutputDebugStringA(msg);
+
+	// Pick the survivors of each species. Members are in the same order as m_controllers, so
+	// the best ones come first. Stagnant species die out, unless they have the best controller.
+	const std::vector<Species>& species = m_speciation->GetSpecies();
+	const int numSpecies = static_cast<int>(species.size());
+	std::vector<int> numSurvivors(numSpecies, 0);
+	std::vector<double> childShares(numSpecies, 0.0);
+	std::vector<bool> isSurvivor(numControllers, false);
+	double totalChildShares = 0.0;
+	for (int s = 0; s < numSpecies; s++)
+	{
+		const std::vector<int>& members = species[s].m_members;
+		const bool hasBestController = (members[0] == 0);
+		if (!hasBestController && (species[s].m_generationsWithoutImprovement >= m_config.m_speciesStagnationLimit))
+		{
+			continue;
+		}
+
+		numSurvivors[s] = Math::Max(1, static_cast<int>(members.size() * m_config.m_percentToKeep));
+		for (int i = 0; i < numSurvivors[s]; i++)
+		{
+			isSurvivor[members[i]] = true;
+		}
+
+		// Explicit fitness sharing. Each species gets children in proportion to its average points,
+		// so one big species can't take over the population just by being big.
+		int totalPoints = 0;
+		for (const int member : members)
+		{
+			totalPoints += points[member] - minSharePoints;
+		}
+		childShares[s] = static_cast<double>(totalPoints) / members.size();
+		totalChildShares += childShares[s];
+	}
+
+	std::vector<int> deadControllers;
+	for (int i = 0; i < numControllers; i++)
+	{
+		if (!isSurvivor[i])
+		{
+			deadControllers.push_back(i);
+		}
+	}
+
+	// Split the children between the species using the largest remainder method
+	const int numChildren = static_cast<int>(deadControllers.size());
+	std::vector<int> numChildrenPerSpecies(numSpecies, 0);
+	std::vector<std::pair<double, int>> remainders;
+	int numChildrenAssigned = 0;
+	for (int s = 0; s < numSpecies; s++)
+	{
+		if (numSurvivors[s] == 0)
+		{
+			continue;
+		}
+		// If nobody scored any points, or every rating is the same, share based on the number of
+		// survivors instead
+		const double share = (totalChildShares > 0.0) ?
+			(childShares[s] / totalChildShares) :
+			(static_cast<double>(numSurvivors[s]) / (numControllers - numChildren));
+		const double quota = share * numChildren;
+		numChildrenPerSpecies[s] = static_cast<int>(quota);
+		numChildrenAssigned += numChildrenPerSpecies[s];
+		remainders.push_back(std::make_pair(quota - numChildrenPerSpecies[s], s));
+	}
+	std::sort(remainders.begin(), remainders.end(),
+		[](const std::pair<double, int>& a, const std::pair<double, int>& b) { return a.first > b.first; });
+	for (int i = 0; numChildrenAssigned < numChildren; i = (i + 1) % remainders.size())
+	{
+		numChildrenPerSpecies[remainders[i].second]++;
+		numChildrenAssigned++;
+	}
+
+	int nextDeadController = 0;
+	for (int s = 0; s < numSpecies; s++)
+	{
+		for (int child = 0; child < numChildrenPerSpecies[s]; child++)
+		{
+			const int parentIndex = species[s].m_members[m_rand.NextInt(0, numSurvivors[s])];
+			BreedChild(*m_controllers[deadControllers[nextDeadController++]], *m_controllers[parentIndex]);
+		}
+	}
+	_ASSERT(nextDeadController == numChildren);
+}
+
+void AiPlayerTrainer::UpdateHallOfFame(const Network& champion)
 {
-	if (outputFileName == nullptr)
+	if (m_hallOfFame == nullptr)
 	{
 		return;
 	}
 
-	// TODO: Use a dynamically sized buffer or write each controller one at a time so
-	//       not as much memory is needed, or both
-	HeapBuffer buffer(1024 * 1024 * 16);	// allocate a buffer that's easily bigger than needed
-	const char* magicString = AiControllerManager::GetFileMagicString();
-	buffer.WriteBytes(magicString, static_cast<int>(strlen(magicString)));
-	buffer.WriteInt(AiControllerManager::GetFileMajorVersion());
-	buffer.WriteInt(AiControllerManager::GetFileMinorVersion());
-	buffer.WriteInt(AiControllerManager::GetFileRevisionNumber());
+	NeuralNetPlayerController candidate(m_rand);
+	candidate.SetNetwork(champion);
+	const uint64_t candidateHash = candidate.GetHash();
+	// These games always run to the end, whatever the training games' early end rules are
+	const uint64_t rulesHash = GetGameRulesHash(m_config.m_gameDuration);
 
-	buffer.WriteInt(static_cast<int>(m_controllers.size()));
-	for (const AiControllerData* controller : m_controllers)
+	// Cached results are looked up first, so only games that haven't been played before are
+	// simulated. Results are indexed by (member * 2) + seat.
+	const int numMembers = m_hallOfFame->GetNumMembers();
+	std::vector<MatchResult> results(numMembers * 2);
+	std::vector<int> gamesToPlay;
+	std::vector<NeuralNetPlayerController*> members(numMembers, nullptr);
+	Network memberNetwork;
+	for (int i = 0; i < numMembers; i++)
 	{
-		controller->Serialize(buffer);
+		for (int seat = 0; seat < 2; seat++)
+		{
+			if (!m_hallOfFame->TryGetResult(candidateHash, i, seat, rulesHash, results[(i * 2) + seat]))
+			{
+				if (members[i] == nullptr)
+				{
+					m_hallOfFame->GetNetwork(i, memberNetwork);
+					members[i] = new NeuralNetPlayerController(m_rand);
+					members[i]->SetNetwork(memberNetwork);
+				}
+				gamesToPlay.push_back((i * 2) + seat);
+			}
+		}
+	}
+
+	// The controllers are only read while playing, so they can be in several games at once, the
+	// same as in UpdateParallel()
+	const int numGamesPlayed = static_cast<int>(gamesToPlay.size());
+	const auto playGame = [&](const int jobIndex, NeuronGame& game)
+	{
+		// Each job writes to its own result, so no locking is needed
+		const int gameIndex = gamesToPlay[jobIndex];
+		NeuralNetPlayerController* member = members[gameIndex / 2];
+		results[gameIndex] = ((gameIndex % 2) == 0) ?
+			PlayHeadlessGame(game, m_config.m_gameDuration, &candidate, member) :
+			PlayHeadlessGame(game, m_config.m_gameDuration, member, &candidate);
+	};
+	if (m_threadPool != nullptr)
+	{
+		// m_workerGames end early, so these get games of their own
+		_ASSERT(!m_threadPool->IsBusy());
+		std::vector<NeuronGame> games(m_threadPool->GetNumThreads());
+		m_threadPool->ParallelFor(numGamesPlayed, [&](const int jobIndex, const int threadIndex)
+			{
+				playGame(jobIndex, games[threadIndex]);
+			});
+	}
+	else
+	{
+		NeuronGame game;
+		for (int i = 0; i < numGamesPlayed; i++)
+		{
+			playGame(i, game);
+		}
+	}
+
+	for (const int gameIndex : gamesToPlay)
+	{
+		m_hallOfFame->StoreResult(candidateHash, gameIndex / 2, gameIndex % 2, rulesHash, results[gameIndex]);
+	}
+	for (NeuralNetPlayerController* member : members)
+	{
+		delete member;
 	}
 
-	auto file = std::fstream(outputFileName, std::ios::out | std::ios::binary);
-	file.write(buffer.GetPtr(), buffer.GetCurrent());
-	file.close();
+	WinLossRecord record;
+	for (int i = 0; i < numMembers; i++)
+	{
+		for (int seat = 0; seat < 2; seat++)
+		{
+			const MatchResult& result = results[(i * 2) + seat];
+			record.AddResult(result.m_scores[seat], result.m_scores[1 - seat]);
+		}
+	}
+
+	if (record.GetNumGames() > 0)
+	{
+		char msg[256];
+		sprintf_s(msg, "Hall of fame: champion scored %.1f%% (%d/%d/%d) against %d members, %d of %d games played\n",
+			(100.0f * record.GetPoints()) / (record.GetNumGames() * k_pointsForWin),
+			record.m_wins,
+			record.m_losses,
+			record.m_ties,
+			m_hallOfFame->GetNumMembers(),
+			numGamesPlayed,
+			record.GetNumGames()
+		);
+		OutputDebugStringA(msg);
+	}
+
+	if ((m_generation % m_config.m_hallOfFameEveryNGenerations) == 0)
+	{
+		m_hallOfFame->Add(champion, m_generation);
+	}
+}
+
+void AiPlayerTrainer::SampleProbeState(const NeuronGame& game)
+{
+	// One state per second of game time, alternating between the players' points of view
+	constexpr int k_ticksPerProbeState = 60;
+	if ((m_probeStateTick++ % k_ticksPerProbeState) != 0)
+	{
+		return;
+	}
+
+	const int playerIndex = (m_probeStateTick / k_ticksPerProbeState) % NeuronGame::GetNumPlayers();
+	const GameStateForNeuralNetInput state(game, playerIndex);
+	m_probeStates.insert(m_probeStates.end(), state.GetState(), state.GetState() + GameStateForNeuralNetInput::k_numGameStateInputs);
+	if (static_cast<int>(m_probeStates.size()) >= m_config.m_surrogateProbeStates * GameStateForNeuralNetInput::k_numGameStateInputs)
+	{
+		m_surrogate->SetProbeStates(m_probeStates, GameStateForNeuralNetInput::k_numGameStateInputs);
+		m_probeStates.clear();
+	}
+}
+
+void AiPlayerTrainer::UpdateSurrogate()
+{
+	char msg[256];
+	if (!m_surrogatePredictions.empty())
+	{
+		const int numChildren = static_cast<int>(m_surrogatePredictions.size());
+		std::vector<float> predicted(numChildren);
+		std::vector<float> actual(numChildren);
+		float totalError = 0.0f;
+		for (int i = 0; i < numChildren; i++)
+		{
+			predicted[i] = m_surrogatePredictions[i].second;
+			actual[i] = GetSelectionScore(*m_surrogatePredictions[i].first);
+			totalError += Math::Abs(predicted[i] - actual[i]);
+		}
+
+		// Every candidate that was screened out would have needed a controller's share of the games
+		const int numScreenedOut = m_surrogateCandidatesThisGeneration - numChildren;
+		sprintf_s(msg, "Surrogate: rank correlation %.2f, mean error %.3f over %d children. %d candidates screened out, saving about %d games\n",
+			FitnessSurrogate::ComputeRankCorrelation(predicted, actual),
+			totalError / numChildren,
+			numChildren,
+			numScreenedOut,
+			numScreenedOut * m_config.m_numGameSeasons
+		);
+		OutputDebugStringA(msg);
+	}
+	m_surrogatePredictions.clear();
+	m_surrogateCandidatesThisGeneration = 0;
+
+	if (m_surrogate->GetNumProbeStates() > 0)
+	{
+		std::vector<float> behavior;
+		for (const AiControllerData* controller : m_controllers)
+		{
+			m_surrogate->ComputeBehavior(*controller->m_controller->DebugGetNetwork(), behavior);
+			m_surrogate->AddSample(behavior, GetSelectionScore(*controller));
+		}
+	}
+}
+
+void AiPlayerTrainer::WriteControllersToFile(const char* outputFileName) const
+{
+	AiControllerManager::WriteControllersToFile(outputFileName, m_controllers, m_hallOfFame);
 }
 
 
@@ -334,12 +1493,21 @@ bool AiPlayerTrainer::ReadControllersFromFile(const char* inputFileName, int gen
 		{
 			controller = new AiControllerData(m_rand);
 		}
-		controller->Deserialize(buffer);
+		controller->Deserialize(buffer, fileRevisionNumber);
+	}
+
+	// The hall of fame was added in revision 2
+	if ((fileRevisionNumber >= 2) && (m_hallOfFame != nullptr))
+	{
+		m_hallOfFame->Deserialize(buffer);
 	}
 
 	const bool success = buffer.GetErrorStatus() == BinaryBuffer::ErrorStatus::NoError;
 	_ASSERT(success);
 
+	// The number of controllers may have changed
+	StartEvaluation();
+
 	return success;
 }
 
@@ -350,16 +1518,18 @@ AiControllerData* AiPlayerTrainer::GetAiController(int index)
 
 AiControllerData* AiPlayerTrainer::GetBestAiController()
 {
+	// By selection score rather than total points, since in steady state mode older controllers
+	// have played more games
 	AiControllerData* bestController = nullptr;
-	int bestPoints = 0;
+	float bestScore = 0.0f;
 
 	for (AiControllerData* controller : m_controllers)
 	{
-		const int controllerPoints = controller->m_winLossRecord.GetPoints();
-		if ((bestController == nullptr) || (controllerPoints > bestPoints))
+		const float controllerScore = GetSelectionScore(*controller);
+		if ((bestController == nullptr) || (controllerScore > bestScore))
 		{
 			bestController = controller;
-			bestPoints = controllerPoints;
+			bestScore = controllerScore;
 		}
 	}
 	return bestController;
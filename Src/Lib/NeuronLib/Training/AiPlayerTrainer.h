@@ -1,11 +1,27 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include "Matchmaker.h"
+#include "NeuronBall/NeuronGame.h"
 #include "Util/Random.h"
 #include <vector>
 
 class AiControllerData;
+class EvaluationScheduler;
+class FitnessSurrogate;
 class GameSeason;
-class NeuronGame;
+class GameStats;
+class HallOfFame;
+class MatchResult;
+class MatchResultCache;
+class Network;
+class NeuralNetPlayerController;
+class ScriptedPlayerController;
+class Speciation;
+class SteadyStateEvolution;
+class ThreadPool;
+class WinLossRecord;
 
 class AiPlayerTrainer
 {
@@ -17,7 +33,14 @@ public:
 		int m_numControllers = 16;
 		// How many seasons to run. Each season has controllers play two games.
 		int m_numGameSeasons = 1;
+		// How controllers are paired up. Other than RoundRobin, each season is split into two
+		// rounds, and each round is paired using the results of the rounds before it. Works best with
+		// m_useRatings, since points per game don't account for the strength of the opponents.
+		MatchmakingStrategy m_matchmaking = MatchmakingStrategy::RoundRobin;
 		float m_gameDuration = 60.0f;
+		// Ends population games early once the result is clear or nothing is happening. Gating and
+		// benchmark games always play out in full.
+		EarlyEndRules m_earlyEndRules;
 
 		float m_percentToKeep = 0.2f;
 		//float m_mutationRate = 0.01f;
@@ -25,6 +48,86 @@ public:
 		int m_numGenerations = 10;
 		int m_saveEveryNGenerations = 100;
 		const char* m_saveFile = nullptr;
+
+		// Maximum number of match results remembered across generations.
+		// Games are deterministic, so a rematch between identical networks can reuse the old result.
+		// Set to 0 to disable the cache.
+		int m_matchCacheCapacity = 1024 * 64;
+
+		// Number of species to split the population into. Controllers are only replaced by children
+		// of survivors from their own species, which protects new ideas from being wiped out by
+		// better tuned ones before they get a chance to improve. Set to 0 to disable speciation.
+		int m_targetNumSpecies = 0;
+		// Species whose best score hasn't improved in this many generations no longer get survivors
+		int m_speciesStagnationLimit = 15;
+
+		// Rank controllers by both score and evaluation cost (multiply-adds per Evaluate) with
+		// NSGA-II, instead of by score alone. Survivors are picked from the best Pareto fronts, so the
+		// population moves toward controllers that are both strong and cheap to simulate. Not used in
+		// steady state mode.
+		bool m_paretoSelection = false;
+
+		// Evaluate controllers in rounds, and stop playing games with controllers that are clearly
+		// going to survive or clearly going to be replaced. The rest of the games go to controllers
+		// near the cut line. Racing never plays more games than m_numGameSeasons would.
+		bool m_racing = false;
+		int m_racingGamesPerRound = 1;
+		// At most this fraction of the controllers still racing are eliminated each round
+		float m_racingEliminationFraction = 0.5f;
+		// Width of the confidence interval used to decide a controller is clearly in or out, in
+		// standard errors. 0 always eliminates the bottom fraction (plain successive halving).
+		float m_racingConfidence = 2.0f;
+
+		// Rank controllers by a Glicko rating that persists across generations, instead of by this
+		// generation's points. When racing, controllers with established ratings are decided after a
+		// few games, so most of the games go to new children.
+		bool m_useRatings = false;
+		// Rating deviation of new children. Children start at their parent's rating.
+		float m_childRatingDeviation = 200.0f;
+		// Added to every rating deviation each generation, since the population keeps changing
+		float m_ratingDeviationPerGeneration = 30.0f;
+
+		// Play each round of games on m_numThreads worker threads, each with its own game, instead of
+		// one game at a time. Results are recorded in schedule order once the whole round is done, so
+		// training goes exactly as if the games were played one by one. The current game only shows
+		// what the population is doing. Not used in steady state mode.
+		bool m_parallelGames = false;
+
+		// Replace controllers one at a time as results come in, instead of a generation at a time.
+		// Games are played continuously on worker threads, and the current game only shows what
+		// the population is doing. A generation is counted every m_numControllers replacements.
+		// Speciation isn't used in this mode.
+		bool m_steadyState = false;
+		// Worker threads used in steady state mode and for parallel games. 0 uses one per hardware thread.
+		int m_numThreads = 0;
+		// Controllers must play this many games before they can be replaced or chosen as a parent
+		int m_minGamesBeforeReplacement = 8;
+
+		// Number of past champions kept in the hall of fame. Every generation the champion plays
+		// each member in both seats, and its score is a measure of progress that doesn't depend on
+		// the current population. The hall of fame is saved with the controllers. Set to 0 to disable.
+		int m_hallOfFameSize = 0;
+		// The champion joins the hall of fame every this many generations
+		int m_hallOfFameEveryNGenerations = 10;
+
+		// Breed this many candidates for each child, and only keep the one a surrogate model predicts
+		// will score best, so fewer games are spent on bad mutations. The surrogate learns from the
+		// results of every generation, so screening starts in the second generation. Set to 0 or 1 to
+		// disable. Not used in steady state mode.
+		int m_surrogateCandidatesPerChild = 0;
+		// Game states, sampled from the first generation's games, that describe each network's behavior
+		int m_surrogateProbeStates = 64;
+
+		// Before a child joins the population, it plays a short game in each seat against the weakest
+		// scripted opponent, and is bred again if it can't outscore it, up to this many times. Only
+		// children of parents that pass are tested, so it starts once the population can score, and
+		// then catches children that lost the ability for the cost of two short games. Set to 0 to
+		// disable. Not used in steady state mode.
+		int m_gatingAttempts = 0;
+		float m_gatingGameDuration = 10.0f;
+		// Every generation the champion plays each scripted opponent in both seats. The opponents
+		// never change, so the results are a fixed measure of progress. Not used in steady state mode.
+		bool m_scriptedBaselines = false;
 	};
 
 	AiPlayerTrainer(const Config& config);
@@ -32,8 +135,9 @@ public:
 
 	void Update();
 
-	int GetNumGames() const { return static_cast<int>(1); }
-	const NeuronGame* GetGame(const int index) { return m_currentGame; }
+	// The game to display. With parallel games or steady state, training games are played on worker
+	// threads, and this one only shows what the population is doing.
+	const NeuronGame* GetGame() const { return m_currentGame; }
 
 	// TODO: Should this be public???
 	// TODO: The entire managment of saving and loading AIControllers should be rethought and refactored
@@ -44,14 +148,72 @@ public:
 
 private:
 	void PrepareNextGeneration();
+	// Schedules the next round, or prepares the next generation if evaluation is complete
+	void FinishRound();
+	// Update for parallel games. Starts the next round whenever the last one is done, and plays the
+	// showcase game in the meantime.
+	void UpdateParallel();
+	// Plays the games in the current round that aren't in the match cache on the thread pool
+	void StartParallelRound();
+	// Records the results of the round in schedule order. Expects the thread pool to be idle.
+	void FinishParallelRound();
+	// Update for steady state mode. Plays the showcase game and reports progress.
+	void UpdateSteadyState();
+	void ReportSteadyStateGeneration();
 	void WriteControllersToFile(const char* outputFileName) const;
 
+	// Sorts m_controllers from best to worst
+	void SortControllers();
+	// Replace the worst controllers with children of the best ones. Expects m_controllers to be sorted.
+	void BreedFromBest();
+	// Same as BreedFromBest, but survivors are picked and children are bred within each species
+	void BreedWithinSpecies();
+
+	// Checks the match cache for the result of the given game. Returns true if the game can be skipped.
+	bool TryGetCachedResult(const GameStats& stats, int& outP0Score, int& outP1Score);
+	// Adds the result of a game to the controllers' win/loss records
+	void RecordGameResult(const GameStats& stats, const int p0Score, const int p1Score);
+	// Moves on to the next game in the season, starting the next generation if the season is over
+	void AdvanceToNextGame();
+	// Starts evaluating the current controllers. Only needed when racing or matchmaking.
+	void StartEvaluation();
+	// Replaces the season with the next round of games. Returns false if evaluation is complete.
+	bool ScheduleNextRound();
+	// Current strength estimate of every controller
+	void GetEstimates(std::vector<EvaluationScheduler::Estimate>& outEstimates) const;
+	// Hash of all the game settings that can influence the result of a match
+	uint64_t GetGameRulesHash() const { return GetGameRulesHash(m_config.m_gameDuration, m_config.m_earlyEndRules); }
+	static uint64_t GetGameRulesHash(const float gameDuration, const EarlyEndRules& earlyEndRules = EarlyEndRules());
+	// Score used to pick survivors. Higher is better.
+	float GetSelectionScore(const AiControllerData& controller) const;
+	// Cost of evaluating a controller's network once, in multiply-adds. Lower is better.
+	static float GetEvaluationCost(const AiControllerData& controller);
+	// Gives a child of 'parent' a new network and updates its history to match
+	void BreedChild(AiControllerData& child, const AiControllerData& parent);
+	// Breeds a new network for 'child', screened by the surrogate if it's ready. Returns true and the
+	// predicted score if it was screened.
+	bool BreedNetwork(AiControllerData& child, const AiControllerData& parent, float& outPrediction);
+	// Whether 'controller' outscores the weakest scripted opponent over a short game in each seat
+	bool PassesGate(NeuralNetPlayerController& controller);
+	// Plays 'controller' against a scripted opponent in both seats, reusing cached results. Returns
+	// the controller's record, and adds the games that had to be simulated to 'ioNumGamesPlayed'.
+	WinLossRecord PlayScriptedOpponent(NeuralNetPlayerController& controller, ScriptedPlayerController& opponent, const float gameDuration, int& outGoalDifference, int& ioNumGamesPlayed);
+	// Reports the champion's results against every scripted opponent
+	void ReportScriptedBaselines(NeuralNetPlayerController& champion);
+	// Benchmarks the champion against the hall of fame, then adds it if it's time for a new member.
+	// The games are shared between the workers when there are any.
+	void UpdateHallOfFame(const Network& champion);
+	// Keeps some of the states from the current game as the surrogate's probe states, until there are enough
+	void SampleProbeState(const NeuronGame& game);
+	// Reports how well the surrogate predicted this generation's children, then learns from the results
+	void UpdateSurrogate();
+
 private:
 	const Config m_config;
 	Random m_rand;
 
-	// Actively running game
-	// TODO: Make this a list of games and run them concurrently on different threads
+	// Game played on this thread. Training games when games are played one at a time, otherwise a
+	// showcase. See m_workerGames.
 	NeuronGame* m_currentGame = nullptr;
 
 	// Current AI controllers being trained
@@ -59,6 +221,57 @@ private:
 
 	GameSeason* m_season = nullptr;
 	int m_currentGameInSeason = 0;
+	int m_gamesThisGeneration = 0;
+
+	// Only created when racing
+	EvaluationScheduler* m_evaluationScheduler = nullptr;
+	// Only created when not using MatchmakingStrategy::RoundRobin
+	IMatchmaker* m_matchmaker = nullptr;
+	int m_matchmakingRound = 0;
+
+	// Results of previously played games, persisted across generations
+	MatchResultCache* m_matchCache = nullptr;
+	int m_cacheLookupsThisGeneration = 0;
+	int m_cacheHitsThisGeneration = 0;
+
+	// Only created when speciation is enabled
+	Speciation* m_speciation = nullptr;
+
+	// Only created when m_hallOfFameSize is set
+	HallOfFame* m_hallOfFame = nullptr;
+
+	// Only created when m_surrogateCandidatesPerChild is more than 1
+	FitnessSurrogate* m_surrogate = nullptr;
+	std::vector<float> m_probeStates;
+	int m_probeStateTick = 0;
+	// Children bred this generation and the score the surrogate predicted for them
+	std::vector<std::pair<const AiControllerData*, float>> m_surrogatePredictions;
+	int m_surrogateCandidatesThisGeneration = 0;
+
+	// Only created when gating or m_scriptedBaselines is set. Ordered from weakest to strongest.
+	std::vector<ScriptedPlayerController*> m_scriptedOpponents;
+	int m_gatedChildrenThisGeneration = 0;
+	int m_gatingRejectionsThisGeneration = 0;
+	int m_gatingGamesThisGeneration = 0;
+
+	// Only created when m_parallelGames is set
+	ThreadPool* m_threadPool = nullptr;
+	// One game for each worker thread
+	std::vector<NeuronGame*> m_workerGames;
+	bool m_isRoundRunning = false;
+	// Result of every game in the current round, and the games that had to be simulated
+	std::vector<MatchResult> m_roundResults;
+	std::vector<int> m_roundGamesToPlay;
+	std::chrono::steady_clock::time_point m_roundStartTime;
+	// Game in the current round being shown by m_currentGame
+	int m_showcaseGameIndex = 0;
+	int m_parallelGamesThisGeneration = 0;
+	double m_parallelSecondsThisGeneration = 0.0;
+
+	// Only created in steady state mode
+	SteadyStateEvolution* m_steadyState = nullptr;
+	// Copies of the controllers in the showcase game, since the originals can be replaced at any time
+	NeuralNetPlayerController* m_showcaseControllers[2] = { nullptr, nullptr };
 
 	int m_generation = 0;
 };
@@ -0,0 +1,139 @@
+#include "pch.h"
+#include "DemonstrationFile.h"
+
+#include "NeuralNet/BackpropTrainer.h"
+#include <windows.h> // for memory mapped files
+
+
+DemonstrationFile::~DemonstrationFile()
+{
+	Close();
+}
+
+bool DemonstrationFile::Open(const char* filename)
+{
+	Close();
+	if (filename == nullptr)
+	{
+		return false;
+	}
+
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	m_file = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart < static_cast<LONGLONG>(sizeof(DemonstrationFileHeader))))
+	{
+		Close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+	m_view = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if ((m_view == nullptr) || !ReadChunks(fileSize.QuadPart))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void DemonstrationFile::Close()
+{
+	if (m_view != nullptr)
+	{
+		UnmapViewOfFile(m_view);
+		m_view = nullptr;
+	}
+	if (m_mapping != nullptr)
+	{
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+	}
+	if (m_file != nullptr)
+	{
+		CloseHandle(m_file);
+		m_file = nullptr;
+	}
+	m_header = DemonstrationFileHeader();
+	m_chunks.clear();
+	m_numRows = 0;
+}
+
+void DemonstrationFile::AppendTo(TrainingSet& outData) const
+{
+	const int numObservations = GetNumObservationColumns();
+	const int numActions = GetNumActionColumns();
+	_ASSERT(outData.GetNumInputs() == numObservations);
+	_ASSERT(outData.GetNumOutputs() == numActions);
+
+	// The training set stores rows, so each row is gathered from the columns
+	std::vector<float> observation(numObservations);
+	std::vector<float> action(numActions);
+	outData.Reserve(outData.GetNumSamples() + static_cast<int>(m_numRows));
+	for (const Chunk& chunk : m_chunks)
+	{
+		for (int row = 0; row < chunk.m_numRows; row++)
+		{
+			for (int c = 0; c < numObservations; c++)
+			{
+				observation[c] = chunk.GetColumn(c)[row];
+			}
+			for (int c = 0; c < numActions; c++)
+			{
+				action[c] = chunk.GetColumn(numObservations + c)[row];
+			}
+			outData.AddSample(observation.data(), action.data());
+		}
+	}
+}
+
+bool DemonstrationFile::ReadChunks(const int64_t fileSize)
+{
+	memcpy(&m_header, m_view, sizeof(m_header));
+	if ((memcmp(m_header.m_magic, DemonstrationFileHeader::k_magic, sizeof(m_header.m_magic)) != 0) ||
+		(m_header.m_version != DemonstrationFileHeader::k_version))
+	{
+		return false;
+	}
+
+	int64_t offset = sizeof(DemonstrationFileHeader);
+	while (offset + static_cast<int64_t>(sizeof(DemonstrationChunkHeader)) <= fileSize)
+	{
+		DemonstrationChunkHeader chunkHeader;
+		memcpy(&chunkHeader, m_view + offset, sizeof(chunkHeader));
+		if ((memcmp(chunkHeader.m_magic, DemonstrationChunkHeader::k_magic, sizeof(chunkHeader.m_magic)) != 0) ||
+			(chunkHeader.m_numColumns != GetNumColumns()) ||
+			(chunkHeader.m_numRows < 0) ||
+			(chunkHeader.m_rowStride < chunkHeader.m_numRows))
+		{
+			// Not a chunk, so nothing after this can be trusted
+			break;
+		}
+
+		const int64_t chunkSize = sizeof(DemonstrationChunkHeader) + (static_cast<int64_t>(chunkHeader.m_rowStride) * chunkHeader.m_numColumns * sizeof(float));
+		if (offset + chunkSize > fileSize)
+		{
+			// Cut short while it was being written
+			break;
+		}
+
+		Chunk chunk;
+		chunk.m_numRows = chunkHeader.m_numRows;
+		chunk.m_rowStride = chunkHeader.m_rowStride;
+		chunk.m_columns = reinterpret_cast<const float*>(m_view + offset + sizeof(DemonstrationChunkHeader));
+		m_chunks.push_back(chunk);
+		m_numRows += chunk.m_numRows;
+		offset += chunkSize;
+	}
+	return true;
+}
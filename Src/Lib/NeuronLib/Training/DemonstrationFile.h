@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class TrainingSet;
+
+// Behavior cloning data: what a player saw and what it did, one row per player per tick
+//
+// File layout:
+//   File header (16 bytes)
+//   Chunks, one after another, each one made of
+//     Chunk header (16 bytes)
+//     Columns, each one 'row stride' float32 values, of which the first 'number of rows' are used
+//
+// The columns are the observation (GameStateForNeuralNetInput) followed by the action
+// (NeuronPlayerInput). Storing each column contiguously keeps the file compact and lets a column
+// be used straight from the file. The row stride is a multiple of 4, so with 16 byte headers every
+// column starts 16 byte aligned.
+//
+// Files are append-only. Recording more data adds chunks to the end, and since a chunk is only
+// useful once it's complete, a chunk cut short (eg. by a crash) is ignored when reading.
+class DemonstrationFileHeader
+{
+public:
+	static constexpr char k_magic[4] = { 'p', 'c', 'B', 'C' };
+	static constexpr int k_version = 1;
+
+	char m_magic[4] = { k_magic[0], k_magic[1], k_magic[2], k_magic[3] };
+	int m_version = k_version;
+	int m_numObservationColumns = 0;
+	int m_numActionColumns = 0;
+};
+
+class DemonstrationChunkHeader
+{
+public:
+	static constexpr char k_magic[4] = { 'c', 'h', 'n', 'k' };
+
+	char m_magic[4] = { k_magic[0], k_magic[1], k_magic[2], k_magic[3] };
+	int m_numRows = 0;
+	int m_rowStride = 0;
+	int m_numColumns = 0;
+};
+
+static_assert(sizeof(DemonstrationFileHeader) == 16, "Headers must keep the columns 16 byte aligned");
+static_assert(sizeof(DemonstrationChunkHeader) == 16, "Headers must keep the columns 16 byte aligned");
+
+// Memory mapped view of a demonstration file
+// Opening a file only maps it and reads the chunk headers, so even millions of rows are ready
+// immediately. The data is paged in by the OS as it's used.
+class DemonstrationFile
+{
+public:
+	class Chunk
+	{
+	public:
+		const float* GetColumn(const int columnIndex) const { return m_columns + (static_cast<size_t>(columnIndex) * m_rowStride); }
+
+	public:
+		int m_numRows = 0;
+		int m_rowStride = 0;
+		const float* m_columns = nullptr;
+	};
+
+	DemonstrationFile() {}
+	~DemonstrationFile();
+
+	// Maps the file and finds its chunks. Returns false if the file can't be opened or isn't a
+	// demonstration file.
+	bool Open(const char* filename);
+	void Close();
+	bool IsOpen() const { return m_view != nullptr; }
+
+	int GetNumObservationColumns() const { return m_header.m_numObservationColumns; }
+	int GetNumActionColumns() const { return m_header.m_numActionColumns; }
+	int GetNumColumns() const { return m_header.m_numObservationColumns + m_header.m_numActionColumns; }
+	int64_t GetNumRows() const { return m_numRows; }
+	int GetNumChunks() const { return static_cast<int>(m_chunks.size()); }
+	const Chunk& GetChunk(const int chunkIndex) const { return m_chunks[chunkIndex]; }
+
+	// Adds every row to 'outData', with the observation as the inputs and the action as the targets
+	void AppendTo(TrainingSet& outData) const;
+
+private:
+	// Finds the chunks in the mapped file
+	bool ReadChunks(const int64_t fileSize);
+
+private:
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+	const char* m_view = nullptr;
+
+	DemonstrationFileHeader m_header;
+	std::vector<Chunk> m_chunks;
+	int64_t m_numRows = 0;
+};
@@ -0,0 +1,254 @@
+#include "pch.h"
+#include "DemonstrationRecorder.h"
+
+#include <cstring>
+#include "DemonstrationFile.h"
+#include <filesystem>
+#include "NeuronBall/GameStateForNeuralNetInput.h"
+#include "NeuronBall/NeuronPlayerInput.h"
+
+DemonstrationRecorder::DemonstrationRecorder(const Config& config) :
+	m_config(config),
+	m_rowStride((config.m_rowsPerChunk + 3) & ~3)
+{
+	_ASSERT(m_config.m_rowsPerChunk > 0);
+}
+
+DemonstrationRecorder::~DemonstrationRecorder()
+{
+	Close();
+	delete m_currentChunk;
+	for (Chunk* chunk : m_freeChunks)
+	{
+		delete chunk;
+	}
+}
+
+bool DemonstrationRecorder::Open(const char* filename)
+{
+	Close();
+	if (filename == nullptr)
+	{
+		return false;
+	}
+
+	int64_t endOfData = 0;
+	{
+		std::ifstream inFile(filename, std::ios::binary);
+		if (inFile.is_open() && !FindEndOfData(inFile, endOfData))
+		{
+			return false;
+		}
+	}
+
+	std::error_code error;
+	if ((endOfData > 0) && (static_cast<int64_t>(std::filesystem::file_size(filename, error)) > endOfData))
+	{
+		// A chunk was cut short. Nothing added after it could be read, so throw it away.
+		std::filesystem::resize_file(filename, endOfData, error);
+		if (error)
+		{
+			return false;
+		}
+	}
+
+	m_file.open(filename, std::ios::binary | std::ios::app);
+	if (!m_file.is_open())
+	{
+		return false;
+	}
+	if (endOfData == 0)
+	{
+		DemonstrationFileHeader header;
+		header.m_numObservationColumns = GetNumObservationColumns();
+		header.m_numActionColumns = k_numActionColumns;
+		m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		m_file.flush();
+	}
+
+	m_stopWriter = false;
+	m_writer = std::thread(&DemonstrationRecorder::WriterThread, this);
+	return true;
+}
+
+void DemonstrationRecorder::Close()
+{
+	if (!m_file.is_open())
+	{
+		return;
+	}
+
+	if ((m_currentChunk != nullptr) && (m_currentChunk->m_numRows > 0))
+	{
+		SubmitChunk(m_currentChunk);
+		m_currentChunk = nullptr;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopWriter = true;
+	}
+	m_condition.notify_one();
+	m_writer.join();
+	m_file.close();
+}
+
+//static
+int DemonstrationRecorder::GetNumObservationColumns()
+{
+	return GameStateForNeuralNetInput::k_numGameStateInputs;
+}
+
+bool DemonstrationRecorder::ShouldRecordPlayer(const int playerIndex) const
+{
+	return IsOpen() && ((m_config.m_playerIndex < 0) || (m_config.m_playerIndex == playerIndex));
+}
+
+void DemonstrationRecorder::Record(const float* observation, const NeuronPlayerInput& action)
+{
+	_ASSERT(IsOpen());
+	if (m_currentChunk == nullptr)
+	{
+		m_currentChunk = GetFreeChunk();
+	}
+
+	const int numObservations = GetNumObservationColumns();
+	const int row = m_currentChunk->m_numRows;
+	float* columns = m_currentChunk->m_columns.data();
+	for (int c = 0; c < numObservations; c++)
+	{
+		columns[(c * m_rowStride) + row] = observation[c];
+	}
+	columns[((numObservations + 0) * m_rowStride) + row] = action.m_steering;
+	columns[((numObservations + 1) * m_rowStride) + row] = action.m_speed;
+	columns[((numObservations + 2) * m_rowStride) + row] = action.m_boost;
+	m_currentChunk->m_numRows++;
+	m_numRowsRecorded++;
+
+	if (m_currentChunk->m_numRows == m_config.m_rowsPerChunk)
+	{
+		SubmitChunk(m_currentChunk);
+		m_currentChunk = nullptr;
+	}
+}
+
+//static
+bool DemonstrationRecorder::FindEndOfData(std::ifstream& file, int64_t& outEndOfData)
+{
+	outEndOfData = 0;
+	file.seekg(0, std::ios::end);
+	const int64_t fileSize = file.tellg();
+	file.seekg(0, std::ios::beg);
+	if (fileSize < static_cast<int64_t>(sizeof(DemonstrationFileHeader)))
+	{
+		// Empty, so it can be written from the start
+		return fileSize == 0;
+	}
+
+	DemonstrationFileHeader header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if ((memcmp(header.m_magic, DemonstrationFileHeader::k_magic, sizeof(header.m_magic)) != 0) ||
+		(header.m_version != DemonstrationFileHeader::k_version) ||
+		(header.m_numObservationColumns != GetNumObservationColumns()) ||
+		(header.m_numActionColumns != k_numActionColumns))
+	{
+		return false;
+	}
+
+	// Skip over the complete chunks, the same way DemonstrationFile reads them
+	const int numColumns = header.m_numObservationColumns + header.m_numActionColumns;
+	int64_t offset = sizeof(DemonstrationFileHeader);
+	while (offset + static_cast<int64_t>(sizeof(DemonstrationChunkHeader)) <= fileSize)
+	{
+		DemonstrationChunkHeader chunkHeader;
+		file.seekg(offset);
+		file.read(reinterpret_cast<char*>(&chunkHeader), sizeof(chunkHeader));
+		if ((memcmp(chunkHeader.m_magic, DemonstrationChunkHeader::k_magic, sizeof(chunkHeader.m_magic)) != 0) ||
+			(chunkHeader.m_numColumns != numColumns) ||
+			(chunkHeader.m_numRows < 0) ||
+			(chunkHeader.m_rowStride < chunkHeader.m_numRows))
+		{
+			break;
+		}
+
+		const int64_t chunkSize = sizeof(DemonstrationChunkHeader) + (static_cast<int64_t>(chunkHeader.m_rowStride) * numColumns * sizeof(float));
+		if (offset + chunkSize > fileSize)
+		{
+			break;
+		}
+		offset += chunkSize;
+	}
+	outEndOfData = offset;
+	return true;
+}
+
+DemonstrationRecorder::Chunk* DemonstrationRecorder::GetFreeChunk()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_freeChunks.empty())
+		{
+			Chunk* chunk = m_freeChunks.back();
+			m_freeChunks.pop_back();
+			chunk->m_numRows = 0;
+			return chunk;
+		}
+	}
+
+	Chunk* chunk = new Chunk();
+	chunk->m_columns.resize(static_cast<size_t>(m_rowStride) * (GetNumObservationColumns() + k_numActionColumns));
+	return chunk;
+}
+
+void DemonstrationRecorder::SubmitChunk(Chunk* chunk)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pendingChunks.push_back(chunk);
+	}
+	m_condition.notify_one();
+}
+
+void DemonstrationRecorder::WriterThread()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_condition.wait(lock, [this] { return m_stopWriter || !m_pendingChunks.empty(); });
+		if (m_pendingChunks.empty())
+		{
+			// Stopping, and everything has been written
+			return;
+		}
+
+		Chunk* chunk = m_pendingChunks.front();
+		m_pendingChunks.erase(m_pendingChunks.begin());
+		lock.unlock();
+		WriteChunk(*chunk);
+		lock.lock();
+		m_freeChunks.push_back(chunk);
+	}
+}
+
+void DemonstrationRecorder::WriteChunk(Chunk& chunk)
+{
+	const int numColumns = GetNumObservationColumns() + k_numActionColumns;
+
+	// Only the last chunk isn't full. Pack its columns closer together so it doesn't pad the file.
+	const int rowStride = (chunk.m_numRows + 3) & ~3;
+	if (rowStride < m_rowStride)
+	{
+		float* columns = chunk.m_columns.data();
+		for (int c = 1; c < numColumns; c++)
+		{
+			memmove(columns + (c * rowStride), columns + (c * m_rowStride), chunk.m_numRows * sizeof(float));
+		}
+	}
+
+	DemonstrationChunkHeader header;
+	header.m_numRows = chunk.m_numRows;
+	header.m_rowStride = rowStride;
+	header.m_numColumns = numColumns;
+	m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	m_file.write(reinterpret_cast<const char*>(chunk.m_columns.data()), static_cast<std::streamsize>(rowStride) * numColumns * sizeof(float));
+	m_file.flush();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include "NeuronBall/GameRecorder.h"
+#include <thread>
+#include <vector>
+
+class NeuronPlayerInput;
+
+// Records what players see and what they do to a demonstration file (see DemonstrationFile.h), to
+// train networks that imitate them.
+//
+// Rows are gathered into a chunk in memory, one column at a time. Full chunks are handed to a
+// writer thread, so the game never waits on the disk. Recording into a file that already exists
+// adds to it.
+class DemonstrationRecorder : public IGameRecorder
+{
+public:
+	static constexpr int k_numActionColumns = 3;
+
+	class Config
+	{
+	public:
+		// Rows in each chunk. Rounded up to a multiple of 4.
+		int m_rowsPerChunk = 4096;
+		// Player to record, or -1 to record every player
+		int m_playerIndex = -1;
+	};
+
+	explicit DemonstrationRecorder(const Config& config);
+	~DemonstrationRecorder();
+
+	// Starts recording to 'filename'. Returns false if the file can't be opened, or if it's a
+	// demonstration file with a different number of columns.
+	bool Open(const char* filename);
+	// Writes the rows that have been recorded and waits for the writer to finish
+	void Close();
+	bool IsOpen() const { return m_file.is_open(); }
+
+	static int GetNumObservationColumns();
+	virtual bool ShouldRecordPlayer(const int playerIndex) const override;
+
+	// Adds one row. 'observation' holds GetNumObservationColumns() values.
+	virtual void Record(const float* observation, const NeuronPlayerInput& action) override;
+	int64_t GetNumRowsRecorded() const { return m_numRowsRecorded; }
+
+private:
+	class Chunk
+	{
+	public:
+		std::vector<float> m_columns;
+		int m_numRows = 0;
+	};
+
+	// Finds where the complete chunks in an existing file end, and checks that it has the same columns
+	static bool FindEndOfData(std::ifstream& file, int64_t& outEndOfData);
+	Chunk* GetFreeChunk();
+	void SubmitChunk(Chunk* chunk);
+	void WriterThread();
+	void WriteChunk(Chunk& chunk);
+
+private:
+	const Config m_config;
+	const int m_rowStride;
+	std::ofstream m_file;
+	int64_t m_numRowsRecorded = 0;
+	Chunk* m_currentChunk = nullptr;
+
+	std::thread m_writer;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	// Full chunks waiting to be written, oldest first
+	std::vector<Chunk*> m_pendingChunks;
+	// Chunks that have been written and can be reused
+	std::vector<Chunk*> m_freeChunks;
+	bool m_stopWriter = false;
+};
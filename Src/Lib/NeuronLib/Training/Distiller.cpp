@@ -0,0 +1,282 @@
+#include "pch.h"
+#include "Distiller.h"
+
+#include "DemonstrationFile.h"
+#include "NeuronBall/GameStateForNeuralNetInput.h"
+#include "NeuronBall/NeuronGame.h"
+#include "NeuronBall/NeuronPlayerController.h"
+#include "NeuronBall/NeuronPlayerInput.h"
+#include "Util/Math.h"
+#include "Util/Random.h"
+#include <windows.h> // for OutputDebugString
+
+namespace
+{
+	// Plays a network with noise added to its actions, optionally keeping every observation
+	class NoisyNetworkController : public NeuronPlayerController
+	{
+	public:
+		NoisyNetworkController(const Network& network, Random& rand, const float noise, std::vector<float>* outObservations) :
+			m_network(network),
+			m_rand(rand),
+			m_noise(noise),
+			m_observations(outObservations)
+		{
+		}
+
+		virtual void GetInputFromGameState(NeuronPlayerInput& outPlayerInput, const NeuronGame& game, const int playerIndex) override
+		{
+			GameStateForNeuralNetInput networkInput(game, playerIndex);
+			if (m_observations != nullptr)
+			{
+				const float* state = networkInput.GetState();
+				m_observations->insert(m_observations->end(), state, state + GameStateForNeuralNetInput::k_numGameStateInputs);
+			}
+
+			const std::vector<float> networkOutput = m_network.Evaluate(networkInput.GetStateAsStdVector());
+			_ASSERT(networkOutput.size() == 3); // Network is expected to produce 3 values
+			outPlayerInput.m_steering = networkOutput[0] + (m_rand.NextGaussian() * m_noise);
+			outPlayerInput.m_speed = networkOutput[1] + (m_rand.NextGaussian() * m_noise);
+			outPlayerInput.m_boost = networkOutput[2] + (m_rand.NextGaussian() * m_noise);
+		}
+
+	private:
+		const Network& m_network;
+		Random& m_rand;
+		const float m_noise;
+		std::vector<float>* m_observations;
+	};
+
+	int GetNumOutputs(const Network& network)
+	{
+		return static_cast<int>(network.GetLevel(network.GetNumLevels() - 1).neurons.size());
+	}
+}
+
+
+Distiller::Distiller(const Network& teacher, const Config& config) :
+	m_config(config),
+	m_teacher(teacher),
+	m_data(GameStateForNeuralNetInput::k_numGameStateInputs, GetNumOutputs(teacher))
+{
+	_ASSERT(static_cast<int>(teacher.GetLevel(0).neurons.size()) == GameStateForNeuralNetInput::k_numGameStateInputs);
+}
+
+void Distiller::AddStates(const DemonstrationFile& file)
+{
+	_ASSERT(file.GetNumObservationColumns() == m_data.GetNumInputs());
+	const int numInputs = m_data.GetNumInputs();
+
+	std::vector<float> observations;
+	observations.reserve(static_cast<size_t>(file.GetNumRows()) * numInputs);
+	for (int chunkIndex = 0; chunkIndex < file.GetNumChunks(); chunkIndex++)
+	{
+		const DemonstrationFile::Chunk& chunk = file.GetChunk(chunkIndex);
+		for (int row = 0; row < chunk.m_numRows; row++)
+		{
+			for (int c = 0; c < numInputs; c++)
+			{
+				observations.push_back(chunk.GetColumn(c)[row]);
+			}
+		}
+	}
+	AddObservations(observations);
+}
+
+void Distiller::AddStatesFromSelfPlay(Random& rand)
+{
+	SampleGames(rand, m_config.m_numSelfPlayGames, false);
+}
+
+const Network& Distiller::Run(Random& rand)
+{
+	if (m_data.GetNumSamples() == 0)
+	{
+		AddStatesFromSelfPlay(rand);
+	}
+	ComputeInputScaling();
+
+	std::vector<int> neuronsPerLevel;
+	neuronsPerLevel.push_back(m_data.GetNumInputs());
+	neuronsPerLevel.insert(neuronsPerLevel.end(), m_config.m_studentHiddenLevels.begin(), m_config.m_studentHiddenLevels.end());
+	neuronsPerLevel.push_back(m_data.GetNumOutputs());
+	Network scaledStudent(neuronsPerLevel);
+	scaledStudent.Randomize(rand);
+
+	TrainingSet scaledData(m_data.GetNumInputs(), m_data.GetNumOutputs());
+	BackpropTrainer trainer(scaledStudent, m_config.m_trainer);
+	for (int round = 0; round < m_config.m_numRounds; round++)
+	{
+		if (round > 0)
+		{
+			// The student plays with the scaling folded in, the same way it will be used
+			m_student = scaledStudent;
+			FoldInputScaling(m_student, m_inputMean, m_inputScale);
+			SampleGames(rand, m_config.m_numStudentGamesPerRound, true);
+		}
+		AddScaledSamples(scaledData);
+		for (int epoch = 0; epoch < m_config.m_numEpochsPerRound; epoch++)
+		{
+			trainer.TrainEpoch(scaledData, rand);
+		}
+	}
+	m_loss = trainer.ComputeLoss(scaledData);
+	m_student = scaledStudent;
+	FoldInputScaling(m_student, m_inputMean, m_inputScale);
+
+	char msg[256];
+	sprintf_s(msg, "Distillation: student has %d parameters (teacher %d), loss %.5f over %d states\n",
+		m_student.GetNumParameters(),
+		m_teacher.GetNumParameters(),
+		m_loss,
+		m_data.GetNumSamples()
+	);
+	OutputDebugStringA(msg);
+
+	return m_student;
+}
+
+WinLossRecord Distiller::PlayMatch(Random& rand) const
+{
+	WinLossRecord record;
+	NeuronGame game;
+	for (int gameIndex = 0; gameIndex < m_config.m_numMatchGames; gameIndex++)
+	{
+		NoisyNetworkController student(m_student, rand, m_config.m_matchActionNoise, nullptr);
+		NoisyNetworkController teacher(m_teacher, rand, m_config.m_matchActionNoise, nullptr);
+		const int studentSeat = gameIndex % 2;
+		if (studentSeat == 0)
+		{
+			PlayGame(game, &student, &teacher);
+		}
+		else
+		{
+			PlayGame(game, &teacher, &student);
+		}
+		record.AddResult(game.GetPlayerScore(studentSeat), game.GetPlayerScore(1 - studentSeat));
+	}
+
+	char msg[256];
+	sprintf_s(msg, "Distillation: student scored %.1f%% (%d/%d/%d) against the teacher\n",
+		(record.GetNumGames() > 0) ? (100.0f * record.GetPoints()) / (record.GetNumGames() * k_pointsForWin) : 0.0f,
+		record.m_wins,
+		record.m_losses,
+		record.m_ties
+	);
+	OutputDebugStringA(msg);
+
+	return record;
+}
+
+void Distiller::AddObservations(const std::vector<float>& observations)
+{
+	const int numInputs = m_data.GetNumInputs();
+	const int numObservations = static_cast<int>(observations.size()) / numInputs;
+	m_data.Reserve(m_data.GetNumSamples() + numObservations);
+
+	std::vector<float> inputs(numInputs);
+	for (int i = 0; i < numObservations; i++)
+	{
+		inputs.assign(observations.begin() + (static_cast<size_t>(i) * numInputs), observations.begin() + (static_cast<size_t>(i + 1) * numInputs));
+		const std::vector<float> targets = m_teacher.Evaluate(inputs);
+		m_data.AddSample(inputs.data(), targets.data());
+	}
+}
+
+void Distiller::ComputeInputScaling()
+{
+	const int numInputs = m_data.GetNumInputs();
+	const int numSamples = m_data.GetNumSamples();
+	std::vector<double> sum(numInputs, 0.0);
+	std::vector<double> sumSquares(numInputs, 0.0);
+	for (int i = 0; i < numSamples; i++)
+	{
+		const float* inputs = m_data.GetInputs(i);
+		for (int c = 0; c < numInputs; c++)
+		{
+			sum[c] += inputs[c];
+			sumSquares[c] += static_cast<double>(inputs[c]) * inputs[c];
+		}
+	}
+
+	m_inputMean.assign(numInputs, 0.0f);
+	m_inputScale.assign(numInputs, 1.0f);
+	for (int c = 0; (c < numInputs) && (numSamples > 0); c++)
+	{
+		const double mean = sum[c] / numSamples;
+		const double variance = (sumSquares[c] / numSamples) - (mean * mean);
+		m_inputMean[c] = static_cast<float>(mean);
+		// Inputs that never change (eg. the score in short games) are only centered
+		m_inputScale[c] = (variance > 1e-8) ? static_cast<float>(Math::InvSqrt(variance)) : 1.0f;
+	}
+}
+
+void Distiller::AddScaledSamples(TrainingSet& outData) const
+{
+	const int numInputs = m_data.GetNumInputs();
+	std::vector<float> inputs(numInputs);
+	outData.Reserve(m_data.GetNumSamples());
+	for (int i = outData.GetNumSamples(); i < m_data.GetNumSamples(); i++)
+	{
+		const float* rawInputs = m_data.GetInputs(i);
+		for (int c = 0; c < numInputs; c++)
+		{
+			inputs[c] = (rawInputs[c] - m_inputMean[c]) * m_inputScale[c];
+		}
+		outData.AddSample(inputs.data(), m_data.GetTargets(i));
+	}
+}
+
+//static
+void Distiller::FoldInputScaling(Network& network, const std::vector<float>& mean, const std::vector<float>& scale)
+{
+	// Each neuron in the first level computes b + sum(w * (x - mean) * scale), which is the same as
+	// (b - sum(w * mean * scale)) + sum((w * scale) * x)
+	const int numInputs = static_cast<int>(network.GetLevel(0).neurons.size());
+	_ASSERT((mean.size() == numInputs) && (scale.size() == numInputs));
+	std::vector<float> parameters(network.GetNumParameters());
+	network.GetParameters(parameters.data());
+	const int numNeurons = static_cast<int>(network.GetLevel(1).neurons.size());
+	for (int n = 0; n < numNeurons; n++)
+	{
+		float* weights = &parameters[static_cast<size_t>(n) * (numInputs + 1)];
+		float& bias = weights[numInputs];
+		for (int c = 0; c < numInputs; c++)
+		{
+			weights[c] *= scale[c];
+			bias -= weights[c] * mean[c];
+		}
+	}
+	network.SetParameters(parameters.data());
+}
+
+void Distiller::SampleGames(Random& rand, const int numGames, const bool studentPlays)
+{
+	std::vector<float> observations;
+	NeuronGame game;
+	for (int gameIndex = 0; gameIndex < numGames; gameIndex++)
+	{
+		NoisyNetworkController player(studentPlays ? m_student : m_teacher, rand, m_config.m_actionNoise, &observations);
+		NoisyNetworkController opponent(m_teacher, rand, m_config.m_actionNoise, studentPlays ? nullptr : &observations);
+		if ((gameIndex % 2) == 0)
+		{
+			PlayGame(game, &player, &opponent);
+		}
+		else
+		{
+			PlayGame(game, &opponent, &player);
+		}
+	}
+	AddObservations(observations);
+}
+
+void Distiller::PlayGame(NeuronGame& game, NeuronPlayerController* player0, NeuronPlayerController* player1) const
+{
+	game.ResetGame(m_config.m_gameDuration);
+	game.SetPlayerController(0, player0);
+	game.SetPlayerController(1, player1);
+	while (!game.IsGameOver())
+	{
+		game.Update();
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "AiControllerData.h"
+#include "NeuralNet/BackpropTrainer.h"
+#include "NeuralNet/Network.h"
+#include <vector>
+
+class DemonstrationFile;
+class NeuronGame;
+class NeuronPlayerController;
+class Random;
+
+// Trains a small 'student' network to reproduce the outputs of a large 'teacher' network
+//
+// Mutation only ever grows networks, so a controller that has trained for a long time is expensive
+// to evaluate. A student with a fraction of the parameters can often play almost as well, and is
+// much cheaper to use in big tournaments and interactive play.
+//
+// The student learns from game states labeled with the teacher's outputs. States come from recorded
+// games, or from games the teacher plays against itself with some noise added to its actions so
+// the games don't all play out the same way. A student that isn't perfect will get itself into
+// states the teacher never does, so every round after the first also samples the games the student
+// plays against the teacher, and labels those with what the teacher would have done.
+//
+// Games are deterministic, so the match between the teacher and the student adds a little noise
+// to both players' actions. Otherwise there would only be two different games, one per seat.
+class Distiller
+{
+public:
+	class Config
+	{
+	public:
+		// Neurons in each hidden level of the student. The inputs and outputs match the teacher.
+		std::vector<int> m_studentHiddenLevels = { 8 };
+		float m_gameDuration = 60.0f;
+
+		// Games the teacher plays against itself to sample states, if there are no others
+		int m_numSelfPlayGames = 32;
+		// Standard deviation of the noise added to actions while sampling states
+		float m_actionNoise = 0.1f;
+
+		int m_numRounds = 3;
+		int m_numEpochsPerRound = 20;
+		// Games the student plays against the teacher at the start of each round after the first
+		int m_numStudentGamesPerRound = 16;
+		BackpropTrainer::Config m_trainer;
+
+		// Games in the final match between the teacher and the student, alternating seats
+		int m_numMatchGames = 32;
+		float m_matchActionNoise = 0.05f;
+	};
+
+	Distiller(const Network& teacher, const Config& config);
+
+	// Adds the observations in 'file' as training states, ignoring the recorded actions
+	void AddStates(const DemonstrationFile& file);
+	// Adds the states from games the teacher plays against itself
+	void AddStatesFromSelfPlay(Random& rand);
+
+	// Trains the student from scratch and returns it. Samples self-play games first if no states
+	// have been added.
+	const Network& Run(Random& rand);
+	// Plays the student against the teacher, and returns the student's record
+	WinLossRecord PlayMatch(Random& rand) const;
+
+	const Network& GetStudent() const { return m_student; }
+	int GetNumStates() const { return m_data.GetNumSamples(); }
+	// Average loss over every state after the last round
+	float GetLoss() const { return m_loss; }
+
+	// Changes the first level of 'network' so it gives the same outputs for inputs x as it did for
+	// (x - mean) * scale
+	static void FoldInputScaling(Network& network, const std::vector<float>& mean, const std::vector<float>& scale);
+
+private:
+	// Labels each observation with the teacher's outputs and adds it to the training data
+	void AddObservations(const std::vector<float>& observations);
+	// Plays 'numGames' games with noisy actions and adds the states that are seen. If
+	// 'studentPlays' is set, the student plays the teacher and only the student's states are added.
+	// Otherwise the teacher plays itself.
+	void SampleGames(Random& rand, const int numGames, const bool studentPlays);
+
+	// Game state values are in meters and seconds, far from the range the activation functions
+	// respond to. The student is trained on inputs with zero mean and unit variance, and the scaling
+	// is then folded into its first level so it takes the same inputs as the teacher.
+	void ComputeInputScaling();
+	// Adds the samples that aren't in 'outData' yet, with the inputs scaled
+	void AddScaledSamples(TrainingSet& outData) const;
+	void PlayGame(NeuronGame& game, NeuronPlayerController* player0, NeuronPlayerController* player1) const;
+
+private:
+	const Config m_config;
+	const Network m_teacher;
+	Network m_student;
+	TrainingSet m_data;
+	std::vector<float> m_inputMean;
+	std::vector<float> m_inputScale;
+	float m_loss = 0.0f;
+};
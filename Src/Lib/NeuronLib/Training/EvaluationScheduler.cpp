@@ -0,0 +1,215 @@
+#include "pch.h"
+#include "EvaluationScheduler.h"
+
+#include <algorithm>
+#include "AiControllerData.h"
+#include "Matchmaker.h"
+#include "Rating.h"
+#include "Util/Math.h"
+#include "Util/Random.h"
+
+
+EvaluationScheduler::EvaluationScheduler(const Config& config, IMatchmaker* matchmaker) :
+	m_config(config),
+	m_matchmaker(matchmaker)
+{
+	_ASSERT(config.m_gamesPerRound > 0);
+	_ASSERT((config.m_eliminationFraction > 0.0f) && (config.m_eliminationFraction <= 1.0f));
+}
+
+void EvaluationScheduler::Reset(const int numControllers)
+{
+	m_status.assign(numControllers, Status::Racing);
+	m_round = 0;
+	m_numAccepted = 0;
+	m_numEliminated = 0;
+	if (m_matchmaker != nullptr)
+	{
+		m_matchmaker->Reset(numControllers);
+	}
+}
+
+bool EvaluationScheduler::ScheduleNextRound(const std::vector<Estimate>& estimates, Random& rand, std::vector<Matchup>& outMatchups)
+{
+	_ASSERT(estimates.size() == m_status.size());
+	outMatchups.clear();
+
+	if (m_round > 0)
+	{
+		UpdateRacing(estimates);
+	}
+
+	const int numControllers = static_cast<int>(m_status.size());
+	if ((numControllers < 2) ||
+		(m_round >= m_config.m_maxRounds) ||
+		(GetNumRacing() == 0))
+	{
+		return false;
+	}
+
+	// A lone racer has nobody to be paired with, so it plays random opponents like below
+	if ((m_matchmaker != nullptr) && (GetNumRacing() >= 2))
+	{
+		std::vector<int> racers;
+		for (int i = 0; i < numControllers; i++)
+		{
+			if (m_status[i] == Status::Racing)
+			{
+				racers.push_back(i);
+			}
+		}
+		// A pairing round only takes half as many games as there are racers, so two of them match
+		// the number of games in a random round
+		for (int pairing = 0; pairing < m_config.m_gamesPerRound * 2; pairing++)
+		{
+			m_matchmaker->PairRound(estimates, racers, rand, outMatchups);
+		}
+		m_round++;
+		return true;
+	}
+
+	for (int i = 0; i < numControllers; i++)
+	{
+		if (m_status[i] != Status::Racing)
+		{
+			continue;
+		}
+		for (int game = 0; game < m_config.m_gamesPerRound; game++)
+		{
+			// Any opponent but itself
+			int opponent = rand.NextInt(0, numControllers - 1);
+			if (opponent >= i)
+			{
+				opponent++;
+			}
+
+			// Alternate seats, since the game isn't perfectly symmetric
+			Matchup matchup;
+			matchup.m_index0 = ((game % 2) == 0) ? i : opponent;
+			matchup.m_index1 = ((game % 2) == 0) ? opponent : i;
+			outMatchups.push_back(matchup);
+		}
+	}
+
+	m_round++;
+	return true;
+}
+
+int EvaluationScheduler::GetNumRacing() const
+{
+	return static_cast<int>(m_status.size()) - m_numAccepted - m_numEliminated;
+}
+
+//static
+float EvaluationScheduler::GetPointsPerGame(const WinLossRecord& record)
+{
+	const int numGames = record.GetNumGames();
+	return (numGames > 0) ? static_cast<float>(record.GetPoints()) / numGames : 0.0f;
+}
+
+//static
+void EvaluationScheduler::GetConfidenceInterval(const WinLossRecord& record, const float confidence, float& outLower, float& outUpper)
+{
+	const Estimate estimate = MakeEstimate(record);
+	outLower = estimate.m_value - (confidence * estimate.m_standardError);
+	outUpper = estimate.m_value + (confidence * estimate.m_standardError);
+}
+
+//static
+EvaluationScheduler::Estimate EvaluationScheduler::MakeEstimate(const WinLossRecord& record)
+{
+	Estimate estimate;
+	const int numGames = record.GetNumGames();
+	if (numGames == 0)
+	{
+		// Anything from losing every game to winning every game
+		estimate.m_value = 0.5f * (k_pointsForLoss + k_pointsForWin);
+		estimate.m_standardError = 0.5f * (k_pointsForWin - k_pointsForLoss);
+		return estimate;
+	}
+
+	const float wins = static_cast<float>(record.m_wins + 1);
+	const float losses = static_cast<float>(record.m_losses + 1);
+	const float ties = static_cast<float>(record.m_ties);
+	const float count = wins + losses + ties;
+	const float mean = ((wins * k_pointsForWin) + (ties * k_pointsForTie) + (losses * k_pointsForLoss)) / count;
+	const float meanSquare = (
+		(wins * k_pointsForWin * k_pointsForWin) +
+		(ties * k_pointsForTie * k_pointsForTie) +
+		(losses * k_pointsForLoss * k_pointsForLoss)) / count;
+	const float variance = Math::Max(0.0f, meanSquare - (mean * mean));
+
+	estimate.m_value = GetPointsPerGame(record);
+	estimate.m_standardError = Math::Sqrt(variance / numGames);
+	return estimate;
+}
+
+//static
+EvaluationScheduler::Estimate EvaluationScheduler::MakeEstimate(const Rating& rating)
+{
+	Estimate estimate;
+	estimate.m_value = rating.m_rating;
+	estimate.m_standardError = rating.m_deviation;
+	return estimate;
+}
+
+void EvaluationScheduler::UpdateRacing(const std::vector<Estimate>& estimates)
+{
+	const int numControllers = static_cast<int>(m_status.size());
+	const int numToKeep = static_cast<int>(numControllers * m_config.m_percentToKeep);
+	if ((numToKeep <= 0) || (numToKeep >= numControllers))
+	{
+		// Everyone is kept or everyone is replaced, so more games can't change anything
+		return;
+	}
+
+	// The cut line sits halfway between the last controller kept and the first one replaced
+	std::vector<float> scores(numControllers);
+	std::vector<int> order(numControllers);
+	for (int i = 0; i < numControllers; i++)
+	{
+		scores[i] = estimates[i].m_value;
+		order[i] = i;
+	}
+	std::nth_element(order.begin(), order.begin() + numToKeep, order.end(),
+		[&scores](const int a, const int b) { return scores[a] > scores[b]; });
+	const float firstReplaced = scores[order[numToKeep]];
+	float lastKept = scores[order[0]];
+	for (int i = 1; i < numToKeep; i++)
+	{
+		lastKept = Math::Min(lastKept, scores[order[i]]);
+	}
+	const float cutLine = 0.5f * (lastKept + firstReplaced);
+
+	const int maxEliminations = Math::Max(1, static_cast<int>(GetNumRacing() * m_config.m_eliminationFraction));
+	std::vector<int> belowCutLine;
+	for (int i = 0; i < numControllers; i++)
+	{
+		if (m_status[i] != Status::Racing)
+		{
+			continue;
+		}
+
+		const float lower = estimates[i].m_value - (m_config.m_confidence * estimates[i].m_standardError);
+		const float upper = estimates[i].m_value + (m_config.m_confidence * estimates[i].m_standardError);
+		if (lower > cutLine)
+		{
+			m_status[i] = Status::Accepted;
+			m_numAccepted++;
+		}
+		else if (upper < cutLine)
+		{
+			belowCutLine.push_back(i);
+		}
+	}
+
+	// Eliminate the worst ones first
+	std::sort(belowCutLine.begin(), belowCutLine.end(),
+		[&scores](const int a, const int b) { return scores[a] < scores[b]; });
+	const int numEliminations = Math::Min(maxEliminations, static_cast<int>(belowCutLine.size()));
+	for (int i = 0; i < numEliminations; i++)
+	{
+		m_status[belowCutLine[i]] = Status::Eliminated;
+	}
+	m_numEliminated += numEliminations;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <vector>
+
+class IMatchmaker;
+class Random;
+class Rating;
+class WinLossRecord;
+
+// Decides which games to play when evaluating a generation, using racing (successive halving)
+//
+// Controllers are evaluated in rounds. Each round, every controller that's still racing plays a
+// few games. Without a matchmaker, opponents are picked at random from the whole population, so
+// everyone is measured against the same field. With a matchmaker, the racers are paired with each
+// other, which works best with estimates that account for the opponent's strength, like ratings.
+// A lone racer still plays random opponents, since there's nobody left to pair it with.
+//
+// After each round, the cut line is placed between the last controller that would be kept and the
+// first one that wouldn't. Controllers whose confidence interval (on points per game) is entirely
+// above the cut line are certain to be kept, and the ones entirely below it are certain to be
+// replaced, so both stop racing. The remaining games go to the controllers near the cut line,
+// which are the only ones where more games can change the outcome.
+//
+// Strength can be measured by this generation's points per game, or by a Rating that persists
+// across generations. With ratings, controllers that have been around for a while are already
+// known well enough to be decided after a game or two, and new children get most of the games.
+//
+// The confidence interval is (estimate) +/- m_confidence * (standard error). A confidence of 0
+// drops the bottom m_eliminationFraction every round, which is plain successive halving.
+class EvaluationScheduler
+{
+public:
+	class Config
+	{
+	public:
+		// Fraction of the controllers that will survive the generation
+		float m_percentToKeep = 0.2f;
+		// Games each racing controller is scheduled for per round
+		int m_gamesPerRound = 1;
+		// Evaluation ends after this many rounds. If nobody stops racing, every controller is
+		// scheduled for (m_maxRounds * m_gamesPerRound) games, plus about as many as an opponent.
+		int m_maxRounds = 8;
+		// At most this fraction of the racing controllers are eliminated each round
+		float m_eliminationFraction = 0.5f;
+		// Width of the confidence interval in standard errors. Decisions are made every round, so
+		// this needs to be fairly wide to avoid compounding mistakes.
+		float m_confidence = 2.0f;
+	};
+
+	// Estimated strength of a controller
+	class Estimate
+	{
+	public:
+		float m_value = 0.0f;
+		float m_standardError = 0.0f;
+	};
+
+	class Matchup
+	{
+	public:
+		int m_index0 = -1;
+		int m_index1 = -1;
+	};
+
+	// The matchmaker is optional, and isn't owned by the scheduler
+	EvaluationScheduler(const Config& config, IMatchmaker* matchmaker = nullptr);
+
+	// Starts evaluating a new population. Every controller starts out racing.
+	void Reset(const int numControllers);
+
+	// Uses the current estimates to decide who's still racing, then fills 'outMatchups' with the
+	// games for the next round. The estimates should include the results for both seats of every
+	// game played so far. Returns false when evaluation is complete.
+	bool ScheduleNextRound(const std::vector<Estimate>& estimates, Random& rand, std::vector<Matchup>& outMatchups);
+
+	int GetRound() const { return m_round; }
+	int GetNumRacing() const;
+	int GetNumAccepted() const { return m_numAccepted; }
+	int GetNumEliminated() const { return m_numEliminated; }
+	bool IsRacing(const int index) const { return m_status[index] == Status::Racing; }
+
+	// Points per game, and its confidence interval for the given width in standard errors.
+	// The variance includes one imaginary win and one imaginary loss, so a controller that has lost
+	// its only two games still has a wide interval.
+	static float GetPointsPerGame(const WinLossRecord& record);
+	static void GetConfidenceInterval(const WinLossRecord& record, const float confidence, float& outLower, float& outUpper);
+
+	static Estimate MakeEstimate(const WinLossRecord& record);
+	static Estimate MakeEstimate(const Rating& rating);
+
+private:
+	// Updates m_status from the current estimates
+	void UpdateRacing(const std::vector<Estimate>& estimates);
+
+private:
+	enum class Status
+	{
+		Racing,
+		Accepted,
+		Eliminated,
+	};
+
+	const Config m_config;
+	IMatchmaker* m_matchmaker = nullptr;
+	std::vector<Status> m_status;
+	int m_round = 0;
+	int m_numAccepted = 0;
+	int m_numEliminated = 0;
+};
@@ -0,0 +1,361 @@
+#include "pch.h"
+#include "EvolutionStrategyTrainer.h"
+
+#include <algorithm>
+#include <chrono>
+#include "AiControllerData.h"
+#include "AiControllerManager.h"
+#include "NeuralNet/Network.h"
+#include "NeuralNet/Optimizer.h"
+#include "NeuronBall/NeuronGame.h"
+#include "NeuronBall/Controllers/NeuralNetPlayerController.h"
+#include <thread>
+#include "Util/Math.h"
+#include <windows.h> // for OutputDebugString
+
+
+// Everything a thread needs to play games on its own
+class EvolutionStrategyTrainer::Worker
+{
+public:
+	Worker(Random& rand) :
+		m_player(rand)
+	{
+	}
+
+	~Worker()
+	{
+		for (NeuralNetPlayerController* opponent : m_opponents)
+		{
+			delete opponent;
+		}
+	}
+
+public:
+	NeuronGame m_game;
+	Network m_network;
+	std::vector<float> m_parameters;
+	NeuralNetPlayerController m_player;
+	// Copies of this iteration's opponents
+	std::vector<NeuralNetPlayerController*> m_opponents;
+};
+
+
+EvolutionStrategyTrainer::EvolutionStrategyTrainer(const Config& config, const Network* initialNetwork) :
+	m_config(config)
+{
+	_ASSERT(config.m_numPairsPerIteration > 0);
+	_ASSERT(config.m_numOpponentsPerIteration > 0);
+
+	// Seed the random number generator from the clock
+	m_rand.Seed();
+
+	// A new controller builds a randomized network with the standard inputs and outputs
+	NeuralNetPlayerController startingController(m_rand);
+	m_centerNetwork = new Network((initialNetwork != nullptr) ? *initialNetwork : *startingController.DebugGetNetwork());
+	m_centerParameters.resize(m_centerNetwork->GetNumParameters());
+	m_centerNetwork->GetParameters(m_centerParameters.data());
+	_ASSERT(m_config.m_noiseTableSize > static_cast<int>(m_centerParameters.size()));
+
+	AdamOptimizer::Config optimizerConfig;
+	optimizerConfig.m_learningRate = config.m_learningRate;
+	m_optimizer = new AdamOptimizer(static_cast<int>(m_centerParameters.size()), optimizerConfig);
+
+	// The noise table only depends on its seed, so it's the same for every run
+	m_noiseTable.resize(config.m_noiseTableSize);
+	Random noiseRand(config.m_noiseTableSeed);
+	noiseRand.FillGaussian(m_noiseTable.data(), config.m_noiseTableSize);
+
+	// Start by playing against the starting network
+	m_opponentPool.push_back(new Network(*m_centerNetwork));
+
+	const int numThreads = (config.m_numThreads > 0) ?
+		config.m_numThreads :
+		Math::Max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	for (int i = 0; i < numThreads; i++)
+	{
+		m_workers.push_back(new Worker(m_rand));
+	}
+
+	m_showcaseGame = new NeuronGame();
+	m_showcaseControllers[0] = new NeuralNetPlayerController(m_rand);
+	m_showcaseControllers[1] = new NeuralNetPlayerController(m_rand);
+	ResetShowcaseGame();
+}
+
+EvolutionStrategyTrainer::~EvolutionStrategyTrainer()
+{
+	delete m_centerNetwork;
+	delete m_optimizer;
+
+	for (Network* opponent : m_opponentPool)
+	{
+		delete opponent;
+	}
+	m_opponentPool.clear();
+
+	for (Worker* worker : m_workers)
+	{
+		delete worker;
+	}
+	m_workers.clear();
+
+	delete m_showcaseGame;
+	delete m_showcaseControllers[0];
+	delete m_showcaseControllers[1];
+}
+
+void EvolutionStrategyTrainer::Update()
+{
+	if (IsTrainingComplete())
+	{
+		return;
+	}
+
+	m_showcaseGame->Update();
+	if (m_showcaseGame->IsGameOver())
+	{
+		RunIteration();
+		ResetShowcaseGame();
+	}
+}
+
+void EvolutionStrategyTrainer::RunIteration()
+{
+	const auto startTime = std::chrono::steady_clock::now();
+	const int numParameters = static_cast<int>(m_centerParameters.size());
+	const int numPairs = m_config.m_numPairsPerIteration;
+
+	// Pick the noise for each pair and the opponents for this iteration
+	m_pairNoiseOffsets.resize(numPairs);
+	for (int& offset : m_pairNoiseOffsets)
+	{
+		offset = m_rand.NextInt(0, m_config.m_noiseTableSize - numParameters + 1);
+	}
+	m_iterationOpponents.resize(m_config.m_numOpponentsPerIteration);
+	for (int& opponentIndex : m_iterationOpponents)
+	{
+		opponentIndex = m_rand.NextInt(0, static_cast<int>(m_opponentPool.size()));
+	}
+	for (Worker* worker : m_workers)
+	{
+		while (worker->m_opponents.size() < m_iterationOpponents.size())
+		{
+			worker->m_opponents.push_back(new NeuralNetPlayerController(m_rand));
+		}
+		for (int i = 0; i < m_iterationOpponents.size(); i++)
+		{
+			worker->m_opponents[i]->SetNetwork(*m_opponentPool[m_iterationOpponents[i]]);
+		}
+	}
+
+	// Play all the games
+	m_fitness.assign(numPairs * 2, 0.0f);
+	m_nextJob = 0;
+	std::vector<std::thread> threads;
+	for (int i = 1; i < m_workers.size(); i++)
+	{
+		threads.emplace_back(&EvolutionStrategyTrainer::RunWorker, this, std::ref(*m_workers[i]));
+	}
+	// This thread does its share too
+	RunWorker(*m_workers[0]);
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	// Estimate the gradient from the ranks of each pair
+	std::vector<float> ranks;
+	ComputeCenteredRanks(m_fitness, ranks);
+	std::vector<float> gradient(numParameters, 0.0f);
+	for (int pair = 0; pair < numPairs; pair++)
+	{
+		const float weight = ranks[pair * 2] - ranks[(pair * 2) + 1];
+		if (weight != 0.0f)
+		{
+			const float* noise = &m_noiseTable[m_pairNoiseOffsets[pair]];
+			for (int i = 0; i < numParameters; i++)
+			{
+				gradient[i] += weight * noise[i];
+			}
+		}
+	}
+
+	// The optimizer minimizes, so flip the sign to climb towards higher fitness
+	const float gradientScale = -1.0f / (numPairs * 2 * m_config.m_noiseStdDev);
+	for (int i = 0; i < numParameters; i++)
+	{
+		gradient[i] = (gradient[i] * gradientScale) + (m_config.m_weightDecay * m_centerParameters[i]);
+	}
+	m_optimizer->Step(m_centerParameters.data(), gradient.data());
+	m_centerNetwork->SetParameters(m_centerParameters.data());
+
+	m_iteration++;
+
+	// Output stats
+	float totalFitness = 0.0f;
+	float bestFitness = m_fitness[0];
+	for (const float fitness : m_fitness)
+	{
+		totalFitness += fitness;
+		bestFitness = Math::Max(bestFitness, fitness);
+	}
+	const int numGames = static_cast<int>(m_fitness.size() * m_iterationOpponents.size()) * m_config.m_gamesPerOpponent;
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	char msg[256];
+	sprintf_s(msg, "ES iteration %d: average goal difference %.2f, best %.1f, %d games in %.2fs (%.0f games/s) on %d threads\n",
+		m_iteration,
+		totalFitness / m_fitness.size(),
+		bestFitness,
+		numGames,
+		seconds,
+		numGames / Math::Max(seconds, 0.001),
+		static_cast<int>(m_workers.size())
+	);
+	OutputDebugStringA(msg);
+
+	if ((m_iteration % m_config.m_addOpponentEveryNIterations) == 0)
+	{
+		if (m_opponentPool.size() >= m_config.m_maxOpponents)
+		{
+			delete m_opponentPool.front();
+			m_opponentPool.erase(m_opponentPool.begin());
+		}
+		m_opponentPool.push_back(new Network(*m_centerNetwork));
+	}
+
+	// Save to disk
+	if ((m_config.m_saveFile != nullptr) &&
+		((m_iteration % m_config.m_saveEveryNIterations == 0) || IsTrainingComplete()))
+	{
+		char filename[256];
+		sprintf_s(filename, m_config.m_saveFile,
+			AiControllerManager::GetFileMajorVersion(),
+			AiControllerManager::GetFileMinorVersion(),
+			AiControllerManager::GetFileRevisionNumber(),
+			m_iteration
+		);
+		WriteToFile(filename);
+	}
+}
+
+void EvolutionStrategyTrainer::WriteToFile(const char* outputFileName) const
+{
+	// Wrap each network in an AiControllerData so the file can be loaded like any other
+	Random rand;
+	AiControllerList controllers;
+	controllers.push_back(new AiControllerData(rand));
+	controllers.back()->m_controller->SetNetwork(*m_centerNetwork);
+	controllers.back()->m_generation = m_iteration;
+	for (const Network* opponent : m_opponentPool)
+	{
+		controllers.push_back(new AiControllerData(rand));
+		controllers.back()->m_controller->SetNetwork(*opponent);
+	}
+
+	AiControllerManager::WriteControllersToFile(outputFileName, controllers);
+
+	for (AiControllerData* controller : controllers)
+	{
+		delete controller;
+	}
+}
+
+void EvolutionStrategyTrainer::RunWorker(Worker& worker)
+{
+	const int numParameters = static_cast<int>(m_centerParameters.size());
+	const int numJobs = static_cast<int>(m_fitness.size());
+	worker.m_network = *m_centerNetwork;
+	worker.m_parameters.resize(numParameters);
+
+	for (int job = m_nextJob++; job < numJobs; job = m_nextJob++)
+	{
+		// Even jobs add the noise, odd jobs subtract it
+		const int pair = job / 2;
+		const float noiseScale = ((job % 2) == 0) ? m_config.m_noiseStdDev : -m_config.m_noiseStdDev;
+		const float* noise = &m_noiseTable[m_pairNoiseOffsets[pair]];
+		for (int i = 0; i < numParameters; i++)
+		{
+			worker.m_parameters[i] = m_centerParameters[i] + (noiseScale * noise[i]);
+		}
+		worker.m_network.SetParameters(worker.m_parameters.data());
+
+		// Each job writes to its own entry, so no locking is needed
+		m_fitness[job] = EvaluateNetwork(worker, worker.m_network);
+	}
+}
+
+float EvolutionStrategyTrainer::EvaluateNetwork(Worker& worker, const Network& network) const
+{
+	worker.m_player.SetNetwork(network);
+
+	int goalDifference = 0;
+	for (int opponent = 0; opponent < m_iterationOpponents.size(); opponent++)
+	{
+		for (int gameIndex = 0; gameIndex < m_config.m_gamesPerOpponent; gameIndex++)
+		{
+			const int playerSeat = gameIndex % 2;
+			const int opponentSeat = 1 - playerSeat;
+
+			NeuronGame& game = worker.m_game;
+			game.ResetGame(m_config.m_gameDuration);
+			game.SetPlayerController(playerSeat, &worker.m_player);
+			game.SetPlayerController(opponentSeat, worker.m_opponents[opponent]);
+			while (!game.IsGameOver())
+			{
+				game.Update();
+			}
+			goalDifference += game.GetPlayerScore(playerSeat) - game.GetPlayerScore(opponentSeat);
+		}
+	}
+	return static_cast<float>(goalDifference);
+}
+
+//static
+void EvolutionStrategyTrainer::ComputeCenteredRanks(const std::vector<float>& fitness, std::vector<float>& outRanks)
+{
+	const int count = static_cast<int>(fitness.size());
+	outRanks.resize(count);
+	if (count < 2)
+	{
+		std::fill(outRanks.begin(), outRanks.end(), 0.0f);
+		return;
+	}
+
+	std::vector<int> order(count);
+	for (int i = 0; i < count; i++)
+	{
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&fitness](const int a, const int b) { return fitness[a] < fitness[b]; });
+
+	// Goal differences tie a lot, and tied values need the same rank or the update would be biased
+	// by the order they were sorted into
+	for (int first = 0; first < count; )
+	{
+		int last = first;
+		while ((last + 1 < count) && (fitness[order[last + 1]] == fitness[order[first]]))
+		{
+			last++;
+		}
+		const float averageRank = (first + last) * 0.5f;
+		for (int i = first; i <= last; i++)
+		{
+			outRanks[order[i]] = (averageRank / (count - 1)) - 0.5f;
+		}
+		first = last + 1;
+	}
+}
+
+void EvolutionStrategyTrainer::ResetShowcaseGame()
+{
+	m_showcaseControllers[0]->SetNetwork(*m_centerNetwork);
+	m_showcaseControllers[1]->SetNetwork(*m_opponentPool.back());
+
+	// Swap sides every iteration
+	const int centerSeat = m_iteration % 2;
+	m_showcaseGame->ResetGame(m_config.m_gameDuration);
+	m_showcaseGame->SetPlayerController(centerSeat, m_showcaseControllers[0]);
+	m_showcaseGame->SetPlayerController(1 - centerSeat, m_showcaseControllers[1]);
+}
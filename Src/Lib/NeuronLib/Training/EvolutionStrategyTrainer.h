@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "Util/Random.h"
+#include <vector>
+
+class AdamOptimizer;
+class Network;
+class NeuralNetPlayerController;
+class NeuronGame;
+
+// Trains a single fixed-topology network with a natural evolution strategy
+// Reference: Salimans, Ho, Chen, Sidor & Sutskever, "Evolution Strategies as a Scalable
+//            Alternative to Reinforcement Learning" (2017)
+//
+// Each iteration, the center network's parameters are perturbed with Gaussian noise and every
+// perturbed network plays games against a pool of past versions of the center network. The noise
+// comes from a table that's generated once, so a perturbation is just an offset into the table.
+// Perturbations are evaluated in antithetic pairs (center + noise and center - noise), which
+// cancels out a lot of the evaluation noise. Fitness is converted to centered ranks, so the update
+// only depends on which perturbations did better, not by how much.
+//
+// Fitness is goal difference rather than win/loss/tie points, which gives a much smoother signal.
+class EvolutionStrategyTrainer
+{
+public:
+	class Config
+	{
+	public:
+		// Number of antithetic pairs evaluated each iteration
+		int m_numPairsPerIteration = 64;
+		// Standard deviation of the noise added to each parameter
+		float m_noiseStdDev = 0.05f;
+		float m_learningRate = 0.01f;
+		// Pulls parameters towards zero to keep them from growing without bound
+		float m_weightDecay = 0.005f;
+
+		// Number of values in the shared noise table, and the seed used to generate it
+		int m_noiseTableSize = 1024 * 1024 * 4;
+		uint64_t m_noiseTableSeed = 12345;
+
+		// Each perturbation plays this many opponents from the pool, and this many games against
+		// each one. Seats alternate every game. All perturbations in an iteration face the same
+		// opponents so their results can be compared fairly.
+		int m_numOpponentsPerIteration = 4;
+		int m_gamesPerOpponent = 2;
+		// A copy of the center network is added to the opponent pool this often.
+		// The oldest opponent is removed when the pool is full.
+		int m_addOpponentEveryNIterations = 10;
+		int m_maxOpponents = 32;
+
+		float m_gameDuration = 60.0f;
+
+		// Threads used to play games. 0 uses one per hardware thread.
+		int m_numThreads = 0;
+
+		int m_numIterations = 1000;
+		int m_saveEveryNIterations = 100;
+		// Format string for saved files. Takes the file version and iteration number.
+		const char* m_saveFile = nullptr;
+	};
+
+	// If 'initialNetwork' is null, training starts from a randomized network
+	EvolutionStrategyTrainer(const Config& config, const Network* initialNetwork = nullptr);
+	~EvolutionStrategyTrainer();
+
+	// Advances the showcase game (center network vs the newest opponent) by one tick.
+	// Each time the showcase game ends, a training iteration is run.
+	void Update();
+
+	// Evaluates all the perturbations for one iteration and updates the center network
+	void RunIteration();
+
+	bool IsTrainingComplete() const { return m_iteration >= m_config.m_numIterations; }
+	int GetIteration() const { return m_iteration; }
+	const Network& GetCenterNetwork() const { return *m_centerNetwork; }
+	const NeuronGame* GetGame() const { return m_showcaseGame; }
+
+	// Saves the center network followed by the opponent pool, using the same file format as
+	// AiPlayerTrainer. The first controller in the file is always the latest center network.
+	void WriteToFile(const char* outputFileName) const;
+
+private:
+	class Worker;
+
+	// Plays one worker's share of the games for this iteration
+	void RunWorker(Worker& worker);
+	// Plays every game for one network and returns its fitness
+	float EvaluateNetwork(Worker& worker, const Network& network) const;
+	// Converts fitness into centered ranks in [-0.5..0.5]. Tied values share the average rank.
+	static void ComputeCenteredRanks(const std::vector<float>& fitness, std::vector<float>& outRanks);
+	void ResetShowcaseGame();
+
+private:
+	const Config m_config;
+	Random m_rand;
+
+	// Current best guess at a good network. Perturbations are centered around it.
+	Network* m_centerNetwork = nullptr;
+	std::vector<float> m_centerParameters;
+	AdamOptimizer* m_optimizer = nullptr;
+
+	std::vector<float> m_noiseTable;
+
+	// Past versions of the center network
+	std::vector<Network*> m_opponentPool;
+	// Indices into m_opponentPool of the opponents for the current iteration
+	std::vector<int> m_iterationOpponents;
+
+	// Per-iteration data shared with the workers
+	// Noise table offset of each pair
+	std::vector<int> m_pairNoiseOffsets;
+	// Fitness of each perturbation. Pair p is at 2p (positive noise) and 2p + 1 (negative noise).
+	std::vector<float> m_fitness;
+	// Next perturbation to be evaluated. Workers take them one at a time until they run out.
+	std::atomic<int> m_nextJob;
+	std::vector<Worker*> m_workers;
+
+	NeuronGame* m_showcaseGame = nullptr;
+	NeuralNetPlayerController* m_showcaseControllers[2] = { nullptr, nullptr };
+
+	int m_iteration = 0;
+};
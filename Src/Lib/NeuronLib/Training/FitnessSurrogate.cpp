@@ -0,0 +1,163 @@
+#include "pch.h"
+#include "FitnessSurrogate.h"
+
+#include <algorithm>
+#include "NeuralNet/Network.h"
+#include "Util/Math.h"
+
+namespace
+{
+	// Rank of each value, starting at 0. Tied values share the average of their ranks.
+	void ComputeRanks(const std::vector<float>& values, std::vector<float>& outRanks)
+	{
+		const int numValues = static_cast<int>(values.size());
+		std::vector<int> order(numValues);
+		for (int i = 0; i < numValues; i++)
+		{
+			order[i] = i;
+		}
+		std::sort(order.begin(), order.end(), [&values](const int a, const int b) { return values[a] < values[b]; });
+
+		outRanks.resize(numValues);
+		int tieStart = 0;
+		for (int i = 1; i <= numValues; i++)
+		{
+			if ((i == numValues) || (values[order[i]] != values[order[tieStart]]))
+			{
+				const float rank = 0.5f * static_cast<float>(tieStart + i - 1);
+				for (int j = tieStart; j < i; j++)
+				{
+					outRanks[order[j]] = rank;
+				}
+				tieStart = i;
+			}
+		}
+	}
+}
+
+
+float BehaviorDistance::operator()(const std::vector<float>& a, const std::vector<float>& b) const
+{
+	_ASSERT(a.size() == b.size());
+	float sum = 0.0f;
+	for (int i = 0; i < static_cast<int>(a.size()); i++)
+	{
+		const float delta = a[i] - b[i];
+		sum += delta * delta;
+	}
+	return Math::Sqrt(sum);
+}
+
+
+FitnessSurrogate::FitnessSurrogate(const Config& config) :
+	m_config(config),
+	m_tree(BehaviorDistance())
+{
+	_ASSERT(m_config.m_numNeighbours > 0);
+	_ASSERT(m_config.m_capacity >= m_config.m_numNeighbours);
+}
+
+void FitnessSurrogate::SetProbeStates(const std::vector<float>& states, const int numInputs)
+{
+	_ASSERT((numInputs > 0) && ((states.size() % numInputs) == 0));
+	m_probeStates = states;
+	m_numInputs = numInputs;
+
+	// Behaviors on the old probe states can't be compared with the new ones
+	m_samples.clear();
+	m_oldestSample = 0;
+	m_isTreeValid = false;
+}
+
+void FitnessSurrogate::ComputeBehavior(const Network& network, std::vector<float>& outBehavior) const
+{
+	outBehavior.clear();
+	std::vector<float> inputs(m_numInputs);
+	for (int probe = 0; probe < GetNumProbeStates(); probe++)
+	{
+		const float* state = &m_probeStates[static_cast<size_t>(probe) * m_numInputs];
+		inputs.assign(state, state + m_numInputs);
+		const std::vector<float>& outputs = network.Evaluate(inputs);
+		outBehavior.insert(outBehavior.end(), outputs.begin(), outputs.end());
+	}
+}
+
+void FitnessSurrogate::AddSample(const std::vector<float>& behavior, const float score)
+{
+	if (GetNumSamples() < m_config.m_capacity)
+	{
+		m_samples.emplace_back();
+		m_samples.back().m_behavior = behavior;
+		m_samples.back().m_score = score;
+	}
+	else
+	{
+		m_samples[m_oldestSample].m_behavior = behavior;
+		m_samples[m_oldestSample].m_score = score;
+		m_oldestSample = (m_oldestSample + 1) % m_config.m_capacity;
+	}
+	m_isTreeValid = false;
+}
+
+float FitnessSurrogate::Predict(const std::vector<float>& behavior)
+{
+	_ASSERT(IsReady());
+	if (!m_isTreeValid)
+	{
+		std::vector<const std::vector<float>*> items(m_samples.size());
+		for (int i = 0; i < GetNumSamples(); i++)
+		{
+			items[i] = &m_samples[i].m_behavior;
+		}
+		m_tree.Build(items);
+		m_isTreeValid = true;
+	}
+
+	m_tree.FindNearestK(behavior, m_config.m_numNeighbours, m_nearest);
+
+	// Weighted by inverse distance, so an exact match decides the prediction on its own
+	constexpr float k_minDistance = 1e-4f;
+	float totalWeight = 0.0f;
+	float totalScore = 0.0f;
+	for (const std::pair<float, int>& neighbour : m_nearest)
+	{
+		const float weight = 1.0f / Math::Max(neighbour.first, k_minDistance);
+		totalWeight += weight;
+		totalScore += weight * m_samples[neighbour.second].m_score;
+	}
+	return totalScore / totalWeight;
+}
+
+//static
+float FitnessSurrogate::ComputeRankCorrelation(const std::vector<float>& a, const std::vector<float>& b)
+{
+	_ASSERT(a.size() == b.size());
+	const int numValues = static_cast<int>(a.size());
+	if (numValues < 2)
+	{
+		return 0.0f;
+	}
+
+	// Pearson correlation of the ranks
+	std::vector<float> ranksA;
+	std::vector<float> ranksB;
+	ComputeRanks(a, ranksA);
+	ComputeRanks(b, ranksB);
+	const double meanRank = 0.5 * (numValues - 1);
+	double covariance = 0.0;
+	double varianceA = 0.0;
+	double varianceB = 0.0;
+	for (int i = 0; i < numValues; i++)
+	{
+		const double deltaA = ranksA[i] - meanRank;
+		const double deltaB = ranksB[i] - meanRank;
+		covariance += deltaA * deltaB;
+		varianceA += deltaA * deltaA;
+		varianceB += deltaB * deltaB;
+	}
+	if ((varianceA <= 0.0) || (varianceB <= 0.0))
+	{
+		return 0.0f;
+	}
+	return static_cast<float>(covariance / Math::Sqrt(varianceA * varianceB));
+}
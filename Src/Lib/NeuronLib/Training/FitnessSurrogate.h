@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include "Util/VantagePointTree.h"
+
+class Network;
+
+// Euclidean distance between two behaviors
+class BehaviorDistance
+{
+public:
+	float operator()(const std::vector<float>& a, const std::vector<float>& b) const;
+};
+
+// Cheap prediction of how well a network will do, without playing any games
+//
+// A network's behavior is its outputs on a fixed set of probe game states. Networks that behave the
+// same on the probes tend to play the same way, so a network's score is predicted from the scores
+// of the controllers with the nearest behaviors (k nearest neighbours, weighted by inverse
+// distance). Every controller that finishes a generation becomes a sample, and the oldest samples
+// are replaced once the model is full, so predictions follow the population as it changes.
+//
+// Evaluating the probe states costs about as much as a second of game time, which is a tiny
+// fraction of a full game, so many candidate children can be screened for the cost of one game.
+class FitnessSurrogate
+{
+public:
+	class Config
+	{
+	public:
+		int m_numNeighbours = 8;
+		// Maximum number of samples kept
+		int m_capacity = 4096;
+	};
+
+	explicit FitnessSurrogate(const Config& config);
+
+	// Game states every network is evaluated on, one after another
+	void SetProbeStates(const std::vector<float>& states, const int numInputs);
+	int GetNumProbeStates() const { return m_numInputs > 0 ? static_cast<int>(m_probeStates.size()) / m_numInputs : 0; }
+	// Whether there are enough samples to make predictions
+	bool IsReady() const { return (GetNumProbeStates() > 0) && (GetNumSamples() >= m_config.m_numNeighbours); }
+
+	// Outputs of 'network' for every probe state, one after another
+	void ComputeBehavior(const Network& network, std::vector<float>& outBehavior) const;
+
+	void AddSample(const std::vector<float>& behavior, const float score);
+	int GetNumSamples() const { return static_cast<int>(m_samples.size()); }
+	float Predict(const std::vector<float>& behavior);
+
+	// Spearman's rank correlation between two sets of values. 1 means the same order, 0 means no
+	// relation, and -1 means the opposite order.
+	static float ComputeRankCorrelation(const std::vector<float>& a, const std::vector<float>& b);
+
+private:
+	class Sample
+	{
+	public:
+		std::vector<float> m_behavior;
+		float m_score = 0.0f;
+	};
+
+private:
+	const Config m_config;
+	std::vector<float> m_probeStates;
+	int m_numInputs = 0;
+
+	std::vector<Sample> m_samples;
+	// Replaced next once the samples are at capacity
+	int m_oldestSample = 0;
+
+	// Rebuilt before the next prediction whenever samples change
+	VantagePointTree<std::vector<float>, BehaviorDistance> m_tree;
+	bool m_isTreeValid = false;
+	std::vector<std::pair<float, int>> m_nearest;
+};
@@ -0,0 +1,154 @@
+#include "pch.h"
+#include "HallOfFame.h"
+
+#include "NeuralNet/Network.h"
+#include "Util/BinaryBuffer.h"
+
+
+HallOfFame::HallOfFame(const Config& config) :
+	m_config(config),
+	m_results(config.m_resultCacheCapacity)
+{
+	_ASSERT(config.m_capacity > 0);
+}
+
+void HallOfFame::Serialize(BinaryBuffer& stream) const
+{
+	SerializeInt(stream, static_cast<int>(m_members.size()));
+	for (const Member& member : m_members)
+	{
+		SerializeInt(stream, member.m_generation);
+		SerializeInt(stream, static_cast<int>(member.m_networkData.size()));
+		SerializeBuffer(stream, member.m_networkData.data(), static_cast<int>(member.m_networkData.size()));
+	}
+}
+
+void HallOfFame::Deserialize(BinaryBuffer& stream)
+{
+	int numMembers = 0;
+	DeserializeInt(stream, numMembers);
+	m_members.resize(numMembers);
+	Network network;
+	for (int i = 0; i < numMembers; i++)
+	{
+		Member& member = m_members[i];
+		int dataSize = 0;
+		DeserializeInt(stream, member.m_generation);
+		DeserializeInt(stream, dataSize);
+		member.m_networkData.resize(dataSize);
+		DeserializeBuffer(stream, member.m_networkData.data(), dataSize);
+
+		// The hash isn't saved, so it stays correct if hashing ever changes
+		GetNetwork(i, network);
+		member.m_hash = network.GetHash();
+	}
+
+	// The file may have been saved with a larger capacity. Trim it the same way as if the newest
+	// member were being added.
+	while (m_members.size() > m_config.m_capacity)
+	{
+		Member newest = std::move(m_members.back());
+		m_members.pop_back();
+		m_members.erase(m_members.begin() + GetMemberToReplace(newest.m_generation));
+		m_members.push_back(std::move(newest));
+	}
+}
+
+bool HallOfFame::Add(const Network& network, const int generation)
+{
+	const uint64_t hash = network.GetHash();
+	if (Contains(hash))
+	{
+		return false;
+	}
+
+	if (m_members.size() >= m_config.m_capacity)
+	{
+		m_members.erase(m_members.begin() + GetMemberToReplace(generation));
+	}
+
+	Member member;
+	SerializeNetwork(network, member.m_networkData);
+	member.m_hash = hash;
+	member.m_generation = generation;
+	m_members.push_back(std::move(member));
+	return true;
+}
+
+bool HallOfFame::Contains(const uint64_t hash) const
+{
+	for (const Member& member : m_members)
+	{
+		if (member.m_hash == hash)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void HallOfFame::GetNetwork(const int memberIndex, Network& outNetwork) const
+{
+	const std::vector<char>& data = m_members[memberIndex].m_networkData;
+	HeapBuffer buffer(static_cast<int>(data.size()));
+	buffer.WriteBytes(data.data(), static_cast<int>(data.size()));
+	buffer.Seek(0);
+	outNetwork.Deserialize(buffer);
+	_ASSERT(buffer.GetErrorStatus() == BinaryBuffer::ErrorStatus::NoError);
+}
+
+bool HallOfFame::TryGetResult(const uint64_t candidateHash, const int memberIndex, const int candidateSeat, const uint64_t rulesHash, MatchResult& outResult)
+{
+	const uint64_t memberHash = m_members[memberIndex].m_hash;
+	return (candidateSeat == 0) ?
+		m_results.Lookup(candidateHash, memberHash, rulesHash, outResult) :
+		m_results.Lookup(memberHash, candidateHash, rulesHash, outResult);
+}
+
+void HallOfFame::StoreResult(const uint64_t candidateHash, const int memberIndex, const int candidateSeat, const uint64_t rulesHash, const MatchResult& result)
+{
+	const uint64_t memberHash = m_members[memberIndex].m_hash;
+	if (candidateSeat == 0)
+	{
+		m_results.Store(candidateHash, memberHash, rulesHash, result);
+	}
+	else
+	{
+		m_results.Store(memberHash, candidateHash, rulesHash, result);
+	}
+}
+
+//static
+void HallOfFame::SerializeNetwork(const Network& network, std::vector<char>& outData)
+{
+	// Every parameter takes at most 16 bytes, including the per neuron data, with plenty of room
+	// for the input level and the network's own data
+	HeapBuffer buffer((16 * network.GetNumParameters()) + (64 * 1024));
+	network.Serialize(buffer);
+	_ASSERT(buffer.GetErrorStatus() == BinaryBuffer::ErrorStatus::NoError);
+	outData.assign(buffer.GetPtr(), buffer.GetPtr() + buffer.GetCurrent());
+}
+
+int HallOfFame::GetMemberToReplace(const int newGeneration) const
+{
+	const int numMembers = static_cast<int>(m_members.size());
+	if (numMembers <= 1)
+	{
+		return 0;
+	}
+
+	// Never the first member. Removing member i joins the gaps on either side of it.
+	int bestIndex = 1;
+	int smallestGap = 0;
+	for (int i = 1; i < numMembers; i++)
+	{
+		const int nextGeneration = (i + 1 < numMembers) ? m_members[i + 1].m_generation : newGeneration;
+		const int gap = nextGeneration - m_members[i - 1].m_generation;
+		if ((i == 1) || (gap < smallestGap))
+		{
+			bestIndex = i;
+			smallestGap = gap;
+		}
+	}
+	return bestIndex;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include "MatchResultCache.h"
+#include "Util/Serializable.h"
+#include <vector>
+
+class Network;
+
+// A bounded set of past champions that new candidates are benchmarked against
+//
+// Points and ratings only say how a controller compares to the rest of the current population, so
+// they can't show whether training is still making progress. Members of the hall of fame never
+// change, so a candidate's score against them means the same thing 10,000 generations later.
+//
+// Members are frozen: each one is kept as its serialized network, which is a single small
+// allocation that nothing can mutate. Games are deterministic, so the result of every game against
+// a member is cached by (candidate hash, member hash, seat). A champion that survives several
+// generations only has to play the members that joined since it was last benchmarked.
+//
+// When the hall is full, the member whose removal leaves the smallest gap in generations is
+// dropped. The first member and the newest one are always kept, so the members stay spread over
+// the whole history of training instead of only the recent past.
+class HallOfFame : public ISerializable
+{
+public:
+	class Config
+	{
+	public:
+		// Maximum number of members
+		int m_capacity = 32;
+		// Benchmark results remembered. Each candidate needs two per member, one for each seat.
+		int m_resultCacheCapacity = 1024 * 16;
+	};
+
+	class Member
+	{
+	public:
+		// Serialized network
+		std::vector<char> m_networkData;
+		uint64_t m_hash = 0;
+		int m_generation = 0;
+	};
+
+	explicit HallOfFame(const Config& config);
+
+	// ISerializable interface. Only the members are saved, not the cached results.
+	void Serialize(BinaryBuffer& stream) const override;
+	void Deserialize(BinaryBuffer& stream) override;
+
+	// Adds a frozen copy of 'network', dropping a member first if the hall is full.
+	// Returns false if an identical network is already a member.
+	bool Add(const Network& network, const int generation);
+	bool Contains(const uint64_t hash) const;
+
+	int GetNumMembers() const { return static_cast<int>(m_members.size()); }
+	// Members are in the order they were added
+	const Member& GetMember(const int index) const { return m_members[index]; }
+	// Copies a member's network into 'outNetwork', ready to be played
+	void GetNetwork(const int memberIndex, Network& outNetwork) const;
+
+	// Result (indexed by seat) of a previous game between a candidate and a member
+	bool TryGetResult(const uint64_t candidateHash, const int memberIndex, const int candidateSeat, const uint64_t rulesHash, MatchResult& outResult);
+	void StoreResult(const uint64_t candidateHash, const int memberIndex, const int candidateSeat, const uint64_t rulesHash, const MatchResult& result);
+
+private:
+	static void SerializeNetwork(const Network& network, std::vector<char>& outData);
+	// Index of the member to drop to make room for one from 'newGeneration'
+	int GetMemberToReplace(const int newGeneration) const;
+
+private:
+	const Config m_config;
+	std::vector<Member> m_members;
+	MatchResultCache m_results;
+};
@@ -0,0 +1,117 @@
+#include "pch.h"
+#include "MatchResultCache.h"
+
+#include "Util/Hash.h"
+
+MatchResultKey::MatchResultKey(const uint64_t hashSeat0, const uint64_t hashSeat1, const uint64_t rulesHash) :
+	m_rulesHash(rulesHash)
+{
+	// Network A is always the one with the smaller hash
+	if (hashSeat0 <= hashSeat1)
+	{
+		m_hashA = hashSeat0;
+		m_hashB = hashSeat1;
+		m_seatOfA = 0;
+	}
+	else
+	{
+		m_hashA = hashSeat1;
+		m_hashB = hashSeat0;
+		m_seatOfA = 1;
+	}
+}
+
+size_t MatchResultKey::Hasher::operator()(const MatchResultKey& key) const
+{
+	uint64_t hash = Hash::Fnv1aSimpleObject(key.m_hashA);
+	hash = Hash::Fnv1aSimpleObject(key.m_hashB, hash);
+	hash = Hash::Fnv1aSimpleObject(key.m_rulesHash, hash);
+	hash = Hash::Fnv1aSimpleObject(key.m_seatOfA, hash);
+	return static_cast<size_t>(hash);
+}
+
+//=============================================================================
+
+MatchResultCache::MatchResultCache(const int capacity) :
+	m_capacity(capacity)
+{
+	if (m_capacity > 0)
+	{
+		m_lookup.reserve(m_capacity);
+	}
+}
+
+bool MatchResultCache::Lookup(const uint64_t hashSeat0, const uint64_t hashSeat1, const uint64_t rulesHash, MatchResult& outResult)
+{
+	if (!IsEnabled())
+	{
+		return false;
+	}
+
+	m_numLookups++;
+
+	const MatchResultKey key(hashSeat0, hashSeat1, rulesHash);
+	const auto it = m_lookup.find(key);
+	if (it == m_lookup.end())
+	{
+		return false;
+	}
+
+	// Move the entry to the front so it's the last to be evicted
+	m_entries.splice(m_entries.begin(), m_entries, it->second);
+
+	outResult = FromCanonical(key, it->second->second);
+	m_numHits++;
+	return true;
+}
+
+void MatchResultCache::Store(const uint64_t hashSeat0, const uint64_t hashSeat1, const uint64_t rulesHash, const MatchResult& result)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	const MatchResultKey key(hashSeat0, hashSeat1, rulesHash);
+	const auto it = m_lookup.find(key);
+	if (it != m_lookup.end())
+	{
+		// Games are deterministic, so the stored result should never change. Just refresh its position.
+		m_entries.splice(m_entries.begin(), m_entries, it->second);
+		return;
+	}
+
+	// Evict the least recently used entry if the cache is full
+	if (static_cast<int>(m_entries.size()) >= m_capacity)
+	{
+		m_lookup.erase(m_entries.back().first);
+		m_entries.pop_back();
+	}
+
+	m_entries.emplace_front(key, ToCanonical(key, result));
+	m_lookup[key] = m_entries.begin();
+}
+
+void MatchResultCache::Clear()
+{
+	m_entries.clear();
+	m_lookup.clear();
+}
+
+// static
+MatchResult MatchResultCache::ToCanonical(const MatchResultKey& key, const MatchResult& bySeat)
+{
+	MatchResult canonical;
+	canonical.m_scores[0] = bySeat.m_scores[key.m_seatOfA];
+	canonical.m_scores[1] = bySeat.m_scores[1 - key.m_seatOfA];
+	return canonical;
+}
+
+// static
+MatchResult MatchResultCache::FromCanonical(const MatchResultKey& key, const MatchResult& canonical)
+{
+	MatchResult bySeat;
+	bySeat.m_scores[key.m_seatOfA] = canonical.m_scores[0];
+	bySeat.m_scores[1 - key.m_seatOfA] = canonical.m_scores[1];
+	return bySeat;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+// Identifies a single match between two networks.
+// The key is stored in a canonical form so a matchup is found regardless of which network
+// is passed in first. 'm_seatOfA' records which seat network A was sitting in, since the
+// game is not perfectly symmetric (eg. player 0 is always processed first).
+class MatchResultKey
+{
+public:
+	MatchResultKey() {}
+	MatchResultKey(const uint64_t hashSeat0, const uint64_t hashSeat1, const uint64_t rulesHash);
+
+	bool operator == (const MatchResultKey& rhs) const
+	{
+		return
+			(m_hashA == rhs.m_hashA) &&
+			(m_hashB == rhs.m_hashB) &&
+			(m_rulesHash == rhs.m_rulesHash) &&
+			(m_seatOfA == rhs.m_seatOfA);
+	}
+
+	// Hash functor so keys can be used in unordered containers
+	class Hasher
+	{
+	public:
+		size_t operator()(const MatchResultKey& key) const;
+	};
+
+public:
+	uint64_t m_hashA = 0;
+	uint64_t m_hashB = 0;
+	uint64_t m_rulesHash = 0;
+	int m_seatOfA = 0;
+};
+
+// Final score of a match, indexed by seat
+class MatchResult
+{
+public:
+	int m_scores[2] = { 0, 0 };
+};
+
+// Remembers the outcome of deterministic matches so they don't need to be simulated again.
+// Entries are evicted in least-recently-used order once the cache reaches capacity.
+class MatchResultCache
+{
+public:
+	explicit MatchResultCache(const int capacity);
+
+	// Returns true and fills in 'outResult' (indexed by seat) if the match has been seen before
+	bool Lookup(const uint64_t hashSeat0, const uint64_t hashSeat1, const uint64_t rulesHash, MatchResult& outResult);
+	// Records the result (indexed by seat) of a simulated match
+	void Store(const uint64_t hashSeat0, const uint64_t hashSeat1, const uint64_t rulesHash, const MatchResult& result);
+
+	void Clear();
+
+	bool IsEnabled() const { return m_capacity > 0; }
+	int GetCapacity() const { return m_capacity; }
+	int GetNumEntries() const { return static_cast<int>(m_entries.size()); }
+
+	// Lifetime statistics
+	int64_t GetNumLookups() const { return m_numLookups; }
+	int64_t GetNumHits() const { return m_numHits; }
+
+private:
+	// Converts between per-seat results and the canonical (A, B) ordering used by the key
+	static MatchResult ToCanonical(const MatchResultKey& key, const MatchResult& bySeat);
+	static MatchResult FromCanonical(const MatchResultKey& key, const MatchResult& canonical);
+
+private:
+	typedef std::pair<MatchResultKey, MatchResult> Entry;
+	typedef std::list<Entry> EntryList;
+
+	const int m_capacity = 0;
+	// Most recently used entries are at the front of the list
+	EntryList m_entries;
+	std::unordered_map<MatchResultKey, EntryList::iterator, MatchResultKey::Hasher> m_lookup;
+
+	int64_t m_numLookups = 0;
+	int64_t m_numHits = 0;
+};
@@ -0,0 +1,269 @@
+#include "pch.h"
+#include "Matchmaker.h"
+
+#include <algorithm>
+#include "Util/Math.h"
+#include "Util/Random.h"
+
+
+// Shuffles the players, then sorts them from highest to lowest score.
+// Shuffling first means ties are broken randomly.
+static void SortByScore(const std::vector<IMatchmaker::Estimate>& estimates, std::vector<int>& players, Random& rand)
+{
+	const int numPlayers = static_cast<int>(players.size());
+	for (int i = 0; i < numPlayers - 1; i++)
+	{
+		std::swap(players[i], players[rand.NextInt(i, numPlayers)]);
+	}
+	std::stable_sort(players.begin(), players.end(),
+		[&estimates](const int a, const int b) { return estimates[a].m_value > estimates[b].m_value; });
+}
+
+
+//static
+IMatchmaker* IMatchmaker::Create(const MatchmakingStrategy strategy)
+{
+	switch (strategy)
+	{
+	case MatchmakingStrategy::Random:
+		return new RandomMatchmaker();
+	case MatchmakingStrategy::Swiss:
+		return new SwissMatchmaker();
+	case MatchmakingStrategy::InformationGain:
+		return new InformationGainMatchmaker();
+	case MatchmakingStrategy::RoundRobin:
+	default:
+		return nullptr;
+	}
+}
+
+void IMatchmaker::Reset(const int numControllers)
+{
+	m_playedPairs.clear();
+	m_seatBalance.assign(numControllers, 0);
+	m_numRematches = 0;
+}
+
+void IMatchmaker::PairRound(const std::vector<Estimate>& estimates, const std::vector<int>& players, Random& rand, std::vector<Matchup>& outMatchups)
+{
+	const int numPlayers = static_cast<int>(players.size());
+	if (numPlayers < 2)
+	{
+		return;
+	}
+	if (m_seatBalance.size() < estimates.size())
+	{
+		m_seatBalance.resize(estimates.size(), 0);
+	}
+
+	std::vector<int> unpaired(players);
+	std::vector<int> pairs;
+	pairs.reserve(numPlayers);
+	PairPlayers(estimates, unpaired, rand, pairs);
+	_ASSERT((pairs.size() % 2) == 0);
+
+	std::vector<bool> isPaired(estimates.size(), false);
+	for (int i = 0; i < pairs.size(); i += 2)
+	{
+		AddMatchup(pairs[i], pairs[i + 1], outMatchups);
+		isPaired[pairs[i]] = true;
+		isPaired[pairs[i + 1]] = true;
+	}
+
+	for (const int player : players)
+	{
+		if (isPaired[player])
+		{
+			continue;
+		}
+		int opponent = players[rand.NextInt(0, numPlayers - 1)];
+		if (opponent == player)
+		{
+			opponent = players[numPlayers - 1];
+		}
+		AddMatchup(player, opponent, outMatchups);
+		isPaired[player] = true;
+	}
+}
+
+bool IMatchmaker::HavePlayed(const int a, const int b) const
+{
+	return m_playedPairs.find(GetPairKey(a, b)) != m_playedPairs.end();
+}
+
+//static
+uint64_t IMatchmaker::GetPairKey(const int a, const int b)
+{
+	const uint64_t low = static_cast<uint32_t>(Math::Min(a, b));
+	const uint64_t high = static_cast<uint32_t>(Math::Max(a, b));
+	return (high << 32) | low;
+}
+
+void IMatchmaker::AddMatchup(const int a, const int b, std::vector<Matchup>& outMatchups)
+{
+	_ASSERT(a != b);
+	if (!m_playedPairs.insert(GetPairKey(a, b)).second)
+	{
+		m_numRematches++;
+	}
+
+	// Whoever has spent more time in seat 0 takes seat 1
+	Matchup matchup;
+	matchup.m_index0 = (m_seatBalance[a] <= m_seatBalance[b]) ? a : b;
+	matchup.m_index1 = (matchup.m_index0 == a) ? b : a;
+	m_seatBalance[matchup.m_index0]++;
+	m_seatBalance[matchup.m_index1]--;
+	outMatchups.push_back(matchup);
+}
+
+//=============================================================================
+
+void RandomMatchmaker::PairPlayers(const std::vector<Estimate>& estimates, std::vector<int>& players, Random& rand, std::vector<int>& outPairs)
+{
+	const int numPlayers = static_cast<int>(players.size());
+	for (int i = 0; i < numPlayers - 1; i++)
+	{
+		std::swap(players[i], players[rand.NextInt(i, numPlayers)]);
+	}
+	for (int i = 0; i + 1 < numPlayers; i += 2)
+	{
+		outPairs.push_back(players[i]);
+		outPairs.push_back(players[i + 1]);
+	}
+}
+
+//=============================================================================
+
+void SwissMatchmaker::PairPlayers(const std::vector<Estimate>& estimates, std::vector<int>& players, Random& rand, std::vector<int>& outPairs)
+{
+	SortByScore(estimates, players, rand);
+
+	const int numPlayers = static_cast<int>(players.size());
+	std::vector<bool> isPaired(numPlayers, false);
+	for (int i = 0; i < numPlayers; i++)
+	{
+		if (isPaired[i])
+		{
+			continue;
+		}
+
+		// The next player down the standings that hasn't been played yet. If everyone left has
+		// been played, settle for a rematch with the closest one.
+		int opponent = -1;
+		int closestUnpaired = -1;
+		for (int j = i + 1; j < numPlayers; j++)
+		{
+			if (isPaired[j])
+			{
+				continue;
+			}
+			if (closestUnpaired < 0)
+			{
+				closestUnpaired = j;
+			}
+			if (!HavePlayed(players[i], players[j]))
+			{
+				opponent = j;
+				break;
+			}
+		}
+		if (opponent < 0)
+		{
+			opponent = closestUnpaired;
+		}
+		if (opponent < 0)
+		{
+			// Left over
+			break;
+		}
+
+		isPaired[i] = true;
+		isPaired[opponent] = true;
+		outPairs.push_back(players[i]);
+		outPairs.push_back(players[opponent]);
+	}
+}
+
+//=============================================================================
+
+//static
+float InformationGainMatchmaker::GetInformation(const Estimate& a, const Estimate& b)
+{
+	const float variance = (a.m_standardError * a.m_standardError) + (b.m_standardError * b.m_standardError);
+	if (variance <= 0.0f)
+	{
+		return (a.m_value == b.m_value) ? 0.25f : 0.0f;
+	}
+
+	// Chance that A is stronger, using the logistic approximation of the normal distribution
+	const float z = (a.m_value - b.m_value) / Math::Sqrt(variance);
+	const float chanceAIsStronger = 1.0f / (1.0f + ::expf(-1.702f * z));
+	return chanceAIsStronger * (1.0f - chanceAIsStronger);
+}
+
+void InformationGainMatchmaker::PairPlayers(const std::vector<Estimate>& estimates, std::vector<int>& players, Random& rand, std::vector<int>& outPairs)
+{
+	SortByScore(estimates, players, rand);
+
+	const int numPlayers = static_cast<int>(players.size());
+	std::vector<int> pickOrder(numPlayers);
+	for (int i = 0; i < numPlayers; i++)
+	{
+		pickOrder[i] = i;
+	}
+	std::stable_sort(pickOrder.begin(), pickOrder.end(),
+		[&estimates, &players](const int a, const int b)
+		{
+			return estimates[players[a]].m_standardError > estimates[players[b]].m_standardError;
+		});
+
+	std::vector<bool> isPaired(numPlayers, false);
+	for (const int i : pickOrder)
+	{
+		if (isPaired[i])
+		{
+			continue;
+		}
+
+		// Search outwards in score order. Only the players in the window are compared, but if
+		// they've all been paired, the closest unpaired player is used.
+		const Estimate& estimate = estimates[players[i]];
+		int opponent = -1;
+		float bestInformation = 0.0f;
+		for (int distance = 1; distance < numPlayers; distance++)
+		{
+			if ((distance > k_searchWindow) && (opponent >= 0))
+			{
+				break;
+			}
+			for (const int j : { i - distance, i + distance })
+			{
+				if ((j < 0) || (j >= numPlayers) || isPaired[j])
+				{
+					continue;
+				}
+				float information = GetInformation(estimate, estimates[players[j]]);
+				if (HavePlayed(players[i], players[j]))
+				{
+					// Only rematch if there's no other choice
+					information -= 1.0f;
+				}
+				if ((opponent < 0) || (information > bestInformation))
+				{
+					opponent = j;
+					bestInformation = information;
+				}
+			}
+		}
+		if (opponent < 0)
+		{
+			// Left over
+			continue;
+		}
+
+		isPaired[i] = true;
+		isPaired[opponent] = true;
+		outPairs.push_back(players[i]);
+		outPairs.push_back(players[opponent]);
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include "EvaluationScheduler.h"
+#include <unordered_set>
+#include <vector>
+
+class Random;
+
+enum class MatchmakingStrategy
+{
+	// Fixed pairings that ignore strength: controller i plays (i + season + 1) % n
+	RoundRobin,
+	// Random pairings
+	Random,
+	// Controllers with similar scores play each other, without rematches
+	Swiss,
+	// Pairs whose result is hardest to predict play each other, favoring uncertain controllers
+	InformationGain,
+};
+
+// Decides who plays who
+//
+// A round pairs up a list of players so each one plays one game. Games between controllers of very
+// different strength have a predictable result and tell us little, so the strategies that look at
+// strength try to pair controllers whose order is still in question.
+class IMatchmaker
+{
+public:
+	typedef EvaluationScheduler::Estimate Estimate;
+	typedef EvaluationScheduler::Matchup Matchup;
+
+	// Returns null for MatchmakingStrategy::RoundRobin, which doesn't need a matchmaker
+	static IMatchmaker* Create(const MatchmakingStrategy strategy);
+
+	virtual ~IMatchmaker() {}
+
+	// Forgets previous pairings. Called at the start of every generation.
+	void Reset(const int numControllers);
+
+	// Pairs up 'players' (indices into 'estimates') so each one plays one game, and appends the
+	// games to 'outMatchups'. If there's an odd number of players, the one left over plays a random
+	// other player, who ends up playing twice.
+	void PairRound(const std::vector<Estimate>& estimates, const std::vector<int>& players, Random& rand, std::vector<Matchup>& outMatchups);
+
+	int GetNumRematches() const { return m_numRematches; }
+
+protected:
+	// Pairs up as many of 'players' as possible. The two players in each pair are added to
+	// 'outPairs' one after the other. Any player not in 'outPairs' is left over.
+	virtual void PairPlayers(const std::vector<Estimate>& estimates, std::vector<int>& players, Random& rand, std::vector<int>& outPairs) = 0;
+
+	bool HavePlayed(const int a, const int b) const;
+
+private:
+	static uint64_t GetPairKey(const int a, const int b);
+	void AddMatchup(const int a, const int b, std::vector<Matchup>& outMatchups);
+
+private:
+	// Every pair that's played this generation
+	std::unordered_set<uint64_t> m_playedPairs;
+	// Games played in seat 0 minus games played in seat 1, for each controller
+	std::vector<int> m_seatBalance;
+	int m_numRematches = 0;
+};
+
+class RandomMatchmaker : public IMatchmaker
+{
+protected:
+	void PairPlayers(const std::vector<Estimate>& estimates, std::vector<int>& players, Random& rand, std::vector<int>& outPairs) override;
+};
+
+// Swiss-system pairing
+// Players are sorted by their current score, and each one plays the next closest player it hasn't
+// already played this generation. After a few rounds the standings separate the population far
+// better than the same number of fixed pairings would.
+class SwissMatchmaker : public IMatchmaker
+{
+protected:
+	void PairPlayers(const std::vector<Estimate>& estimates, std::vector<int>& players, Random& rand, std::vector<int>& outPairs) override;
+};
+
+// Pairs players whose result is hardest to predict
+// The chance that A is stronger than B is estimated from their scores and standard errors, and
+// the game with the most uncertain outcome is the one that teaches the most about their order.
+// The least certain players choose their opponents first, from the players closest to them.
+class InformationGainMatchmaker : public IMatchmaker
+{
+public:
+	// Number of players on each side of a player, in score order, that are considered as opponents
+	static constexpr int k_searchWindow = 8;
+
+	// How uncertain the result of a game between 'a' and 'b' is. Higher is more informative.
+	static float GetInformation(const Estimate& a, const Estimate& b);
+
+protected:
+	void PairPlayers(const std::vector<Estimate>& estimates, std::vector<int>& players, Random& rand, std::vector<int>& outPairs) override;
+};
@@ -0,0 +1,127 @@
+#include "pch.h"
+#include "ParetoRanking.h"
+
+#include <algorithm>
+#include <limits>
+
+
+void ParetoRanking::Rank(const std::vector<ParetoPoint>& points)
+{
+	const int numPoints = static_cast<int>(points.size());
+	m_ranks.assign(numPoints, 0);
+	m_frontSizes.clear();
+
+	// Best score first, and lowest cost first when scores are equal. Every point that can dominate
+	// a point is visited before it.
+	m_order.resize(numPoints);
+	for (int i = 0; i < numPoints; i++)
+	{
+		m_order[i] = i;
+	}
+	std::sort(m_order.begin(), m_order.end(),
+		[&points](const int a, const int b)
+		{
+			if (points[a].m_score != points[b].m_score)
+			{
+				return points[a].m_score > points[b].m_score;
+			}
+			return points[a].m_cost < points[b].m_cost;
+		});
+
+	// Last point added to each front. Its cost is the lowest in the front, since the front is
+	// ordered by decreasing score and nothing in it is dominated.
+	std::vector<int> frontLast;
+	for (const int pointIndex : m_order)
+	{
+		const ParetoPoint& point = points[pointIndex];
+		auto isDominatedBy = [&points, &point](const int lastIndex)
+		{
+			const ParetoPoint& last = points[lastIndex];
+			const bool isEqual = (last.m_score == point.m_score) && (last.m_cost == point.m_cost);
+			return (last.m_cost <= point.m_cost) && !isEqual;
+		};
+
+		// Find the first front that doesn't dominate the point
+		int low = 0;
+		int high = static_cast<int>(frontLast.size());
+		while (low < high)
+		{
+			const int mid = (low + high) / 2;
+			if (isDominatedBy(frontLast[mid]))
+			{
+				low = mid + 1;
+			}
+			else
+			{
+				high = mid;
+			}
+		}
+
+		if (low == static_cast<int>(frontLast.size()))
+		{
+			frontLast.push_back(pointIndex);
+			m_frontSizes.push_back(0);
+		}
+		frontLast[low] = pointIndex;
+		m_frontSizes[low]++;
+		m_ranks[pointIndex] = low;
+	}
+
+	ComputeCrowdingDistances(points);
+
+	std::stable_sort(m_order.begin(), m_order.end(),
+		[this](const int a, const int b)
+		{
+			if (m_ranks[a] != m_ranks[b])
+			{
+				return m_ranks[a] < m_ranks[b];
+			}
+			return m_crowdingDistances[a] > m_crowdingDistances[b];
+		});
+}
+
+void ParetoRanking::ComputeCrowdingDistances(const std::vector<ParetoPoint>& points)
+{
+	const int numPoints = static_cast<int>(points.size());
+	const int numFronts = GetNumFronts();
+	const float infinity = std::numeric_limits<float>::infinity();
+	m_crowdingDistances.assign(numPoints, 0.0f);
+
+	// m_order is still by decreasing score, so each front's members are in order of decreasing
+	// score and, since they don't dominate each other, decreasing cost. Both objectives are
+	// sorted at once.
+	std::vector<std::vector<int>> fronts(numFronts);
+	for (int f = 0; f < numFronts; f++)
+	{
+		fronts[f].reserve(m_frontSizes[f]);
+	}
+	for (const int pointIndex : m_order)
+	{
+		fronts[m_ranks[pointIndex]].push_back(pointIndex);
+	}
+
+	for (const std::vector<int>& front : fronts)
+	{
+		const int size = static_cast<int>(front.size());
+		m_crowdingDistances[front[0]] = infinity;
+		m_crowdingDistances[front[size - 1]] = infinity;
+
+		const float scoreRange = points[front[0]].m_score - points[front[size - 1]].m_score;
+		const float costRange = points[front[0]].m_cost - points[front[size - 1]].m_cost;
+		for (int i = 1; i < size - 1; i++)
+		{
+			const ParetoPoint& previous = points[front[i - 1]];
+			const ParetoPoint& next = points[front[i + 1]];
+			float distance = 0.0f;
+			if (scoreRange > 0.0f)
+			{
+				distance += (previous.m_score - next.m_score) / scoreRange;
+			}
+			if (costRange > 0.0f)
+			{
+				distance += (previous.m_cost - next.m_cost) / costRange;
+			}
+			m_crowdingDistances[front[i]] = distance;
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+// A controller's position in the two objectives of multi-objective selection
+class ParetoPoint
+{
+public:
+	// Higher is better
+	float m_score = 0.0f;
+	// Lower is better
+	float m_cost = 0.0f;
+};
+
+// NSGA-II ranking of a population by score and cost
+//
+// A point dominates another if it's at least as good in both objectives and better in one. The
+// first front is every point that nothing dominates, the second front is every point that only the
+// first front dominates, and so on. Within a front, points in sparse regions have a larger
+// crowding distance, and are preferred to keep the front spread out.
+//
+// With only two objectives, the fronts can be found in O(N log N) instead of the O(N^2) of the
+// general algorithm. Points are visited best score first, so a point is dominated by a front if and
+// only if it's dominated by the last point added to it, and that's monotonic over the fronts so the
+// front can be found with a binary search.
+class ParetoRanking
+{
+public:
+	void Rank(const std::vector<ParetoPoint>& points);
+
+	int GetNumFronts() const { return static_cast<int>(m_frontSizes.size()); }
+	int GetFrontSize(const int frontIndex) const { return m_frontSizes[frontIndex]; }
+	// 0 is the first front
+	int GetRank(const int pointIndex) const { return m_ranks[pointIndex]; }
+	float GetCrowdingDistance(const int pointIndex) const { return m_crowdingDistances[pointIndex]; }
+
+	// Point indices from best to worst: by rank, then by crowding distance, then by score. Points
+	// with the best score have an infinite crowding distance, so the best score in the first front
+	// (the best score overall) is always first.
+	const std::vector<int>& GetOrder() const { return m_order; }
+
+private:
+	void ComputeCrowdingDistances(const std::vector<ParetoPoint>& points);
+
+private:
+	std::vector<int> m_ranks;
+	std::vector<float> m_crowdingDistances;
+	std::vector<int> m_frontSizes;
+	std::vector<int> m_order;
+};
@@ -0,0 +1,78 @@
+#include "pch.h"
+#include "Rating.h"
+
+#include "Util/Math.h"
+
+
+// ln(10) / 400
+constexpr float k_glickoQ = 0.0057565f;
+
+// Reduces the impact of a game based on the opponent's deviation
+static float GetDeviationWeight(const float deviation)
+{
+	return 1.0f / Math::Sqrt(1.0f + (3.0f * k_glickoQ * k_glickoQ * deviation * deviation) / (Math::PiF * Math::PiF));
+}
+
+static float GetExpectedScore(const float rating, const float opponentRating, const float weight)
+{
+	return 1.0f / (1.0f + Math::Power(10.0f, -weight * (rating - opponentRating) / 400.0f));
+}
+
+
+//static
+void Rating::Update(Rating& a, Rating& b, const float scoreA)
+{
+	const Rating oldA = a;
+	const float scoreB = 1.0f - scoreA;
+	a.UpdateFromGames(&b, &scoreA, 1);
+	b.UpdateFromGames(&oldA, &scoreB, 1);
+}
+
+//static
+float Rating::GetGameScore(const int score, const int opponentScore)
+{
+	return (score > opponentScore) ? 1.0f : ((score < opponentScore) ? 0.0f : 0.5f);
+}
+
+void Rating::UpdateFromGames(const Rating* opponents, const float* scores, const int numGames)
+{
+	if (numGames <= 0)
+	{
+		return;
+	}
+
+	// 1 / d^2 and the sum that moves the rating
+	float inverseDSquared = 0.0f;
+	float ratingChangeSum = 0.0f;
+	for (int i = 0; i < numGames; i++)
+	{
+		const float weight = GetDeviationWeight(opponents[i].m_deviation);
+		const float expected = ::GetExpectedScore(m_rating, opponents[i].m_rating, weight);
+		inverseDSquared += k_glickoQ * k_glickoQ * weight * weight * expected * (1.0f - expected);
+		ratingChangeSum += weight * (scores[i] - expected);
+	}
+
+	const float inverseVariance = (1.0f / (m_deviation * m_deviation)) + inverseDSquared;
+	m_rating += (k_glickoQ / inverseVariance) * ratingChangeSum;
+	m_deviation = Math::Max(Math::Sqrt(1.0f / inverseVariance), k_minDeviation);
+}
+
+void Rating::AddUncertainty(const float deviationPerPeriod)
+{
+	m_deviation = Math::Min(Math::Sqrt((m_deviation * m_deviation) + (deviationPerPeriod * deviationPerPeriod)), k_initialDeviation);
+}
+
+float Rating::GetExpectedScore(const Rating& opponent) const
+{
+	// Uses both deviations, so it's symmetric: A's expected score plus B's is 1
+	const float combinedDeviation = Math::Sqrt((m_deviation * m_deviation) + (opponent.m_deviation * opponent.m_deviation));
+	return ::GetExpectedScore(m_rating, opponent.m_rating, GetDeviationWeight(combinedDeviation));
+}
+
+Rating Rating::MakeChildRating(const float childDeviation) const
+{
+	Rating child;
+	child.m_rating = m_rating;
+	child.m_deviation = Math::Max(m_deviation, childDeviation);
+	return child;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+// Glicko rating of a controller's strength
+// Reference: Glickman, "Parameter estimation in large dynamic paired comparison experiments" (1999)
+//
+// A rating is an estimate of strength (m_rating) with a standard deviation (m_deviation) saying how
+// sure the estimate is. Every game moves the rating towards the result and shrinks the deviation.
+// Games against opponents with uncertain ratings count for less. A rating difference of 400 means
+// the stronger player is expected to score about 10 times as well.
+//
+// Ratings persist across generations, so a controller that's been around for a while doesn't need
+// to be measured again from scratch. Between generations the deviation grows a bit, since the rest
+// of the population has changed.
+class Rating
+{
+public:
+	static constexpr float k_initialRating = 1500.0f;
+	static constexpr float k_initialDeviation = 350.0f;
+	// The deviation never goes below this, so ratings can keep up with a changing population
+	static constexpr float k_minDeviation = 30.0f;
+
+	// Updates both ratings after a game. 'scoreA' is 1 if A won, 0.5 for a tie, and 0 if A lost.
+	// Both updates use the ratings from before the game.
+	static void Update(Rating& a, Rating& b, const float scoreA);
+	// Score for a game with the given final scores, from the point of view of the first one
+	static float GetGameScore(const int score, const int opponentScore);
+
+	// Updates this rating from several games played at the same time (one Glicko rating period)
+	void UpdateFromGames(const Rating* opponents, const float* scores, const int numGames);
+	// Grows the deviation to account for time passing. The deviation never exceeds its initial value.
+	void AddUncertainty(const float deviationPerPeriod);
+
+	// Expected score (0 to 1) in a game against the opponent
+	float GetExpectedScore(const Rating& opponent) const;
+
+	// Rating for a child of this controller. Children start at their parent's rating, but are much
+	// less certain.
+	Rating MakeChildRating(const float childDeviation) const;
+
+public:
+	float m_rating = k_initialRating;
+	float m_deviation = k_initialDeviation;
+};
@@ -0,0 +1,322 @@
+#include "pch.h"
+#include "Speciation.h"
+
+#include <algorithm>
+#include <chrono>
+#include "NeuralNet/Network.h"
+#include "Util/Hash.h"
+#include "Util/Math.h"
+#include "Util/Simd.h"
+#include "Util/VantagePointTree.h"
+
+namespace
+{
+	// When this many new species have been created since the tree was built, rebuild it so they
+	// can be found without a linear search
+	constexpr int k_maxSpeciesOutsideTree = 32;
+
+	float SumAbs(const float* values, const int count)
+	{
+		int i = 0;
+		float sum = 0.0f;
+#if PLIB_SIMD_SSE2
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		__m128 sum0 = _mm_setzero_ps();
+		__m128 sum1 = _mm_setzero_ps();
+		for (; i + 8 <= count; i += 8)
+		{
+			sum0 = _mm_add_ps(sum0, _mm_and_ps(_mm_loadu_ps(values + i), absMask));
+			sum1 = _mm_add_ps(sum1, _mm_and_ps(_mm_loadu_ps(values + i + 4), absMask));
+		}
+		float lanes[4];
+		_mm_storeu_ps(lanes, _mm_add_ps(sum0, sum1));
+		sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+		for (; i < count; i++)
+		{
+			sum += Math::Abs(values[i]);
+		}
+		return sum;
+	}
+
+	float SumAbsDifference(const float* a, const float* b, const int count)
+	{
+		int i = 0;
+		float sum = 0.0f;
+#if PLIB_SIMD_SSE2
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		__m128 sum0 = _mm_setzero_ps();
+		__m128 sum1 = _mm_setzero_ps();
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128 diff0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+			const __m128 diff1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+			sum0 = _mm_add_ps(sum0, _mm_and_ps(diff0, absMask));
+			sum1 = _mm_add_ps(sum1, _mm_and_ps(diff1, absMask));
+		}
+		float lanes[4];
+		_mm_storeu_ps(lanes, _mm_add_ps(sum0, sum1));
+		sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+		for (; i < count; i++)
+		{
+			sum += Math::Abs(a[i] - b[i]);
+		}
+		return sum;
+	}
+}
+
+//=============================================================================
+// CompatibilityGenome
+
+void CompatibilityGenome::Build(const Network& network)
+{
+	m_values.clear();
+	m_levelStart.clear();
+	m_neuronValueStart.clear();
+	m_neuronNumWeights.clear();
+	m_neuronActivation.clear();
+	m_neuronAbsSum.clear();
+
+	// The input level has no weights and its biases are never used, so only its size matters
+	uint64_t hash = Hash::k_fnvOffsetBasis;
+	const int numLevels = network.GetNumLevels();
+	if (numLevels > 0)
+	{
+		hash = Hash::Fnv1aSimpleObject(static_cast<int>(network.GetLevel(0).neurons.size()), hash);
+	}
+
+	for (int levelIndex = 1; levelIndex < numLevels; levelIndex++)
+	{
+		const NetworkLevel& level = network.GetLevel(levelIndex);
+		m_levelStart.push_back(static_cast<int>(m_neuronNumWeights.size()));
+		hash = Hash::Fnv1aSimpleObject(static_cast<int>(level.neurons.size()), hash);
+
+		for (const Neuron& neuron : level.neurons)
+		{
+			const int numWeights = static_cast<int>(neuron.weights.size());
+			const int valueStart = static_cast<int>(m_values.size());
+			m_values.insert(m_values.end(), neuron.weights.begin(), neuron.weights.end());
+			m_values.push_back(neuron.bias);
+
+			m_neuronValueStart.push_back(valueStart);
+			m_neuronNumWeights.push_back(numWeights);
+			m_neuronActivation.push_back(static_cast<uint8_t>(neuron.m_activationFunction));
+			m_neuronAbsSum.push_back(SumAbs(&m_values[valueStart], numWeights + 1));
+
+			hash = Hash::Fnv1aSimpleObject(numWeights, hash);
+			hash = Hash::Fnv1aSimpleObject(neuron.m_activationFunction, hash);
+		}
+	}
+	m_levelStart.push_back(static_cast<int>(m_neuronNumWeights.size()));
+	m_topologyHash = hash;
+}
+
+//=============================================================================
+// CompatibilityDistance
+
+float CompatibilityDistance::operator()(const CompatibilityGenome& a, const CompatibilityGenome& b) const
+{
+	// Fast path. The layouts match, so it's just the difference between the values.
+	if ((a.m_topologyHash == b.m_topologyHash) &&
+		(a.m_neuronNumWeights == b.m_neuronNumWeights) &&
+		(a.m_neuronActivation == b.m_neuronActivation))
+	{
+		const float valueDifference = SumAbsDifference(a.m_values.data(), b.m_values.data(), static_cast<int>(a.m_values.size()));
+		return m_valueWeight * valueDifference;
+	}
+
+	int numUnmatchedGenes = 0;
+	float valueDifference = 0.0f;
+
+	const int numLevelsA = static_cast<int>(a.m_levelStart.size()) - 1;
+	const int numLevelsB = static_cast<int>(b.m_levelStart.size()) - 1;
+	const int numLevels = Math::Max(numLevelsA, numLevelsB);
+	for (int levelIndex = 0; levelIndex < numLevels; levelIndex++)
+	{
+		const int numNeuronsA = (levelIndex < numLevelsA) ? (a.m_levelStart[levelIndex + 1] - a.m_levelStart[levelIndex]) : 0;
+		const int numNeuronsB = (levelIndex < numLevelsB) ? (b.m_levelStart[levelIndex + 1] - b.m_levelStart[levelIndex]) : 0;
+		const int numMatchedNeurons = Math::Min(numNeuronsA, numNeuronsB);
+
+		for (int n = 0; n < numMatchedNeurons; n++)
+		{
+			const int neuronA = a.m_levelStart[levelIndex] + n;
+			const int neuronB = b.m_levelStart[levelIndex] + n;
+			const float* valuesA = &a.m_values[a.m_neuronValueStart[neuronA]];
+			const float* valuesB = &b.m_values[b.m_neuronValueStart[neuronB]];
+			const int numWeightsA = a.m_neuronNumWeights[neuronA];
+			const int numWeightsB = b.m_neuronNumWeights[neuronB];
+			const int numMatchedWeights = Math::Min(numWeightsA, numWeightsB);
+
+			valueDifference += SumAbsDifference(valuesA, valuesB, numMatchedWeights);
+			valueDifference += SumAbs(valuesA + numMatchedWeights, numWeightsA - numMatchedWeights);
+			valueDifference += SumAbs(valuesB + numMatchedWeights, numWeightsB - numMatchedWeights);
+			valueDifference += Math::Abs(valuesA[numWeightsA] - valuesB[numWeightsB]);
+			numUnmatchedGenes += Math::Abs(numWeightsA - numWeightsB);
+			numUnmatchedGenes += (a.m_neuronActivation[neuronA] != b.m_neuronActivation[neuronB]) ? 1 : 0;
+		}
+
+		// Neurons that only exist in one network. Every weight, the bias, and the activation
+		// function are all unmatched.
+		for (int n = numMatchedNeurons; n < numNeuronsA; n++)
+		{
+			const int neuronA = a.m_levelStart[levelIndex] + n;
+			valueDifference += a.m_neuronAbsSum[neuronA];
+			numUnmatchedGenes += a.m_neuronNumWeights[neuronA] + 2;
+		}
+		for (int n = numMatchedNeurons; n < numNeuronsB; n++)
+		{
+			const int neuronB = b.m_levelStart[levelIndex] + n;
+			valueDifference += b.m_neuronAbsSum[neuronB];
+			numUnmatchedGenes += b.m_neuronNumWeights[neuronB] + 2;
+		}
+	}
+
+	return (m_topologyWeight * numUnmatchedGenes) + (m_valueWeight * valueDifference);
+}
+
+//=============================================================================
+// Speciation
+
+Speciation::Speciation(const Config& config) :
+	m_config(config),
+	m_threshold(config.m_initialThreshold)
+{
+	_ASSERT(config.m_targetNumSpecies > 0);
+	m_tree = new RepresentativeTree(config.m_distance);
+}
+
+Speciation::~Speciation()
+{
+	_ASSERT(m_tree != nullptr);
+	delete m_tree;
+}
+
+void Speciation::Speciate(const std::vector<const Network*>& networks, const std::vector<int>& points)
+{
+	_ASSERT(networks.size() == points.size());
+	const auto startTime = std::chrono::steady_clock::now();
+	m_numDistanceCalculations = 0;
+
+	const int numNetworks = static_cast<int>(networks.size());
+	m_genomes.resize(numNetworks);
+	for (int i = 0; i < numNetworks; i++)
+	{
+		m_genomes[i].Build(*networks[i]);
+	}
+
+	for (Species& species : m_species)
+	{
+		species.m_members.clear();
+	}
+	RebuildTree();
+
+	// Species created since the tree was last built. These are searched linearly.
+	std::vector<int> speciesOutsideTree;
+
+	for (int i = 0; i < numNetworks; i++)
+	{
+		const CompatibilityGenome& genome = m_genomes[i];
+
+		float bestDistance = m_threshold;
+		int bestSpecies = -1;
+		// Like NEAT, join the first compatible species rather than searching for the closest one.
+		// Stopping early is what keeps the search fast.
+		const int treeItem = m_tree->FindNearest(genome, m_threshold, bestDistance, m_threshold);
+		if (treeItem >= 0)
+		{
+			bestSpecies = m_treeSpeciesIndex[treeItem];
+		}
+		for (int outsideIndex = 0; (bestSpecies < 0) && (outsideIndex < speciesOutsideTree.size()); outsideIndex++)
+		{
+			const int speciesIndex = speciesOutsideTree[outsideIndex];
+			const float distance = m_config.m_distance(genome, m_species[speciesIndex].m_representative);
+			m_numDistanceCalculations++;
+			if (distance < bestDistance)
+			{
+				bestDistance = distance;
+				bestSpecies = speciesIndex;
+			}
+		}
+
+		if (bestSpecies >= 0)
+		{
+			m_species[bestSpecies].m_members.push_back(i);
+			continue;
+		}
+
+		// Nothing close enough, so start a new species
+		// The tree points into m_species, so it has to be rebuilt if adding to it reallocates
+		const bool willReallocate = (m_species.size() == m_species.capacity());
+		m_species.emplace_back();
+		Species& newSpecies = m_species.back();
+		newSpecies.m_id = m_nextSpeciesId++;
+		newSpecies.m_representative = genome;
+		newSpecies.m_members.push_back(i);
+		newSpecies.m_bestPoints = -1;
+		speciesOutsideTree.push_back(static_cast<int>(m_species.size()) - 1);
+
+		if (willReallocate || (speciesOutsideTree.size() >= k_maxSpeciesOutsideTree))
+		{
+			RebuildTree();
+			speciesOutsideTree.clear();
+		}
+	}
+	// The tree points into m_species, which is about to change
+	m_numDistanceCalculations += m_tree->GetNumDistanceCalculations();
+	m_tree->ResetStats();
+	m_tree->Clear();
+
+	// Remove species that have died out
+	m_species.erase(
+		std::remove_if(m_species.begin(), m_species.end(), [](const Species& species) { return species.m_members.empty(); }),
+		m_species.end());
+
+	// Each species' best member becomes the representative for next generation
+	for (Species& species : m_species)
+	{
+		int bestMember = species.m_members[0];
+		for (const int member : species.m_members)
+		{
+			if (points[member] > points[bestMember])
+			{
+				bestMember = member;
+			}
+		}
+		species.m_representative = m_genomes[bestMember];
+
+		if (points[bestMember] > species.m_bestPoints)
+		{
+			species.m_bestPoints = points[bestMember];
+			species.m_generationsWithoutImprovement = 0;
+		}
+		else
+		{
+			species.m_generationsWithoutImprovement++;
+		}
+	}
+
+	// Move the threshold towards the target number of species. The further off it is, the bigger
+	// the step, up to doubling or halving.
+	const float speciesRatio = static_cast<float>(GetNumSpecies()) / m_config.m_targetNumSpecies;
+	m_threshold *= Math::Clamp(::powf(speciesRatio, m_config.m_thresholdAdjustment), 0.5f, 2.0f);
+
+	const auto endTime = std::chrono::steady_clock::now();
+	m_speciateMilliseconds = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+void Speciation::RebuildTree()
+{
+	m_numDistanceCalculations += m_tree->GetNumDistanceCalculations();
+	m_tree->ResetStats();
+
+	std::vector<const CompatibilityGenome*> representatives;
+	representatives.reserve(m_species.size());
+	m_treeSpeciesIndex.clear();
+	for (int i = 0; i < m_species.size(); i++)
+	{
+		representatives.push_back(&m_species[i].m_representative);
+		m_treeSpeciesIndex.push_back(i);
+	}
+	m_tree->Build(representatives);
+}
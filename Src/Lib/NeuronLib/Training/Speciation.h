@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class Network;
+template <class T, class DistanceFunc> class VantagePointTree;
+
+// Flattened copy of a network used for compatibility distance calculations
+// The weights and bias of every neuron are packed into one array so networks with the same
+// topology can be compared with a single vectorized loop.
+class CompatibilityGenome
+{
+public:
+	CompatibilityGenome() {}
+	explicit CompatibilityGenome(const Network& network) { Build(network); }
+
+	// Reuses the existing allocations, so rebuilding a genome every generation is cheap
+	void Build(const Network& network);
+
+	// Hash of the neurons per level, weights per neuron, and activation functions
+	uint64_t GetTopologyHash() const { return m_topologyHash; }
+	int GetNumValues() const { return static_cast<int>(m_values.size()); }
+
+private:
+	friend class CompatibilityDistance;
+
+	uint64_t m_topologyHash = 0;
+	// Weights followed by bias for every neuron, not including the input level
+	std::vector<float> m_values;
+	// Index of the first neuron of each level, plus one past the last neuron
+	std::vector<int> m_levelStart;
+	// Per neuron data
+	std::vector<int> m_neuronValueStart;
+	std::vector<int> m_neuronNumWeights;
+	std::vector<uint8_t> m_neuronActivation;
+	// Sum of absolute values of the weights and bias. Used when a neuron has no match.
+	std::vector<float> m_neuronAbsSum;
+};
+
+// Compatibility distance between two networks
+//
+//   distance = (topologyWeight * unmatched genes) + (valueWeight * sum of |a - b|)
+//
+// Networks are lined up by level, neuron, and weight index. A weight, bias, or activation function
+// that only exists in one network is an unmatched gene, and missing values are compared against 0.
+// Both terms are metrics, so the distance satisfies the triangle inequality and can be used with a
+// VantagePointTree.
+class CompatibilityDistance
+{
+public:
+	float operator()(const CompatibilityGenome& a, const CompatibilityGenome& b) const;
+
+public:
+	float m_topologyWeight = 0.5f;
+	float m_valueWeight = 0.1f;
+};
+
+//=============================================================================
+
+class Species
+{
+public:
+	int m_id = 0;
+	// Members of other species are compared against this to decide which species they belong to
+	CompatibilityGenome m_representative;
+	// Indices of the members in the population passed to Speciation::Speciate
+	// Ordered the same as the population
+	std::vector<int> m_members;
+
+	// Best points scored by any member, ever
+	int m_bestPoints = 0;
+	int m_generationsWithoutImprovement = 0;
+};
+
+// Groups a population into species of similar networks
+//
+// Species persist across generations. Each generation, every network joins the species with the
+// first representative found within the compatibility threshold, or starts a new species.
+// Representatives are kept in a VantagePointTree so assigning N networks to S species takes about
+// N log S distance calculations instead of N * S.
+//
+// The threshold is adjusted after every call to move the number of species towards the target.
+class Speciation
+{
+public:
+	class Config
+	{
+	public:
+		int m_targetNumSpecies = 10;
+		float m_initialThreshold = 20.0f;
+		// Each generation the threshold is multiplied by (numSpecies / targetNumSpecies) ^ m_thresholdAdjustment
+		float m_thresholdAdjustment = 0.25f;
+		CompatibilityDistance m_distance;
+	};
+
+	Speciation(const Config& config);
+	~Speciation();
+
+	// Assigns every network to a species.
+	// 'points' is the score of each network this generation. It's used to pick each species'
+	// representative (its best member) and to track stagnation.
+	void Speciate(const std::vector<const Network*>& networks, const std::vector<int>& points);
+
+	const std::vector<Species>& GetSpecies() const { return m_species; }
+	int GetNumSpecies() const { return static_cast<int>(m_species.size()); }
+	float GetThreshold() const { return m_threshold; }
+
+	// Stats from the last call to Speciate
+	int GetNumDistanceCalculations() const { return m_numDistanceCalculations; }
+	double GetSpeciateMilliseconds() const { return m_speciateMilliseconds; }
+
+private:
+	typedef VantagePointTree<CompatibilityGenome, CompatibilityDistance> RepresentativeTree;
+
+	void RebuildTree();
+
+private:
+	const Config m_config;
+	float m_threshold = 0.0f;
+	int m_nextSpeciesId = 0;
+
+	std::vector<Species> m_species;
+	// Index into m_species of each item in the tree
+	std::vector<int> m_treeSpeciesIndex;
+	RepresentativeTree* m_tree = nullptr;
+
+	// Genome of every network in the population, kept between generations to reuse the allocations
+	std::vector<CompatibilityGenome> m_genomes;
+
+	int m_numDistanceCalculations = 0;
+	double m_speciateMilliseconds = 0.0;
+};
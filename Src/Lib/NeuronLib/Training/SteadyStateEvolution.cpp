@@ -0,0 +1,306 @@
+#include "pch.h"
+#include "SteadyStateEvolution.h"
+
+#include "AiControllerData.h"
+#include "MatchResultCache.h"
+#include "NeuralNet/Network.h"
+#include "NeuronBall/NeuronGame.h"
+#include "NeuronBall/Controllers/NeuralNetPlayerController.h"
+#include "Util/Math.h"
+
+
+// Everything a thread needs to play games on its own
+class SteadyStateEvolution::Worker
+{
+public:
+	Worker(const Random& rand) :
+		m_rand(rand)
+	{
+		m_players[0] = new NeuralNetPlayerController(m_rand);
+		m_players[1] = new NeuralNetPlayerController(m_rand);
+	}
+
+	~Worker()
+	{
+		delete m_players[0];
+		delete m_players[1];
+	}
+
+public:
+	Random m_rand;
+	NeuronGame m_game;
+	// Private copies of the networks being played, indexed by seat
+	NeuralNetPlayerController* m_players[2] = { nullptr, nullptr };
+
+	// Current matchup, indexed by seat
+	int m_slots[2] = { -1, -1 };
+	uint32_t m_versions[2] = { 0, 0 };
+	uint64_t m_hashes[2] = { 0, 0 };
+	bool m_isCached = false;
+	MatchResult m_result;
+};
+
+
+SteadyStateEvolution::SteadyStateEvolution(const Config& config, std::vector<AiControllerData*>& controllers, MatchResultCache& matchCache, const Random& rand) :
+	m_config(config),
+	m_controllers(controllers),
+	m_matchCache(matchCache),
+	m_rand(rand),
+	m_stopRequested(false)
+{
+	_ASSERT(config.m_resultsPerReplacement > 0);
+	_ASSERT(config.m_tournamentSize > 0);
+
+	m_numThreads = (config.m_numThreads > 0) ?
+		config.m_numThreads :
+		Math::Max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+SteadyStateEvolution::~SteadyStateEvolution()
+{
+	Stop();
+}
+
+void SteadyStateEvolution::Start()
+{
+	if (IsRunning())
+	{
+		return;
+	}
+	_ASSERT(m_controllers.size() >= 2);
+
+	// The controllers may have been replaced (eg. loaded from a file) since the last run
+	m_versions.assign(m_controllers.size(), 0);
+	m_resultsSinceReplacement = 0;
+	m_stopRequested = false;
+	m_startTime = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < m_numThreads; i++)
+	{
+		// Each worker gets its own stream so they never pick the same matchups
+		m_workers.push_back(new Worker(m_rand.Split(m_numWorkersCreated++)));
+	}
+	for (Worker* worker : m_workers)
+	{
+		m_threads.emplace_back(&SteadyStateEvolution::RunWorker, this, std::ref(*worker));
+	}
+}
+
+void SteadyStateEvolution::Stop()
+{
+	if (!IsRunning())
+	{
+		return;
+	}
+
+	m_stopRequested = true;
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+	m_threads.clear();
+
+	for (Worker* worker : m_workers)
+	{
+		delete worker;
+	}
+	m_workers.clear();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+	m_stats.m_runningSeconds += seconds * m_numThreads;
+}
+
+SteadyStateEvolution::Stats SteadyStateEvolution::GetStats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Stats stats = m_stats;
+	if (IsRunning())
+	{
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+		stats.m_runningSeconds += seconds * m_numThreads;
+	}
+	return stats;
+}
+
+void SteadyStateEvolution::RunWorker(Worker& worker)
+{
+	while (!m_stopRequested)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			PickMatchup(worker);
+		}
+
+		// Play the game without holding the lock. Everything used here belongs to the worker.
+		const auto gameStartTime = std::chrono::steady_clock::now();
+		if (!worker.m_isCached)
+		{
+			NeuronGame& game = worker.m_game;
+			game.ResetGame(m_config.m_gameDuration);
+			game.SetEarlyEndRules(m_config.m_earlyEndRules);
+			game.SetPlayerController(0, worker.m_players[0]);
+			game.SetPlayerController(1, worker.m_players[1]);
+			while (!game.IsGameOver() && !m_stopRequested)
+			{
+				game.Update();
+			}
+			if (!game.IsGameOver())
+			{
+				// Stopped partway through, so there's no result
+				break;
+			}
+			worker.m_result.m_scores[0] = game.GetPlayerScore(0);
+			worker.m_result.m_scores[1] = game.GetPlayerScore(1);
+		}
+		const double gameSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - gameStartTime).count();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stats.m_busySeconds += gameSeconds;
+		if (worker.m_isCached)
+		{
+			m_stats.m_numCachedResults++;
+		}
+		else
+		{
+			m_stats.m_numGamesPlayed++;
+			if (m_matchCache.IsEnabled())
+			{
+				m_matchCache.Store(worker.m_hashes[0], worker.m_hashes[1], m_config.m_gameRulesHash, worker.m_result);
+			}
+		}
+
+		// A replaced controller's record belongs to its new network now
+		if ((m_versions[worker.m_slots[0]] != worker.m_versions[0]) ||
+			(m_versions[worker.m_slots[1]] != worker.m_versions[1]))
+		{
+			m_stats.m_numStaleResults++;
+			continue;
+		}
+
+		const int score0 = worker.m_result.m_scores[0];
+		const int score1 = worker.m_result.m_scores[1];
+		AiControllerData* controller0 = m_controllers[worker.m_slots[0]];
+		AiControllerData* controller1 = m_controllers[worker.m_slots[1]];
+		controller0->m_winLossRecord.AddResult(score0, score1);
+		controller1->m_winLossRecord.AddResult(score1, score0);
+		Rating::Update(controller0->m_rating, controller1->m_rating, Rating::GetGameScore(score0, score1));
+
+		if (++m_resultsSinceReplacement >= m_config.m_resultsPerReplacement)
+		{
+			m_resultsSinceReplacement = 0;
+			ReplaceWeakestController(worker.m_rand);
+		}
+	}
+}
+
+void SteadyStateEvolution::PickMatchup(Worker& worker)
+{
+	Random& rand = worker.m_rand;
+	const int numControllers = static_cast<int>(m_controllers.size());
+
+	// Favor controllers that haven't played much, so everyone reaches the replacement threshold
+	// at about the same rate. Checking a small sample keeps this cheap for big populations.
+	int player = rand.NextInt(0, numControllers);
+	for (int i = 1; i < m_config.m_tournamentSize; i++)
+	{
+		const int candidate = rand.NextInt(0, numControllers);
+		if (m_controllers[candidate]->m_winLossRecord.GetNumGames() < m_controllers[player]->m_winLossRecord.GetNumGames())
+		{
+			player = candidate;
+		}
+	}
+	int opponent = rand.NextInt(0, numControllers - 1);
+	if (opponent >= player)
+	{
+		opponent++;
+	}
+
+	const int playerSeat = rand.NextInt(0, 2);
+	worker.m_slots[playerSeat] = player;
+	worker.m_slots[1 - playerSeat] = opponent;
+
+	for (int seat = 0; seat < 2; seat++)
+	{
+		const NeuralNetPlayerController* controller = m_controllers[worker.m_slots[seat]]->m_controller;
+		worker.m_versions[seat] = m_versions[worker.m_slots[seat]];
+		worker.m_hashes[seat] = controller->GetHash();
+	}
+
+	worker.m_isCached = m_matchCache.IsEnabled() &&
+		m_matchCache.Lookup(worker.m_hashes[0], worker.m_hashes[1], m_config.m_gameRulesHash, worker.m_result);
+	if (!worker.m_isCached)
+	{
+		for (int seat = 0; seat < 2; seat++)
+		{
+			worker.m_players[seat]->SetNetwork(*m_controllers[worker.m_slots[seat]]->m_controller->DebugGetNetwork());
+		}
+	}
+}
+
+void SteadyStateEvolution::ReplaceWeakestController(Random& rand)
+{
+	const int numControllers = static_cast<int>(m_controllers.size());
+
+	// Points per game, so controllers that have played more games aren't favored
+	const bool useRatings = m_config.m_useRatings;
+	auto getScore = [useRatings](const AiControllerData* controller)
+	{
+		return useRatings ?
+			controller->m_rating.m_rating :
+			static_cast<float>(controller->m_winLossRecord.GetPoints()) / controller->m_winLossRecord.GetNumGames();
+	};
+
+	int weakest = -1;
+	float weakestScore = 0.0f;
+	for (int i = 0; i < numControllers; i++)
+	{
+		const AiControllerData* controller = m_controllers[i];
+		if (controller->m_winLossRecord.GetNumGames() < m_config.m_minGamesBeforeReplacement)
+		{
+			continue;
+		}
+		const float score = getScore(controller);
+		if ((weakest < 0) || (score < weakestScore))
+		{
+			weakest = i;
+			weakestScore = score;
+		}
+	}
+	if (weakest < 0)
+	{
+		// Nobody has played enough games yet
+		return;
+	}
+
+	// Tournament selection among the controllers that have been evaluated
+	int parent = -1;
+	float parentScore = 0.0f;
+	for (int i = 0; i < m_config.m_tournamentSize; i++)
+	{
+		const int candidate = rand.NextInt(0, numControllers);
+		const AiControllerData* controller = m_controllers[candidate];
+		if ((candidate == weakest) || (controller->m_winLossRecord.GetNumGames() < m_config.m_minGamesBeforeReplacement))
+		{
+			continue;
+		}
+		const float score = getScore(controller);
+		if ((parent < 0) || (score > parentScore))
+		{
+			parent = candidate;
+			parentScore = score;
+		}
+	}
+	if (parent < 0)
+	{
+		// Try again after the next few results
+		return;
+	}
+
+	AiControllerData* child = m_controllers[weakest];
+	child->m_controller->Breed(rand, m_controllers[parent]->m_controller);
+	child->m_generation = m_controllers[parent]->m_generation + 1;
+	child->m_winLossRecord.Reset();
+	child->m_rating = m_controllers[parent]->m_rating.MakeChildRating(m_config.m_childRatingDeviation);
+	m_versions[weakest]++;
+	m_stats.m_numReplacements++;
+}
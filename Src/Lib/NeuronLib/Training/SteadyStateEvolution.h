@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include "NeuronBall/NeuronGame.h"
+#include "Util/Random.h"
+#include <thread>
+#include <vector>
+
+class AiControllerData;
+class MatchResultCache;
+
+// Steady-state evolution, run continuously on worker threads
+//
+// There are no generations. Each worker repeatedly picks a matchup, copies the two networks, plays
+// the game, and reports the result. Every m_resultsPerReplacement results, the weakest controller
+// that has played enough games is replaced by a child of a strong one. Nobody ever waits for the
+// slowest game in a season, so every core stays busy.
+//
+// Every controller slot has a version number that's bumped whenever it's replaced. Results for a
+// slot that was replaced while the game was being played describe a network that no longer exists,
+// so they're thrown away.
+class SteadyStateEvolution
+{
+public:
+	class Config
+	{
+	public:
+		// Worker threads playing games. 0 uses one per hardware thread.
+		int m_numThreads = 0;
+		float m_gameDuration = 60.0f;
+		EarlyEndRules m_earlyEndRules;
+		// Controllers can't be replaced or picked as parents until they've played this many games
+		int m_minGamesBeforeReplacement = 8;
+		// Number of new results needed before the next replacement
+		int m_resultsPerReplacement = 4;
+		// Parents are the best of this many randomly chosen controllers
+		int m_tournamentSize = 4;
+		// Pick parents and replacements by rating instead of points per game
+		bool m_useRatings = false;
+		float m_childRatingDeviation = 200.0f;
+		// Hash of the rules the games are played with, for the match cache
+		uint64_t m_gameRulesHash = 0;
+	};
+
+	class Stats
+	{
+	public:
+		int64_t m_numGamesPlayed = 0;
+		int64_t m_numCachedResults = 0;
+		// Results thrown away because a controller was replaced during the game
+		int64_t m_numStaleResults = 0;
+		int64_t m_numReplacements = 0;
+		// Time workers spent playing games and time they've been running, summed over all workers.
+		// Busy time divided by running time is how well the threads are being used.
+		double m_busySeconds = 0.0;
+		double m_runningSeconds = 0.0;
+	};
+
+	// The controllers are shared with the owner. While the workers are running, only touch them
+	// from inside a LockControllers() scope.
+	SteadyStateEvolution(const Config& config, std::vector<AiControllerData*>& controllers, MatchResultCache& matchCache, const Random& rand);
+	// Stops the workers
+	~SteadyStateEvolution();
+
+	void Start();
+	// Blocks until every worker has finished its current game
+	void Stop();
+	bool IsRunning() const { return !m_threads.empty(); }
+
+	// Holds off the workers while the lock is in scope
+	std::unique_lock<std::mutex> LockControllers() { return std::unique_lock<std::mutex>(m_mutex); }
+
+	// Lifetime stats, including any time spent before the last restart
+	Stats GetStats();
+	int GetNumThreads() const { return m_numThreads; }
+
+private:
+	class Worker;
+
+	void RunWorker(Worker& worker);
+	// The next two expect m_mutex to be locked
+	void PickMatchup(Worker& worker);
+	void ReplaceWeakestController(Random& rand);
+
+private:
+	const Config m_config;
+	std::vector<AiControllerData*>& m_controllers;
+	MatchResultCache& m_matchCache;
+	const Random m_rand;
+	int m_numThreads = 0;
+	// Used to give every worker its own random stream, even across restarts
+	uint64_t m_numWorkersCreated = 0;
+
+	// Guards everything below, and the controllers
+	std::mutex m_mutex;
+	// Bumped every time a controller slot is given a new network
+	std::vector<uint32_t> m_versions;
+	int m_resultsSinceReplacement = 0;
+	Stats m_stats;
+
+	std::chrono::steady_clock::time_point m_startTime;
+	std::atomic<bool> m_stopRequested;
+	std::vector<Worker*> m_workers;
+	std::vector<std::thread> m_threads;
+};
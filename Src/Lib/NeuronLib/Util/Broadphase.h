@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include "Util/Math.h"
+#include "Util/Shapes.h"
+#include "Util/Vector.h"
+
+// Cheap tests that rule out collisions with each shape's bounding circle, before the exact tests do
+// any rotation or corner math. They only reject shapes the exact tests would also find aren't
+// touching, so skipping the exact test never changes the result.
+namespace Broadphase
+{
+	// Added to every bounding circle, so rounding in the exact tests can never find a collision
+	// that was rejected here
+	constexpr float k_slack = 1e-3f;
+
+	// Whether the bounding circles of 'a' and 'b' overlap
+	inline bool CanCollide(const Shape& a, const Shape& b)
+	{
+		const float reach = a.GetBoundingRadius() + b.GetBoundingRadius() + k_slack;
+		return (b.m_pos - a.m_pos).GetLengthSquared() <= Math::Sqr(reach);
+	}
+
+	// Whether any part of 'shape' can be outside the box from (0, 0) to 'size'
+	inline bool CanLeaveBounds(const Shape& shape, const Vector2 size)
+	{
+		const float reach = shape.GetBoundingRadius() + k_slack;
+		return
+			(shape.m_pos.x < reach) ||
+			(shape.m_pos.y < reach) ||
+			(shape.m_pos.x > size.x - reach) ||
+			(shape.m_pos.y > size.y - reach);
+	}
+}
+
+// Counts how often one kind of broadphase test rejected a pair
+class BroadphaseCounter
+{
+public:
+	void Record(const bool isRejected)
+	{
+		m_numTests++;
+		m_numRejections += isRejected ? 1 : 0;
+	}
+
+	void Add(const BroadphaseCounter& other)
+	{
+		m_numTests += other.m_numTests;
+		m_numRejections += other.m_numRejections;
+	}
+
+	// Percentage of tests where the exact test was skipped
+	float GetRejectionPercent() const
+	{
+		return (m_numTests > 0) ? (100.0f * m_numRejections) / m_numTests : 0.0f;
+	}
+
+public:
+	int64_t m_numTests = 0;
+	int64_t m_numRejections = 0;
+};
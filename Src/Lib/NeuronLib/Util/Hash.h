@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>	// for std::is_trivially_copyable
+
+// FNV-1a hashing helpers
+// Used to build stable identities for data (eg. networks and game rules) so results can be
+// cached and looked up again later. Not suitable for anything security related.
+namespace Hash
+{
+	constexpr uint64_t k_fnvOffsetBasis = 14695981039346656037ull;
+	constexpr uint64_t k_fnvPrime = 1099511628211ull;
+
+	// Hashes 'size' bytes starting at 'data'. Pass in the result of a previous call as 'hash'
+	// to combine multiple blocks of data into a single hash.
+	inline uint64_t Fnv1a(const void* data, const size_t size, uint64_t hash = k_fnvOffsetBasis)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= k_fnvPrime;
+		}
+		return hash;
+	}
+
+	template<typename T>
+	inline uint64_t Fnv1aSimpleObject(const T& object, uint64_t hash = k_fnvOffsetBasis)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "This should only be called on simple objects");
+		return Fnv1a(&object, sizeof(object), hash);
+	}
+};
@@ -97,6 +97,7 @@ namespace Math
 	}
 	constexpr float DegToRad(float degrees) { return degrees * (PiF / 180.0f); }
 	constexpr float RadToDeg(float radians) { return radians * (180.0f / PiF); }
+	// Util/SimdMath.h has faster approximations of these for many values at once
 	inline float Sin(float f) { return ::sinf(f); }
 	inline float Cos(float f) { return ::cosf(f); }
 	inline float Tan(float f) { return ::tanf(f); }
@@ -2,18 +2,389 @@
 #include "Random.h"
 
 #include <chrono>
-#include <limits>
+#include <cmath>
+#include "Math.h"
+#include "Simd.h"
 
-//std::default_random_engine Random::s_generator((int)std::chrono::system_clock::now().time_since_epoch().count());
-std::normal_distribution<float> Random::s_gaussianDistribution(0.0f, 1.0f);	// (mean, standard deviation)
-std::uniform_real_distribution<float> Random::s_uniformRealDistribution;
+namespace
+{
+	// SplitMix64 finalizer. Used to scramble stream ids so nested splits don't collide.
+	uint64_t MixBits(uint64_t x)
+	{
+		x += 0x9E3779B97F4A7C15ull;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+		return x ^ (x >> 31);
+	}
+
+	uint64_t MakeUInt64(const uint32_t low, const uint32_t high)
+	{
+		return static_cast<uint64_t>(low) | (static_cast<uint64_t>(high) << 32);
+	}
+
+	// Lookup tables for the 128-layer Ziggurat method
+	// Reference: Marsaglia & Tsang, "The Ziggurat Method for Generating Random Variables" (2000)
+	class ZigguratTables
+	{
+	public:
+		static constexpr int k_numLayers = 128;
+		// Start of the tail. Everything past this is sampled with Marsaglia's tail method.
+		static constexpr double k_tailStart = 3.442619855899;
+		// Area of each layer
+		static constexpr double k_layerArea = 9.91256303526217e-3;
+		// Scales a signed 32-bit word into [-1..1)
+		static constexpr double k_wordScale = 2147483648.0;
+
+		static const ZigguratTables& Get()
+		{
+			// Built on first use. Function local statics are thread-safe to initialize.
+			static const ZigguratTables s_tables;
+			return s_tables;
+		}
+
+		// A word whose magnitude is below this is inside the rectangle of the layer, so it can be
+		// accepted without evaluating the density
+		uint32_t m_accept[k_numLayers];
+		// Scales a word into a value within the layer
+		float m_scale[k_numLayers];
+		// Value of the density function at the top edge of each layer
+		float m_density[k_numLayers];
+
+	private:
+		ZigguratTables()
+		{
+			double edge = k_tailStart;
+			double previousEdge = edge;
+			const double q = k_layerArea / exp(-0.5 * edge * edge);
+
+			m_accept[0] = static_cast<uint32_t>((edge / q) * k_wordScale);
+			m_accept[1] = 0;
+			m_scale[0] = static_cast<float>(q / k_wordScale);
+			m_scale[k_numLayers - 1] = static_cast<float>(edge / k_wordScale);
+			m_density[0] = 1.0f;
+			m_density[k_numLayers - 1] = static_cast<float>(exp(-0.5 * edge * edge));
+
+			for (int i = k_numLayers - 2; i >= 1; i--)
+			{
+				edge = sqrt(-2.0 * log((k_layerArea / edge) + exp(-0.5 * edge * edge)));
+				m_accept[i + 1] = static_cast<uint32_t>((edge / previousEdge) * k_wordScale);
+				previousEdge = edge;
+				m_density[i] = static_cast<float>(exp(-0.5 * edge * edge));
+				m_scale[i] = static_cast<float>(edge / k_wordScale);
+			}
+		}
+	};
+
+	// Hands out words from a random stream in chunks so the Ziggurat can use the bulk generator
+	// without knowing ahead of time how many words it will need
+	class BufferedWords
+	{
+	public:
+		// 'expectedWords' keeps small requests from generating a whole buffer of words they won't use
+		BufferedWords(Random& rand, const int expectedWords) :
+			m_rand(rand),
+			m_expectedWords(expectedWords)
+		{
+		}
+
+		uint32_t Next()
+		{
+			if (m_index >= m_size)
+			{
+				// Round up to whole blocks. Any words that aren't used are skipped.
+				m_size = Math::Clamp((m_expectedWords + 3) & ~3, 4, k_bufferSize);
+				m_expectedWords -= m_size;
+				m_rand.NextUInt32Bulk(m_buffer, m_size);
+				m_index = 0;
+			}
+			return m_buffer[m_index++];
+		}
+
+		// Returns a value in (0..1], so it's always safe to take the log of
+		float NextOpenFloat()
+		{
+			return static_cast<float>((Next() >> 8) + 1) * (1.0f / 16777216.0f);
+		}
+
+	private:
+		static constexpr int k_bufferSize = 256;
+		Random& m_rand;
+		int m_expectedWords;
+		uint32_t m_buffer[k_bufferSize];
+		int m_size = 0;
+		int m_index = 0;
+	};
+
+	float ZigguratGaussian(BufferedWords& words, const ZigguratTables& tables)
+	{
+		while (true)
+		{
+			// The low 7 bits pick the layer and the remaining bits are the signed position within
+			// it. Keeping them separate avoids the correlation in the original algorithm, where the
+			// same bits were used for both.
+			const uint32_t word = words.Next();
+			const int layer = static_cast<int>(word & (ZigguratTables::k_numLayers - 1));
+			const int32_t position = static_cast<int32_t>(word & ~static_cast<uint32_t>(ZigguratTables::k_numLayers - 1));
+			const uint32_t magnitude = (position < 0) ? (0u - static_cast<uint32_t>(position)) : static_cast<uint32_t>(position);
+			const float x = static_cast<float>(position) * tables.m_scale[layer];
+
+			// Fast path. Taken about 98.8% of the time.
+			if (magnitude < tables.m_accept[layer])
+			{
+				return x;
+			}
+
+			if (layer == 0)
+			{
+				// Sample from the tail past k_tailStart
+				const float tailStart = static_cast<float>(ZigguratTables::k_tailStart);
+				float tailX;
+				float tailY;
+				do
+				{
+					tailX = -::logf(words.NextOpenFloat()) / tailStart;
+					tailY = -::logf(words.NextOpenFloat());
+				} while (tailY + tailY < tailX * tailX);
+				return (position > 0) ? (tailStart + tailX) : -(tailStart + tailX);
+			}
+
+			// In the wedge between the rectangle and the curve. Compare against the actual density.
+			const float u = static_cast<float>(words.Next() >> 8) * (1.0f / 16777216.0f);
+			const float y = tables.m_density[layer] + (u * (tables.m_density[layer - 1] - tables.m_density[layer]));
+			if (y < ::expf(-0.5f * x * x))
+			{
+				return x;
+			}
+		}
+	}
+}
 
 void Random::Seed()
 {
-	m_generator.seed((int)std::chrono::system_clock::now().time_since_epoch().count());
+	Seed(static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count()), 0);
 }
 
 void Random::Seed(int seed)
 {
-	m_generator.seed(seed);
+	Seed(static_cast<uint64_t>(static_cast<uint32_t>(seed)), 0);
+}
+
+void Random::Seed(const uint64_t seed, const uint64_t stream)
+{
+	m_key[0] = static_cast<uint32_t>(seed);
+	m_key[1] = static_cast<uint32_t>(seed >> 32);
+	m_counter[0] = 0;
+	m_counter[1] = 0;
+	m_counter[2] = static_cast<uint32_t>(stream);
+	m_counter[3] = static_cast<uint32_t>(stream >> 32);
+	m_blockIndex = k_valuesPerBlock;
+	m_hasSpareGaussian = false;
+}
+
+Random Random::Split(const uint64_t streamIndex) const
+{
+	const uint64_t childStream = MixBits(GetStream() ^ MixBits(streamIndex + 1));
+	return Random(GetSeed(), childStream);
+}
+
+void Random::Jump(const uint64_t numBlocks)
+{
+	const uint64_t blockIndex = MakeUInt64(m_counter[0], m_counter[1]) + numBlocks;
+	m_counter[0] = static_cast<uint32_t>(blockIndex);
+	m_counter[1] = static_cast<uint32_t>(blockIndex >> 32);
+	m_blockIndex = k_valuesPerBlock;
+	m_hasSpareGaussian = false;
+}
+
+uint64_t Random::GetSeed() const
+{
+	return MakeUInt64(m_key[0], m_key[1]);
+}
+
+uint64_t Random::GetStream() const
+{
+	return MakeUInt64(m_counter[2], m_counter[3]);
+}
+
+float Random::NextGaussian()
+{
+	if (m_hasSpareGaussian)
+	{
+		m_hasSpareGaussian = false;
+		return m_spareGaussian;
+	}
+
+	// Box-Muller transform. u0 is in (0..1] so the log is always finite.
+	const float u0 = static_cast<float>((NextUInt32() >> 8) + 1) * k_floatFromBits;
+	const float u1 = static_cast<float>(NextUInt32() >> 8) * k_floatFromBits;
+	const float radius = Math::Sqrt(-2.0f * ::logf(u0));
+	float s;
+	float c;
+	Math::SinCos(Math::TwoPiF * u1, s, c);
+
+	m_spareGaussian = radius * s;
+	m_hasSpareGaussian = true;
+	return radius * c;
+}
+
+void Random::NextUInt32Bulk(uint32_t* dst, const int count)
+{
+	_ASSERT(count >= 0);
+	int i = 0;
+
+	// Use up what's left of the current block first so the sequence matches NextUInt32
+	while ((i < count) && (m_blockIndex < k_valuesPerBlock))
+	{
+		dst[i++] = m_block[m_blockIndex++];
+	}
+
+	const int numWholeBlocks = (count - i) / k_valuesPerBlock;
+	if (numWholeBlocks > 0)
+	{
+		GenerateBlocks(dst + i, numWholeBlocks);
+		i += numWholeBlocks * k_valuesPerBlock;
+	}
+
+	while (i < count)
+	{
+		dst[i++] = NextUInt32();
+	}
+}
+
+void Random::FillUniform(float* dst, const int count)
+{
+	// Generate the words in place, then convert them. Floats and words are the same size.
+	static_assert(sizeof(float) == sizeof(uint32_t), "Words are converted to floats in place");
+	uint32_t* words = reinterpret_cast<uint32_t*>(dst);
+	NextUInt32Bulk(words, count);
+	for (int i = 0; i < count; i++)
+	{
+		const uint32_t word = words[i];
+		dst[i] = static_cast<float>(word >> 8) * k_floatFromBits;
+	}
+}
+
+void Random::FillUniform(float* dst, const int count, const float minInclusive, const float maxExclusive)
+{
+	FillUniform(dst, count);
+	const float range = maxExclusive - minInclusive;
+	for (int i = 0; i < count; i++)
+	{
+		dst[i] = minInclusive + (range * dst[i]);
+	}
+}
+
+void Random::FillGaussian(float* dst, const int count)
+{
+	const ZigguratTables& tables = ZigguratTables::Get();
+	// Almost every value only needs one word. Ask for a little extra for the ones that don't.
+	BufferedWords words(*this, count + (count / 32) + 4);
+	for (int i = 0; i < count; i++)
+	{
+		dst[i] = ZigguratGaussian(words, tables);
+	}
+}
+
+void Random::FillGaussian(float* dst, const int count, const float mean, const float standardDeviation)
+{
+	FillGaussian(dst, count);
+	for (int i = 0; i < count; i++)
+	{
+		dst[i] = mean + (standardDeviation * dst[i]);
+	}
+}
+
+void Random::GenerateNextBlock()
+{
+	Philox4x32::GenerateBlock(m_counter, m_key, m_block);
+	m_blockIndex = 0;
+
+	// Increment the 64-bit block index, leaving the stream id alone
+	m_counter[0]++;
+	if (m_counter[0] == 0)
+	{
+		m_counter[1]++;
+	}
+}
+
+void Random::GenerateBlocks(uint32_t* dst, const int numBlocks)
+{
+	uint64_t blockIndex = MakeUInt64(m_counter[0], m_counter[1]);
+	int block = 0;
+
+#if PLIB_SIMD_SSE2
+	// Four blocks at a time, one block per lane. SSE2 has no 32x32->64 multiply for all four
+	// lanes at once, so the even and odd lanes are multiplied separately and recombined.
+	const __m128i multiplier0 = _mm_set1_epi32(static_cast<int>(Philox4x32::k_multiplier0));
+	const __m128i multiplier1 = _mm_set1_epi32(static_cast<int>(Philox4x32::k_multiplier1));
+	const __m128i lowMask = _mm_set_epi32(0, -1, 0, -1);
+	const __m128i highMask = _mm_set_epi32(-1, 0, -1, 0);
+	const __m128i stream0 = _mm_set1_epi32(static_cast<int>(m_counter[2]));
+	const __m128i stream1 = _mm_set1_epi32(static_cast<int>(m_counter[3]));
+
+	for (; block + 4 <= numBlocks; block += 4)
+	{
+		uint32_t indexLow[4];
+		uint32_t indexHigh[4];
+		for (int lane = 0; lane < 4; lane++)
+		{
+			const uint64_t index = blockIndex + lane;
+			indexLow[lane] = static_cast<uint32_t>(index);
+			indexHigh[lane] = static_cast<uint32_t>(index >> 32);
+		}
+
+		__m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indexLow));
+		__m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indexHigh));
+		__m128i c2 = stream0;
+		__m128i c3 = stream1;
+		uint32_t k0 = m_key[0];
+		uint32_t k1 = m_key[1];
+
+		for (int round = 0; round < Philox4x32::k_numRounds; round++)
+		{
+			const __m128i evenProduct0 = _mm_mul_epu32(c0, multiplier0);
+			const __m128i oddProduct0 = _mm_mul_epu32(_mm_srli_epi64(c0, 32), multiplier0);
+			const __m128i evenProduct1 = _mm_mul_epu32(c2, multiplier1);
+			const __m128i oddProduct1 = _mm_mul_epu32(_mm_srli_epi64(c2, 32), multiplier1);
+
+			const __m128i lo0 = _mm_or_si128(_mm_and_si128(evenProduct0, lowMask), _mm_slli_epi64(oddProduct0, 32));
+			const __m128i hi0 = _mm_or_si128(_mm_srli_epi64(evenProduct0, 32), _mm_and_si128(oddProduct0, highMask));
+			const __m128i lo1 = _mm_or_si128(_mm_and_si128(evenProduct1, lowMask), _mm_slli_epi64(oddProduct1, 32));
+			const __m128i hi1 = _mm_or_si128(_mm_srli_epi64(evenProduct1, 32), _mm_and_si128(oddProduct1, highMask));
+
+			c0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), _mm_set1_epi32(static_cast<int>(k0)));
+			c1 = lo1;
+			c2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), _mm_set1_epi32(static_cast<int>(k1)));
+			c3 = lo0;
+
+			k0 += Philox4x32::k_weyl0;
+			k1 += Philox4x32::k_weyl1;
+		}
+
+		// Transpose from one word per register to one block per register
+		const __m128i t0 = _mm_unpacklo_epi32(c0, c1);
+		const __m128i t1 = _mm_unpacklo_epi32(c2, c3);
+		const __m128i t2 = _mm_unpackhi_epi32(c0, c1);
+		const __m128i t3 = _mm_unpackhi_epi32(c2, c3);
+		__m128i* out = reinterpret_cast<__m128i*>(dst + (block * k_valuesPerBlock));
+		_mm_storeu_si128(out + 0, _mm_unpacklo_epi64(t0, t1));
+		_mm_storeu_si128(out + 1, _mm_unpackhi_epi64(t0, t1));
+		_mm_storeu_si128(out + 2, _mm_unpacklo_epi64(t2, t3));
+		_mm_storeu_si128(out + 3, _mm_unpackhi_epi64(t2, t3));
+
+		blockIndex += 4;
+	}
+#endif
+
+	uint32_t counter[4] = { 0, 0, m_counter[2], m_counter[3] };
+	for (; block < numBlocks; block++)
+	{
+		counter[0] = static_cast<uint32_t>(blockIndex);
+		counter[1] = static_cast<uint32_t>(blockIndex >> 32);
+		Philox4x32::GenerateBlock(counter, m_key, dst + (block * k_valuesPerBlock));
+		blockIndex++;
+	}
+
+	m_counter[0] = static_cast<uint32_t>(blockIndex);
+	m_counter[1] = static_cast<uint32_t>(blockIndex >> 32);
 }
@@ -1,42 +1,190 @@
 #pragma once
 
-#include <random>
+// For _ASSERT
+#include "crtdbg.h"
+#include <cstdint>
 
+// Philox4x32-10 counter-based random number generator
+// Reference: Salmon, Moraes, Dror & Shaw, "Parallel Random Numbers: As Easy as 1, 2, 3" (SC11)
+//
+// Each 128-bit counter is hashed with a 64-bit key to produce 128 random bits. There is no hidden
+// state, so any block of the sequence can be generated directly, which makes splitting streams
+// and jumping ahead free. The output only depends on integer math, so the sequence of words is
+// identical on every compiler and platform.
+class Philox4x32
+{
+public:
+	static constexpr int k_numRounds = 10;
+
+	// Generates one block of 4 random values for the given counter and key
+	static void GenerateBlock(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4])
+	{
+		uint32_t c0 = counter[0];
+		uint32_t c1 = counter[1];
+		uint32_t c2 = counter[2];
+		uint32_t c3 = counter[3];
+		uint32_t k0 = key[0];
+		uint32_t k1 = key[1];
+
+		for (int round = 0; round < k_numRounds; round++)
+		{
+			const uint64_t product0 = static_cast<uint64_t>(k_multiplier0) * c0;
+			const uint64_t product1 = static_cast<uint64_t>(k_multiplier1) * c2;
+			const uint32_t hi0 = static_cast<uint32_t>(product0 >> 32);
+			const uint32_t lo0 = static_cast<uint32_t>(product0);
+			const uint32_t hi1 = static_cast<uint32_t>(product1 >> 32);
+			const uint32_t lo1 = static_cast<uint32_t>(product1);
+
+			c0 = hi1 ^ c1 ^ k0;
+			c1 = lo1;
+			c2 = hi0 ^ c3 ^ k1;
+			c3 = lo0;
+
+			// Bump the key for the next round
+			k0 += k_weyl0;
+			k1 += k_weyl1;
+		}
+
+		out[0] = c0;
+		out[1] = c1;
+		out[2] = c2;
+		out[3] = c3;
+	}
+
+	static constexpr uint32_t k_multiplier0 = 0xD2511F53;
+	static constexpr uint32_t k_multiplier1 = 0xCD9E8D57;
+	static constexpr uint32_t k_weyl0 = 0x9E3779B9;		// Golden ratio
+	static constexpr uint32_t k_weyl1 = 0xBB67AE85;		// sqrt(3) - 1
+};
+
+//=============================================================================
+
+// Random number stream built on Philox4x32-10
+//
+// The 64-bit seed is used as the Philox key. The 128-bit counter is split into a 64-bit block
+// index (counter words 0 and 1) and a 64-bit stream id (counter words 2 and 3), so every
+// (seed, stream) pair is an independent sequence of 2^64 blocks.
+//
+// Every Random owns all of its state, including the spare value used by NextGaussian, so separate
+// instances can safely be used from separate threads. Give each thread its own stream with Split().
+//
+// Sequence definitions. The integer and uniform ones only use integer math and exact float
+// conversions, so they're the same across platforms and standard library versions:
+// - NextUInt32 returns the words of each block in order: block[0], block[1], block[2], block[3]
+// - NextFloat uses the top 24 bits of one word: (word >> 8) * 2^-24, giving [0..1)
+// - NextInt(min, max) uses Lemire's multiply-shift method with rejection, so it has no bias
+// - FillUniform produces exactly the same values as calling NextFloat in a loop
+// The Gaussian ones always use the same words in the same way, but go through the CRT's log,
+// exp and sin/cos, whose last bit can differ between standard libraries. So they only repeat
+// exactly with the same build:
+// - NextGaussian uses the Box-Muller transform on two words and caches the second result
+// - FillGaussian uses a 128-layer Ziggurat (Marsaglia & Tsang, 2000). It's a different sequence
+//   than NextGaussian.
 class Random
 {
 public:
+	static constexpr uint64_t k_defaultSeed = 0;
+
+	Random() { Seed(k_defaultSeed, 0); }
+	explicit Random(const uint64_t seed, const uint64_t stream = 0) { Seed(seed, stream); }
+
+	// Seeds from the clock
 	void Seed();
 	void Seed(int seed);
+	// Resets to the start of the given stream
+	void Seed(const uint64_t seed, const uint64_t stream);
+
+	// Returns a new generator with the same seed on a different stream.
+	// Streams derived from different indices (or from different parent streams) don't overlap,
+	// and splitting doesn't change the state of this generator.
+	Random Split(const uint64_t streamIndex) const;
+
+	// Advances the stream by 'numBlocks' blocks of 4 values without generating them.
+	// Any values remaining from the current block, and any cached Gaussian, are discarded.
+	void Jump(const uint64_t numBlocks);
+
+	uint64_t GetSeed() const;
+	uint64_t GetStream() const;
+
+	uint32_t NextUInt32()
+	{
+		if (m_blockIndex >= k_valuesPerBlock)
+		{
+			GenerateNextBlock();
+		}
+		return m_block[m_blockIndex++];
+	}
 
 	int NextInt()
 	{
-		std::uniform_int_distribution<int> distribution(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
-		return distribution(m_generator);
+		return static_cast<int>(NextUInt32());
 	}
 	int NextInt(int maxExclusive)
 	{
-		std::uniform_int_distribution<int> distribution(0, maxExclusive - 1);
-		return distribution(m_generator);
+		return NextInt(0, maxExclusive);
 	}
 	int NextInt(int minInclusive, int maxExclusive)
 	{
-		std::uniform_int_distribution<int> distribution(minInclusive, maxExclusive - 1);
-		return distribution(m_generator);
+		_ASSERT(minInclusive < maxExclusive);
+		const uint32_t range = static_cast<uint32_t>(static_cast<int64_t>(maxExclusive) - static_cast<int64_t>(minInclusive));
+		return static_cast<int>(static_cast<int64_t>(minInclusive) + NextUInt32(range));
 	}
+	// Returns a value in [0..1)
 	float NextFloat()
 	{
-		return s_uniformRealDistribution(m_generator);
+		return static_cast<float>(NextUInt32() >> 8) * k_floatFromBits;
 	}
 	float NextFloat(float minInclusive, float maxExclusive)
 	{
-		return minInclusive + (maxExclusive * s_uniformRealDistribution(m_generator));
+		return minInclusive + ((maxExclusive - minInclusive) * NextFloat());
 	}
-	float NextGaussian()
+	// Returns a value from the standard normal distribution (mean 0, standard deviation 1)
+	float NextGaussian();
+
+	// Bulk generation
+	// These are much faster than calling the single value functions in a loop because Philox
+	// blocks are generated several at a time using SIMD instructions when they're available.
+	void NextUInt32Bulk(uint32_t* dst, const int count);
+	// Fills 'dst' with values in [0..1)
+	void FillUniform(float* dst, const int count);
+	void FillUniform(float* dst, const int count, const float minInclusive, const float maxExclusive);
+	// Fills 'dst' with values from the standard normal distribution
+	void FillGaussian(float* dst, const int count);
+	void FillGaussian(float* dst, const int count, const float mean, const float standardDeviation);
+
+private:
+	static constexpr int k_valuesPerBlock = 4;
+	// 2^-24. Converts the top 24 bits of a word into a float in [0..1)
+	static constexpr float k_floatFromBits = 1.0f / 16777216.0f;
+
+	// Returns a value in [0..range) with no modulo bias
+	uint32_t NextUInt32(const uint32_t range)
 	{
-		return s_gaussianDistribution(m_generator);
+		uint64_t product = static_cast<uint64_t>(NextUInt32()) * range;
+		uint32_t low = static_cast<uint32_t>(product);
+		if (low < range)
+		{
+			const uint32_t threshold = (0u - range) % range;
+			while (low < threshold)
+			{
+				product = static_cast<uint64_t>(NextUInt32()) * range;
+				low = static_cast<uint32_t>(product);
+			}
+		}
+		return static_cast<uint32_t>(product >> 32);
 	}
+
+	void GenerateNextBlock();
+	// Writes the next 'numBlocks' blocks directly into 'dst' and advances the counter
+	void GenerateBlocks(uint32_t* dst, const int numBlocks);
+
 private:
-	std::default_random_engine m_generator;
-	static std::normal_distribution<float> s_gaussianDistribution;
-	static std::uniform_real_distribution<float> s_uniformRealDistribution;
+	uint32_t m_key[2] = { 0, 0 };
+	// Words 0-1 are the index of the next block to generate. Words 2-3 are the stream id.
+	uint32_t m_counter[4] = { 0, 0, 0, 0 };
+	uint32_t m_block[k_valuesPerBlock] = { 0, 0, 0, 0 };
+	int m_blockIndex = k_valuesPerBlock;
+
+	float m_spareGaussian = 0.0f;
+	bool m_hasSpareGaussian = false;
 };
@@ -0,0 +1,79 @@
+#include "pch.h"
+#include "ShapeDrawer.h"
+
+#include "crtdbg.h"	// for _ASSERT
+#include <SFML/Graphics.hpp>
+#include "Shapes.h"
+
+void ShapeDrawer::Draw(sf::RenderWindow& window, const Shape& shape)
+{
+	const float facing = shape.GetFacing();
+	const int r = Math::Clamp(static_cast<int>(Math::Cos(facing) * 256.0f), 0, 255);
+	const int g = Math::Clamp(static_cast<int>(Math::Cos(facing + (k_2pi / 3.0f)) * 256.0f), 0, 255);
+	const int b = Math::Clamp(static_cast<int>(Math::Cos(facing - (k_2pi / 3.0f)) * 256.0f), 0, 255);
+	sf::Color fillColor(r, g, b);
+
+	if (const Circle* circle = dynamic_cast<const Circle*>(&shape))
+	{
+		Draw(window, *circle, fillColor, sf::Color::Transparent, 0.0f);
+	}
+	else if (const Rectangle* rect = dynamic_cast<const Rectangle*>(&shape))
+	{
+		Draw(window, *rect, fillColor, sf::Color::Transparent, 0.0f);
+	}
+	else
+	{
+		_ASSERT(false);
+	}
+}
+
+void ShapeDrawer::Draw(
+	sf::RenderWindow& window,
+	const Circle& circle,
+	const sf::Color& fillColor,
+	const sf::Color& outlineColor,
+	const float outlineThickness
+)
+{
+	const float k_radiusThicknessScalar = 0.05f;
+
+	// Draw ball
+
+	sf::CircleShape ball;
+	ball.setRadius(circle.m_radius);
+	ball.setRotation(Math::RadToDeg(circle.m_facing));
+	ball.setOrigin(circle.m_radius, circle.m_radius);
+	ball.setFillColor(fillColor);
+	ball.setOutlineColor(outlineColor);
+	ball.setOutlineThickness(outlineThickness);
+	ball.setPosition(circle.m_pos.x, circle.m_pos.y);
+	window.draw(ball);
+
+	sf::RectangleShape radius;
+	radius.setSize(sf::Vector2f(circle.m_radius, circle.m_radius * k_radiusThicknessScalar));
+	radius.setRotation(Math::RadToDeg(circle.m_facing));
+	radius.setOrigin(0.0f, 0.0f);
+	radius.setFillColor(sf::Color::White);
+	radius.setPosition(circle.m_pos.x, circle.m_pos.y);
+	window.draw(radius);
+}
+
+void ShapeDrawer::Draw(
+	sf::RenderWindow& window,
+	const Rectangle& rect,
+	const sf::Color& fillColor,
+	const sf::Color& outlineColor,
+	const float outlineThickness
+)
+{
+	// Draw rectangle
+	sf::RectangleShape shape;
+	shape.setSize(sf::Vector2f(2.0f * rect.m_halfLength, 2.0f * rect.m_halfWidth));
+	shape.setRotation(Math::RadToDeg(rect.m_facing));
+	shape.setOrigin(rect.m_halfLength, rect.m_halfWidth);
+	shape.setFillColor(fillColor);
+	shape.setOutlineColor(outlineColor);
+	shape.setOutlineThickness(outlineThickness);
+	shape.setPosition(rect.m_pos.x, rect.m_pos.y);
+	window.draw(shape);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+class Shape;
+class Circle;
+class Rectangle;
+namespace sf { class RenderWindow; }
+namespace sf { class Color; }
+
+// Draws shapes with SFML.
+// Kept out of Shapes.cpp so the physics doesn't depend on SFML, and anything that only simulates
+// (eg. the tests) can link without it.
+namespace ShapeDrawer
+{
+	// Colored by the shape's facing
+	void Draw(sf::RenderWindow& window, const Shape& shape);
+
+	void Draw(
+		sf::RenderWindow& window,
+		const Circle& circle,
+		const sf::Color& fillColor,
+		const sf::Color& outlineColor,
+		const float outlineThickness
+	);
+	void Draw(
+		sf::RenderWindow& window,
+		const Rectangle& rect,
+		const sf::Color& fillColor,
+		const sf::Color& outlineColor,
+		const float outlineThickness
+	);
+}
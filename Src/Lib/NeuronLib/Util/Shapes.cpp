@@ -3,12 +3,10 @@
 
 #include "crtdbg.h"	// for _ASSERT
 
-// TODO: Move SFML-related code into another class (ie. shape drawer)
-#include <SFML/Graphics.hpp>
-
 void Circle::ComputeMassAndInertia(const float density)
 {
 	m_mass = density * k_pi * Math::Sqr(m_radius);
+	m_boundingRadius = m_radius;
 
 	// Reference for inertia calculations of common shapes...
 	// https://en.wikipedia.org/wiki/List_of_moments_of_inertia
@@ -47,7 +45,7 @@ CollisionResponse Circle::Collide(const Rectangle& rect) const
 	Vector2 collisionNormal = Vector2::UnitX;
 
 	// Transform circle into rectangle's space so collision detection is done centered and axis-aligned
-	const Vector2 relCirclePos = (m_pos - rect.m_pos).RotateAroundOrigin(-rect.m_facing);
+	const Vector2 relCirclePos = rect.RotateToLocal(m_pos - rect.m_pos);
 
 	// Determine whether circle should be tested against width, length, or the corner and compute penetration vector
 	Vector2 absRelPenetrationVector = Vector2::Zero;
@@ -99,59 +97,24 @@ CollisionResponse Circle::Collide(const Rectangle& rect) const
 		const Vector2 signCorrection(Math::Sign(relCirclePos.x), Math::Sign(relCirclePos.y));
 
 		response.m_penetrationVector = (absRelPenetrationVector * signCorrection);
-		response.m_penetrationVector = response.m_penetrationVector.RotateAroundOrigin(rect.m_facing);
+		response.m_penetrationVector = rect.RotateToWorld(response.m_penetrationVector);
 
 		response.m_collisionPoint = (collisionPoint * signCorrection);
-		response.m_collisionPoint = response.m_collisionPoint.RotateAroundOrigin(rect.m_facing);
+		response.m_collisionPoint = rect.RotateToWorld(response.m_collisionPoint);
 		response.m_collisionPoint += rect.m_pos;
 
-		response.m_collisionNormal = (collisionNormal * signCorrection).RotateAroundOrigin(rect.m_facing);
+		response.m_collisionNormal = rect.RotateToWorld(collisionNormal * signCorrection);
 		response.m_collided = true;
 	}
 
 	return response;
 }
 
-void Circle::Draw(sf::RenderWindow& window) const
-{
-	// Draw ball
-	const int r = Math::Clamp(static_cast<int>(Math::Cos(m_facing) * 256.0f), 0, 255);
-	const int g = Math::Clamp(static_cast<int>(Math::Cos(m_facing + (k_2pi / 3.0f)) * 256.0f), 0, 255);
-	const int b = Math::Clamp(static_cast<int>(Math::Cos(m_facing - (k_2pi / 3.0f)) * 256.0f), 0, 255);
-	sf::Color fillColor(r, g, b);
-
-	Draw(window, fillColor, sf::Color::Transparent, 0.0f);
-}
-
-void Circle::Draw(sf::RenderWindow& window, const sf::Color& fillColor, const sf::Color& outlineColor, const float outlineThickness) const
-{
-	const float k_radiusThicknessScalar = 0.05f;
-
-	// Draw ball
-
-	sf::CircleShape ball;
-	ball.setRadius(m_radius);
-	ball.setRotation(Math::RadToDeg(m_facing));
-	ball.setOrigin(m_radius, m_radius);
-	ball.setFillColor(fillColor);
-	ball.setOutlineColor(outlineColor);
-	ball.setOutlineThickness(outlineThickness);
-	ball.setPosition(m_pos.x, m_pos.y);
-	window.draw(ball);
-
-	sf::RectangleShape radius;
-	radius.setSize(sf::Vector2f(m_radius, m_radius * k_radiusThicknessScalar));
-	radius.setRotation(Math::RadToDeg(m_facing));
-	radius.setOrigin(0.0f, 0.0f);
-	radius.setFillColor(sf::Color::White);
-	radius.setPosition(m_pos.x, m_pos.y);
-	window.draw(radius);
-}
-
 
 void Rectangle::ComputeMassAndInertia(const float density)
 {
 	m_mass = density * m_halfLength * m_halfWidth * 4.0f;
+	m_boundingRadius = Math::Sqrt(Math::Sqr(m_halfLength) + Math::Sqr(m_halfWidth));
 
 	// Reference for inertia calculations of common shapes...
 	// https://en.wikipedia.org/wiki/List_of_moments_of_inertia
@@ -170,7 +133,7 @@ CollisionResponse Rectangle::Collide(const Circle& other) const
 
 CollisionResponse Rectangle::Collide(const Rectangle& other) const
 {
-	// TODO: 1. Early-out if bounding circles are far enough apart
+	// 1. Shapes that are far apart are expected to be ruled out first by Broadphase::CanCollide
 
 	Array<CollisionResponse, 2> responses;
 
@@ -208,11 +171,10 @@ CollisionResponse Rectangle::Collide(const Rectangle& other) const
 		response.m_collided = true;
 
 		// Transform r1's position and facing into r0's space
-		const Vector2 relPos = (r1.m_pos - r0.m_pos).RotateAroundOrigin(-r0.m_facing);
-		const float relFacing = r1.m_facing - r0.m_facing;
+		const Vector2 relPos = r0.RotateToLocal(r1.m_pos - r0.m_pos);
 
 		// Get the corner points of r1 relative to r0
-		const Vector2 relForward = Vector2(Math::Cos(relFacing), Math::Sin(relFacing));
+		const Vector2 relForward = r0.RotateToLocal(r1.GetForward());
 		const Vector2 relRight(relForward.y, -relForward.x);
 		const Vector2 relHalfLength = relForward * r1.m_halfLength;
 		const Vector2 relHalfWidth = relRight * r1.m_halfWidth;
@@ -316,47 +278,17 @@ CollisionResponse Rectangle::Collide(const Rectangle& other) const
 		&responses[1];
 
 	// 5. Transform response back into world-space. At this point, the vectors are all still in shape0's space
-	response->m_penetrationVector = response->m_penetrationVector.RotateAroundOrigin(response->m_shape0->m_facing);
+	response->m_penetrationVector = response->m_shape0->RotateToWorld(response->m_penetrationVector);
 
-	response->m_collisionPoint = response->m_collisionPoint.RotateAroundOrigin(response->m_shape0->m_facing);
+	response->m_collisionPoint = response->m_shape0->RotateToWorld(response->m_collisionPoint);
 	response->m_collisionPoint += response->m_shape0->m_pos;
 
-	response->m_collisionNormal = response->m_collisionNormal.RotateAroundOrigin(response->m_shape0->m_facing);
+	response->m_collisionNormal = response->m_shape0->RotateToWorld(response->m_collisionNormal);
 
 	_ASSERT(response->m_collided == true);
 	return *response;
 }
 
-void Rectangle::Draw(sf::RenderWindow& window) const
-{
-	// Draw rectangle
-	const int r = Math::Clamp(static_cast<int>(Math::Cos(m_facing) * 256.0f), 0, 255);
-	const int g = Math::Clamp(static_cast<int>(Math::Cos(m_facing + (k_2pi / 3.0f)) * 256.0f), 0, 255);
-	const int b = Math::Clamp(static_cast<int>(Math::Cos(m_facing - (k_2pi / 3.0f)) * 256.0f), 0, 255);
-	sf::Color fillColor(r, g, b);
-
-	Draw(window, fillColor, sf::Color::Transparent, 0.0f);
-}
-
-void Rectangle::Draw(
-	sf::RenderWindow& window,
-	const sf::Color& fillColor,
-	const sf::Color& outlineColor,
-	const float outlineThickness
-) const
-{
-	// Draw rectangle
-	sf::RectangleShape rect;
-	rect.setSize(sf::Vector2f(2.0f * m_halfLength, 2.0f * m_halfWidth));
-	rect.setRotation(Math::RadToDeg(m_facing));
-	rect.setOrigin(m_halfLength, m_halfWidth);
-	rect.setFillColor(fillColor);
-	rect.setOutlineColor(outlineColor);
-	rect.setOutlineThickness(outlineThickness);
-	rect.setPosition(m_pos.x, m_pos.y);
-	window.draw(rect);
-}
-
 
 void CollisionResponse::ApplyResponse(Shape& shape0, Shape& shape1) const
 {
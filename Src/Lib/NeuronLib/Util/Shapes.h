@@ -6,29 +6,22 @@
 class CollisionResponse;
 class Circle;
 class Rectangle;
-namespace sf { class RenderWindow; }
-namespace sf { class Color; }
 
 class Shape
 {
 public:
-	// Computes and sets mass and inertia given the provided density
+	// Computes and sets mass and inertia given the provided density, and caches the bounding radius
 	// Since these values are dependent on the exact dimensions of the shape,
 	// this function should only be called after the shape's form has been set.
 	virtual void ComputeMassAndInertia(const float density) = 0;
 
+	// Only for when neither shape's type is known, since it takes two virtual calls to reach the
+	// right test. Circle and Rectangle are final, so calling Collide on them with the other shape's
+	// real type resolves at compile time.
 	virtual CollisionResponse Collide(const Shape& other) const = 0;
 	virtual CollisionResponse Collide(const Circle& other) const = 0;
 	virtual CollisionResponse Collide(const Rectangle& other) const = 0;
 
-	virtual void Draw(sf::RenderWindow& window) const = 0;
-	virtual void Draw(
-		sf::RenderWindow& window,
-		const sf::Color& fillColor,
-		const sf::Color& outlineColor,
-		const float outlineThickness
-	) const = 0;
-
 	Vector2 GetPos() const
 	{
 		return m_pos;
@@ -56,9 +49,37 @@ public:
 		return m_facing;
 	}
 
+	// Unit vector in the direction of m_facing
 	Vector2 GetForward() const
 	{
-		return Vector2(Math::Cos(m_facing), Math::Sin(m_facing));
+		// Cached against the facing it was computed for, so it's recomputed whenever m_facing
+		// changes, however it was set
+		if (m_facing != m_basisFacing)
+		{
+			m_basisFacing = m_facing;
+			m_basisForward = Vector2(Math::Cos(m_facing), Math::Sin(m_facing));
+		}
+		return m_basisForward;
+	}
+
+	// Same as v.RotateAroundOrigin(m_facing), without computing sin and cos again
+	Vector2 RotateToWorld(const Vector2 v) const
+	{
+		const Vector2 forward = GetForward();
+		return Vector2((v.x * forward.x) - (v.y * forward.y), (v.y * forward.x) + (v.x * forward.y));
+	}
+
+	// Same as v.RotateAroundOrigin(-m_facing), without computing sin and cos again
+	Vector2 RotateToLocal(const Vector2 v) const
+	{
+		const Vector2 forward = GetForward();
+		return Vector2((v.x * forward.x) + (v.y * forward.y), (v.y * forward.x) - (v.x * forward.y));
+	}
+
+	// Radius of the smallest circle around m_pos that holds the whole shape at any facing
+	float GetBoundingRadius() const
+	{
+		return m_boundingRadius;
 	}
 
 	// Returns the linear velocity of the shape at a given world position.
@@ -102,9 +123,18 @@ public:
 	float m_angularVelocity = 0.0f;
 	// kg*m^2
 	float m_inertia = 0.0f;
+
+protected:
+	// m. Set by ComputeMassAndInertia.
+	float m_boundingRadius = 0.0f;
+
+private:
+	// See GetForward. Starts out matching the default facing of 0.
+	mutable float m_basisFacing = 0.0f;
+	mutable Vector2 m_basisForward = Vector2::UnitX;
 };
 
-class Circle : public Shape
+class Circle final : public Shape
 {
 public:
 	virtual void ComputeMassAndInertia(const float density) override;
@@ -113,21 +143,13 @@ public:
 	virtual CollisionResponse Collide(const Circle& other) const override;
 	virtual CollisionResponse Collide(const Rectangle& other) const override;
 
-	virtual void Draw(sf::RenderWindow& window) const override;
-	virtual void Draw(
-		sf::RenderWindow& window,
-		const sf::Color& fillColor,
-		const sf::Color& outlineColor,
-		const float outlineThickness
-	) const override;
-
 public:
 	float m_radius = 0.0f;
 };
 
 // A facing angle of 0 radians points down the x-axis,
 // so length is along the x-axis and width is along the y-axis
-class Rectangle : public Shape
+class Rectangle final : public Shape
 {
 public:
 	virtual void ComputeMassAndInertia(const float density) override;
@@ -136,14 +158,6 @@ public:
 	virtual CollisionResponse Collide(const Circle& other) const override;
 	virtual CollisionResponse Collide(const Rectangle& other) const override;
 
-	virtual void Draw(sf::RenderWindow& window) const override;
-	virtual void Draw(
-		sf::RenderWindow& window,
-		const sf::Color& fillColor,
-		const sf::Color& outlineColor,
-		const float outlineThickness
-	) const override;
-
 protected:
 	Array<Vector2, 4> GetCornerPoints() const;
 
@@ -0,0 +1,145 @@
+#pragma once
+
+// Compile-time detection of the SIMD instruction sets that are safe to use.
+// x64 builds always have SSE2. 32-bit builds have it when compiled with /arch:SSE2 or higher,
+// which is the compiler default. Code using these should always provide a scalar fallback.
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define PLIB_SIMD_SSE2 1
+#include <emmintrin.h>
+#else
+#define PLIB_SIMD_SSE2 0
+#include <cmath>
+#endif
+
+namespace Simd
+{
+	// Comparison results for Float4, one per lane
+	class Mask4
+	{
+	public:
+#if PLIB_SIMD_SSE2
+		Mask4() = default;
+		explicit Mask4(const __m128 m) : m_m(m) {}
+
+		Mask4 operator&(const Mask4 rhs) const { return Mask4(_mm_and_ps(m_m, rhs.m_m)); }
+		Mask4 operator|(const Mask4 rhs) const { return Mask4(_mm_or_ps(m_m, rhs.m_m)); }
+		Mask4 operator!() const { return Mask4(_mm_xor_ps(m_m, _mm_castsi128_ps(_mm_set1_epi32(-1)))); }
+		bool Any() const { return _mm_movemask_ps(m_m) != 0; }
+		// Bit 'i' is set if lane 'i' is
+		int GetBits() const { return _mm_movemask_ps(m_m); }
+
+		__m128 m_m;
+#else
+		Mask4 operator&(const Mask4 rhs) const { Mask4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = m_lanes[i] && rhs.m_lanes[i]; } return r; }
+		Mask4 operator|(const Mask4 rhs) const { Mask4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = m_lanes[i] || rhs.m_lanes[i]; } return r; }
+		Mask4 operator!() const { Mask4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = !m_lanes[i]; } return r; }
+		bool Any() const { return m_lanes[0] || m_lanes[1] || m_lanes[2] || m_lanes[3]; }
+		// Bit 'i' is set if lane 'i' is
+		int GetBits() const { int bits = 0; for (int i = 0; i < 4; i++) { bits |= m_lanes[i] ? (1 << i) : 0; } return bits; }
+
+		bool m_lanes[4];
+#endif
+	};
+
+	// Four floats operated on together. Every operation gives exactly the same result in each lane
+	// as the scalar float operation, so code written with it matches the scalar code it replaces.
+	class Float4
+	{
+	public:
+		static constexpr int k_numLanes = 4;
+
+#if PLIB_SIMD_SSE2
+		Float4() = default;
+		Float4(const float f) : m_m(_mm_set1_ps(f)) {}
+		explicit Float4(const __m128 m) : m_m(m) {}
+
+		static Float4 Load(const float* p) { return Float4(_mm_loadu_ps(p)); }
+		void Store(float* p) const { _mm_storeu_ps(p, m_m); }
+
+		Float4 operator+(const Float4 rhs) const { return Float4(_mm_add_ps(m_m, rhs.m_m)); }
+		Float4 operator-(const Float4 rhs) const { return Float4(_mm_sub_ps(m_m, rhs.m_m)); }
+		Float4 operator*(const Float4 rhs) const { return Float4(_mm_mul_ps(m_m, rhs.m_m)); }
+		Float4 operator/(const Float4 rhs) const { return Float4(_mm_div_ps(m_m, rhs.m_m)); }
+		Float4 operator-() const { return Float4(_mm_xor_ps(m_m, _mm_set1_ps(-0.0f))); }
+
+		Mask4 operator<(const Float4 rhs) const { return Mask4(_mm_cmplt_ps(m_m, rhs.m_m)); }
+		Mask4 operator<=(const Float4 rhs) const { return Mask4(_mm_cmple_ps(m_m, rhs.m_m)); }
+		Mask4 operator>(const Float4 rhs) const { return Mask4(_mm_cmpgt_ps(m_m, rhs.m_m)); }
+		Mask4 operator>=(const Float4 rhs) const { return Mask4(_mm_cmpge_ps(m_m, rhs.m_m)); }
+		Mask4 operator==(const Float4 rhs) const { return Mask4(_mm_cmpeq_ps(m_m, rhs.m_m)); }
+		Mask4 operator!=(const Float4 rhs) const { return Mask4(_mm_cmpneq_ps(m_m, rhs.m_m)); }
+
+		__m128 m_m;
+#else
+		Float4() = default;
+		Float4(const float f) { for (int i = 0; i < 4; i++) { m_lanes[i] = f; } }
+
+		static Float4 Load(const float* p) { Float4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = p[i]; } return r; }
+		void Store(float* p) const { for (int i = 0; i < 4; i++) { p[i] = m_lanes[i]; } }
+
+		Float4 operator+(const Float4 rhs) const { Float4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = m_lanes[i] + rhs.m_lanes[i]; } return r; }
+		Float4 operator-(const Float4 rhs) const { Float4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = m_lanes[i] - rhs.m_lanes[i]; } return r; }
+		Float4 operator*(const Float4 rhs) const { Float4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = m_lanes[i] * rhs.m_lanes[i]; } return r; }
+		Float4 operator/(const Float4 rhs) const { Float4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = m_lanes[i] / rhs.m_lanes[i]; } return r; }
+		Float4 operator-() const { Float4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = -m_lanes[i]; } return r; }
+
+		Mask4 operator<(const Float4 rhs) const { Mask4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = m_lanes[i] < rhs.m_lanes[i]; } return r; }
+		Mask4 operator<=(const Float4 rhs) const { Mask4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = m_lanes[i] <= rhs.m_lanes[i]; } return r; }
+		Mask4 operator>(const Float4 rhs) const { Mask4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = m_lanes[i] > rhs.m_lanes[i]; } return r; }
+		Mask4 operator>=(const Float4 rhs) const { Mask4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = m_lanes[i] >= rhs.m_lanes[i]; } return r; }
+		Mask4 operator==(const Float4 rhs) const { Mask4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = m_lanes[i] == rhs.m_lanes[i]; } return r; }
+		Mask4 operator!=(const Float4 rhs) const { Mask4 r; for (int i = 0; i < 4; i++) { r.m_lanes[i] = m_lanes[i] != rhs.m_lanes[i]; } return r; }
+
+		float m_lanes[4];
+#endif
+
+		Float4& operator+=(const Float4 rhs) { return *this = *this + rhs; }
+		Float4& operator-=(const Float4 rhs) { return *this = *this - rhs; }
+		Float4& operator*=(const Float4 rhs) { return *this = *this * rhs; }
+	};
+
+	// Per lane 'mask ? a : b'
+	inline Float4 Select(const Mask4 mask, const Float4 a, const Float4 b)
+	{
+#if PLIB_SIMD_SSE2
+		return Float4(_mm_or_ps(_mm_and_ps(mask.m_m, a.m_m), _mm_andnot_ps(mask.m_m, b.m_m)));
+#else
+		Float4 r;
+		for (int i = 0; i < 4; i++) { r.m_lanes[i] = mask.m_lanes[i] ? a.m_lanes[i] : b.m_lanes[i]; }
+		return r;
+#endif
+	}
+
+	// Same tie-breaking as Math::Min and Math::Max
+	inline Float4 Min(const Float4 a, const Float4 b) { return Select(a < b, a, b); }
+	inline Float4 Max(const Float4 a, const Float4 b) { return Select(a < b, b, a); }
+	inline Float4 Clamp(const Float4 v, const Float4 a, const Float4 b) { return Max(a, Min(b, v)); }
+
+	inline Float4 Abs(const Float4 f)
+	{
+#if PLIB_SIMD_SSE2
+		return Float4(_mm_andnot_ps(_mm_set1_ps(-0.0f), f.m_m));
+#else
+		Float4 r;
+		for (int i = 0; i < 4; i++) { r.m_lanes[i] = ::fabsf(f.m_lanes[i]); }
+		return r;
+#endif
+	}
+
+	// Same as Math::Sign. 1, -1, or 0 for zero.
+	inline Float4 Sign(const Float4 f)
+	{
+		return Select(Float4(0.0f) < f, Float4(1.0f), Select(f < Float4(0.0f), Float4(-1.0f), Float4(0.0f)));
+	}
+
+	inline Float4 Sqrt(const Float4 f)
+	{
+#if PLIB_SIMD_SSE2
+		return Float4(_mm_sqrt_ps(f.m_m));
+#else
+		Float4 r;
+		for (int i = 0; i < 4; i++) { r.m_lanes[i] = ::sqrtf(f.m_lanes[i]); }
+		return r;
+#endif
+	}
+}
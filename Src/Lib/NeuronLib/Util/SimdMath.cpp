@@ -0,0 +1,258 @@
+#include "pch.h"
+#include "SimdMath.h"
+
+#include <cmath>
+#include "Constants.h"
+#include "Vector.h"
+
+namespace
+{
+	using Simd::Float4;
+	using Simd::Mask4;
+	constexpr int k_numLanes = Float4::k_numLanes;
+
+	// Rounds to the nearest whole number, with ties to even
+	Float4 Round(const Float4 f)
+	{
+#if PLIB_SIMD_SSE2
+		return Float4(_mm_cvtepi32_ps(_mm_cvtps_epi32(f.m_m)));
+#else
+		Float4 r;
+		for (int i = 0; i < k_numLanes; i++) { r.m_lanes[i] = ::nearbyintf(f.m_lanes[i]); }
+		return r;
+#endif
+	}
+
+	// Approximations of sin and cos on [-pi/4..pi/4], from Cephes' sinf and cosf
+	Float4 SinPolynomial(const Float4 x, const Float4 xSquared)
+	{
+		const Float4 p = ((Float4(-1.9515295891e-4f) * xSquared + 8.3321608736e-3f) * xSquared - 1.6666654611e-1f) * xSquared;
+		return (p * x) + x;
+	}
+
+	Float4 CosPolynomial(const Float4 xSquared)
+	{
+		const Float4 p = ((Float4(2.443315711809948e-5f) * xSquared - 1.388731625493765e-3f) * xSquared + 4.166664568298827e-2f) * xSquared;
+		return (p * xSquared) - (xSquared * 0.5f) + 1.0f;
+	}
+
+	// Approximation of atan on [-tan(pi/8)..tan(pi/8)], from Cephes' atanf
+	Float4 ATanPolynomial(const Float4 x)
+	{
+		const Float4 xSquared = x * x;
+		const Float4 p = (((Float4(8.05374449538e-2f) * xSquared - 1.38776856032e-1f) * xSquared + 1.99777106478e-1f) * xSquared - 3.33329491539e-1f) * xSquared;
+		return (p * x) + x;
+	}
+
+	// Calls 'function' on 'count' values four at a time. The last partial group is copied into
+	// padding so nothing is read or written past the end of the arrays.
+	template <int NumInputs, int NumOutputs, typename Function>
+	void ForEachFloat4(const float* const (&inputs)[NumInputs], float* const (&outputs)[NumOutputs], const int count, const Function& function)
+	{
+		Float4 in[NumInputs];
+		Float4 out[NumOutputs];
+		int i = 0;
+		for (; i + k_numLanes <= count; i += k_numLanes)
+		{
+			for (int n = 0; n < NumInputs; n++) { in[n] = Float4::Load(inputs[n] + i); }
+			function(in, out);
+			for (int n = 0; n < NumOutputs; n++) { out[n].Store(outputs[n] + i); }
+		}
+		if (i < count)
+		{
+			const int numLeft = count - i;
+			float padded[k_numLanes] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			for (int n = 0; n < NumInputs; n++)
+			{
+				for (int lane = 0; lane < numLeft; lane++) { padded[lane] = inputs[n][i + lane]; }
+				in[n] = Float4::Load(padded);
+			}
+			function(in, out);
+			for (int n = 0; n < NumOutputs; n++)
+			{
+				out[n].Store(padded);
+				for (int lane = 0; lane < numLeft; lane++) { outputs[n][i + lane] = padded[lane]; }
+			}
+		}
+	}
+
+	// Splits four Vector2s into their x and y components, and back again
+	void LoadVectors(const Vector2* v, Float4& outX, Float4& outY)
+	{
+#if PLIB_SIMD_SSE2
+		const __m128 v01 = _mm_loadu_ps(v[0].Ptr());
+		const __m128 v23 = _mm_loadu_ps(v[2].Ptr());
+		outX = Float4(_mm_shuffle_ps(v01, v23, _MM_SHUFFLE(2, 0, 2, 0)));
+		outY = Float4(_mm_shuffle_ps(v01, v23, _MM_SHUFFLE(3, 1, 3, 1)));
+#else
+		for (int i = 0; i < k_numLanes; i++)
+		{
+			outX.m_lanes[i] = v[i].x;
+			outY.m_lanes[i] = v[i].y;
+		}
+#endif
+	}
+
+	void StoreVectors(const Float4 x, const Float4 y, Vector2* outV)
+	{
+#if PLIB_SIMD_SSE2
+		_mm_storeu_ps(outV[0].Ptr(), _mm_unpacklo_ps(x.m_m, y.m_m));
+		_mm_storeu_ps(outV[2].Ptr(), _mm_unpackhi_ps(x.m_m, y.m_m));
+#else
+		for (int i = 0; i < k_numLanes; i++)
+		{
+			outV[i].x = x.m_lanes[i];
+			outV[i].y = y.m_lanes[i];
+		}
+#endif
+	}
+
+	// Same as ForEachFloat4, for functions of four vectors (and optionally four floats)
+	template <typename Function>
+	void ForEachVector4(const Vector2* vectors, const float* floats, Vector2* outVectors, const int count, const Function& function)
+	{
+		Float4 x;
+		Float4 y;
+		Float4 f = 1.0f;
+		int i = 0;
+		for (; i + k_numLanes <= count; i += k_numLanes)
+		{
+			LoadVectors(vectors + i, x, y);
+			if (floats != nullptr)
+			{
+				f = Float4::Load(floats + i);
+			}
+			function(x, y, f);
+			StoreVectors(x, y, outVectors + i);
+		}
+		if (i < count)
+		{
+			const int numLeft = count - i;
+			Vector2 paddedVectors[k_numLanes] = { Vector2::UnitX, Vector2::UnitX, Vector2::UnitX, Vector2::UnitX };
+			float paddedFloats[k_numLanes] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			for (int lane = 0; lane < numLeft; lane++)
+			{
+				paddedVectors[lane] = vectors[i + lane];
+				paddedFloats[lane] = (floats != nullptr) ? floats[i + lane] : 1.0f;
+			}
+			LoadVectors(paddedVectors, x, y);
+			f = Float4::Load(paddedFloats);
+			function(x, y, f);
+			StoreVectors(x, y, paddedVectors);
+			for (int lane = 0; lane < numLeft; lane++)
+			{
+				outVectors[i + lane] = paddedVectors[lane];
+			}
+		}
+	}
+}
+
+void Simd::SinCos(const Float4 radians, Float4& outSin, Float4& outCos)
+{
+	// Find the nearest multiple of pi/2, and the offset from it in [-pi/4..pi/4]. pi/2 is split
+	// into three parts with enough trailing zeros that multiplying them by the quadrant is exact,
+	// which keeps the offset accurate for large angles (Cody-Waite reduction).
+	constexpr float k_piOver2Part0 = 1.5703125f;
+	constexpr float k_piOver2Part1 = 4.837512969970703125e-4f;
+	constexpr float k_piOver2Part2 = 7.54978995489188216e-8f;
+	const Float4 quadrant = Round(radians * (2.0f / k_pi));
+	const Float4 x = ((radians - (quadrant * k_piOver2Part0)) - (quadrant * k_piOver2Part1)) - (quadrant * k_piOver2Part2);
+	const Float4 xSquared = x * x;
+	const Float4 sinX = SinPolynomial(x, xSquared);
+	const Float4 cosX = CosPolynomial(xSquared);
+
+	// Quadrant mod 4, as one of -2, -1, 0, 1 or 2 (where -2 and 2 are the same)
+	const Float4 quadrantMod4 = quadrant - (Round(quadrant * 0.25f) * 4.0f);
+	// sin(x + pi/2) = cos(x), sin(x + pi) = -sin(x), sin(x + 3pi/2) = -cos(x). Same for cos, one
+	// quadrant on.
+	const Mask4 isOdd = (quadrantMod4 == -1.0f) | (quadrantMod4 == 1.0f);
+	const Mask4 isSinNegative = (quadrantMod4 < -0.5f) | (quadrantMod4 > 1.5f);
+	const Mask4 isCosNegative = (quadrantMod4 < -1.5f) | (quadrantMod4 > 0.5f);
+	const Float4 s = Select(isOdd, cosX, sinX);
+	const Float4 c = Select(isOdd, sinX, cosX);
+	outSin = Select(isSinNegative, -s, s);
+	outCos = Select(isCosNegative, -c, c);
+}
+
+Simd::Float4 Simd::ATan2(const Float4 y, const Float4 x)
+{
+	// Work out the angle in the first octant, then reflect it into place
+	const Float4 absX = Abs(x);
+	const Float4 absY = Abs(y);
+	const Float4 minXY = Min(absX, absY);
+	const Float4 maxXY = Max(absX, absY);
+	const Mask4 isZero = maxXY == 0.0f;
+	const Float4 ratio = Select(isZero, 0.0f, minXY / Select(isZero, 1.0f, maxXY));
+
+	// Shift ratios above tan(pi/8) down by pi/4, so the polynomial only sees [0..tan(pi/8)]
+	constexpr float k_tanPiOver8 = 0.4142135623730950f;
+	const Mask4 isShifted = ratio > k_tanPiOver8;
+	const Float4 reduced = Select(isShifted, (ratio - 1.0f) / (ratio + 1.0f), ratio);
+	Float4 angle = ATanPolynomial(reduced) + Select(isShifted, Float4(k_pi * 0.25f), Float4(0.0f));
+
+	angle = Select(absY > absX, Float4(k_pi * 0.5f) - angle, angle);
+	angle = Select(x < 0.0f, Float4(k_pi) - angle, angle);
+	return Select(y < 0.0f, -angle, angle);
+}
+
+Simd::Float4 Simd::InvSqrt(const Float4 f)
+{
+#if PLIB_SIMD_SSE2
+	// The estimate has a relative error of up to 1.5 * 2^-12. One step of Newton-Raphson on
+	// 1/y^2 - f = 0 roughly squares that.
+	const Float4 estimate = Float4(_mm_rsqrt_ps(f.m_m));
+	return estimate * (Float4(1.5f) - (Float4(0.5f) * f * estimate * estimate));
+#else
+	Float4 r;
+	for (int i = 0; i < k_numLanes; i++) { r.m_lanes[i] = 1.0f / ::sqrtf(f.m_lanes[i]); }
+	return r;
+#endif
+}
+
+void Simd::SinCos(const float* radians, float* outSin, float* outCos, const int count)
+{
+	ForEachFloat4<1, 2>({ radians }, { outSin, outCos }, count, [](const Float4* in, Float4* out)
+	{
+		SinCos(in[0], out[0], out[1]);
+	});
+}
+
+void Simd::ATan2(const float* y, const float* x, float* outRadians, const int count)
+{
+	ForEachFloat4<2, 1>({ y, x }, { outRadians }, count, [](const Float4* in, Float4* out)
+	{
+		out[0] = ATan2(in[0], in[1]);
+	});
+}
+
+void Simd::InvSqrt(const float* f, float* outInvSqrt, const int count)
+{
+	ForEachFloat4<1, 1>({ f }, { outInvSqrt }, count, [](const Float4* in, Float4* out)
+	{
+		out[0] = InvSqrt(in[0]);
+	});
+}
+
+void Simd::Normalize(const Vector2* vectors, Vector2* outVectors, const int count)
+{
+	ForEachVector4(vectors, nullptr, outVectors, count, [](Float4& x, Float4& y, const Float4)
+	{
+		const Float4 invLength = InvSqrt((x * x) + (y * y));
+		x *= invLength;
+		y *= invLength;
+	});
+}
+
+void Simd::RotateAroundOrigin(const Vector2* vectors, const float* radians, Vector2* outVectors, const int count)
+{
+	ForEachVector4(vectors, radians, outVectors, count, [](Float4& x, Float4& y, const Float4 angle)
+	{
+		Float4 sin;
+		Float4 cos;
+		SinCos(angle, sin, cos);
+		const Float4 rotatedX = (x * cos) - (y * sin);
+		const Float4 rotatedY = (y * cos) + (x * sin);
+		x = rotatedX;
+		y = rotatedY;
+	});
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Simd.h"
+
+struct Vector2;
+
+// Approximate math functions that work on four values at once, and on whole arrays.
+//
+// These trade a little accuracy for speed, so they don't match Math::Sin etc. exactly. Anything
+// that has to match the scalar simulation bit for bit (eg. BatchedNeuronGame) should keep using
+// the Math versions. Error bounds are measured against the float libm functions, and checked by
+// the tests in Test/SimdMath.cpp.
+//
+// The same polynomial code is used with and without SSE2, so both give the same results. The only
+// exception is InvSqrt, which is exact without SSE2.
+namespace Simd
+{
+	// Largest magnitude of angle that SinCos handles to the accuracy below
+	constexpr float k_maxSinCosRadians = 8192.0f;
+
+	// Sine and cosine of 'radians'.
+	// Absolute error is at most 2e-7 for |radians| <= k_maxSinCosRadians, and slowly grows beyond that
+	void SinCos(const Float4 radians, Float4& outSin, Float4& outCos);
+
+	// Angle of (x, y) in radians, in the range [-pi..pi], the same as Math::ATan2.
+	// Absolute error is at most 4e-7. Both inputs must be finite. The sign of zero inputs is
+	// ignored, so ATan2(0, 0) is 0, and ATan2(+-0, -1) is pi.
+	Float4 ATan2(const Float4 y, const Float4 x);
+
+	// 1 / sqrt(f), from the hardware estimate refined with one Newton-Raphson step.
+	// Relative error is at most 4e-7. 'f' must be positive and no smaller than FLT_MIN.
+	Float4 InvSqrt(const Float4 f);
+
+	// Array versions of the above. 'count' doesn't have to be a multiple of four.
+	// Outputs may be the same arrays as inputs.
+	void SinCos(const float* radians, float* outSin, float* outCos, const int count);
+	void ATan2(const float* y, const float* x, float* outRadians, const int count);
+	void InvSqrt(const float* f, float* outInvSqrt, const int count);
+
+	// Same as Vector2::GetNormalized on each vector, using InvSqrt above.
+	// Vectors must not be zero length. Relative error of each component is at most 5e-7.
+	void Normalize(const Vector2* vectors, Vector2* outVectors, const int count);
+
+	// Same as Vector2::RotateAroundOrigin on each vector, by the angle with the same index, using
+	// SinCos above. Absolute error is at most 3e-7 times the length of the vector.
+	void RotateAroundOrigin(const Vector2* vectors, const float* radians, Vector2* outVectors, const int count);
+}
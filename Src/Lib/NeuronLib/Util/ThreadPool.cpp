@@ -0,0 +1,243 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+#include "Util/Math.h"
+
+
+ThreadPool::Batch::Batch(const int numJobs, const Job& job, const int numQueues) :
+	m_job(job),
+	m_numJobs(numJobs),
+	m_numQueues(numQueues),
+	m_queues(new JobQueue[numQueues]),
+	m_numJobsRemaining(numJobs),
+	m_startTime(std::chrono::steady_clock::now())
+{
+	// Contiguous ranges, so a worker's jobs stay near each other in memory
+	for (int i = 0; i < numQueues; i++)
+	{
+		m_queues[i].m_begin = static_cast<int>((static_cast<int64_t>(numJobs) * i) / numQueues);
+		m_queues[i].m_end = static_cast<int>((static_cast<int64_t>(numJobs) * (i + 1)) / numQueues);
+	}
+}
+
+
+ThreadPool::ThreadPool(const int numThreads)
+{
+	const int count = (numThreads > 0) ?
+		numThreads :
+		Math::Max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+	// Every worker exists before any thread starts
+	m_workers.resize(count);
+	const Random rand;
+	for (int i = 0; i < count; i++)
+	{
+		m_workers[i].m_rand = rand.Split(i);
+	}
+	for (int i = 0; i < count; i++)
+	{
+		m_threads.emplace_back(&ThreadPool::RunWorker, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	Wait();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopRequested = true;
+	}
+	m_batchStarted.notify_all();
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+void ThreadPool::Start(const int numJobs, const Job& job)
+{
+	_ASSERT(!IsBusy());
+	if (numJobs <= 0)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_batch = std::make_shared<Batch>(numJobs, job, static_cast<int>(m_workers.size()));
+	}
+	m_batchStarted.notify_all();
+}
+
+bool ThreadPool::IsBusy() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (m_batch != nullptr) && !m_batch->m_isFinished;
+}
+
+void ThreadPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_batchFinished.wait(lock, [this]() { return (m_batch == nullptr) || m_batch->m_isFinished; });
+}
+
+void ThreadPool::ParallelFor(const int numJobs, const Job& job)
+{
+	Start(numJobs, job);
+	Wait();
+}
+
+ThreadPool::WorkerStats ThreadPool::GetWorkerStats(const int threadIndex) const
+{
+	_ASSERT(!IsBusy());
+	WorkerStats stats = m_workers[threadIndex].m_stats;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	stats.m_idleSeconds = Math::Max(0.0, m_batchSeconds - stats.m_busySeconds);
+	return stats;
+}
+
+void ThreadPool::ResetStats()
+{
+	_ASSERT(!IsBusy());
+	for (Worker& worker : m_workers)
+	{
+		worker.m_stats = WorkerStats();
+	}
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_batchSeconds = 0.0;
+}
+
+void ThreadPool::RunWorker(const int threadIndex)
+{
+	std::shared_ptr<Batch> lastBatch;
+	while (true)
+	{
+		std::shared_ptr<Batch> batch;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_batchStarted.wait(lock, [this, &lastBatch]() { return m_stopRequested || (m_batch != lastBatch); });
+			if (m_stopRequested)
+			{
+				return;
+			}
+			batch = m_batch;
+		}
+		lastBatch = batch;
+		RunBatch(*batch, threadIndex);
+	}
+}
+
+void ThreadPool::RunBatch(Batch& batch, const int threadIndex)
+{
+	Worker& worker = m_workers[threadIndex];
+	while (true)
+	{
+		int begin = 0;
+		int end = 0;
+		if (!TakeJobs(batch, threadIndex, begin, end))
+		{
+			if (StealJobs(batch, threadIndex))
+			{
+				continue;
+			}
+			// Every queue is empty. Jobs other workers have already taken can't be stolen.
+			return;
+		}
+
+		const auto startTime = std::chrono::steady_clock::now();
+		for (int job = begin; job < end; job++)
+		{
+			batch.m_job(job, threadIndex);
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		// Stats are written before the jobs are counted as done, so they're complete by the time
+		// Wait() returns
+		const int numJobs = end - begin;
+		worker.m_stats.m_numJobs += numJobs;
+		worker.m_stats.m_busySeconds += seconds;
+		constexpr double k_smoothing = 0.25;
+		const double secondsPerJob = seconds / numJobs;
+		worker.m_secondsPerJob = (worker.m_secondsPerJob > 0.0) ?
+			worker.m_secondsPerJob + ((secondsPerJob - worker.m_secondsPerJob) * k_smoothing) :
+			secondsPerJob;
+
+		if ((batch.m_numJobsRemaining -= numJobs) == 0)
+		{
+			// Wait() only returns once m_isFinished is set, so the batch time is always recorded
+			// by then. Setting it under the lock also stops the notification slipping in between
+			// Wait() checking and sleeping.
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_batchSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - batch.m_startTime).count();
+			batch.m_isFinished = true;
+			m_batchFinished.notify_all();
+		}
+	}
+}
+
+bool ThreadPool::TakeJobs(Batch& batch, const int threadIndex, int& outBegin, int& outEnd)
+{
+	// Enough jobs to keep the worker busy for a while, so the lock is a tiny part of the cost. Never
+	// more than half the queue, so there's something left for other workers to steal.
+	constexpr double k_targetSecondsPerTake = 0.0005;
+	const double secondsPerJob = m_workers[threadIndex].m_secondsPerJob;
+	const int targetNumJobs = (secondsPerJob > 0.0) ?
+		static_cast<int>(Math::Min(k_targetSecondsPerTake / secondsPerJob, 1e6)) :
+		1;
+
+	JobQueue& queue = batch.m_queues[threadIndex];
+	std::lock_guard<std::mutex> lock(queue.m_mutex);
+	const int numQueued = queue.m_end - queue.m_begin;
+	if (numQueued <= 0)
+	{
+		return false;
+	}
+	const int numJobs = Math::Clamp(targetNumJobs, 1, Math::Max(1, numQueued / 2));
+	outBegin = queue.m_begin;
+	outEnd = queue.m_begin + numJobs;
+	queue.m_begin = outEnd;
+	return true;
+}
+
+bool ThreadPool::StealJobs(Batch& batch, const int threadIndex)
+{
+	// Try every other worker once, starting from a random one
+	const int numQueues = batch.m_numQueues;
+	Worker& worker = m_workers[threadIndex];
+	const int firstVictim = worker.m_rand.NextInt(0, numQueues);
+	for (int i = 0; i < numQueues; i++)
+	{
+		const int victim = (firstVictim + i) % numQueues;
+		if (victim == threadIndex)
+		{
+			continue;
+		}
+
+		int begin = 0;
+		int end = 0;
+		{
+			JobQueue& victimQueue = batch.m_queues[victim];
+			std::lock_guard<std::mutex> lock(victimQueue.m_mutex);
+			const int numQueued = victimQueue.m_end - victimQueue.m_begin;
+			if (numQueued <= 0)
+			{
+				continue;
+			}
+			// Round up, so a single queued job can still be stolen
+			const int numStolen = (numQueued + 1) / 2;
+			end = victimQueue.m_end;
+			begin = end - numStolen;
+			victimQueue.m_end = begin;
+		}
+
+		// Only this worker adds to its own queue, and it's empty, so nothing can be lost here
+		JobQueue& queue = batch.m_queues[threadIndex];
+		std::lock_guard<std::mutex> lock(queue.m_mutex);
+		_ASSERT(queue.m_begin >= queue.m_end);
+		queue.m_begin = begin;
+		queue.m_end = end;
+		worker.m_stats.m_numSteals++;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "Util/Random.h"
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads that run batches of independent jobs
+//
+// Threads are created once and sleep between batches, so starting a batch is cheap enough to do
+// every round of a season.
+//
+// Jobs can take very different amounts of time (eg. games that end early on score), so they're
+// balanced with work stealing. Each batch starts with the job indices split evenly into one queue
+// per worker. Workers take jobs from the front of their own queue, and once it's empty they steal
+// the back half of a randomly chosen worker's queue. Workers take several jobs at a time when jobs
+// are quick, so locking stays cheap compared to the work, and one at a time when jobs are slow, so
+// there's always work left to steal.
+class ThreadPool
+{
+public:
+	// Called once for each job. 'threadIndex' is in [0, GetNumThreads()) and is stable for the
+	// duration of the call, so it can be used to index per-thread scratch data.
+	using Job = std::function<void(const int jobIndex, const int threadIndex)>;
+
+	class WorkerStats
+	{
+	public:
+		int64_t m_numJobs = 0;
+		// Number of times the worker ran out of jobs and took some from another worker
+		int64_t m_numSteals = 0;
+		double m_busySeconds = 0.0;
+		// Time spent waiting for other workers to finish their batches
+		double m_idleSeconds = 0.0;
+	};
+
+	// 0 uses one thread per hardware thread
+	explicit ThreadPool(const int numThreads = 0);
+	// Waits for the current batch to finish
+	~ThreadPool();
+
+	int GetNumThreads() const { return static_cast<int>(m_threads.size()); }
+
+	// Starts running 'job' for every index in [0, numJobs) and returns immediately. The previous
+	// batch must be finished.
+	void Start(const int numJobs, const Job& job);
+	// Whether the current batch still has jobs running
+	bool IsBusy() const;
+	// Blocks until every job in the current batch has finished
+	void Wait();
+
+	// Same as Start followed by Wait
+	void ParallelFor(const int numJobs, const Job& job);
+
+	// Totals over every batch since the last ResetStats(). Only valid while the pool isn't busy.
+	WorkerStats GetWorkerStats(const int threadIndex) const;
+	void ResetStats();
+
+private:
+	// Job indices [m_begin, m_end) that a worker hasn't started yet
+	class JobQueue
+	{
+	public:
+		std::mutex m_mutex;
+		int m_begin = 0;
+		int m_end = 0;
+	};
+
+	// Everything about one call to Start. Workers keep their own reference, so a worker that's slow
+	// to notice a batch has finished can't take jobs from the next one.
+	class Batch
+	{
+	public:
+		Batch(const int numJobs, const Job& job, const int numQueues);
+
+	public:
+		const Job m_job;
+		const int m_numJobs;
+		const int m_numQueues;
+		std::unique_ptr<JobQueue[]> m_queues;
+		std::atomic<int> m_numJobsRemaining;
+		const std::chrono::steady_clock::time_point m_startTime;
+		// Set under ThreadPool::m_mutex once the last job is done and the batch time is recorded
+		bool m_isFinished = false;
+	};
+
+	// Per worker state. Only written by its own worker.
+	class Worker
+	{
+	public:
+		WorkerStats m_stats;
+		// Picks which worker to steal from
+		Random m_rand;
+		// Recent average time per job, used to pick how many jobs to take at once
+		double m_secondsPerJob = 0.0;
+	};
+
+	void RunWorker(const int threadIndex);
+	void RunBatch(Batch& batch, const int threadIndex);
+	// Takes the next few jobs from the front of the worker's own queue
+	bool TakeJobs(Batch& batch, const int threadIndex, int& outBegin, int& outEnd);
+	// Moves the back half of another worker's queue into this worker's queue
+	bool StealJobs(Batch& batch, const int threadIndex);
+
+private:
+	std::vector<std::thread> m_threads;
+	std::vector<Worker> m_workers;
+
+	// Guards m_batch, m_stopRequested and m_batchSeconds, and is used with both condition variables
+	mutable std::mutex m_mutex;
+	std::condition_variable m_batchStarted;
+	std::condition_variable m_batchFinished;
+	std::shared_ptr<Batch> m_batch;
+	bool m_stopRequested = false;
+	// Time from the start of each batch until its last job finished, since the last ResetStats()
+	double m_batchSeconds = 0.0;
+};
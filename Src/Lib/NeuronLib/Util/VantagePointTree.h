@@ -0,0 +1,237 @@
+#pragma once
+
+// For _ASSERT
+#include "crtdbg.h"
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Vantage-point tree for nearest neighbor searches in any metric space
+// Reference: Yianilos, "Data Structures and Algorithms for Nearest Neighbor Search in General
+//            Metric Spaces" (1993)
+//
+// Each node picks an item as its vantage point and splits the remaining items by their distance
+// to it, so only the distance function is needed. The distance must be a true metric (symmetric
+// and obeying the triangle inequality) or searches can miss the nearest item.
+//
+// DistanceFunc must be callable as float(const T&, const T&).
+// The tree only stores pointers, so the items must stay alive and unmoved until it's rebuilt.
+template <class T, class DistanceFunc>
+class VantagePointTree
+{
+public:
+	VantagePointTree(const DistanceFunc& distance) :
+		m_distance(distance)
+	{
+	}
+
+	void Build(const std::vector<const T*>& items)
+	{
+		m_items = items;
+		m_nodes.clear();
+		m_nodes.reserve(items.size());
+
+		m_scratch.resize(items.size());
+		for (int i = 0; i < m_scratch.size(); i++)
+		{
+			m_scratch[i].m_itemIndex = i;
+			m_scratch[i].m_distance = 0.0f;
+		}
+		m_root = BuildRecursive(0, static_cast<int>(m_scratch.size()));
+	}
+
+	void Clear()
+	{
+		m_items.clear();
+		m_nodes.clear();
+		m_root = -1;
+	}
+
+	int GetNumItems() const { return static_cast<int>(m_items.size()); }
+
+	// Returns the index (into the items passed to Build) of the item closest to 'target' that's less
+	// than 'maxDistance' away, or -1 if there isn't one.
+	// If 'goodEnoughDistance' is set, the search stops as soon as it finds an item closer than that,
+	// even if it isn't the closest.
+	int FindNearest(const T& target, const float maxDistance, float& outDistance, const float goodEnoughDistance = 0.0f) const
+	{
+		int bestIndex = -1;
+		outDistance = maxDistance;
+		if (m_root >= 0)
+		{
+			SearchRecursive(m_root, target, goodEnoughDistance, bestIndex, outDistance);
+		}
+		return bestIndex;
+	}
+
+	// Finds the 'k' items closest to 'target', closest first. Each result is (distance, item index).
+	void FindNearestK(const T& target, const int k, std::vector<std::pair<float, int>>& outNearest) const
+	{
+		outNearest.clear();
+		if ((m_root >= 0) && (k > 0))
+		{
+			// Max heap on distance, so the furthest of the items found so far is on top
+			SearchKRecursive(m_root, target, k, outNearest);
+			std::sort_heap(outNearest.begin(), outNearest.end());
+		}
+	}
+
+	// Number of times the distance function has been called since the last reset
+	int GetNumDistanceCalculations() const { return m_numDistanceCalculations; }
+	void ResetStats() { m_numDistanceCalculations = 0; }
+
+private:
+	struct Node
+	{
+		int m_itemIndex = -1;
+		// Items closer than this to the vantage point are in the 'inside' subtree
+		float m_radius = 0.0f;
+		int m_inside = -1;
+		int m_outside = -1;
+	};
+
+	struct ScratchItem
+	{
+		int m_itemIndex;
+		float m_distance;
+	};
+
+	// Builds a subtree from m_scratch[begin..end) and returns its node index
+	int BuildRecursive(const int begin, const int end)
+	{
+		if (begin >= end)
+		{
+			return -1;
+		}
+
+		const int nodeIndex = static_cast<int>(m_nodes.size());
+		m_nodes.emplace_back();
+		m_nodes[nodeIndex].m_itemIndex = m_scratch[begin].m_itemIndex;
+
+		if (end - begin > 1)
+		{
+			const T& vantagePoint = *m_items[m_scratch[begin].m_itemIndex];
+			for (int i = begin + 1; i < end; i++)
+			{
+				m_scratch[i].m_distance = m_distance(vantagePoint, *m_items[m_scratch[i].m_itemIndex]);
+			}
+			m_numDistanceCalculations += (end - begin - 1);
+
+			// Split the rest of the items at the median distance
+			const int median = (begin + 1 + end) / 2;
+			std::nth_element(
+				m_scratch.begin() + begin + 1,
+				m_scratch.begin() + median,
+				m_scratch.begin() + end,
+				[](const ScratchItem& a, const ScratchItem& b) { return a.m_distance < b.m_distance; });
+
+			// Note: m_nodes may reallocate during the recursive calls, so don't hold a reference
+			const float radius = m_scratch[median].m_distance;
+			const int inside = BuildRecursive(begin + 1, median);
+			const int outside = BuildRecursive(median, end);
+			m_nodes[nodeIndex].m_radius = radius;
+			m_nodes[nodeIndex].m_inside = inside;
+			m_nodes[nodeIndex].m_outside = outside;
+		}
+		return nodeIndex;
+	}
+
+	// Returns true if the search should stop
+	bool SearchRecursive(const int nodeIndex, const T& target, const float goodEnoughDistance, int& bestIndex, float& bestDistance) const
+	{
+		const Node& node = m_nodes[nodeIndex];
+		const float distance = m_distance(target, *m_items[node.m_itemIndex]);
+		m_numDistanceCalculations++;
+		if (distance < bestDistance)
+		{
+			bestDistance = distance;
+			bestIndex = node.m_itemIndex;
+			if (distance < goodEnoughDistance)
+			{
+				return true;
+			}
+		}
+
+		// Search the side the target is on first since it's most likely to shrink bestDistance.
+		// The triangle inequality rules out the other side unless the search radius crosses the split.
+		if (distance < node.m_radius)
+		{
+			if ((node.m_inside >= 0) && SearchRecursive(node.m_inside, target, goodEnoughDistance, bestIndex, bestDistance))
+			{
+				return true;
+			}
+			if ((node.m_outside >= 0) && (distance + bestDistance >= node.m_radius))
+			{
+				return SearchRecursive(node.m_outside, target, goodEnoughDistance, bestIndex, bestDistance);
+			}
+		}
+		else
+		{
+			if ((node.m_outside >= 0) && SearchRecursive(node.m_outside, target, goodEnoughDistance, bestIndex, bestDistance))
+			{
+				return true;
+			}
+			if ((node.m_inside >= 0) && (distance - bestDistance < node.m_radius))
+			{
+				return SearchRecursive(node.m_inside, target, goodEnoughDistance, bestIndex, bestDistance);
+			}
+		}
+		return false;
+	}
+
+	void SearchKRecursive(const int nodeIndex, const T& target, const int k, std::vector<std::pair<float, int>>& heap) const
+	{
+		const Node& node = m_nodes[nodeIndex];
+		const float distance = m_distance(target, *m_items[node.m_itemIndex]);
+		m_numDistanceCalculations++;
+		if (static_cast<int>(heap.size()) < k)
+		{
+			heap.emplace_back(distance, node.m_itemIndex);
+			std::push_heap(heap.begin(), heap.end());
+		}
+		else if (distance < heap.front().first)
+		{
+			std::pop_heap(heap.begin(), heap.end());
+			heap.back() = std::make_pair(distance, node.m_itemIndex);
+			std::push_heap(heap.begin(), heap.end());
+		}
+
+		// Same pruning as SearchRecursive, with the search radius being the kth closest so far.
+		// The radius can only shrink, so it's checked again after the first side is searched.
+		auto searchRadius = [&heap, k]()
+		{
+			return (static_cast<int>(heap.size()) < k) ? std::numeric_limits<float>::max() : heap.front().first;
+		};
+		if (distance < node.m_radius)
+		{
+			if (node.m_inside >= 0)
+			{
+				SearchKRecursive(node.m_inside, target, k, heap);
+			}
+			if ((node.m_outside >= 0) && (distance + searchRadius() >= node.m_radius))
+			{
+				SearchKRecursive(node.m_outside, target, k, heap);
+			}
+		}
+		else
+		{
+			if (node.m_outside >= 0)
+			{
+				SearchKRecursive(node.m_outside, target, k, heap);
+			}
+			if ((node.m_inside >= 0) && (distance - searchRadius() < node.m_radius))
+			{
+				SearchKRecursive(node.m_inside, target, k, heap);
+			}
+		}
+	}
+
+private:
+	DistanceFunc m_distance;
+	std::vector<const T*> m_items;
+	std::vector<Node> m_nodes;
+	std::vector<ScratchItem> m_scratch;
+	int m_root = -1;
+	mutable int m_numDistanceCalculations = 0;
+};
@@ -0,0 +1,240 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include <memory>
+#include "NeuronBall/BatchedNeuronGame.h"
+#include "NeuronBall/Controllers/ScriptedPlayerController.h"
+#include "NeuronBall/GameStateForNeuralNetInput.h"
+#include "NeuronBall/NeuronGame.h"
+#include "NeuronBall/NeuronPlayerController.h"
+#include "NeuronBall/NeuronPlayerInput.h"
+#include "Util/Math.h"
+#include "Util/Random.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Plays whatever input it was last given, so a NeuronGame gets exactly the same input as the batch
+	class FixedInputController : public NeuronPlayerController
+	{
+	public:
+		virtual void GetInputFromGameState(NeuronPlayerInput& outPlayerInput, const NeuronGame&, const int) override
+		{
+			outPlayerInput = m_input;
+		}
+
+	public:
+		NeuronPlayerInput m_input;
+	};
+}
+
+namespace Test
+{
+	TEST_CLASS(TestBatchedNeuronGame)
+	{
+	public:
+		TEST_METHOD(IdleGamesRunOutTheClock)
+		{
+			// Not a whole number of SIMD lanes, so the padding is exercised too
+			BatchedNeuronGame batch(5);
+			batch.ResetGames(1.0f);
+			Assert::AreEqual(5, batch.GetNumGamesRunning());
+			Assert::IsTrue(batch.GetGameState(4) == GameState::PreGame);
+			const Vector2 startPos = batch.GetPlayerPos(0, 0);
+
+			int numTicks = 0;
+			while (batch.GetNumGamesRunning() > 0)
+			{
+				batch.Update();
+				numTicks++;
+				Assert::IsTrue(numTicks <= 61);
+			}
+			Assert::IsTrue(numTicks >= 60);
+			for (int i = 0; i < batch.GetNumGames(); i++)
+			{
+				Assert::IsTrue(batch.GetGameState(i) == GameState::GameOver);
+				Assert::AreEqual(0, batch.GetPlayerScore(i, 0));
+				Assert::AreEqual(0, batch.GetPlayerScore(i, 1));
+				Assert::IsTrue(batch.GetPlayerPos(i, 0) == startPos);
+			}
+		}
+
+		TEST_METHOD(FinishedGamesStopUpdating)
+		{
+			BatchedNeuronGame batch(2);
+			batch.ResetGames(10.0f);
+			batch.ResetGame(0, 0.4f);
+			NeuronPlayerInput input;
+			input.m_speed = 1.0f;
+			for (int i = 0; i < batch.GetNumGames(); i++)
+			{
+				batch.SetPlayerInput(i, 0, input);
+			}
+
+			// Drives up to top speed, which takes less than a quarter of a second
+			for (int tick = 0; tick < 15; tick++)
+			{
+				batch.Update();
+			}
+			Assert::IsTrue(batch.GetPlayerVelocity(0, 0) == Vector2(k_maxForwardSpeed, 0.0f));
+			Assert::IsTrue(batch.GetPlayerVelocity(1, 0) == Vector2(k_maxForwardSpeed, 0.0f));
+			Assert::AreEqual(0.0f, batch.GetPlayerFacing(0, 0));
+
+			// Game 0 runs out of time, but game 1 keeps going
+			for (int tick = 0; tick < 15; tick++)
+			{
+				batch.Update();
+			}
+			Assert::IsTrue(batch.IsGameOver(0));
+			Assert::IsFalse(batch.IsGameOver(1));
+			const Vector2 finalPos = batch.GetPlayerPos(0, 0);
+			const Vector2 otherPos = batch.GetPlayerPos(1, 0);
+			batch.Update();
+			Assert::IsTrue(batch.GetPlayerPos(0, 0) == finalPos);
+			Assert::IsTrue(batch.GetPlayerPos(1, 0).x > otherPos.x);
+		}
+
+		TEST_METHOD(RestoredGameContinuesTheSame)
+		{
+			BatchedNeuronGame batch(2);
+			batch.ResetGames(10.0f);
+			NeuronPlayerInput input;
+			input.m_speed = 1.0f;
+			input.m_steering = 0.5f;
+			batch.SetPlayerInput(0, 0, input);
+			for (int tick = 0; tick < 30; tick++)
+			{
+				batch.Update();
+			}
+
+			// Game 1 picks up from game 0, and both carry on the same way
+			const NeuronGameSnapshot snapshot = batch.Snapshot(0);
+			batch.Restore(1, snapshot);
+			batch.SetPlayerInput(1, 0, input);
+			Assert::IsTrue(batch.GetGameState(1) == GameState::InGame);
+			for (int tick = 0; tick < 30; tick++)
+			{
+				batch.Update();
+			}
+			Assert::IsTrue(batch.GetPlayerPos(1, 0) == batch.GetPlayerPos(0, 0));
+			Assert::IsTrue(batch.GetPlayerVelocity(1, 0) == batch.GetPlayerVelocity(0, 0));
+			Assert::AreEqual(batch.GetPlayerFacing(0, 0), batch.GetPlayerFacing(1, 0));
+			Assert::AreEqual(batch.GetTimeRemaining(0), batch.GetTimeRemaining(1));
+
+			// Restoring doesn't change the snapshot's game
+			Assert::IsTrue(batch.GetPlayerPos(0, 0) != Vector2(snapshot.m_players[0].m_body.m_posX, snapshot.m_players[0].m_body.m_posY));
+			batch.Restore(0, snapshot);
+			Assert::IsTrue(batch.GetPlayerPos(0, 0) == Vector2(snapshot.m_players[0].m_body.m_posX, snapshot.m_players[0].m_body.m_posY));
+		}
+
+		TEST_METHOD(ObservationIsMirroredForPlayer1)
+		{
+			// Kickoff is symmetric, so both players see the same thing
+			BatchedNeuronGame batch(1);
+			batch.ResetGames(60.0f);
+			float state0[GameStateForNeuralNetInput::k_numGameStateInputs];
+			float state1[GameStateForNeuralNetInput::k_numGameStateInputs];
+			batch.GetObservation(0, 0, state0);
+			batch.GetObservation(0, 1, state1);
+			for (int i = 0; i < GameStateForNeuralNetInput::k_numGameStateInputs; i++)
+			{
+				Assert::IsTrue(Math::Equals(state0[i], state1[i], 0.001f));
+			}
+			// Own position, then forward
+			Assert::IsTrue(Math::Equals(state1[0], k_fieldLength * 0.1f, 0.001f));
+			Assert::IsTrue(Math::Equals(state1[4], 1.0f, 0.001f));
+			Assert::AreEqual(60.0f, state1[20]);
+		}
+
+		TEST_METHOD(MatchesNeuronGame)
+		{
+			// Not a whole number of SIMD lanes, so the padding is exercised too
+			constexpr int k_numGames = 7;
+			constexpr float k_gameDuration = 30.0f;
+			BatchedNeuronGame batch(k_numGames);
+			batch.ResetGames(k_gameDuration);
+			std::unique_ptr<NeuronGame> games[k_numGames];
+			FixedInputController controllers[k_numGames][2];
+			for (int i = 0; i < k_numGames; i++)
+			{
+				games[i].reset(new NeuronGame());
+				games[i]->ResetGame(k_gameDuration);
+				games[i]->SetPlayerController(0, &controllers[i][0]);
+				games[i]->SetPlayerController(1, &controllers[i][1]);
+			}
+			constexpr int k_numScripts = static_cast<int>(ScriptedOpponent::Count);
+			std::unique_ptr<ScriptedPlayerController> scripts[k_numScripts];
+			for (int i = 0; i < k_numScripts; i++)
+			{
+				scripts[i].reset(ScriptedPlayerController::Create(static_cast<ScriptedOpponent>(i)));
+			}
+
+			Random rand(1234);
+			int numGoals = 0;
+			int numTicks = 0;
+			while (batch.GetNumGamesRunning() > 0)
+			{
+				for (int i = 0; i < k_numGames; i++)
+				{
+					for (int p = 0; p < 2; p++)
+					{
+						// Mostly scripted players, which score goals and bump into each other, plus
+						// some random input to cover reversing and boosting
+						NeuronPlayerInput& input = controllers[i][p].m_input;
+						const int script = (i + p) % (k_numScripts + 1);
+						if (script < k_numScripts)
+						{
+							scripts[script]->GetInputFromGameState(input, *games[i], p);
+						}
+						else if ((numTicks % 20) == 0)
+						{
+							input.m_steering = rand.NextFloat(-1.5f, 1.5f);
+							input.m_speed = rand.NextFloat(-1.5f, 1.5f);
+							input.m_boost = rand.NextFloat(0.0f, 1.0f);
+						}
+						batch.SetPlayerInput(i, p, input);
+					}
+				}
+
+				batch.Update();
+				numTicks++;
+				Assert::IsTrue(numTicks <= 31 * 60);
+				for (int i = 0; i < k_numGames; i++)
+				{
+					NeuronGame& game = *games[i];
+					const int prevGoals = game.GetPlayerScore(0) + game.GetPlayerScore(1);
+					game.Update();
+					numGoals += game.GetPlayerScore(0) + game.GetPlayerScore(1) - prevGoals;
+
+					// The batch does the same float operations in the same order, so it matches exactly
+					Assert::IsTrue(batch.GetGameState(i) == game.GetGameState());
+					Assert::AreEqual(game.GetTimeRemaining(), batch.GetTimeRemaining(i));
+					Assert::IsTrue(batch.GetBallPos(i) == game.GetBall().m_shape.GetPos());
+					Assert::IsTrue(batch.GetBallVelocity(i) == game.GetBall().m_shape.GetVelocity());
+					for (int p = 0; p < 2; p++)
+					{
+						const NeuronPlayer& player = game.GetPlayer(p);
+						Assert::AreEqual(game.GetPlayerScore(p), batch.GetPlayerScore(i, p));
+						Assert::IsTrue(batch.GetPlayerPos(i, p) == player.GetPos());
+						Assert::IsTrue(batch.GetPlayerVelocity(i, p) == player.GetVelocity());
+						Assert::AreEqual(player.GetFacing(), batch.GetPlayerFacing(i, p));
+
+						const GameStateForNeuralNetInput expected(game, p);
+						float state[GameStateForNeuralNetInput::k_numGameStateInputs];
+						batch.GetObservation(i, p, state);
+						for (int s = 0; s < GameStateForNeuralNetInput::k_numGameStateInputs; s++)
+						{
+							Assert::AreEqual(expected.GetState()[s], state[s]);
+						}
+					}
+				}
+			}
+			Assert::IsTrue(numGoals > 0);
+			for (int i = 0; i < k_numGames; i++)
+			{
+				Assert::IsTrue(games[i]->IsGameOver());
+			}
+		}
+	};
+}
@@ -0,0 +1,197 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include "NeuronBall/NeuronGame.h"
+#include "NeuronBall/NeuronPlayer.h"
+#include "Util/Broadphase.h"
+#include "Util/Math.h"
+#include "Util/Random.h"
+#include "Util/Shapes.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Test
+{
+	TEST_CLASS(TestBroadphase)
+	{
+	public:
+		static Circle MakeCircle(const float radius, Random& rand)
+		{
+			Circle circle;
+			circle.m_radius = radius;
+			circle.m_facing = rand.NextFloat(-k_pi, k_pi);
+			circle.ComputeMassAndInertia(1.0f);
+			return circle;
+		}
+
+		static Rectangle MakeRectangle(const float halfLength, const float halfWidth, Random& rand)
+		{
+			Rectangle rect;
+			rect.m_halfLength = halfLength;
+			rect.m_halfWidth = halfWidth;
+			rect.m_facing = rand.NextFloat(-k_pi, k_pi);
+			rect.ComputeMassAndInertia(1.0f);
+			return rect;
+		}
+
+		// Moves 'b' to 'distance' from 'a' in a random direction
+		static void PlaceAt(const Shape& a, Shape& b, const float distance, Random& rand)
+		{
+			const float angle = rand.NextFloat(-k_pi, k_pi);
+			b.m_pos = a.m_pos + (Vector2(Math::Cos(angle), Math::Sin(angle)) * distance);
+		}
+
+		// Places 'b' around the edge of the bounding reach of 'a', and checks the broadphase never
+		// rejects a pair the exact test finds touching. Returns the number of pairs that collided.
+		template <typename ShapeA, typename ShapeB>
+		static int CheckNeverRejectsCollision(const ShapeA& a, ShapeB& b, Random& rand)
+		{
+			const float reach = a.GetBoundingRadius() + b.GetBoundingRadius();
+			int numCollided = 0;
+			for (int test = 0; test < 500; test++)
+			{
+				b.m_facing = rand.NextFloat(-k_pi, k_pi);
+				PlaceAt(a, b, reach * rand.NextFloat(0.5f, 1.01f), rand);
+				if (a.Collide(b).m_collided)
+				{
+					Assert::IsTrue(Broadphase::CanCollide(a, b));
+					numCollided++;
+				}
+			}
+			return numCollided;
+		}
+
+		TEST_METHOD(CanCollideAtBoundingReach)
+		{
+			Random rand(1);
+			const Circle a = MakeCircle(1.0f, rand);
+			Rectangle b = MakeRectangle(3.0f, 2.0f, rand);
+			const float reach = a.GetBoundingRadius() + b.GetBoundingRadius();
+			Assert::AreEqual(1.0f, a.GetBoundingRadius());
+			Assert::IsTrue(Math::Equals(b.GetBoundingRadius(), Math::Sqrt(13.0f), 0.0001f));
+
+			for (int test = 0; test < 100; test++)
+			{
+				PlaceAt(a, b, reach + (0.5f * Broadphase::k_slack), rand);
+				Assert::IsTrue(Broadphase::CanCollide(a, b));
+				Assert::IsTrue(Broadphase::CanCollide(b, a));
+				PlaceAt(a, b, reach + (2.0f * Broadphase::k_slack), rand);
+				Assert::IsFalse(Broadphase::CanCollide(a, b));
+				Assert::IsFalse(Broadphase::CanCollide(b, a));
+			}
+		}
+
+		TEST_METHOD(CanCollideNeverRejectsCollisions)
+		{
+			Random rand(2);
+			for (int shapes = 0; shapes < 10; shapes++)
+			{
+				const Circle circle = MakeCircle(rand.NextFloat(0.5f, 3.0f), rand);
+				const Rectangle rect = MakeRectangle(rand.NextFloat(0.5f, 4.0f), rand.NextFloat(0.5f, 4.0f), rand);
+				Circle otherCircle = MakeCircle(rand.NextFloat(0.5f, 3.0f), rand);
+				Rectangle otherRect = MakeRectangle(rand.NextFloat(0.5f, 4.0f), rand.NextFloat(0.5f, 4.0f), rand);
+
+				// Some of the placements have to collide, or the test doesn't show anything
+				Assert::IsTrue(CheckNeverRejectsCollision(circle, otherCircle, rand) > 0);
+				Assert::IsTrue(CheckNeverRejectsCollision(circle, otherRect, rand) > 0);
+				Assert::IsTrue(CheckNeverRejectsCollision(rect, otherCircle, rand) > 0);
+				Assert::IsTrue(CheckNeverRejectsCollision(rect, otherRect, rand) > 0);
+			}
+
+			// Circles that touch at their bounding reach, where the two tests are closest
+			const Circle a = MakeCircle(1.0f, rand);
+			Circle b = MakeCircle(2.0f, rand);
+			PlaceAt(a, b, 3.0f - 1e-4f, rand);
+			Assert::IsTrue(a.Collide(b).m_collided);
+			Assert::IsTrue(Broadphase::CanCollide(a, b));
+		}
+
+		TEST_METHOD(CanLeaveBoundsAtBoundingReach)
+		{
+			Random rand(3);
+			const Vector2 size(100.0f, 80.0f);
+			const Rectangle rect = MakeRectangle(3.0f, 2.0f, rand);
+			const float reach = rect.GetBoundingRadius();
+			// Just beyond and just within the bounding reach of a wall
+			const float clear = reach + (2.0f * Broadphase::k_slack);
+			const float close = reach + (0.5f * Broadphase::k_slack);
+
+			Rectangle test = rect;
+			test.m_pos = size * 0.5f;
+			Assert::IsFalse(Broadphase::CanLeaveBounds(test, size));
+
+			// Near each wall in turn
+			const Vector2 nearWalls[4][2] =
+			{
+				{ Vector2(clear, 40.0f), Vector2(close, 40.0f) },
+				{ Vector2(50.0f, clear), Vector2(50.0f, close) },
+				{ Vector2(size.x - clear, 40.0f), Vector2(size.x - close, 40.0f) },
+				{ Vector2(50.0f, size.y - clear), Vector2(50.0f, size.y - close) },
+			};
+			for (const auto& positions : nearWalls)
+			{
+				test.m_pos = positions[0];
+				Assert::IsFalse(Broadphase::CanLeaveBounds(test, size));
+				test.m_pos = positions[1];
+				Assert::IsTrue(Broadphase::CanLeaveBounds(test, size));
+			}
+		}
+
+		TEST_METHOD(CanLeaveBoundsNeverRejectsFieldCollisions)
+		{
+			Random rand(4);
+			NeuronGame game;
+			const Vector2 size(game.GetFieldLength(), game.GetFieldWidth());
+			NeuronPlayer player;
+			const float reach = player.m_shape.GetBoundingRadius();
+			Assert::IsTrue(Math::Equals(reach, NeuronPlayer::GetPlayerRadius(), 0.0001f));
+
+			int numCollided = 0;
+			for (int test = 0; test < 2000; test++)
+			{
+				// Anywhere within a little more than the bounding reach of the walls
+				const float margin = reach * 1.2f;
+				Vector2 pos(rand.NextFloat(0.0f, size.x), rand.NextFloat(0.0f, size.y));
+				switch (test % 4)
+				{
+				case 0: pos.x = rand.NextFloat(0.0f, margin); break;
+				case 1: pos.y = rand.NextFloat(0.0f, margin); break;
+				case 2: pos.x = size.x - rand.NextFloat(0.0f, margin); break;
+				case 3: pos.y = size.y - rand.NextFloat(0.0f, margin); break;
+				}
+				player.SetPos(pos);
+				player.SetFacing(rand.NextFloat(-k_pi, k_pi));
+
+				const bool canLeaveBounds = Broadphase::CanLeaveBounds(player.m_shape, size);
+				if (player.CollideWithField(game))
+				{
+					Assert::IsTrue(canLeaveBounds);
+					numCollided++;
+				}
+			}
+			Assert::IsTrue(numCollided > 0);
+		}
+
+		TEST_METHOD(Counter)
+		{
+			BroadphaseCounter counter;
+			Assert::AreEqual(0.0f, counter.GetRejectionPercent());
+			counter.Record(true);
+			counter.Record(false);
+			counter.Record(false);
+			counter.Record(true);
+			Assert::AreEqual(static_cast<int64_t>(4), counter.m_numTests);
+			Assert::AreEqual(static_cast<int64_t>(2), counter.m_numRejections);
+			Assert::AreEqual(50.0f, counter.GetRejectionPercent());
+
+			BroadphaseCounter other;
+			other.Record(false);
+			other.Record(false);
+			other.Record(false);
+			other.Record(false);
+			counter.Add(other);
+			Assert::AreEqual(static_cast<int64_t>(8), counter.m_numTests);
+			Assert::AreEqual(25.0f, counter.GetRejectionPercent());
+		}
+	};
+}
@@ -1,7 +1,9 @@
 #include "pch.h"
 #include "CppUnitTest.h"
 
+#include "NeuralNet/BackpropTrainer.h"
 #include "NeuralNet/Network.h"
+#include "NeuralNet/Optimizer.h"
 #include "Util/Math.h"
 #include "Util/Random.h"
 
@@ -33,5 +35,229 @@ namespace Test
 			// If this fails
 			Assert::IsTrue(outControl == outTest);
 		}
+
+		TEST_METHOD(Hash)
+		{
+			std::vector<int> neuronsPerLevel = { 4, 3, 2 };
+			Network network0(neuronsPerLevel);
+			Network network1(neuronsPerLevel);
+			Assert::IsTrue(network0.GetHash() == network1.GetHash());
+
+			Random rand;
+			rand.Seed(1234);
+			network0.Randomize(rand);
+			Assert::IsFalse(network0.GetHash() == network1.GetHash());
+
+			network1 = network0;
+			Assert::IsTrue(network0.GetHash() == network1.GetHash());
+
+			// Adding an identity level doesn't change the output, but it is a different network
+			network1.AddIdentityLevel(1);
+			Assert::IsFalse(network0.GetHash() == network1.GetHash());
+		}
+
+		TEST_METHOD(Parameters)
+		{
+			std::vector<int> neuronsPerLevel = { 4, 3, 2 };
+			Network network0(neuronsPerLevel);
+			Network network1(neuronsPerLevel);
+			Random rand(77);
+			network0.Randomize(rand);
+
+			// 3 neurons with 4 weights and 2 neurons with 3 weights, plus a bias for each
+			Assert::AreEqual(network0.GetNumParameters(), (3 * 5) + (2 * 4));
+
+			std::vector<float> parameters(network0.GetNumParameters());
+			network0.GetParameters(parameters.data());
+			Assert::AreEqual(parameters[4], network0.GetLevel(1).neurons[0].bias);
+			Assert::AreEqual(parameters[5], network0.GetLevel(1).neurons[1].weights[0]);
+
+			// The input level's biases aren't parameters, so compare behavior instead of the networks
+			network1.SetParameters(parameters.data());
+			std::vector<float> parameters1(network1.GetNumParameters());
+			network1.GetParameters(parameters1.data());
+			Assert::IsTrue(parameters == parameters1);
+			const std::vector<float> inputs = { 0.1f, -0.5f, 0.7f, 0.2f };
+			Assert::IsTrue(network0.Evaluate(inputs) == network1.Evaluate(inputs));
+		}
+	};
+
+	TEST_CLASS(TestOptimizer)
+	{
+	public:
+		TEST_METHOD(AdamFindsMinimum)
+		{
+			// Minimize (x - 3)^2 + (y + 1)^2
+			AdamOptimizer::Config config;
+			config.m_learningRate = 0.1f;
+			AdamOptimizer optimizer(2, config);
+			float parameters[2] = { 0.0f, 0.0f };
+			for (int step = 0; step < 500; step++)
+			{
+				const float gradient[2] = { 2.0f * (parameters[0] - 3.0f), 2.0f * (parameters[1] + 1.0f) };
+				optimizer.Step(parameters, gradient);
+			}
+			Assert::IsTrue(Math::Equals(parameters[0], 3.0f, 0.01f));
+			Assert::IsTrue(Math::Equals(parameters[1], -1.0f, 0.01f));
+			Assert::AreEqual(optimizer.GetNumSteps(), 500);
+
+			// The first step moves every parameter by about the learning rate, no matter the gradient
+			optimizer.Reset();
+			parameters[0] = 0.0f;
+			parameters[1] = 0.0f;
+			const float gradient[2] = { 1000.0f, -0.001f };
+			optimizer.Step(parameters, gradient);
+			Assert::IsTrue(Math::Equals(parameters[0], -0.1f, 0.001f));
+			Assert::IsTrue(Math::Equals(parameters[1], 0.1f, 0.001f));
+		}
+
+		TEST_METHOD(SgdFindsMinimum)
+		{
+			// Minimize (x - 3)^2 + (y + 1)^2
+			SgdOptimizer::Config config;
+			config.m_learningRate = 0.05f;
+			SgdOptimizer optimizer(2, config);
+			float parameters[2] = { 0.0f, 0.0f };
+			for (int step = 0; step < 500; step++)
+			{
+				const float gradient[2] = { 2.0f * (parameters[0] - 3.0f), 2.0f * (parameters[1] + 1.0f) };
+				optimizer.Step(parameters, gradient);
+			}
+			Assert::IsTrue(Math::Equals(parameters[0], 3.0f, 0.01f));
+			Assert::IsTrue(Math::Equals(parameters[1], -1.0f, 0.01f));
+		}
+	};
+
+	TEST_CLASS(TestBackpropTrainer)
+	{
+	public:
+		// Random inputs, with targets from the given network
+		static TrainingSet MakeTrainingSet(const Network& network, const int numInputs, const int numOutputs, const int numSamples, Random& rand)
+		{
+			TrainingSet data(numInputs, numOutputs);
+			std::vector<float> inputs(numInputs);
+			for (int s = 0; s < numSamples; s++)
+			{
+				for (float& input : inputs)
+				{
+					input = rand.NextFloat(-1.0f, 1.0f);
+				}
+				data.AddSample(inputs.data(), network.Evaluate(inputs).data());
+			}
+			return data;
+		}
+
+		static BackpropTrainer::Config MakeConfig(const int numThreads)
+		{
+			BackpropTrainer::Config config;
+			config.m_numThreads = numThreads;
+			config.m_minSamplesPerThread = 1;
+			return config;
+		}
+
+		TEST_METHOD(ForwardMatchesEvaluate)
+		{
+			Random rand(3);
+			Network network({ 5, 7, 3 });
+			network.Randomize(rand);
+			network.AddIdentityLevel(2);
+			const TrainingSet data = MakeTrainingSet(network, 5, 3, 23, rand);
+
+			BackpropTrainer trainer(network, MakeConfig(1));
+			Assert::IsTrue(trainer.ComputeLoss(data) < 1e-10f);
+		}
+
+		TEST_METHOD(GradientMatchesFiniteDifferences)
+		{
+			Random rand(4);
+			Network target({ 3, 5, 4, 2 });
+			target.Randomize(rand);
+			const TrainingSet data = MakeTrainingSet(target, 3, 2, 10, rand);
+
+			Network network({ 3, 5, 4, 2 });
+			network.Randomize(rand);
+			network.AddIdentityLevel(3);
+			BackpropTrainer trainer(network, MakeConfig(1));
+			std::vector<int> samples(data.GetNumSamples());
+			for (int i = 0; i < samples.size(); i++)
+			{
+				samples[i] = i;
+			}
+			std::vector<float> gradient;
+			trainer.ComputeGradient(data, samples.data(), data.GetNumSamples(), gradient);
+
+			std::vector<float> parameters(network.GetNumParameters());
+			network.GetParameters(parameters.data());
+			const float epsilon = 1e-3f;
+			for (int i = 0; i < parameters.size(); i++)
+			{
+				std::vector<float> shifted = parameters;
+				shifted[i] = parameters[i] + epsilon;
+				Network plus = network;
+				plus.SetParameters(shifted.data());
+				shifted[i] = parameters[i] - epsilon;
+				Network minus = network;
+				minus.SetParameters(shifted.data());
+				const float lossPlus = BackpropTrainer(plus, MakeConfig(1)).ComputeLoss(data);
+				const float lossMinus = BackpropTrainer(minus, MakeConfig(1)).ComputeLoss(data);
+				const float expected = (lossPlus - lossMinus) / (2.0f * epsilon);
+				Assert::IsTrue(Math::Abs(gradient[i] - expected) < 1e-3f + (0.02f * Math::Abs(expected)));
+			}
+		}
+
+		TEST_METHOD(ThreadsGiveSameGradient)
+		{
+			Random rand(5);
+			Network target({ 6, 9, 3 });
+			target.Randomize(rand);
+			const TrainingSet data = MakeTrainingSet(target, 6, 3, 37, rand);
+			std::vector<int> samples(data.GetNumSamples());
+			for (int i = 0; i < samples.size(); i++)
+			{
+				samples[i] = i;
+			}
+
+			Network network({ 6, 9, 3 });
+			network.Randomize(rand);
+			std::vector<float> singleThreaded;
+			std::vector<float> multiThreaded;
+			BackpropTrainer(network, MakeConfig(1)).ComputeGradient(data, samples.data(), data.GetNumSamples(), singleThreaded);
+			BackpropTrainer(network, MakeConfig(4)).ComputeGradient(data, samples.data(), data.GetNumSamples(), multiThreaded);
+			for (int i = 0; i < singleThreaded.size(); i++)
+			{
+				Assert::IsTrue(Math::Equals(singleThreaded[i], multiThreaded[i], 1e-5f));
+			}
+		}
+
+		TEST_METHOD(LearnsFunction)
+		{
+			for (const GradientOptimizer optimizer : { GradientOptimizer::Adam, GradientOptimizer::Sgd })
+			{
+				Random rand(6);
+				TrainingSet data(2, 1);
+				for (int s = 0; s < 256; s++)
+				{
+					const float inputs[2] = { rand.NextFloat(-2.0f, 2.0f), rand.NextFloat(-1.0f, 1.0f) };
+					const float target = (0.5f * sinf(inputs[0])) + (0.3f * inputs[1]);
+					data.AddSample(inputs, &target);
+				}
+
+				Network network({ 2, 12, 1 });
+				network.Randomize(rand);
+				BackpropTrainer::Config config = MakeConfig(2);
+				config.m_optimizer = optimizer;
+				config.m_learningRate = (optimizer == GradientOptimizer::Adam) ? 0.01f : 0.02f;
+				config.m_batchSize = 32;
+				BackpropTrainer trainer(network, config);
+
+				const float initialLoss = trainer.ComputeLoss(data);
+				for (int epoch = 0; epoch < 200; epoch++)
+				{
+					trainer.TrainEpoch(data, rand);
+				}
+				Assert::IsTrue(trainer.ComputeLoss(data) < initialLoss * 0.05f);
+				Assert::AreEqual(trainer.GetNumSteps(), 200 * 8);
+			}
+		}
 	};
 }
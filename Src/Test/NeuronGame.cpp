@@ -0,0 +1,218 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include "NeuronBall/NeuronGame.h"
+#include "Util/Math.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Test
+{
+	TEST_CLASS(TestNeuronGame)
+	{
+	public:
+		// Updates an idle game until it ends. Returns the number of ticks it took.
+		static int PlayUntilOver(NeuronGame& game, const int maxTicks)
+		{
+			int numTicks = 0;
+			while (!game.IsGameOver())
+			{
+				game.Update();
+				numTicks++;
+				Assert::IsTrue(numTicks <= maxTicks);
+			}
+			return numTicks;
+		}
+
+		TEST_METHOD(EarlyEndRulesOffByDefault)
+		{
+			NeuronGame game;
+			game.ResetGame(2.0f);
+			Assert::IsFalse(game.GetEarlyEndRules().IsEnabled());
+			Assert::IsTrue(game.GetEndReason() == GameEndReason::None);
+
+			// Nobody moves, but the game still runs out the clock
+			const int numTicks = PlayUntilOver(game, 121);
+			Assert::IsTrue(numTicks >= 120);
+			Assert::IsTrue(game.GetEndReason() == GameEndReason::TimeUp);
+			Assert::AreEqual(1, game.GetGameEndStats().GetNumGames(GameEndReason::TimeUp));
+			Assert::AreEqual(0, game.GetGameEndStats().GetNumEndedEarly());
+		}
+
+		TEST_METHOD(MercyAgainstTimeRemaining)
+		{
+			EarlyEndRules rules;
+			rules.m_mercyGoalsPerMinute = 1.0f;
+
+			// A lead of 3 can be scored back at 1 goal a minute with more than 3 minutes left
+			NeuronGame game;
+			game.SetEarlyEndRules(rules);
+			game.ResetGame(300.0f);
+			NeuronGameSnapshot snapshot = game.Snapshot();
+			snapshot.m_scores[0] = 3;
+			snapshot.m_timeRemaining = 181.0f;
+			game.Restore(snapshot);
+			game.Update();
+			Assert::IsFalse(game.IsGameOver());
+
+			// But not with less
+			snapshot.m_timeRemaining = 179.0f;
+			game.Restore(snapshot);
+			game.Update();
+			Assert::IsTrue(game.IsGameOver());
+			Assert::IsTrue(game.GetEndReason() == GameEndReason::Mercy);
+			Assert::IsTrue(game.GetTimeRemaining() > 178.0f);
+
+			// The lead is what counts, whoever has it
+			snapshot.m_scores[0] = 1;
+			snapshot.m_scores[1] = 4;
+			game.Restore(snapshot);
+			game.Update();
+			Assert::IsTrue(game.GetEndReason() == GameEndReason::Mercy);
+			snapshot.m_scores[0] = 2;
+			game.Restore(snapshot);
+			game.Update();
+			Assert::IsFalse(game.IsGameOver());
+		}
+
+		TEST_METHOD(StallEndsIdleGame)
+		{
+			EarlyEndRules rules;
+			rules.m_stallSeconds = 1.0f;
+			NeuronGame game;
+			game.SetEarlyEndRules(rules);
+			game.ResetGame(60.0f);
+
+			const int numTicks = PlayUntilOver(game, 61);
+			Assert::IsTrue(numTicks >= 59);
+			Assert::IsTrue(game.GetEndReason() == GameEndReason::Stall);
+			Assert::AreEqual(1, game.GetGameEndStats().GetNumGames(GameEndReason::Stall));
+			Assert::IsTrue(game.GetGameEndStats().m_secondsSaved > 58.0f);
+
+			// Rules are kept when the game is reset
+			game.ResetGame(60.0f);
+			Assert::IsTrue(game.GetEndReason() == GameEndReason::None);
+			PlayUntilOver(game, 61);
+			Assert::IsTrue(game.GetEndReason() == GameEndReason::Stall);
+		}
+
+		TEST_METHOD(StallResetOnKickoff)
+		{
+			EarlyEndRules rules;
+			rules.m_stallSeconds = 1.0f;
+			NeuronGame game;
+			game.SetEarlyEndRules(rules);
+			game.ResetGame(60.0f);
+
+			// The ball sits in player 1's goal, one tick short of stalling
+			NeuronGameSnapshot snapshot = game.Snapshot();
+			snapshot.m_ball.m_posX = game.GetFieldLength() - game.GetBall().GetRadius();
+			snapshot.m_stallSeconds = rules.m_stallSeconds - (0.5f * k_timePerTick);
+			game.Restore(snapshot);
+			game.Update();
+
+			// Scoring kicks off again, which starts the stall timer over
+			Assert::AreEqual(1, game.GetPlayerScore(0));
+			Assert::IsFalse(game.IsGameOver());
+			Assert::AreEqual(k_timePerTick, game.Snapshot().m_stallSeconds);
+			Assert::IsTrue(game.GetBall().m_shape.GetPos() == Vector2(game.GetFieldLength() * 0.5f, game.GetFieldWidth() * 0.5f));
+
+			// Anything moving fast enough also starts it over
+			snapshot.m_ball.m_posX = game.GetFieldLength() * 0.5f;
+			snapshot.m_ball.m_velX = rules.m_stallSpeed * 2.0f;
+			game.Restore(snapshot);
+			game.Update();
+			Assert::IsFalse(game.IsGameOver());
+			Assert::AreEqual(0.0f, game.Snapshot().m_stallSeconds);
+		}
+
+		TEST_METHOD(NoProgressResetByTouch)
+		{
+			EarlyEndRules rules;
+			rules.m_noProgressSeconds = 1.0f;
+			NeuronGame game;
+			game.SetEarlyEndRules(rules);
+			game.ResetGame(60.0f);
+
+			const int numTicks = PlayUntilOver(game, 61);
+			Assert::IsTrue(numTicks >= 59);
+			Assert::IsTrue(game.GetEndReason() == GameEndReason::NoProgress);
+
+			// One tick short of ending, player 0 is pressed against the ball
+			game.ResetGame(60.0f);
+			NeuronGameSnapshot snapshot = game.Snapshot();
+			const float touching = game.GetBall().GetRadius() + (game.GetPlayer(0).m_shape.m_halfLength * 0.5f);
+			snapshot.m_players[0].m_body.m_posX = snapshot.m_ball.m_posX - touching;
+			snapshot.m_players[0].m_body.m_posY = snapshot.m_ball.m_posY;
+			snapshot.m_secondsSinceBallTouched = rules.m_noProgressSeconds - (0.5f * k_timePerTick);
+			game.Restore(snapshot);
+			game.Update();
+			Assert::IsFalse(game.IsGameOver());
+			Assert::AreEqual(0.0f, game.Snapshot().m_secondsSinceBallTouched);
+
+			// Without the touch, it ends
+			snapshot.m_players[0].m_body.m_posX = game.GetFieldLength() * 0.1f;
+			game.Restore(snapshot);
+			game.Update();
+			Assert::IsTrue(game.GetEndReason() == GameEndReason::NoProgress);
+		}
+
+		TEST_METHOD(EndReasonPriority)
+		{
+			NeuronGame game;
+			game.ResetGame(60.0f);
+			NeuronGameSnapshot snapshot = game.Snapshot();
+			snapshot.m_scores[0] = k_scoreToWin;
+			snapshot.m_earlyEndReason = static_cast<uint8_t>(GameEndReason::Stall);
+			snapshot.m_timeRemaining = 0.0f;
+			game.Restore(snapshot);
+			Assert::IsTrue(game.GetEndReason() == GameEndReason::ScoreToWin);
+
+			snapshot.m_scores[0] = k_scoreToWin - 1;
+			game.Restore(snapshot);
+			Assert::IsTrue(game.GetEndReason() == GameEndReason::Stall);
+
+			snapshot.m_earlyEndReason = static_cast<uint8_t>(GameEndReason::None);
+			game.Restore(snapshot);
+			Assert::IsTrue(game.GetEndReason() == GameEndReason::TimeUp);
+
+			snapshot.m_timeRemaining = 1.0f;
+			game.Restore(snapshot);
+			Assert::IsFalse(game.IsGameOver());
+			Assert::IsTrue(game.GetEndReason() == GameEndReason::None);
+		}
+
+		TEST_METHOD(SnapshotCarriesEarlyEndState)
+		{
+			EarlyEndRules rules;
+			rules.m_stallSeconds = 1.0f;
+			rules.m_noProgressSeconds = 2.0f;
+			NeuronGame game;
+			game.SetEarlyEndRules(rules);
+			game.ResetGame(60.0f);
+			for (int tick = 0; tick < 30; tick++)
+			{
+				game.Update();
+			}
+
+			// Both timers are part of the state of play, so the restored game ends on the same tick
+			const NeuronGameSnapshot snapshot = game.Snapshot();
+			Assert::IsTrue(snapshot.m_stallSeconds > 0.4f);
+			Assert::IsTrue(snapshot.m_secondsSinceBallTouched > 0.4f);
+			NeuronGame other;
+			other.SetEarlyEndRules(rules);
+			other.Restore(snapshot);
+			Assert::AreEqual(snapshot.m_stallSeconds, other.Snapshot().m_stallSeconds);
+			Assert::AreEqual(snapshot.m_secondsSinceBallTouched, other.Snapshot().m_secondsSinceBallTouched);
+			Assert::AreEqual(PlayUntilOver(game, 31), PlayUntilOver(other, 31));
+			Assert::IsTrue(other.GetEndReason() == GameEndReason::Stall);
+
+			// And a game that ended early stays ended
+			NeuronGame ended;
+			ended.Restore(game.Snapshot());
+			Assert::IsTrue(ended.IsGameOver());
+			Assert::IsTrue(ended.GetEndReason() == GameEndReason::Stall);
+			Assert::IsTrue(game.Fork().GetEndReason() == GameEndReason::Stall);
+		}
+	};
+}
@@ -0,0 +1,124 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include "Util/Math.h"
+#include "Util/SimdMath.h"
+#include "Util/Vector.h"
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Test
+{
+	TEST_CLASS(TestSimdMath)
+	{
+	public:
+		TEST_METHOD(SinCosMatchesLibm)
+		{
+			// Not a multiple of four, so the last partial group is tested too
+			const int count = 4003;
+			std::vector<float> radians(count);
+			for (int i = 0; i < count; i++)
+			{
+				radians[i] = Math::Lerp(-Simd::k_maxSinCosRadians, Simd::k_maxSinCosRadians, static_cast<float>(i) / (count - 1));
+			}
+			// Exact multiples of pi/2 and the edges between quadrants
+			radians[1] = 0.0f;
+			radians[2] = k_pi * 0.5f;
+			radians[3] = -k_pi;
+			radians[4] = k_pi * 0.25f;
+			radians[5] = k_pi * -0.75f;
+
+			std::vector<float> sin(count);
+			std::vector<float> cos(count);
+			Simd::SinCos(radians.data(), sin.data(), cos.data(), count);
+			for (int i = 0; i < count; i++)
+			{
+				Assert::IsTrue(Math::Equals(sin[i], Math::Sin(radians[i]), 3e-7f));
+				Assert::IsTrue(Math::Equals(cos[i], Math::Cos(radians[i]), 3e-7f));
+			}
+			Assert::AreEqual(0.0f, sin[1]);
+			Assert::AreEqual(1.0f, cos[1]);
+		}
+
+		TEST_METHOD(ATan2MatchesLibm)
+		{
+			// Every octant, the axes, and the diagonals between them
+			std::vector<float> y;
+			std::vector<float> x;
+			for (int i = 0; i < 360; i++)
+			{
+				const float angle = Math::DegToRad(static_cast<float>(i - 179));
+				const float length = 0.01f + static_cast<float>(i);
+				y.push_back(Math::Sin(angle) * length);
+				x.push_back(Math::Cos(angle) * length);
+			}
+			y.push_back(0.0f);
+			x.push_back(-3.0f);
+			y.push_back(-2.0f);
+			x.push_back(0.0f);
+			y.push_back(5.0f);
+			x.push_back(-5.0f);
+
+			const int count = static_cast<int>(y.size());
+			std::vector<float> radians(count);
+			Simd::ATan2(y.data(), x.data(), radians.data(), count);
+			for (int i = 0; i < count; i++)
+			{
+				Assert::IsTrue(Math::Equals(radians[i], Math::ATan2(y[i], x[i]), 5e-7f));
+			}
+
+			// Unlike libm, (0, 0) has no direction rather than one depending on the signs of zero
+			const float zero = 0.0f;
+			Simd::ATan2(&zero, &zero, radians.data(), 1);
+			Assert::AreEqual(0.0f, radians[0]);
+		}
+
+		TEST_METHOD(InvSqrtIsAccurate)
+		{
+			std::vector<float> f;
+			for (float value = 1e-30f; value < 1e30f; value *= 3.7f)
+			{
+				f.push_back(value);
+			}
+			const int count = static_cast<int>(f.size());
+			std::vector<float> invSqrt(count);
+			Simd::InvSqrt(f.data(), invSqrt.data(), count);
+			for (int i = 0; i < count; i++)
+			{
+				const float expected = 1.0f / Math::Sqrt(f[i]);
+				Assert::IsTrue(Math::Abs(invSqrt[i] - expected) <= expected * 5e-7f);
+			}
+		}
+
+		TEST_METHOD(VectorKernelsMatchVector2)
+		{
+			const int count = 7;
+			std::vector<Vector2> vectors;
+			std::vector<float> radians;
+			for (int i = 0; i < count; i++)
+			{
+				vectors.push_back(Vector2(static_cast<float>(i) - 3.5f, static_cast<float>(i * i) + 0.25f));
+				radians.push_back(static_cast<float>(i) * 1.3f - 4.0f);
+			}
+
+			std::vector<Vector2> normalized(count);
+			Simd::Normalize(vectors.data(), normalized.data(), count);
+			std::vector<Vector2> rotated(count);
+			Simd::RotateAroundOrigin(vectors.data(), radians.data(), rotated.data(), count);
+			for (int i = 0; i < count; i++)
+			{
+				Assert::IsTrue(normalized[i].Equals(vectors[i].GetNormalized(), 1e-6f));
+				const float tolerance = vectors[i].GetLength() * 1e-6f;
+				Assert::IsTrue(rotated[i].Equals(vectors[i].RotateAroundOrigin(radians[i]), tolerance));
+			}
+
+			// In place
+			Simd::Normalize(vectors.data(), vectors.data(), count);
+			for (int i = 0; i < count; i++)
+			{
+				Assert::IsTrue(vectors[i] == normalized[i]);
+			}
+		}
+	};
+}
@@ -3,6 +3,7 @@
 
 #include "Util/Math.h"
 #include "Util/Random.h"
+#include <vector>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -149,16 +150,210 @@ namespace Test
 			Assert::IsTrue(Math::Equals(stats.GetStdDev(), expectedStddev, k_stdTolerance));
 		}
 
-		// TODO: Implement
-// 		TEST_METHOD(NextFloatRange)
-// 		{
-// 			Assert::IsTrue(false, L"TODO: Implement test");
-// 		}
-
-		// TODO: Implement
-// 		TEST_METHOD(NextGaussian)
-// 		{
-// 			Assert::IsTrue(false, L"TODO: Implement test");
-// 		}
+		TEST_METHOD(NextFloatRange)
+		{
+			const float minInclusive = -3.0f;
+			const float maxExclusive = 5.0f;
+
+			Random rand;
+			SequenceStats stats;
+			for (int i = 0; i < k_numSamples; i++)
+			{
+				stats.AddSample(rand.NextFloat(minInclusive, maxExclusive));
+			}
+			const double range = maxExclusive - minInclusive;
+			Assert::IsTrue(Math::Equals(stats.GetAverage(), 1.0, range * k_avgTolerance));
+
+			Assert::IsTrue((stats.GetMinSample() >= minInclusive) && (stats.GetMinSample() < minInclusive + (range * k_sampleTolerance)));
+			Assert::IsTrue((stats.GetMaxSample() < maxExclusive) && (stats.GetMaxSample() > maxExclusive - (range * k_sampleTolerance)));
+
+			double expectedStddev = SequenceStats::ExpectedStdDevForUniformDistribution(minInclusive, maxExclusive);
+			Assert::IsTrue(Math::Equals(stats.GetStdDev(), expectedStddev, expectedStddev * k_stdTolerance));
+		}
+
+		TEST_METHOD(NextGaussian)
+		{
+			Random rand;
+			SequenceStats stats;
+			for (int i = 0; i < k_numSamples; i++)
+			{
+				stats.AddSample(rand.NextGaussian());
+			}
+			Assert::IsTrue(Math::Equals(stats.GetAverage(), 0.0, k_avgTolerance * 3.0));
+			Assert::IsTrue(Math::Equals(stats.GetStdDev(), 1.0, k_stdTolerance));
+			// With a million samples, the extremes should be a little past 4.5 standard deviations
+			Assert::IsTrue(stats.GetMinSample() < -4.0 && stats.GetMinSample() > -6.0);
+			Assert::IsTrue(stats.GetMaxSample() > 4.0 && stats.GetMaxSample() < 6.0);
+		}
+
+		// Bulk generation has to produce exactly the same words as one at a time, no matter how the
+		// request lines up with the blocks
+		TEST_METHOD(BulkMatchesSequential)
+		{
+			Random sequential(7, 3);
+			Random bulk(7, 3);
+			const int requestSizes[] = { 1, 2, 7, 16, 3, 100, 4, 0, 33 };
+			uint32_t words[100];
+			for (const int requestSize : requestSizes)
+			{
+				bulk.NextUInt32Bulk(words, requestSize);
+				for (int i = 0; i < requestSize; i++)
+				{
+					Assert::IsTrue(words[i] == sequential.NextUInt32());
+				}
+			}
+			Assert::IsTrue(bulk.NextUInt32() == sequential.NextUInt32());
+
+			float values[37];
+			bulk.FillUniform(values, 37);
+			for (const float value : values)
+			{
+				Assert::IsTrue(value == sequential.NextFloat());
+			}
+		}
+
+		TEST_METHOD(FillUniform)
+		{
+			constexpr float minInclusive = -3.0f;
+			constexpr float maxExclusive = 5.0f;
+			std::vector<float> values(k_numSamples);
+			Random rand;
+			rand.FillUniform(values.data(), k_numSamples, minInclusive, maxExclusive);
+
+			SequenceStats stats;
+			for (const float value : values)
+			{
+				Assert::IsTrue(value >= minInclusive && value < maxExclusive);
+				stats.AddSample(value);
+			}
+			Assert::IsTrue(Math::Equals(stats.GetAverage(), (minInclusive + maxExclusive) * 0.5, k_avgTolerance * (maxExclusive - minInclusive)));
+			double expectedStddev = SequenceStats::ExpectedStdDevForUniformDistribution(minInclusive, maxExclusive);
+			Assert::IsTrue(Math::Equals(stats.GetStdDev(), expectedStddev, expectedStddev * k_stdTolerance));
+		}
+
+		TEST_METHOD(FillGaussian)
+		{
+			std::vector<float> values(k_numSamples);
+			Random rand;
+			rand.FillGaussian(values.data(), k_numSamples);
+
+			SequenceStats stats;
+			int numBeyondTwo = 0;
+			int numInTail = 0;
+			for (const float value : values)
+			{
+				stats.AddSample(value);
+				numBeyondTwo += (Math::Abs(value) > 2.0f) ? 1 : 0;
+				// Past the base of the Ziggurat, so these all come from the tail algorithm
+				numInTail += (Math::Abs(value) > 3.5f) ? 1 : 0;
+			}
+			Assert::IsTrue(Math::Equals(stats.GetAverage(), 0.0, k_avgTolerance * 3.0));
+			Assert::IsTrue(Math::Equals(stats.GetStdDev(), 1.0, k_stdTolerance));
+			// Expected fractions are 4.55% beyond 2 and 0.0465% beyond 3.5
+			Assert::IsTrue(Math::Equals(numBeyondTwo / static_cast<double>(k_numSamples), 0.0455, 0.002));
+			Assert::IsTrue(Math::Equals(numInTail / static_cast<double>(k_numSamples), 0.000465, 0.0001));
+			Assert::IsTrue(stats.GetMinSample() < -4.0 && stats.GetMinSample() > -6.0);
+			Assert::IsTrue(stats.GetMaxSample() > 4.0 && stats.GetMaxSample() < 6.0);
+
+			// Scaled version is the same sequence
+			std::vector<float> scaled(1000);
+			Random rand2;
+			rand2.FillGaussian(scaled.data(), 1000, 10.0f, 2.0f);
+			for (int i = 0; i < 1000; i++)
+			{
+				Assert::IsTrue(Math::Equals(scaled[i], 10.0f + (2.0f * values[i]), 0.0001f));
+			}
+		}
+
+		// Philox4x32-10 known answer tests from the Random123 distribution (kat_vectors)
+		TEST_METHOD(PhiloxKnownAnswers)
+		{
+			struct KnownAnswer
+			{
+				uint32_t counter[4];
+				uint32_t key[2];
+				uint32_t expected[4];
+			};
+			const KnownAnswer knownAnswers[] =
+			{
+				{ { 0x00000000, 0x00000000, 0x00000000, 0x00000000 }, { 0x00000000, 0x00000000 }, { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+				{ { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff }, { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+				{ { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 }, { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } },
+			};
+
+			for (const KnownAnswer& knownAnswer : knownAnswers)
+			{
+				uint32_t out[4];
+				Philox4x32::GenerateBlock(knownAnswer.counter, knownAnswer.key, out);
+				for (int i = 0; i < 4; i++)
+				{
+					Assert::IsTrue(out[i] == knownAnswer.expected[i]);
+				}
+			}
+		}
+
+		TEST_METHOD(SeedIsReproducible)
+		{
+			Random rand0(1234, 5);
+			Random rand1(1234, 5);
+			Random rand2(1234, 6);
+			bool anyDifferent = false;
+			for (int i = 0; i < 1000; i++)
+			{
+				const uint32_t value0 = rand0.NextUInt32();
+				Assert::IsTrue(value0 == rand1.NextUInt32());
+				anyDifferent |= (value0 != rand2.NextUInt32());
+			}
+			Assert::IsTrue(anyDifferent, L"Different streams should produce different sequences");
+		}
+
+		TEST_METHOD(Jump)
+		{
+			constexpr int k_blocksToSkip = 37;
+			Random stepped(42);
+			Random jumped(42);
+
+			for (int i = 0; i < k_blocksToSkip * 4; i++)
+			{
+				stepped.NextUInt32();
+			}
+			jumped.Jump(k_blocksToSkip);
+
+			for (int i = 0; i < 100; i++)
+			{
+				Assert::IsTrue(stepped.NextUInt32() == jumped.NextUInt32());
+			}
+		}
+
+		TEST_METHOD(Split)
+		{
+			Random parent(99);
+			Random parentCopy = parent;
+
+			Random child0 = parent.Split(0);
+			Random child1 = parent.Split(1);
+			Random child0Again = parent.Split(0);
+			Random grandchild = child0.Split(1);
+
+			// Splitting doesn't consume values from the parent
+			for (int i = 0; i < 16; i++)
+			{
+				Assert::IsTrue(parent.NextUInt32() == parentCopy.NextUInt32());
+			}
+
+			// Splits are deterministic, and different indices produce different streams
+			int numMatches01 = 0;
+			int numMatchesGrandchild = 0;
+			for (int i = 0; i < 1000; i++)
+			{
+				const uint32_t value0 = child0.NextUInt32();
+				Assert::IsTrue(value0 == child0Again.NextUInt32());
+				numMatches01 += (value0 == child1.NextUInt32()) ? 1 : 0;
+				numMatchesGrandchild += (value0 == grandchild.NextUInt32()) ? 1 : 0;
+			}
+			Assert::IsTrue(numMatches01 < 5);
+			Assert::IsTrue(numMatchesGrandchild < 5);
+			Assert::IsTrue(child1.GetStream() != grandchild.GetStream());
+		}
 	};
 }
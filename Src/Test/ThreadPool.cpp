@@ -0,0 +1,95 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "Util/ThreadPool.h"
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Test
+{
+	TEST_CLASS(TestThreadPool)
+	{
+	public:
+		TEST_METHOD(EveryJobRunsOnce)
+		{
+			ThreadPool pool(4);
+			Assert::AreEqual(4, pool.GetNumThreads());
+
+			// Several batches in a row, so workers that are slow to wake up overlap the next batch
+			for (int batch = 0; batch < 50; batch++)
+			{
+				const int numJobs = 1 + ((batch * 37) % 200);
+				std::vector<std::atomic<int>> counts(numJobs);
+				std::atomic<int> badThreadIndices(0);
+				pool.ParallelFor(numJobs,
+					[&counts, &badThreadIndices, &pool](const int jobIndex, const int threadIndex)
+					{
+						counts[jobIndex]++;
+						if ((threadIndex < 0) || (threadIndex >= pool.GetNumThreads()))
+						{
+							badThreadIndices++;
+						}
+					});
+				Assert::IsFalse(pool.IsBusy());
+				Assert::AreEqual(0, badThreadIndices.load());
+				for (int i = 0; i < numJobs; i++)
+				{
+					Assert::AreEqual(1, counts[i].load());
+				}
+			}
+		}
+
+		TEST_METHOD(StartAndWait)
+		{
+			ThreadPool pool(2);
+			std::vector<int> results(1000, 0);
+			pool.Start(static_cast<int>(results.size()),
+				[&results](const int jobIndex, const int threadIndex)
+				{
+					// Each job writes to its own entry
+					results[jobIndex] = jobIndex * jobIndex;
+				});
+			pool.Wait();
+			Assert::IsFalse(pool.IsBusy());
+			for (int i = 0; i < static_cast<int>(results.size()); i++)
+			{
+				Assert::AreEqual(i * i, results[i]);
+			}
+
+			// An empty batch finishes straight away
+			pool.ParallelFor(0, [](const int jobIndex, const int threadIndex) { Assert::Fail(); });
+			Assert::IsFalse(pool.IsBusy());
+		}
+
+		TEST_METHOD(IdleWorkersStealJobs)
+		{
+			// The first job is much slower than the rest, so whichever worker runs it should leave
+			// most of its share to the other worker
+			ThreadPool pool(2);
+			constexpr int k_numJobs = 100;
+			std::vector<int> threadOfJob(k_numJobs, -1);
+			pool.ParallelFor(k_numJobs,
+				[&threadOfJob](const int jobIndex, const int threadIndex)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds((jobIndex == 0) ? 200 : 1));
+					threadOfJob[jobIndex] = threadIndex;
+				});
+
+			const int slowThread = threadOfJob[0];
+			const ThreadPool::WorkerStats slowStats = pool.GetWorkerStats(slowThread);
+			const ThreadPool::WorkerStats otherStats = pool.GetWorkerStats(1 - slowThread);
+			Assert::IsTrue(slowStats.m_numJobs + otherStats.m_numJobs == k_numJobs);
+			Assert::IsTrue(otherStats.m_numJobs > (k_numJobs * 3) / 4);
+			Assert::IsTrue(otherStats.m_numSteals > 0);
+			Assert::IsTrue(otherStats.m_busySeconds > 0.0);
+
+			pool.ResetStats();
+			Assert::IsTrue(pool.GetWorkerStats(0).m_numJobs == 0);
+			Assert::IsTrue(pool.GetWorkerStats(1).m_idleSeconds == 0.0);
+		}
+	};
+}
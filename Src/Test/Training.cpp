@@ -0,0 +1,1124 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include <cstdio>
+#include <fstream>
+#include "NeuralNet/BackpropTrainer.h"
+#include "NeuralNet/Network.h"
+#include "NeuronBall/GameStateForNeuralNetInput.h"
+#include "NeuronBall/NeuronGame.h"
+#include "NeuronBall/NeuronPlayerController.h"
+#include "NeuronBall/NeuronPlayerInput.h"
+#include "Training/AiControllerData.h"
+#include "Training/DemonstrationFile.h"
+#include "Training/DemonstrationRecorder.h"
+#include "Training/Distiller.h"
+#include "Training/EvaluationScheduler.h"
+#include "Training/FitnessSurrogate.h"
+#include "Training/HallOfFame.h"
+#include "Training/Matchmaker.h"
+#include "Training/ParetoRanking.h"
+#include "Training/Rating.h"
+#include "Training/MatchResultCache.h"
+#include "Training/Speciation.h"
+#include "Util/BinaryBuffer.h"
+#include "Util/Math.h"
+#include "Util/Random.h"
+#include "Util/VantagePointTree.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Test
+{
+	TEST_CLASS(TestMatchResultCache)
+	{
+	public:
+		static MatchResult MakeResult(const int score0, const int score1)
+		{
+			MatchResult result;
+			result.m_scores[0] = score0;
+			result.m_scores[1] = score1;
+			return result;
+		}
+
+		TEST_METHOD(StoreAndLookup)
+		{
+			MatchResultCache cache(4);
+			MatchResult result;
+			Assert::IsFalse(cache.Lookup(1, 2, 7, result));
+
+			cache.Store(1, 2, 7, MakeResult(3, 5));
+			Assert::IsTrue(cache.Lookup(1, 2, 7, result));
+			Assert::AreEqual(result.m_scores[0], 3);
+			Assert::AreEqual(result.m_scores[1], 5);
+
+			// Different rules are a different match
+			Assert::IsFalse(cache.Lookup(1, 2, 8, result));
+
+			Assert::AreEqual(cache.GetNumLookups(), static_cast<int64_t>(3));
+			Assert::AreEqual(cache.GetNumHits(), static_cast<int64_t>(1));
+		}
+
+		TEST_METHOD(SeatsAreDistinct)
+		{
+			MatchResultCache cache(4);
+			MatchResult result;
+
+			// Store with the larger hash in seat 0 to exercise the canonical ordering
+			cache.Store(9, 2, 0, MakeResult(4, 1));
+			Assert::IsTrue(cache.Lookup(9, 2, 0, result));
+			Assert::AreEqual(result.m_scores[0], 4);
+			Assert::AreEqual(result.m_scores[1], 1);
+
+			// Swapping seats is not the same game
+			Assert::IsFalse(cache.Lookup(2, 9, 0, result));
+
+			cache.Store(2, 9, 0, MakeResult(0, 2));
+			Assert::IsTrue(cache.Lookup(2, 9, 0, result));
+			Assert::AreEqual(result.m_scores[0], 0);
+			Assert::AreEqual(result.m_scores[1], 2);
+		}
+
+		TEST_METHOD(LeastRecentlyUsedEviction)
+		{
+			MatchResultCache cache(2);
+			MatchResult result;
+
+			cache.Store(1, 2, 0, MakeResult(1, 0));
+			cache.Store(3, 4, 0, MakeResult(2, 0));
+
+			// Touch the first entry so the second becomes the least recently used
+			Assert::IsTrue(cache.Lookup(1, 2, 0, result));
+
+			cache.Store(5, 6, 0, MakeResult(3, 0));
+			Assert::AreEqual(cache.GetNumEntries(), 2);
+			Assert::IsTrue(cache.Lookup(1, 2, 0, result));
+			Assert::IsFalse(cache.Lookup(3, 4, 0, result));
+			Assert::IsTrue(cache.Lookup(5, 6, 0, result));
+		}
+
+		TEST_METHOD(Disabled)
+		{
+			MatchResultCache cache(0);
+			MatchResult result;
+			cache.Store(1, 2, 0, MakeResult(1, 0));
+			Assert::IsFalse(cache.IsEnabled());
+			Assert::IsFalse(cache.Lookup(1, 2, 0, result));
+			Assert::AreEqual(cache.GetNumEntries(), 0);
+		}
+	};
+
+	TEST_CLASS(TestSpeciation)
+	{
+	public:
+		static Network MakeRandomNetwork(const std::vector<int>& neuronsPerLevel, Random& rand)
+		{
+			Network network(neuronsPerLevel);
+			network.Randomize(rand);
+			return network;
+		}
+
+		TEST_METHOD(DistanceIsMetric)
+		{
+			Random rand(5);
+			const std::vector<std::vector<int>> topologies = { { 4, 6, 3 }, { 4, 6, 3 }, { 4, 7, 3 }, { 4, 6, 5, 3 }, { 4, 3 } };
+			std::vector<CompatibilityGenome> genomes;
+			for (const auto& topology : topologies)
+			{
+				genomes.emplace_back(MakeRandomNetwork(topology, rand));
+			}
+
+			const CompatibilityDistance distance;
+			for (const auto& a : genomes)
+			{
+				Assert::AreEqual(distance(a, a), 0.0f);
+				for (const auto& b : genomes)
+				{
+					Assert::AreEqual(distance(a, b), distance(b, a));
+					for (const auto& c : genomes)
+					{
+						Assert::IsTrue(distance(a, c) <= distance(a, b) + distance(b, c) + 0.001f);
+					}
+				}
+			}
+
+			// Different topologies always have unmatched genes
+			Assert::IsTrue(distance(genomes[0], genomes[2]) >= distance.m_topologyWeight * 5);
+		}
+
+		TEST_METHOD(DistanceMatchesWeights)
+		{
+			// Networks with the same layout take the vectorized path. Check it against a plain loop.
+			Random rand(11);
+			const Network network0 = MakeRandomNetwork({ 21, 13, 8, 3 }, rand);
+			const Network network1 = MakeRandomNetwork({ 21, 13, 8, 3 }, rand);
+
+			double expected = 0.0;
+			for (int levelIndex = 1; levelIndex < network0.GetNumLevels(); levelIndex++)
+			{
+				const auto& neurons0 = network0.GetLevel(levelIndex).neurons;
+				const auto& neurons1 = network1.GetLevel(levelIndex).neurons;
+				for (int n = 0; n < neurons0.size(); n++)
+				{
+					for (int w = 0; w < neurons0[n].weights.size(); w++)
+					{
+						expected += Math::Abs(neurons0[n].weights[w] - neurons1[n].weights[w]);
+					}
+					expected += Math::Abs(neurons0[n].bias - neurons1[n].bias);
+				}
+			}
+
+			const CompatibilityDistance distance;
+			const float actual = distance(CompatibilityGenome(network0), CompatibilityGenome(network1));
+			Assert::IsTrue(Math::Equals(actual, static_cast<float>(expected * distance.m_valueWeight), 0.01f));
+		}
+
+		TEST_METHOD(VantagePointTreeFindsNearest)
+		{
+			struct AbsDistance
+			{
+				float operator()(const float& a, const float& b) const { return Math::Abs(a - b); }
+			};
+
+			Random rand(3);
+			std::vector<float> points(200);
+			rand.FillUniform(points.data(), static_cast<int>(points.size()), -100.0f, 100.0f);
+			std::vector<const float*> items;
+			for (const float& point : points)
+			{
+				items.push_back(&point);
+			}
+
+			VantagePointTree<float, AbsDistance> tree((AbsDistance()));
+			tree.Build(items);
+			for (int i = 0; i < 100; i++)
+			{
+				const float target = rand.NextFloat(-120.0f, 120.0f);
+				const float maxDistance = rand.NextFloat(0.0f, 5.0f);
+
+				int expected = -1;
+				float expectedDistance = maxDistance;
+				for (int p = 0; p < points.size(); p++)
+				{
+					if (Math::Abs(points[p] - target) < expectedDistance)
+					{
+						expected = p;
+						expectedDistance = Math::Abs(points[p] - target);
+					}
+				}
+
+				float foundDistance = 0.0f;
+				const int found = tree.FindNearest(target, maxDistance, foundDistance);
+				Assert::AreEqual(found, expected);
+				Assert::AreEqual(foundDistance, expectedDistance);
+			}
+		}
+
+		TEST_METHOD(VantagePointTreeFindsNearestK)
+		{
+			struct AbsDistance
+			{
+				float operator()(const float& a, const float& b) const { return Math::Abs(a - b); }
+			};
+
+			Random rand(4);
+			std::vector<float> points(300);
+			rand.FillUniform(points.data(), static_cast<int>(points.size()), -100.0f, 100.0f);
+			std::vector<const float*> items;
+			for (const float& point : points)
+			{
+				items.push_back(&point);
+			}
+
+			VantagePointTree<float, AbsDistance> tree((AbsDistance()));
+			tree.Build(items);
+			std::vector<std::pair<float, int>> found;
+			for (int i = 0; i < 50; i++)
+			{
+				const float target = rand.NextFloat(-120.0f, 120.0f);
+				const int k = rand.NextInt(1, 12);
+
+				std::vector<std::pair<float, int>> expected;
+				for (int p = 0; p < points.size(); p++)
+				{
+					expected.emplace_back(Math::Abs(points[p] - target), p);
+				}
+				std::sort(expected.begin(), expected.end());
+				expected.resize(k);
+
+				tree.FindNearestK(target, k, found);
+				Assert::AreEqual(static_cast<int>(found.size()), k);
+				for (int j = 0; j < k; j++)
+				{
+					Assert::AreEqual(found[j].second, expected[j].second);
+				}
+			}
+		}
+
+		TEST_METHOD(ClonesShareSpecies)
+		{
+			Random rand(17);
+			const Network parent0 = MakeRandomNetwork({ 4, 6, 3 }, rand);
+			const Network parent1 = MakeRandomNetwork({ 4, 9, 9, 3 }, rand);
+
+			// Two families of identical networks
+			std::vector<const Network*> networks;
+			std::vector<int> points;
+			for (int i = 0; i < 20; i++)
+			{
+				networks.push_back(((i % 2) == 0) ? &parent0 : &parent1);
+				points.push_back(i);
+			}
+
+			Speciation::Config config;
+			config.m_targetNumSpecies = 2;
+			config.m_initialThreshold = 1.0f;
+			Speciation speciation(config);
+			speciation.Speciate(networks, points);
+
+			Assert::AreEqual(speciation.GetNumSpecies(), 2);
+			for (const Species& species : speciation.GetSpecies())
+			{
+				Assert::AreEqual(static_cast<int>(species.m_members.size()), 10);
+				for (const int member : species.m_members)
+				{
+					Assert::IsTrue(networks[member] == networks[species.m_members[0]]);
+				}
+				// The best member is the representative, so its score is the species' best
+				Assert::AreEqual(species.m_bestPoints, species.m_members.back());
+			}
+
+			// Species persist from one generation to the next
+			const int firstId = speciation.GetSpecies()[0].m_id;
+			speciation.Speciate(networks, points);
+			Assert::AreEqual(speciation.GetNumSpecies(), 2);
+			Assert::AreEqual(speciation.GetSpecies()[0].m_id, firstId);
+			Assert::AreEqual(speciation.GetSpecies()[0].m_generationsWithoutImprovement, 1);
+		}
+	};
+
+	TEST_CLASS(TestEvaluationScheduler)
+	{
+	public:
+		// Plays every scheduled round between controllers whose strength is their index.
+		// Returns the total number of games played.
+		static int RunEvaluation(EvaluationScheduler& scheduler, std::vector<WinLossRecord>& records, Random& rand)
+		{
+			const int numControllers = static_cast<int>(records.size());
+			scheduler.Reset(numControllers);
+			int numGames = 0;
+			std::vector<EvaluationScheduler::Estimate> estimates(numControllers);
+			std::vector<EvaluationScheduler::Matchup> matchups;
+			while (true)
+			{
+				for (int i = 0; i < numControllers; i++)
+				{
+					estimates[i] = EvaluationScheduler::MakeEstimate(records[i]);
+				}
+				if (!scheduler.ScheduleNextRound(estimates, rand, matchups))
+				{
+					break;
+				}
+
+				for (const EvaluationScheduler::Matchup& matchup : matchups)
+				{
+					// The stronger controller usually wins
+					const float p0Wins = 0.5f + (0.5f * (matchup.m_index0 - matchup.m_index1)) / numControllers;
+					const int score0 = (rand.NextFloat() < p0Wins) ? 1 : 0;
+					records[matchup.m_index0].AddResult(score0, 1 - score0);
+					records[matchup.m_index1].AddResult(1 - score0, score0);
+				}
+				numGames += static_cast<int>(matchups.size());
+			}
+			return numGames;
+		}
+
+		TEST_METHOD(ConfidenceInterval)
+		{
+			WinLossRecord record;
+			float lower = 0.0f;
+			float upper = 0.0f;
+			EvaluationScheduler::GetConfidenceInterval(record, 1.0f, lower, upper);
+			Assert::AreEqual(lower, static_cast<float>(k_pointsForLoss));
+			Assert::AreEqual(upper, static_cast<float>(k_pointsForWin));
+
+			// Losing every game still leaves some doubt
+			record.m_losses = 2;
+			EvaluationScheduler::GetConfidenceInterval(record, 1.0f, lower, upper);
+			Assert::IsTrue(upper > 0.5f);
+
+			// More games narrow the interval around points per game
+			record.m_wins = 2;
+			EvaluationScheduler::GetConfidenceInterval(record, 1.0f, lower, upper);
+			const float width = upper - lower;
+			record.m_wins *= 10;
+			record.m_losses *= 10;
+			EvaluationScheduler::GetConfidenceInterval(record, 1.0f, lower, upper);
+			Assert::IsTrue(upper - lower < width);
+			Assert::IsTrue(Math::Abs((0.5f * (lower + upper)) - EvaluationScheduler::GetPointsPerGame(record)) < 0.0001f);
+		}
+
+		TEST_METHOD(PlaysFullScheduleWhenUncertain)
+		{
+			EvaluationScheduler::Config config;
+			config.m_gamesPerRound = 2;
+			config.m_maxRounds = 4;
+			config.m_confidence = 1000.0f;
+			EvaluationScheduler scheduler(config);
+
+			Random rand(5);
+			std::vector<WinLossRecord> records(32);
+			const int numGames = RunEvaluation(scheduler, records, rand);
+			Assert::AreEqual(numGames, 32 * 8);
+			Assert::AreEqual(scheduler.GetNumAccepted(), 0);
+			Assert::AreEqual(scheduler.GetNumEliminated(), 0);
+		}
+
+		TEST_METHOD(RacingSavesGames)
+		{
+			const int numControllers = 100;
+			EvaluationScheduler::Config config;
+			config.m_percentToKeep = 0.2f;
+			config.m_maxRounds = 16;
+			EvaluationScheduler scheduler(config);
+
+			Random rand(9);
+			std::vector<WinLossRecord> records(numControllers);
+			const int numGames = RunEvaluation(scheduler, records, rand);
+			const int fullScheduleGames = numControllers * config.m_maxRounds * config.m_gamesPerRound;
+			Assert::IsTrue(numGames < (fullScheduleGames * 6) / 10);
+
+			// Most of the controllers picked should still be among the strongest
+			std::vector<int> order(numControllers);
+			for (int i = 0; i < numControllers; i++)
+			{
+				order[i] = i;
+			}
+			std::sort(order.begin(), order.end(), [&records](const int a, const int b)
+				{
+					return EvaluationScheduler::GetPointsPerGame(records[a]) > EvaluationScheduler::GetPointsPerGame(records[b]);
+				});
+			int numStrongKept = 0;
+			for (int i = 0; i < 20; i++)
+			{
+				numStrongKept += (order[i] >= 70) ? 1 : 0;
+			}
+			Assert::IsTrue(numStrongKept >= 16);
+		}
+
+		TEST_METHOD(LoneRacerStillPlays)
+		{
+			const int numControllers = 10;
+			EvaluationScheduler::Config config;
+			config.m_percentToKeep = 0.2f;
+			config.m_eliminationFraction = 1.0f;
+			IMatchmaker* matchmaker = IMatchmaker::Create(MatchmakingStrategy::InformationGain);
+			EvaluationScheduler scheduler(config, matchmaker);
+			scheduler.Reset(numControllers);
+
+			Random rand(3);
+			std::vector<EvaluationScheduler::Estimate> estimates(numControllers);
+			std::vector<EvaluationScheduler::Matchup> matchups;
+			Assert::IsTrue(scheduler.ScheduleNextRound(estimates, rand, matchups));
+
+			// 0 is clearly kept and 2..9 are clearly replaced, which leaves 1 racing on its own
+			for (EvaluationScheduler::Estimate& estimate : estimates)
+			{
+				estimate.m_value = 0.0f;
+				estimate.m_standardError = 1.0f;
+			}
+			estimates[0].m_value = 100.0f;
+			estimates[1].m_value = 50.0f;
+			estimates[1].m_standardError = 100.0f;
+			Assert::IsTrue(scheduler.ScheduleNextRound(estimates, rand, matchups));
+			Assert::AreEqual(1, scheduler.GetNumRacing());
+			Assert::IsTrue(scheduler.IsRacing(1));
+
+			// An empty round would never finish, so it plays anyone else instead
+			Assert::IsFalse(matchups.empty());
+			for (const EvaluationScheduler::Matchup& matchup : matchups)
+			{
+				Assert::IsTrue((matchup.m_index0 == 1) != (matchup.m_index1 == 1));
+			}
+			delete matchmaker;
+		}
+	};
+	TEST_CLASS(TestRating)
+	{
+	public:
+		static Rating MakeRating(const float rating, const float deviation)
+		{
+			Rating result;
+			result.m_rating = rating;
+			result.m_deviation = deviation;
+			return result;
+		}
+
+		TEST_METHOD(GlickmanExample)
+		{
+			// Worked example from Glickman's description of the Glicko system
+			Rating player = MakeRating(1500.0f, 200.0f);
+			const Rating opponents[] = { MakeRating(1400.0f, 30.0f), MakeRating(1550.0f, 100.0f), MakeRating(1700.0f, 300.0f) };
+			const float scores[] = { 1.0f, 0.0f, 0.0f };
+			player.UpdateFromGames(opponents, scores, 3);
+			Assert::IsTrue(Math::Abs(player.m_rating - 1464.1f) < 0.5f);
+			Assert::IsTrue(Math::Abs(player.m_deviation - 151.4f) < 0.5f);
+		}
+
+		TEST_METHOD(UpdateMovesBothRatings)
+		{
+			Rating a;
+			Rating b;
+			Rating::Update(a, b, Rating::GetGameScore(3, 1));
+			Assert::IsTrue(a.m_rating > Rating::k_initialRating);
+			Assert::IsTrue(b.m_rating < Rating::k_initialRating);
+			// Equal ratings move by the same amount
+			Assert::IsTrue(Math::Abs((a.m_rating - Rating::k_initialRating) - (Rating::k_initialRating - b.m_rating)) < 0.01f);
+			Assert::IsTrue(a.m_deviation < Rating::k_initialDeviation);
+			Assert::AreEqual(a.m_deviation, b.m_deviation);
+
+			// A tie between equal ratings only makes them more certain
+			Rating c;
+			Rating d;
+			Rating::Update(c, d, Rating::GetGameScore(2, 2));
+			Assert::AreEqual(c.m_rating, Rating::k_initialRating);
+			Assert::AreEqual(d.m_rating, Rating::k_initialRating);
+			Assert::IsTrue(Math::Abs(a.GetExpectedScore(b) + b.GetExpectedScore(a) - 1.0f) < 0.0001f);
+		}
+
+		TEST_METHOD(Uncertainty)
+		{
+			Rating rating = MakeRating(1800.0f, 40.0f);
+			rating.AddUncertainty(30.0f);
+			Assert::IsTrue(Math::Abs(rating.m_deviation - 50.0f) < 0.01f);
+			rating.AddUncertainty(1000.0f);
+			Assert::AreEqual(rating.m_deviation, Rating::k_initialDeviation);
+
+			// Children keep their parent's rating, but are less certain
+			const Rating parent = MakeRating(1800.0f, 60.0f);
+			const Rating child = parent.MakeChildRating(200.0f);
+			Assert::AreEqual(child.m_rating, parent.m_rating);
+			Assert::AreEqual(child.m_deviation, 200.0f);
+		}
+	};
+	TEST_CLASS(TestMatchmaker)
+	{
+	public:
+		static std::vector<int> MakePlayers(const int numPlayers)
+		{
+			std::vector<int> players(numPlayers);
+			for (int i = 0; i < numPlayers; i++)
+			{
+				players[i] = i;
+			}
+			return players;
+		}
+
+		// Runs a generation between controllers whose strength is their index, updating ratings
+		// after every round. Returns the average distance between each controller's rank and its
+		// true rank.
+		static float MeasureRankError(const MatchmakingStrategy strategy, const int numRounds, Random& rand)
+		{
+			const int numControllers = 64;
+			IMatchmaker* matchmaker = IMatchmaker::Create(strategy);
+			matchmaker->Reset(numControllers);
+			std::vector<Rating> ratings(numControllers);
+			const std::vector<int> players = MakePlayers(numControllers);
+			std::vector<IMatchmaker::Estimate> estimates(numControllers);
+			std::vector<IMatchmaker::Matchup> matchups;
+			for (int round = 0; round < numRounds; round++)
+			{
+				for (int i = 0; i < numControllers; i++)
+				{
+					estimates[i] = EvaluationScheduler::MakeEstimate(ratings[i]);
+				}
+				matchups.clear();
+				matchmaker->PairRound(estimates, players, rand, matchups);
+				for (const IMatchmaker::Matchup& matchup : matchups)
+				{
+					// Every step in strength is worth 10 rating points
+					const float p0Wins = 1.0f / (1.0f + Math::Power(10.0f, (matchup.m_index1 - matchup.m_index0) * 10.0f / 400.0f));
+					const float score0 = (rand.NextFloat() < p0Wins) ? 1.0f : 0.0f;
+					Rating::Update(ratings[matchup.m_index0], ratings[matchup.m_index1], score0);
+				}
+			}
+			delete matchmaker;
+
+			std::vector<int> order = MakePlayers(numControllers);
+			std::sort(order.begin(), order.end(),
+				[&ratings](const int a, const int b) { return ratings[a].m_rating < ratings[b].m_rating; });
+			float totalError = 0.0f;
+			for (int rank = 0; rank < numControllers; rank++)
+			{
+				totalError += Math::Abs(static_cast<float>(order[rank] - rank));
+			}
+			return totalError / numControllers;
+		}
+
+		TEST_METHOD(SwissPairsNeighbours)
+		{
+			SwissMatchmaker matchmaker;
+			matchmaker.Reset(8);
+			std::vector<IMatchmaker::Estimate> estimates(8);
+			for (int i = 0; i < 8; i++)
+			{
+				estimates[i].m_value = static_cast<float>(i);
+			}
+			const std::vector<int> players = MakePlayers(8);
+			Random rand(3);
+
+			// Closest scores play each other first
+			std::vector<IMatchmaker::Matchup> matchups;
+			matchmaker.PairRound(estimates, players, rand, matchups);
+			Assert::AreEqual(static_cast<int>(matchups.size()), 4);
+			for (const IMatchmaker::Matchup& matchup : matchups)
+			{
+				Assert::AreEqual(Math::Max(matchup.m_index0, matchup.m_index1) / 2, Math::Min(matchup.m_index0, matchup.m_index1) / 2);
+			}
+
+			// The next round avoids rematches, and everyone still plays once
+			matchups.clear();
+			matchmaker.PairRound(estimates, players, rand, matchups);
+			Assert::AreEqual(static_cast<int>(matchups.size()), 4);
+			Assert::AreEqual(matchmaker.GetNumRematches(), 0);
+			std::vector<int> numGames(8, 0);
+			for (const IMatchmaker::Matchup& matchup : matchups)
+			{
+				numGames[matchup.m_index0]++;
+				numGames[matchup.m_index1]++;
+			}
+			for (const int count : numGames)
+			{
+				Assert::AreEqual(count, 1);
+			}
+		}
+
+		TEST_METHOD(OddPlayersAndSeats)
+		{
+			for (const MatchmakingStrategy strategy : { MatchmakingStrategy::Random, MatchmakingStrategy::Swiss, MatchmakingStrategy::InformationGain })
+			{
+				IMatchmaker* matchmaker = IMatchmaker::Create(strategy);
+				matchmaker->Reset(7);
+				Random rand(11);
+				std::vector<IMatchmaker::Estimate> estimates(7);
+				const std::vector<int> players = MakePlayers(7);
+				std::vector<int> seatBalance(7, 0);
+				for (int round = 0; round < 20; round++)
+				{
+					for (IMatchmaker::Estimate& estimate : estimates)
+					{
+						estimate.m_value = rand.NextFloat();
+						estimate.m_standardError = rand.NextFloat();
+					}
+					std::vector<IMatchmaker::Matchup> matchups;
+					matchmaker->PairRound(estimates, players, rand, matchups);
+					// The odd player out plays someone twice
+					Assert::AreEqual(static_cast<int>(matchups.size()), 4);
+					for (const IMatchmaker::Matchup& matchup : matchups)
+					{
+						Assert::IsTrue(matchup.m_index0 != matchup.m_index1);
+						seatBalance[matchup.m_index0]++;
+						seatBalance[matchup.m_index1]--;
+					}
+				}
+				// Seats are kept close to even
+				for (const int balance : seatBalance)
+				{
+					Assert::IsTrue(Math::Abs(balance) <= 2);
+				}
+				delete matchmaker;
+			}
+			Assert::IsTrue(IMatchmaker::Create(MatchmakingStrategy::RoundRobin) == nullptr);
+		}
+
+		TEST_METHOD(InformativePairingsRankBetter)
+		{
+			// Same number of games, but pairing by uncertainty ranks the population more accurately
+			Random randomRand(21);
+			Random informationRand(21);
+			float randomError = 0.0f;
+			float informationError = 0.0f;
+			for (int trial = 0; trial < 20; trial++)
+			{
+				randomError += MeasureRankError(MatchmakingStrategy::Random, 16, randomRand);
+				informationError += MeasureRankError(MatchmakingStrategy::InformationGain, 16, informationRand);
+			}
+			Assert::IsTrue(informationError < randomError);
+		}
+	};
+	TEST_CLASS(TestHallOfFame)
+	{
+	public:
+		static HallOfFame::Config MakeConfig(const int capacity)
+		{
+			HallOfFame::Config config;
+			config.m_capacity = capacity;
+			return config;
+		}
+
+		TEST_METHOD(MembersAreFrozen)
+		{
+			Random rand(8);
+			HallOfFame hallOfFame(MakeConfig(4));
+			Network network({ 6, 5, 3 });
+			network.Randomize(rand);
+			const Network original = network;
+
+			Assert::IsTrue(hallOfFame.Add(network, 0));
+			Assert::IsFalse(hallOfFame.Add(network, 1));
+
+			// Changing the champion later doesn't change the member
+			network.Randomize(rand);
+			Network member;
+			hallOfFame.GetNetwork(0, member);
+			Assert::IsTrue(member == original);
+			Assert::IsTrue(hallOfFame.Contains(original.GetHash()));
+			Assert::IsFalse(hallOfFame.Contains(network.GetHash()));
+		}
+
+		TEST_METHOD(MembersSpanHistory)
+		{
+			Random rand(9);
+			HallOfFame hallOfFame(MakeConfig(5));
+			Network network({ 4, 3 });
+			for (int generation = 0; generation <= 400; generation += 10)
+			{
+				network.Randomize(rand);
+				hallOfFame.Add(network, generation);
+			}
+
+			// The first and newest members are kept, and the rest are spread out between them
+			Assert::AreEqual(hallOfFame.GetNumMembers(), 5);
+			Assert::AreEqual(hallOfFame.GetMember(0).m_generation, 0);
+			Assert::AreEqual(hallOfFame.GetMember(4).m_generation, 400);
+			for (int i = 1; i < hallOfFame.GetNumMembers(); i++)
+			{
+				const int gap = hallOfFame.GetMember(i).m_generation - hallOfFame.GetMember(i - 1).m_generation;
+				Assert::IsTrue((gap > 0) && (gap <= 200));
+			}
+		}
+
+		TEST_METHOD(ResultsAreCachedBySeat)
+		{
+			Random rand(10);
+			HallOfFame hallOfFame(MakeConfig(4));
+			Network network({ 4, 3 });
+			network.Randomize(rand);
+			hallOfFame.Add(network, 0);
+			const uint64_t candidateHash = 1234;
+			const uint64_t rulesHash = 99;
+
+			MatchResult result;
+			result.m_scores[0] = 1;
+			result.m_scores[1] = 3;
+			Assert::IsFalse(hallOfFame.TryGetResult(candidateHash, 0, 1, rulesHash, result));
+			hallOfFame.StoreResult(candidateHash, 0, 1, rulesHash, result);
+
+			MatchResult cached;
+			Assert::IsTrue(hallOfFame.TryGetResult(candidateHash, 0, 1, rulesHash, cached));
+			Assert::AreEqual(cached.m_scores[0], 1);
+			Assert::AreEqual(cached.m_scores[1], 3);
+			// The other seat is a different game
+			Assert::IsFalse(hallOfFame.TryGetResult(candidateHash, 0, 0, rulesHash, cached));
+			Assert::IsFalse(hallOfFame.TryGetResult(candidateHash, 0, 1, rulesHash + 1, cached));
+		}
+
+		TEST_METHOD(SerializeRoundTrip)
+		{
+			Random rand(11);
+			HallOfFame hallOfFame(MakeConfig(8));
+			for (int generation = 0; generation < 3; generation++)
+			{
+				Network network({ 5, 4, 3 });
+				network.Randomize(rand);
+				hallOfFame.Add(network, generation * 7);
+			}
+
+			HeapBuffer buffer(64 * 1024);
+			hallOfFame.Serialize(buffer);
+			buffer.Seek(0);
+
+			HallOfFame loaded(MakeConfig(8));
+			loaded.Deserialize(buffer);
+			Assert::IsTrue(buffer.GetErrorStatus() == BinaryBuffer::ErrorStatus::NoError);
+			Assert::AreEqual(loaded.GetNumMembers(), 3);
+			for (int i = 0; i < 3; i++)
+			{
+				Assert::AreEqual(loaded.GetMember(i).m_generation, hallOfFame.GetMember(i).m_generation);
+				Assert::IsTrue(loaded.GetMember(i).m_hash == hallOfFame.GetMember(i).m_hash);
+			}
+
+			// Loading into a smaller hall of fame keeps the first and newest members
+			buffer.Seek(0);
+			HallOfFame smaller(MakeConfig(2));
+			smaller.Deserialize(buffer);
+			Assert::AreEqual(smaller.GetNumMembers(), 2);
+			Assert::AreEqual(smaller.GetMember(0).m_generation, 0);
+			Assert::AreEqual(smaller.GetMember(1).m_generation, 14);
+		}
+	};
+	TEST_CLASS(TestDemonstrationFile)
+	{
+	public:
+		static constexpr const char* k_fileName = "TestDemonstrations.bin";
+
+		// Row 'row' has observation[c] = row * 100 + c, and the action is (row, -row, row * 0.5)
+		static void RecordRows(const int firstRow, const int numRows, const int rowsPerChunk)
+		{
+			DemonstrationRecorder::Config config;
+			config.m_rowsPerChunk = rowsPerChunk;
+			DemonstrationRecorder recorder(config);
+			Assert::IsTrue(recorder.Open(k_fileName));
+
+			std::vector<float> observation(DemonstrationRecorder::GetNumObservationColumns());
+			for (int row = firstRow; row < firstRow + numRows; row++)
+			{
+				for (int c = 0; c < static_cast<int>(observation.size()); c++)
+				{
+					observation[c] = static_cast<float>((row * 100) + c);
+				}
+				NeuronPlayerInput action;
+				action.m_steering = static_cast<float>(row);
+				action.m_speed = static_cast<float>(-row);
+				action.m_boost = row * 0.5f;
+				recorder.Record(observation.data(), action);
+			}
+			recorder.Close();
+			Assert::IsTrue(recorder.GetNumRowsRecorded() == numRows);
+		}
+
+		static void CheckRows(const DemonstrationFile& file, const int numRows)
+		{
+			Assert::IsTrue(file.GetNumRows() == numRows);
+			int row = 0;
+			for (int chunkIndex = 0; chunkIndex < file.GetNumChunks(); chunkIndex++)
+			{
+				const DemonstrationFile::Chunk& chunk = file.GetChunk(chunkIndex);
+				Assert::AreEqual(chunk.m_rowStride % 4, 0);
+				for (int i = 0; i < chunk.m_numRows; i++, row++)
+				{
+					Assert::AreEqual(chunk.GetColumn(0)[i], static_cast<float>(row * 100));
+					Assert::AreEqual(chunk.GetColumn(file.GetNumObservationColumns() - 1)[i], static_cast<float>((row * 100) + file.GetNumObservationColumns() - 1));
+					Assert::AreEqual(chunk.GetColumn(file.GetNumObservationColumns() + 1)[i], static_cast<float>(-row));
+				}
+			}
+			Assert::AreEqual(row, numRows);
+		}
+
+		TEST_METHOD(RoundTrip)
+		{
+			std::remove(k_fileName);
+			// Not a multiple of the chunk size, so the last chunk is partly full
+			RecordRows(0, 50, 16);
+
+			DemonstrationFile file;
+			Assert::IsTrue(file.Open(k_fileName));
+			Assert::AreEqual(file.GetNumObservationColumns(), DemonstrationRecorder::GetNumObservationColumns());
+			Assert::AreEqual(file.GetNumActionColumns(), DemonstrationRecorder::k_numActionColumns);
+			Assert::AreEqual(file.GetNumChunks(), 4);
+			CheckRows(file, 50);
+
+			TrainingSet data(file.GetNumObservationColumns(), file.GetNumActionColumns());
+			file.AppendTo(data);
+			Assert::AreEqual(data.GetNumSamples(), 50);
+			Assert::AreEqual(data.GetInputs(37)[2], 3702.0f);
+			Assert::AreEqual(data.GetTargets(37)[0], 37.0f);
+			Assert::AreEqual(data.GetTargets(37)[2], 18.5f);
+			file.Close();
+			std::remove(k_fileName);
+		}
+
+		TEST_METHOD(AppendsToExistingFile)
+		{
+			std::remove(k_fileName);
+			RecordRows(0, 10, 8);
+			RecordRows(10, 20, 8);
+
+			DemonstrationFile file;
+			Assert::IsTrue(file.Open(k_fileName));
+			Assert::AreEqual(file.GetNumChunks(), 5);
+			CheckRows(file, 30);
+			file.Close();
+			std::remove(k_fileName);
+		}
+
+		TEST_METHOD(TruncatedChunkIsIgnored)
+		{
+			std::remove(k_fileName);
+			RecordRows(0, 24, 8);
+			{
+				// Cut the last chunk short, as if recording had crashed
+				std::ifstream inFile(k_fileName, std::ios::binary);
+				std::vector<char> contents((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+				inFile.close();
+				std::ofstream outFile(k_fileName, std::ios::binary | std::ios::trunc);
+				outFile.write(contents.data(), contents.size() - 40);
+			}
+
+			DemonstrationFile file;
+			Assert::IsTrue(file.Open(k_fileName));
+			CheckRows(file, 16);
+			file.Close();
+
+			// Recording more replaces the partial chunk
+			RecordRows(16, 8, 8);
+			Assert::IsTrue(file.Open(k_fileName));
+			CheckRows(file, 24);
+			file.Close();
+			std::remove(k_fileName);
+		}
+	};
+	TEST_CLASS(TestParetoRanking)
+	{
+	public:
+		static bool Dominates(const ParetoPoint& a, const ParetoPoint& b)
+		{
+			return (a.m_score >= b.m_score) && (a.m_cost <= b.m_cost) && ((a.m_score > b.m_score) || (a.m_cost < b.m_cost));
+		}
+
+		TEST_METHOD(FrontsMatchBruteForce)
+		{
+			Random rand(13);
+			std::vector<ParetoPoint> points(300);
+			for (ParetoPoint& point : points)
+			{
+				// Few distinct values, so there are plenty of ties and duplicates
+				point.m_score = static_cast<float>(rand.NextInt(0, 20));
+				point.m_cost = static_cast<float>(rand.NextInt(0, 20));
+			}
+			ParetoRanking ranking;
+			ranking.Rank(points);
+
+			// Peel off the non-dominated points one front at a time
+			const int numPoints = static_cast<int>(points.size());
+			std::vector<int> expectedRanks(numPoints, -1);
+			int numRanked = 0;
+			for (int front = 0; numRanked < numPoints; front++)
+			{
+				std::vector<int> members;
+				for (int i = 0; i < numPoints; i++)
+				{
+					if (expectedRanks[i] != -1)
+					{
+						continue;
+					}
+					bool isDominated = false;
+					for (int j = 0; (j < numPoints) && !isDominated; j++)
+					{
+						isDominated = (expectedRanks[j] == -1) && Dominates(points[j], points[i]);
+					}
+					if (!isDominated)
+					{
+						members.push_back(i);
+					}
+				}
+				for (const int i : members)
+				{
+					expectedRanks[i] = front;
+				}
+				numRanked += static_cast<int>(members.size());
+				Assert::AreEqual(ranking.GetFrontSize(front), static_cast<int>(members.size()));
+			}
+			for (int i = 0; i < numPoints; i++)
+			{
+				Assert::AreEqual(ranking.GetRank(i), expectedRanks[i]);
+			}
+		}
+
+		TEST_METHOD(CrowdingDistanceAndOrder)
+		{
+			// One front, with a point crowded in next to the cheapest one, and one dominated point
+			std::vector<ParetoPoint> points(5);
+			points[0].m_score = 10.0f; points[0].m_cost = 100.0f;
+			points[1].m_score = 5.0f; points[1].m_cost = 50.0f;
+			points[2].m_score = 1.0f; points[2].m_cost = 11.0f;
+			points[3].m_score = 0.0f; points[3].m_cost = 10.0f;
+			points[4].m_score = 4.0f; points[4].m_cost = 60.0f;
+			ParetoRanking ranking;
+			ranking.Rank(points);
+
+			Assert::AreEqual(ranking.GetNumFronts(), 2);
+			Assert::AreEqual(ranking.GetRank(4), 1);
+			Assert::IsTrue(Math::IsInfinite(ranking.GetCrowdingDistance(0)));
+			Assert::IsTrue(Math::IsInfinite(ranking.GetCrowdingDistance(3)));
+			Assert::IsTrue(ranking.GetCrowdingDistance(1) > ranking.GetCrowdingDistance(2));
+
+			// Best score first, then the other end of the front, then by crowding
+			const std::vector<int>& order = ranking.GetOrder();
+			Assert::AreEqual(order[0], 0);
+			Assert::AreEqual(order[1], 3);
+			Assert::AreEqual(order[2], 1);
+			Assert::AreEqual(order[3], 2);
+			Assert::AreEqual(order[4], 4);
+		}
+	};
+	TEST_CLASS(TestFitnessSurrogate)
+	{
+	public:
+		TEST_METHOD(PredictsFromSimilarBehavior)
+		{
+			Random rand(14);
+			FitnessSurrogate::Config config;
+			config.m_numNeighbours = 3;
+			config.m_capacity = 64;
+			FitnessSurrogate surrogate(config);
+
+			std::vector<float> probeStates(5 * 4);
+			rand.FillUniform(probeStates.data(), static_cast<int>(probeStates.size()), -1.0f, 1.0f);
+			surrogate.SetProbeStates(probeStates, 4);
+			Assert::AreEqual(surrogate.GetNumProbeStates(), 5);
+
+			// Random networks behave differently on the probes, so each one is its own sample
+			std::vector<Network> networks;
+			std::vector<float> behavior;
+			for (int i = 0; i < 40; i++)
+			{
+				Network network({ 4, 3, 2 });
+				network.Randomize(rand);
+				surrogate.ComputeBehavior(network, behavior);
+				Assert::AreEqual(static_cast<int>(behavior.size()), 5 * 2);
+				surrogate.AddSample(behavior, static_cast<float>(i));
+				networks.push_back(network);
+			}
+			Assert::IsTrue(surrogate.IsReady());
+
+			// A known network is predicted exactly
+			surrogate.ComputeBehavior(networks[17], behavior);
+			Assert::IsTrue(Math::Equals(surrogate.Predict(behavior), 17.0f, 0.01f));
+
+			// Old samples are replaced once the surrogate is full
+			for (int i = 0; i < 64; i++)
+			{
+				surrogate.AddSample(behavior, 100.0f);
+			}
+			Assert::AreEqual(surrogate.GetNumSamples(), 64);
+			surrogate.ComputeBehavior(networks[3], behavior);
+			Assert::IsTrue(Math::Equals(surrogate.Predict(behavior), 100.0f, 0.01f));
+		}
+
+		TEST_METHOD(RankCorrelation)
+		{
+			const std::vector<float> a = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f };
+			const std::vector<float> same = { 10.0f, 20.0f, 25.0f, 100.0f, 101.0f };
+			const std::vector<float> reversed = { 5.0f, 4.0f, 3.0f, 2.0f, 1.0f };
+			const std::vector<float> constant = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+			Assert::IsTrue(Math::Equals(FitnessSurrogate::ComputeRankCorrelation(a, same), 1.0f, 1e-5f));
+			Assert::IsTrue(Math::Equals(FitnessSurrogate::ComputeRankCorrelation(a, reversed), -1.0f, 1e-5f));
+			Assert::IsTrue(Math::Equals(FitnessSurrogate::ComputeRankCorrelation(a, constant), 0.0f, 1e-5f));
+		}
+	};
+
+	TEST_CLASS(TestDistiller)
+	{
+	public:
+		// Plays a network without noise, and keeps every state it sees
+		class StateCollector : public NeuronPlayerController
+		{
+		public:
+			StateCollector(const Network& network, std::vector<std::vector<float>>& outStates) :
+				m_network(network),
+				m_states(outStates)
+			{
+			}
+
+			virtual void GetInputFromGameState(NeuronPlayerInput& outPlayerInput, const NeuronGame& game, const int playerIndex) override
+			{
+				const GameStateForNeuralNetInput networkInput(game, playerIndex);
+				m_states.push_back(networkInput.GetStateAsStdVector());
+				const std::vector<float> outputs = m_network.Evaluate(m_states.back());
+				outPlayerInput.m_steering = outputs[0];
+				outPlayerInput.m_speed = outputs[1];
+				outPlayerInput.m_boost = outputs[2];
+			}
+
+		private:
+			const Network& m_network;
+			std::vector<std::vector<float>>& m_states;
+		};
+
+		// Mean squared difference between the outputs of the two networks over 'states'
+		static float ComputeError(const Network& network, const Network& teacher, const std::vector<std::vector<float>>& states)
+		{
+			double sum = 0.0;
+			int count = 0;
+			for (const std::vector<float>& state : states)
+			{
+				const std::vector<float> outputs = network.Evaluate(state);
+				const std::vector<float> targets = teacher.Evaluate(state);
+				for (int i = 0; i < outputs.size(); i++)
+				{
+					sum += Math::Sqr(outputs[i] - targets[i]);
+					count++;
+				}
+			}
+			return static_cast<float>(sum / count);
+		}
+
+		TEST_METHOD(FoldedScalingKeepsOutputs)
+		{
+			Random rand(21);
+			Network scaled({ 4, 6, 2 });
+			scaled.Randomize(rand);
+			const std::vector<float> mean = { 50.0f, -3.0f, 0.0f, 10.0f };
+			const std::vector<float> scale = { 0.02f, 0.5f, 1.0f, 0.1f };
+			Network folded = scaled;
+			Distiller::FoldInputScaling(folded, mean, scale);
+
+			for (int test = 0; test < 20; test++)
+			{
+				std::vector<float> inputs(mean.size());
+				std::vector<float> scaledInputs(mean.size());
+				for (int c = 0; c < inputs.size(); c++)
+				{
+					inputs[c] = mean[c] + (rand.NextFloat(-3.0f, 3.0f) / scale[c]);
+					scaledInputs[c] = (inputs[c] - mean[c]) * scale[c];
+				}
+				const std::vector<float> expected = scaled.Evaluate(scaledInputs);
+				const std::vector<float> actual = folded.Evaluate(inputs);
+				for (int i = 0; i < expected.size(); i++)
+				{
+					Assert::IsTrue(Math::Equals(expected[i], actual[i], 1e-4f));
+				}
+			}
+		}
+
+		TEST_METHOD(StudentLearnsTeacher)
+		{
+			Random rand(8);
+			const std::vector<int> teacherLevels = { GameStateForNeuralNetInput::k_numGameStateInputs, 16, 16, 3 };
+			Network teacher(teacherLevels);
+			teacher.Randomize(rand);
+
+			Distiller::Config config;
+			config.m_studentHiddenLevels = { 8 };
+			config.m_gameDuration = 10.0f;
+			config.m_numSelfPlayGames = 4;
+			config.m_numRounds = 2;
+			config.m_numEpochsPerRound = 10;
+			config.m_numStudentGamesPerRound = 2;
+			Distiller distiller(teacher, config);
+			const Network& student = distiller.Run(rand);
+			Assert::IsTrue(distiller.GetNumStates() > 0);
+			Assert::IsTrue(student.GetNumParameters() < teacher.GetNumParameters());
+
+			// Held out states, from a game the sampled ones didn't include
+			std::vector<std::vector<float>> states;
+			StateCollector player(teacher, states);
+			NeuronGame game;
+			game.ResetGame(config.m_gameDuration);
+			game.SetPlayerController(0, &player);
+			game.SetPlayerController(1, &player);
+			while (!game.IsGameOver())
+			{
+				game.Update();
+			}
+
+			// Compared against an untrained network the same shape as the student
+			Network untrained({ GameStateForNeuralNetInput::k_numGameStateInputs, 8, 3 });
+			untrained.Randomize(rand);
+			const float untrainedError = ComputeError(untrained, teacher, states);
+			const float studentError = ComputeError(student, teacher, states);
+			Assert::IsTrue(studentError < untrainedError * 0.25f);
+		}
+	};
+}